@@ -0,0 +1,69 @@
+/*
+	CXKernelOps.h
+
+	CX Animation Tools - libcx_kernels internals
+	Each kernel adapter (ColorLinesCApi.cpp, PencilLineCApi.cpp) exposes its
+	render info, parameter setters and render call through a CX_KernelOps
+	table; cx_kernels.cpp owns contexts, buffers, threading and stats. The
+	kernel headers cannot share a translation unit, hence the table.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_KERNEL_OPS_H
+#define CX_KERNEL_OPS_H
+
+#include "CXCommon.h"
+#include "CXHost.h"
+#include "cx_kernels.h"
+#include <string.h>
+#include <stdlib.h>
+
+typedef struct {
+	size_t		infoSize;
+
+	// Plugin defaults, as after applying the effect in AE
+	void		(*initInfo)(void *info);
+
+	// Name lookups; CX_STATUS_UNKNOWN_PARAM when the kernel has no such parameter
+	cx_status	(*setValue)(void *info, const char *name, double value);
+	cx_status	(*setColor)(void *info, const char *name, PF_Pixel color);
+
+	// info is the context's copy; prev / next may be NULL
+	PF_Err		(*render)(const CX_Host *host, const void *info, PF_PixelFormat format,
+						  PF_EffectWorld *src, PF_EffectWorld *prev, PF_EffectWorld *next, PF_EffectWorld *dst);
+} CX_KernelOps;
+
+extern const CX_KernelOps g_cxColorLinesOps;
+extern const CX_KernelOps g_cxPencilLineOps;
+
+// ============================================================================
+// Parameter Name Helpers
+// ============================================================================
+
+// Index of an indexed parameter name: "useColor3" with base "useColor"
+// gives 3. Returns 0 when name is not base followed by 1..maxIndex;
+// a bare base name is index 1 when allowBare is set.
+static inline A_long CX_ParamIndex(const char *name, const char *base, A_long maxIndex, bool allowBare) {
+	size_t length = strlen(base);
+	if (strncmp(name, base, length) != 0) return 0;
+	const char *digits = name + length;
+	if (!*digits) return allowBare ? 1 : 0;
+	if (*digits < '1' || *digits > '9') return 0;
+	char *end = NULL;
+	long index = strtol(digits, &end, 10);
+	if (*end || index > maxIndex) return 0;
+	return (A_long)index;
+}
+
+// Parameter value checks; popups are whole numbers 1..count
+static inline cx_status CX_CheckRange(double value, double min, double max) {
+	return (value >= min && value <= max) ? CX_STATUS_OK : CX_STATUS_OUT_OF_RANGE;
+}
+
+static inline cx_status CX_CheckChoice(double value, A_long count) {
+	return (value >= 1 && value <= count && value == (double)(A_long)value) ? CX_STATUS_OK : CX_STATUS_OUT_OF_RANGE;
+}
+
+#endif // CX_KERNEL_OPS_H
@@ -0,0 +1,84 @@
+/*
+	CXServe.h
+
+	CX Animation Tools - cx_render frame server protocol
+	cx_render --serve keeps one warm context per kernel (thread pool, frame
+	caches, tables) and renders jobs sent over a local Unix socket. Pixels
+	never go through the socket: the client puts source and destination
+	frames in a POSIX shared-memory segment (shm_open) and sends offsets;
+	the server maps the segment and renders in place.
+
+	Per connection: CX_ServeRequest [+ paramCount x CX_ServeParam] ->
+	CX_ServeReply for a job, or CX_ServeStats for a stats request. Jobs from
+	all connections go through one queue to one render thread; the pool
+	parallelises each frame. POSIX only.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_SERVE_H
+#define CX_SERVE_H
+
+#include "cx_kernels.h"
+#include <stdint.h>
+
+#define CX_SERVE_MAGIC			0x56535843u		// "CXSV"
+#define CX_SERVE_VERSION		1
+#define CX_SERVE_NO_FRAME		UINT64_MAX		// Offset of an absent prev / next frame
+#define CX_SERVE_MAX_PARAMS		256
+
+enum {
+	CX_SERVE_JOB = 1,
+	CX_SERVE_STATS
+};
+
+// One parameter, applied on top of the kernel defaults for this job only
+typedef struct {
+	char		name[64];
+	int32_t		isColor;		// value[0..2] is r, g, b (0.0-1.0)
+	int32_t		reserved;
+	double		value[3];
+} CX_ServeParam;
+
+typedef struct {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	type;			// CX_SERVE_JOB / CX_SERVE_STATS
+	uint32_t	paramCount;		// CX_ServeParam records following a job
+	int32_t		kernel;			// cx_kernel
+	int32_t		format;			// cx_format (kernel layout, see cx_kernels.h)
+	int32_t		width;
+	int32_t		height;
+	int64_t		stride;
+	uint64_t	srcOffset;		// Byte offsets into the segment
+	uint64_t	prevOffset;
+	uint64_t	nextOffset;
+	uint64_t	dstOffset;
+	char		shmName[64];	// shm_open name, e.g. "/cx_client_1234"
+} CX_ServeRequest;
+
+typedef struct {
+	int32_t		status;			// cx_status
+	int32_t		queueDepth;		// Jobs waiting when this one was queued
+	double		queueMs;		// Queued until the render thread took it
+	double		renderMs;		// Segment mapping and render
+	double		latencyMs;		// Request received until rendered
+} CX_ServeReply;
+
+typedef struct {
+	uint64_t	jobs;			// Finished jobs, failed ones included
+	uint64_t	failed;
+	int32_t		queueDepth;		// Jobs waiting now
+	int32_t		maxQueueDepth;
+	double		avgLatencyMs;
+	double		maxLatencyMs;
+	double		avgQueueMs;
+	double		avgRenderMs;
+	double		uptimeSeconds;
+} CX_ServeStats;
+
+// Runs the server until SIGINT / SIGTERM; threads as for cx_context_create
+int CX_RunServer(const char *socketPath, int threads, bool verbose);
+
+#endif // CX_SERVE_H
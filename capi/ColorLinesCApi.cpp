@@ -0,0 +1,130 @@
+/*
+	ColorLinesCApi.cpp
+
+	cx_ColorLines in libcx_kernels: parameter names and values follow the
+	OpenFX plugin (ColorLinesOfx.cpp); the render is ColorLinesRender.
+*/
+
+#include "CXKernelOps.h"
+#include "ColorLinesKernels.h"
+#include "CXColorMatch.h"
+
+static void InitInfo(void *infoP) {
+	ColorLinesInfo *info = (ColorLinesInfo*)infoP;
+	AEFX_CLR_STRUCT(*info);
+	for (A_long i = 0; i < COLORLINES_MAX_COLORS; i++) {
+		info->colors[i].color.alpha = PF_MAX_CHAN8;
+		info->colors[i].tolerance = TOLERANCE_DFLT;
+	}
+	info->colors[0].enabled = TRUE;
+
+	info->fillMode = FILL_MODE_WEIGHTED;
+	info->searchRadius = SEARCH_RADIUS_DFLT;
+	info->ignoreTransparent = TRUE;
+	info->sampleBlur = SAMPLE_BLUR_DFLT;
+	info->brightness = BRIGHTNESS_DFLT;
+	info->contrast = CONTRAST_DFLT;
+	info->saturation = SATURATION_DFLT;
+	info->outputMode = OUTPUT_MODE_FULL;
+	info->distanceOutput = DISTANCE_OUTPUT_OFF;
+	info->distanceChannel = DISTANCE_CHANNEL_ALPHA;
+	info->distanceRange = DISTANCE_RANGE_DFLT;
+	info->quality = PF_Quality_HI;
+}
+
+static cx_status SetValue(void *infoP, const char *name, double value) {
+	ColorLinesInfo *info = (ColorLinesInfo*)infoP;
+	cx_status status = CX_STATUS_UNKNOWN_PARAM;
+	A_long n = 0;
+
+	if ((n = CX_ParamIndex(name, "colorTolerance", COLORLINES_MAX_COLORS, true)) != 0) {
+		status = CX_CheckRange(value, TOLERANCE_MIN, TOLERANCE_MAX);
+		if (!status) info->colors[n - 1].tolerance = value;
+	} else if ((n = CX_ParamIndex(name, "useColor", COLORLINES_MAX_COLORS, false)) > 1) {
+		// Target Color (1) is always on
+		status = CX_CheckRange(value, 0, 1);
+		if (!status) info->colors[n - 1].enabled = value != 0 ? TRUE : FALSE;
+	} else if (strcmp(name, "fillMode") == 0) {
+		status = CX_CheckChoice(value, FILL_MODE_NUM_MODES - 1);
+		if (!status) info->fillMode = (A_long)value;
+	} else if (strcmp(name, "searchRadius") == 0) {
+		status = CX_CheckRange(value, SEARCH_RADIUS_MIN, SEARCH_RADIUS_MAX);
+		if (!status) info->searchRadius = (A_long)value;
+	} else if (strcmp(name, "ignoreTransparent") == 0) {
+		status = CX_CheckRange(value, 0, 1);
+		if (!status) info->ignoreTransparent = value != 0 ? TRUE : FALSE;
+	} else if (strcmp(name, "sampleBlur") == 0) {
+		status = CX_CheckRange(value, SAMPLE_BLUR_MIN, SAMPLE_BLUR_MAX);
+		if (!status) info->sampleBlur = value;
+	} else if (strcmp(name, "temporalFill") == 0) {
+		status = CX_CheckRange(value, 0, 1);
+		if (!status) info->temporalFill = value != 0 ? TRUE : FALSE;
+	} else if (strcmp(name, "brightness") == 0) {
+		status = CX_CheckRange(value, BRIGHTNESS_MIN, BRIGHTNESS_MAX);
+		if (!status) info->brightness = value;
+	} else if (strcmp(name, "contrast") == 0) {
+		status = CX_CheckRange(value, CONTRAST_MIN, CONTRAST_MAX);
+		if (!status) info->contrast = value;
+	} else if (strcmp(name, "saturation") == 0) {
+		status = CX_CheckRange(value, SATURATION_MIN, SATURATION_MAX);
+		if (!status) info->saturation = value;
+	} else if (strcmp(name, "outputMode") == 0) {
+		status = CX_CheckChoice(value, OUTPUT_MODE_NUM_MODES - 1);
+		if (!status) info->outputMode = (A_long)value;
+	} else if (strcmp(name, "distanceOutput") == 0) {
+		status = CX_CheckChoice(value, DISTANCE_OUTPUT_NUM_MODES - 1);
+		if (!status) info->distanceOutput = (A_long)value;
+	} else if (strcmp(name, "distanceChannel") == 0) {
+		status = CX_CheckChoice(value, DISTANCE_CHANNEL_NUM_CHANNELS - 1);
+		if (!status) info->distanceChannel = (A_long)value;
+	} else if (strcmp(name, "distanceRange") == 0) {
+		status = CX_CheckRange(value, DISTANCE_RANGE_MIN, DISTANCE_RANGE_MAX);
+		if (!status) info->distanceRange = value;
+	} else if (strcmp(name, "draftQuality") == 0) {
+		// AE Draft / OFX draft render: enables the kernels' approximations
+		status = CX_CheckRange(value, 0, 1);
+		if (!status) info->quality = value != 0 ? PF_Quality_LO : PF_Quality_HI;
+	} else if (strcmp(name, "matchBackend") == 0) {
+		// Engine overrides, for comparing the fast paths with the exact ones
+		status = CX_CheckRange(value, CX_MATCH_BACKEND_AUTO, CX_MATCH_BACKEND_BITSET);
+		if (!status) info->matchBackend = (A_long)value;
+	} else if (strcmp(name, "scalarKernels") == 0) {
+		status = CX_CheckRange(value, 0, 1);
+		if (!status) info->scalarKernels = value != 0 ? TRUE : FALSE;
+	}
+	return status;
+}
+
+static cx_status SetColor(void *infoP, const char *name, PF_Pixel color) {
+	ColorLinesInfo *info = (ColorLinesInfo*)infoP;
+	A_long n = CX_ParamIndex(name, "targetColor", COLORLINES_MAX_COLORS, true);
+	if (!n) return CX_STATUS_UNKNOWN_PARAM;
+	info->colors[n - 1].color = color;
+	return CX_STATUS_OK;
+}
+
+static PF_Err Render(const CX_Host *host, const void *infoP, PF_PixelFormat format,
+					 PF_EffectWorld *src, PF_EffectWorld *prev, PF_EffectWorld *next, PF_EffectWorld *dst) {
+	// The render fills in per-frame state, so it works on a copy
+	ColorLinesInfo info = *(const ColorLinesInfo*)infoP;
+
+	// Adjacent frames are only read by the fill (not Line Mask or Background Only)
+	ColorLinesStages stages;
+	ColorLinesPlanStages(&info, &stages);
+	info.temporalFill = stages.temporal;
+	if (info.temporalFill) {
+		info.prevWorld = prev;
+		info.nextWorld = next;
+		info.hasPrevFrame = prev != NULL;
+		info.hasNextFrame = next != NULL;
+	}
+	return ColorLinesRender(host, &info, format, src, dst);
+}
+
+const CX_KernelOps g_cxColorLinesOps = {
+	sizeof(ColorLinesInfo),
+	InitInfo,
+	SetValue,
+	SetColor,
+	Render
+};
@@ -0,0 +1,123 @@
+/*
+ * PencilLineCApi.cpp
+ * cx_PencilLine in libcx_kernels
+ *
+ * Parameter names and values follow the OpenFX plugin (PencilLineOfx.cpp);
+ * the render is PencilLineRender.
+ */
+
+#include "CXKernelOps.h"
+#include "PencilLineKernels.h"
+#include <cstdio>
+
+static void InitInfo(void* infoP)
+{
+    PencilLineInfo* info = static_cast<PencilLineInfo*>(infoP);
+    memset(info, 0, sizeof(PencilLineInfo));
+
+    info->colorCount = MAX_COLORS;
+    for (A_long i = 0; i < MAX_COLORS; ++i) {
+        info->colors[i].enabled = (i == 0);
+        info->colors[i].color.alpha = PF_MAX_CHAN8;
+        info->colors[i].tolerance = DEFAULT_TOLERANCE;
+        info->colors[i].toleranceSq = CX_ToleranceToDistSq(DEFAULT_TOLERANCE);
+        info->colors[i].newColor.alpha = PF_MAX_CHAN8;
+        info->colors[i].lineWidth = DEFAULT_LINE_WIDTH;
+        info->colors[i].lineDensity = DEFAULT_LINE_DENSITY;
+        info->colors[i].textureStrength = DEFAULT_CUSTOM_TEXTURE_STRENGTH;
+    }
+
+    info->lineWidth = DEFAULT_LINE_WIDTH;
+    info->lineDensity = DEFAULT_LINE_DENSITY;
+    info->textureStrength = DEFAULT_TEXTURE_STRENGTH;
+    info->outputMode = OUTPUT_MODE_FULL;
+    info->downsampleX = 1;
+    info->downsampleY = 1;
+}
+
+static cx_status SetValue(void* infoP, const char* name, double value)
+{
+    PencilLineInfo* info = static_cast<PencilLineInfo*>(infoP);
+    cx_status status = CX_STATUS_UNKNOWN_PARAM;
+    A_long n = 0;
+
+    if ((n = CX_ParamIndex(name, "tolerance", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, TOLERANCE_MIN, TOLERANCE_MAX);
+        if (!status) {
+            info->colors[n - 1].tolerance = value;
+            info->colors[n - 1].toleranceSq = CX_ToleranceToDistSq(value);
+        }
+    } else if ((n = CX_ParamIndex(name, "color", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, 0, 1);
+        if (!status) info->colors[n - 1].enabled = value != 0 ? TRUE : FALSE;
+    } else if ((n = CX_ParamIndex(name, "recolor", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, 0, 1);
+        if (!status) info->colors[n - 1].recolor = value != 0 ? TRUE : FALSE;
+    } else if ((n = CX_ParamIndex(name, "texture", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, 0, 1);
+        if (!status) info->colors[n - 1].customTexture = value != 0 ? TRUE : FALSE;
+    } else if ((n = CX_ParamIndex(name, "lineWidth", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, LINE_WIDTH_MIN, LINE_WIDTH_MAX);
+        if (!status) info->colors[n - 1].lineWidth = static_cast<A_long>(value);
+    } else if ((n = CX_ParamIndex(name, "lineDensity", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, LINE_DENSITY_MIN, LINE_DENSITY_MAX);
+        if (!status) info->colors[n - 1].lineDensity = value;
+    } else if ((n = CX_ParamIndex(name, "textureStrength", MAX_COLORS, false)) != 0) {
+        status = CX_CheckRange(value, TEXTURE_STRENGTH_MIN, TEXTURE_STRENGTH_MAX);
+        if (!status) info->colors[n - 1].textureStrength = value;
+    } else if (strcmp(name, "lineWidth") == 0) {
+        status = CX_CheckRange(value, LINE_WIDTH_MIN, LINE_WIDTH_MAX);
+        if (!status) info->lineWidth = static_cast<A_long>(value);
+    } else if (strcmp(name, "lineDensity") == 0) {
+        status = CX_CheckRange(value, LINE_DENSITY_MIN, LINE_DENSITY_MAX);
+        if (!status) info->lineDensity = value;
+    } else if (strcmp(name, "textureStrength") == 0) {
+        status = CX_CheckRange(value, TEXTURE_STRENGTH_MIN, TEXTURE_STRENGTH_MAX);
+        if (!status) info->textureStrength = value;
+    } else if (strcmp(name, "outputMode") == 0) {
+        status = CX_CheckChoice(value, OUTPUT_MODE_BG_ONLY);
+        if (!status) info->outputMode = static_cast<A_long>(value);
+    }
+    return status;
+}
+
+// Colour names are "color<N>Value" / "recolor<N>Value", the checkboxes being
+// "color<N>" / "recolor<N>"
+static cx_status SetColor(void* infoP, const char* name, PF_Pixel color)
+{
+    PencilLineInfo* info = static_cast<PencilLineInfo*>(infoP);
+    char indexed[32];
+    for (A_long n = 1; n <= MAX_COLORS; ++n) {
+        snprintf(indexed, sizeof(indexed), "color%dValue", (int)n);
+        if (strcmp(name, indexed) == 0) {
+            info->colors[n - 1].color = color;
+            return CX_STATUS_OK;
+        }
+        snprintf(indexed, sizeof(indexed), "recolor%dValue", (int)n);
+        if (strcmp(name, indexed) == 0) {
+            info->colors[n - 1].newColor = color;
+            return CX_STATUS_OK;
+        }
+    }
+    return CX_STATUS_UNKNOWN_PARAM;
+}
+
+static PF_Err Render(
+    const CX_Host*      host,
+    const void*         infoP,
+    PF_PixelFormat      format,
+    PF_EffectWorld*     src,
+    PF_EffectWorld*     /*prev*/,
+    PF_EffectWorld*     /*next*/,
+    PF_EffectWorld*     dst)
+{
+    return PencilLineRender(host, static_cast<const PencilLineInfo*>(infoP), format, src, dst);
+}
+
+const CX_KernelOps g_cxPencilLineOps = {
+    sizeof(PencilLineInfo),
+    InitInfo,
+    SetValue,
+    SetColor,
+    Render
+};
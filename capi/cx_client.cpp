@@ -0,0 +1,254 @@
+/*
+	cx_client.cpp
+
+	CX Animation Tools - test client for cx_render --serve
+
+		cx_render --serve /tmp/cx.sock &
+		cx_client --socket /tmp/cx.sock --size 1920x1080 --frames 50 --clients 4
+
+	Each client thread puts a synthetic line-art frame and its output in a
+	shared-memory segment and sends jobs for it. The first result of every
+	client is checked against an in-process libcx_kernels render with the
+	same parameters; round-trip latency and the server's stats are printed.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "cx_kernels.h"
+#include "CXServe.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+
+int main() {
+	fprintf(stderr, "cx_client: needs Unix sockets and POSIX shared memory\n");
+	return EXIT_FAILURE;
+}
+
+#else
+
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef struct {
+	const char					*socketPath;
+	cx_kernel					kernel;
+	int							width;
+	int							height;
+	int							frames;
+	int							clients;
+	std::vector<CX_ServeParam>	params;
+} ClientOptions;
+
+typedef struct {
+	bool		ok;
+	bool		verified;
+	double		totalMs;
+	double		maxMs;
+} ClientResult;
+
+static int Connect(const char *path) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+static bool SendAll(int fd, const void *data, size_t size) {
+	return send(fd, data, size, MSG_NOSIGNAL) == (ssize_t)size;
+}
+
+static bool ReceiveAll(int fd, void *data, size_t size) {
+	char *p = (char*)data;
+	while (size) {
+		ssize_t got = recv(fd, p, size, 0);
+		if (got <= 0) return false;
+		p += got;
+		size -= (size_t)got;
+	}
+	return true;
+}
+
+// Opaque noise crossed by black diagonal lines, ARGB 8-bit
+static void FillTestFrame(uint8_t *pixels, int width, int height, unsigned seed) {
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++, pixels += 4) {
+			bool line = (x * 3 + y * 2) % 37 < 3 || (x - y + 4096) % 53 < 2;
+			seed = seed * 1664525u + 1013904223u;
+			pixels[0] = 255;
+			pixels[1] = line ? 0 : (uint8_t)(64 + (seed >> 24) % 192);
+			pixels[2] = line ? 0 : (uint8_t)(64 + (seed >> 16) % 192);
+			pixels[3] = line ? 0 : (uint8_t)(64 + (seed >> 8) % 192);
+		}
+	}
+}
+
+static bool RenderReference(const ClientOptions *options, const cx_image *src, const uint8_t *result) {
+	cx_context *context = NULL;
+	if (cx_context_create(options->kernel, 0, &context)) return false;
+	for (const CX_ServeParam &param : options->params) {
+		if (param.isColor) cx_set_color(context, param.name, param.value[0], param.value[1], param.value[2]);
+		else cx_set_float(context, param.name, param.value[0]);
+	}
+	std::vector<uint8_t> reference((size_t)src->stride * src->height);
+	cx_image dst = *src;
+	dst.data = reference.data();
+	bool same = cx_process(context, src, NULL, NULL, &dst) == CX_STATUS_OK &&
+				memcmp(reference.data(), result, reference.size()) == 0;
+	cx_context_destroy(context);
+	return same;
+}
+
+static void RunClient(const ClientOptions *options, int index, ClientResult *result) {
+	memset(result, 0, sizeof(ClientResult));
+	const size_t frameBytes = (size_t)options->width * options->height * 4;
+
+	CX_ServeRequest request;
+	memset(&request, 0, sizeof(request));
+	request.magic = CX_SERVE_MAGIC;
+	request.version = CX_SERVE_VERSION;
+	request.type = CX_SERVE_JOB;
+	request.paramCount = (uint32_t)options->params.size();
+	request.kernel = options->kernel;
+	request.format = CX_FORMAT_ARGB8;
+	request.width = options->width;
+	request.height = options->height;
+	request.stride = options->width * 4;
+	request.srcOffset = 0;
+	request.dstOffset = frameBytes;
+	request.prevOffset = request.nextOffset = CX_SERVE_NO_FRAME;
+	snprintf(request.shmName, sizeof(request.shmName), "/cx_client_%d_%d", (int)getpid(), index);
+
+	int shm = shm_open(request.shmName, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (shm < 0) return;
+	void *base = MAP_FAILED;
+	if (ftruncate(shm, (off_t)(frameBytes * 2)) == 0) {
+		base = mmap(NULL, frameBytes * 2, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+	}
+	close(shm);
+
+	int fd = base != MAP_FAILED ? Connect(options->socketPath) : -1;
+	if (fd >= 0) {
+		uint8_t *src = (uint8_t*)base;
+		FillTestFrame(src, options->width, options->height, 17u + index);
+		result->ok = true;
+
+		for (int frame = 0; frame < options->frames && result->ok; frame++) {
+			const auto start = std::chrono::steady_clock::now();
+			CX_ServeReply reply;
+			result->ok = SendAll(fd, &request, sizeof(request)) &&
+						 (options->params.empty() || SendAll(fd, options->params.data(), options->params.size() * sizeof(CX_ServeParam))) &&
+						 ReceiveAll(fd, &reply, sizeof(reply));
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (result->ok && reply.status != CX_STATUS_OK) {
+				fprintf(stderr, "cx_client: job failed: %s\n", cx_status_string((cx_status)reply.status));
+				result->ok = false;
+			}
+			result->totalMs += ms;
+			result->maxMs = std::max(result->maxMs, ms);
+
+			if (result->ok && frame == 0) {
+				cx_image image = { src, options->width, options->height, (ptrdiff_t)request.stride, CX_FORMAT_ARGB8 };
+				result->verified = RenderReference(options, &image, src + frameBytes);
+			}
+		}
+		close(fd);
+	}
+
+	if (base != MAP_FAILED) munmap(base, frameBytes * 2);
+	shm_unlink(request.shmName);
+}
+
+static bool ParseOptions(int argc, char **argv, ClientOptions *options) {
+	options->socketPath = NULL;
+	options->kernel = CX_KERNEL_COLORLINES;
+	options->width = 1920;
+	options->height = 1080;
+	options->frames = 20;
+	options->clients = 1;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const char *arg = argv[i], *value = argv[i + 1];
+		if (strcmp(arg, "--socket") == 0) options->socketPath = value;
+		else if (strcmp(arg, "--kernel") == 0) options->kernel = strcmp(value, "pencilline") == 0 ? CX_KERNEL_PENCILLINE : CX_KERNEL_COLORLINES;
+		else if (strcmp(arg, "--size") == 0) { if (sscanf(value, "%dx%d", &options->width, &options->height) != 2) return false; }
+		else if (strcmp(arg, "--frames") == 0) options->frames = atoi(value);
+		else if (strcmp(arg, "--clients") == 0) options->clients = atoi(value);
+		else if (strcmp(arg, "--set") == 0 || strcmp(arg, "--color") == 0) {
+			CX_ServeParam param;
+			memset(&param, 0, sizeof(param));
+			const char *equals = strchr(value, '=');
+			if (!equals || (size_t)(equals - value) >= sizeof(param.name)) return false;
+			memcpy(param.name, value, equals - value);
+			param.isColor = arg[2] == 'c';
+			int expected = param.isColor ? 3 : 1;
+			if (sscanf(equals + 1, "%lf,%lf,%lf", &param.value[0], &param.value[1], &param.value[2]) != expected) return false;
+			options->params.push_back(param);
+		} else {
+			return false;
+		}
+	}
+	return options->socketPath && options->width > 0 && options->height > 0 && options->frames > 0 && options->clients > 0;
+}
+
+int main(int argc, char **argv) {
+	ClientOptions options;
+	if (!ParseOptions(argc, argv, &options)) {
+		fprintf(stderr, "usage: cx_client --socket <path> [--kernel colorlines|pencilline] [--size WxH]\n"
+						"                 [--frames N] [--clients N] [--set name=value]... [--color name=r,g,b]...\n");
+		return EXIT_FAILURE;
+	}
+
+	std::vector<ClientResult> results(options.clients);
+	std::vector<std::thread> clients;
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < options.clients; i++) clients.emplace_back(RunClient, &options, i, &results[i]);
+	for (std::thread &client : clients) client.join();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	bool ok = true;
+	double totalMs = 0.0, maxMs = 0.0;
+	for (const ClientResult &result : results) {
+		ok = ok && result.ok && result.verified;
+		totalMs += result.totalMs;
+		maxMs = std::max(maxMs, result.maxMs);
+	}
+	const int jobs = options.frames * options.clients;
+	printf("cx_client: %d jobs, %s, round trip avg %.2f / max %.2f ms, %.1f MPix/s\n",
+		   jobs, ok ? "results verified" : "FAILED", totalMs / jobs, maxMs,
+		   seconds > 0 ? (double)jobs * options.width * options.height / 1e6 / seconds : 0.0);
+
+	// Server-side metrics
+	int fd = Connect(options.socketPath);
+	CX_ServeRequest request;
+	memset(&request, 0, sizeof(request));
+	request.magic = CX_SERVE_MAGIC;
+	request.version = CX_SERVE_VERSION;
+	request.type = CX_SERVE_STATS;
+	CX_ServeStats stats;
+	if (fd >= 0 && SendAll(fd, &request, sizeof(request)) && ReceiveAll(fd, &stats, sizeof(stats))) {
+		printf("cx_render: %llu jobs (%llu failed), latency avg %.2f / max %.2f ms, queue avg %.2f ms, "
+			   "render avg %.2f ms, queue depth %d (max %d), up %.1f s\n",
+			   (unsigned long long)stats.jobs, (unsigned long long)stats.failed, stats.avgLatencyMs, stats.maxLatencyMs,
+			   stats.avgQueueMs, stats.avgRenderMs, stats.queueDepth, stats.maxQueueDepth, stats.uptimeSeconds);
+	}
+	if (fd >= 0) close(fd);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
@@ -0,0 +1,238 @@
+/*
+	cx_kernels.cpp
+
+	CX Animation Tools - libcx_kernels
+	Contexts, caller buffer wrapping, threading and stats behind the C API
+	(cx_kernels.h). Kernel specifics live in the CX_KernelOps adapters.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXKernelOps.h"
+#include "CXThreadPool.h"
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <system_error>
+
+// ============================================================================
+// Context
+// ============================================================================
+
+struct cx_context {
+	std::mutex			lock;		// Serialises every call on the context
+	const CX_KernelOps	*ops;
+	void				*info;		// ops->infoSize bytes
+	CX_ThreadPool		pool;
+	cx_stats			stats;
+
+	cx_context(const CX_KernelOps *kernelOps, A_long threads) : ops(kernelOps), info(NULL), pool(threads) {
+		AEFX_CLR_STRUCT(stats);
+		stats.threads = pool.ThreadCount();
+	}
+	~cx_context() {
+		free(info);
+	}
+};
+
+static const CX_KernelOps* KernelOps(cx_kernel kernel) {
+	switch (kernel) {
+		case CX_KERNEL_COLORLINES: return &g_cxColorLinesOps;
+		case CX_KERNEL_PENCILLINE: return &g_cxPencilLineOps;
+		default: return NULL;
+	}
+}
+
+static cx_status StatusFromErr(PF_Err err) {
+	switch (err) {
+		case PF_Err_NONE: return CX_STATUS_OK;
+		case PF_Err_OUT_OF_MEMORY: return CX_STATUS_OUT_OF_MEMORY;
+		default: return CX_STATUS_FAILED;
+	}
+}
+
+// ============================================================================
+// Images
+// ============================================================================
+
+static A_long PixelBytes(cx_format format) {
+	switch (format) {
+		case CX_FORMAT_ARGB8: return sizeof(PF_Pixel8);
+		case CX_FORMAT_ARGB16: return sizeof(PF_Pixel16);
+		case CX_FORMAT_ARGB32F: return sizeof(PF_PixelFloat);
+		default: return 0;
+	}
+}
+
+static PF_PixelFormat PixelFormat(cx_format format) {
+	switch (format) {
+		case CX_FORMAT_ARGB16: return PF_PixelFormat_ARGB64;
+		case CX_FORMAT_ARGB32F: return PF_PixelFormat_ARGB128;
+		default: return PF_PixelFormat_ARGB32;
+	}
+}
+
+// Wraps a caller buffer as a world without copying; extent_hint covers it all
+static cx_status WrapImage(const cx_image *image, PF_EffectWorld *world) {
+	AEFX_CLR_STRUCT(*world);
+	if (!image || !image->data || image->width <= 0 || image->height <= 0) return CX_STATUS_INVALID_ARGUMENT;
+	A_long pixelBytes = PixelBytes(image->format);
+	if (!pixelBytes) return CX_STATUS_INVALID_ARGUMENT;
+	if (image->stride < (ptrdiff_t)image->width * pixelBytes || image->stride > 0x7FFFFFFF) return CX_STATUS_INVALID_ARGUMENT;
+
+	world->data = image->data;
+	world->width = image->width;
+	world->height = image->height;
+	world->rowbytes = (A_long)image->stride;
+	world->extent_hint.right = image->width;
+	world->extent_hint.bottom = image->height;
+	return CX_STATUS_OK;
+}
+
+static bool SameShape(const cx_image *a, const cx_image *b) {
+	return a->width == b->width && a->height == b->height && a->format == b->format;
+}
+
+static bool Overlaps(const cx_image *a, const cx_image *b) {
+	const char *aStart = (const char*)a->data, *bStart = (const char*)b->data;
+	const char *aEnd = aStart + (ptrdiff_t)(a->height - 1) * a->stride + (ptrdiff_t)a->width * PixelBytes(a->format);
+	const char *bEnd = bStart + (ptrdiff_t)(b->height - 1) * b->stride + (ptrdiff_t)b->width * PixelBytes(b->format);
+	return aStart < bEnd && bStart < aEnd;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+extern "C" {
+
+CX_API int cx_api_version(void) {
+	return CX_KERNELS_API_VERSION;
+}
+
+CX_API const char* cx_status_string(cx_status status) {
+	switch (status) {
+		case CX_STATUS_OK: return "ok";
+		case CX_STATUS_INVALID_ARGUMENT: return "invalid argument";
+		case CX_STATUS_UNKNOWN_PARAM: return "unknown parameter";
+		case CX_STATUS_OUT_OF_RANGE: return "value out of range";
+		case CX_STATUS_FORMAT_MISMATCH: return "image size or format mismatch";
+		case CX_STATUS_OUT_OF_MEMORY: return "out of memory";
+		case CX_STATUS_FAILED: return "render failed";
+		default: return "unknown status";
+	}
+}
+
+CX_API cx_status cx_context_create(cx_kernel kernel, int threads, cx_context **context) {
+	if (!context) return CX_STATUS_INVALID_ARGUMENT;
+	*context = NULL;
+	const CX_KernelOps *ops = KernelOps(kernel);
+	if (!ops) return CX_STATUS_INVALID_ARGUMENT;
+
+	cx_context *ctx = NULL;
+	try {
+		ctx = new cx_context(ops, threads);
+	} catch (const std::bad_alloc&) {
+		return CX_STATUS_OUT_OF_MEMORY;
+	} catch (const std::system_error&) {
+		return CX_STATUS_FAILED;
+	}
+
+	ctx->info = malloc(ops->infoSize);
+	if (!ctx->info) {
+		delete ctx;
+		return CX_STATUS_OUT_OF_MEMORY;
+	}
+	ops->initInfo(ctx->info);
+	*context = ctx;
+	return CX_STATUS_OK;
+}
+
+CX_API void cx_context_destroy(cx_context *context) {
+	delete context;
+}
+
+CX_API cx_status cx_set_float(cx_context *context, const char *name, double value) {
+	if (!context || !name) return CX_STATUS_INVALID_ARGUMENT;
+	std::lock_guard<std::mutex> guard(context->lock);
+	return context->ops->setValue(context->info, name, value);
+}
+
+CX_API cx_status cx_set_int(cx_context *context, const char *name, int value) {
+	return cx_set_float(context, name, (double)value);
+}
+
+CX_API cx_status cx_set_color(cx_context *context, const char *name, double red, double green, double blue) {
+	if (!context || !name) return CX_STATUS_INVALID_ARGUMENT;
+	if (CX_CheckRange(red, 0, 1) || CX_CheckRange(green, 0, 1) || CX_CheckRange(blue, 0, 1)) return CX_STATUS_OUT_OF_RANGE;
+
+	// Colour params are 8-bit in AE; round like the OpenFX adapter
+	PF_Pixel color;
+	color.alpha = PF_MAX_CHAN8;
+	color.red = CX_ClampByte(red * 255.0 + 0.5);
+	color.green = CX_ClampByte(green * 255.0 + 0.5);
+	color.blue = CX_ClampByte(blue * 255.0 + 0.5);
+
+	std::lock_guard<std::mutex> guard(context->lock);
+	return context->ops->setColor(context->info, name, color);
+}
+
+CX_API void cx_reset_params(cx_context *context) {
+	if (!context) return;
+	std::lock_guard<std::mutex> guard(context->lock);
+	context->ops->initInfo(context->info);
+}
+
+CX_API cx_status cx_process(cx_context *context, const cx_image *src, const cx_image *prev,
+							const cx_image *next, cx_image *dst) {
+	if (!context) return CX_STATUS_INVALID_ARGUMENT;
+
+	PF_EffectWorld srcWorld, prevWorld, nextWorld, dstWorld;
+	cx_status status = WrapImage(src, &srcWorld);
+	if (!status) status = WrapImage(dst, &dstWorld);
+	if (!status && !SameShape(src, dst)) status = CX_STATUS_FORMAT_MISMATCH;
+	if (!status && Overlaps(src, dst)) status = CX_STATUS_INVALID_ARGUMENT;
+
+	// Adjacent frames that do not match the current one are ignored, as in the
+	// plugins; the render reads the ones it uses while writing dst
+	PF_EffectWorld *prevP = NULL, *nextP = NULL;
+	if (!status && prev && SameShape(prev, src) && !WrapImage(prev, &prevWorld)) prevP = &prevWorld;
+	if (!status && next && SameShape(next, src) && !WrapImage(next, &nextWorld)) nextP = &nextWorld;
+	if (!status && ((prevP && Overlaps(prev, dst)) || (nextP && Overlaps(next, dst)))) status = CX_STATUS_INVALID_ARGUMENT;
+	if (status) return status;
+
+	std::lock_guard<std::mutex> guard(context->lock);
+	const auto start = std::chrono::steady_clock::now();
+
+	CX_Host host = context->pool.Host();
+	status = StatusFromErr(context->ops->render(&host, context->info, PixelFormat(src->format),
+												&srcWorld, prevP, nextP, &dstWorld));
+
+	if (!status) {
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		cx_stats &stats = context->stats;
+		stats.frames++;
+		stats.pixels += (uint64_t)src->width * (uint64_t)src->height;
+		stats.lastMs = ms;
+		stats.totalMs += ms;
+		stats.megapixelsPerSecond = stats.totalMs > 0.0 ? (double)stats.pixels / (stats.totalMs * 1000.0) : 0.0;
+	}
+	return status;
+}
+
+CX_API cx_status cx_get_stats(cx_context *context, cx_stats *stats, size_t statsSize) {
+	if (!context || !stats) return CX_STATUS_INVALID_ARGUMENT;
+	std::lock_guard<std::mutex> guard(context->lock);
+	memcpy(stats, &context->stats, CX_MIN(statsSize, sizeof(cx_stats)));
+	return CX_STATUS_OK;
+}
+
+CX_API void cx_reset_stats(cx_context *context) {
+	if (!context) return;
+	std::lock_guard<std::mutex> guard(context->lock);
+	A_long threads = context->stats.threads;
+	AEFX_CLR_STRUCT(context->stats);
+	context->stats.threads = threads;
+}
+
+} // extern "C"
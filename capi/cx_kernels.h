@@ -0,0 +1,132 @@
+/*
+	cx_kernels.h
+
+	CX Animation Tools - C API of libcx_kernels
+	Runs the cx_ColorLines and cx_PencilLine render cores in-process on
+	caller-owned buffers, for pipeline tools (C/C++, Python ctypes, ...).
+
+	Usage:
+		cx_context *ctx;
+		cx_context_create(CX_KERNEL_COLORLINES, 0, &ctx);
+		cx_set_color(ctx, "targetColor", 0.0, 0.0, 0.0);
+		cx_set_float(ctx, "colorTolerance", 10.0);
+		cx_image src = { pixels, width, height, stride, CX_FORMAT_ARGB8 };
+		cx_image dst = { result, width, height, stride, CX_FORMAT_ARGB8 };
+		cx_process(ctx, &src, NULL, NULL, &dst);
+		cx_context_destroy(ctx);
+
+	Buffers are used in place, never copied, so they must already be in the
+	kernels' layout: ARGB channel order, 8-bit 0-255, 16-bit 0-32768 (After
+	Effects range) or 32-bit float. Rows may be padded (stride in bytes).
+
+	Parameters use the OpenFX scripting names, values as in the plugin UI
+	(popups are 1-based). Every call on one context is serialised, so a
+	context can be shared between threads; separate contexts render in
+	parallel.
+
+	ColorLines also takes draftQuality (0/1, the host's draft render) and,
+	to compare its fast paths with the exact ones, matchBackend (0 auto,
+	1 direct, 2 LUT, 3 bitset) and scalarKernels (0/1).
+
+	The ABI is stable: entry points are only added, cx_image never changes
+	and cx_stats only grows at the end (callers pass its size). Check
+	cx_api_version() against CX_KERNELS_API_VERSION.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#ifndef CX_KERNELS_H
+#define CX_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+	#if defined(CX_KERNELS_BUILD)
+		#define CX_API __declspec(dllexport)
+	#else
+		#define CX_API __declspec(dllimport)
+	#endif
+#elif defined(__GNUC__) || defined(__clang__)
+	#define CX_API __attribute__((visibility("default")))
+#else
+	#define CX_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CX_KERNELS_API_VERSION	2
+
+typedef enum {
+	CX_STATUS_OK = 0,
+	CX_STATUS_INVALID_ARGUMENT,		// NULL pointer, bad size or stride
+	CX_STATUS_UNKNOWN_PARAM,		// No parameter of that name for this kernel
+	CX_STATUS_OUT_OF_RANGE,			// Value outside the parameter range
+	CX_STATUS_FORMAT_MISMATCH,		// Images differ in format or size
+	CX_STATUS_OUT_OF_MEMORY,
+	CX_STATUS_FAILED
+} cx_status;
+
+typedef enum {
+	CX_KERNEL_COLORLINES = 1,		// Line extraction and fill
+	CX_KERNEL_PENCILLINE = 2		// Pencil texture on matched line colours
+} cx_kernel;
+
+typedef enum {
+	CX_FORMAT_ARGB8 = 1,			// 4 x uint8_t, 0-255
+	CX_FORMAT_ARGB16 = 2,			// 4 x uint16_t, 0-32768
+	CX_FORMAT_ARGB32F = 3			// 4 x float, 0.0-1.0
+} cx_format;
+
+typedef struct {
+	void			*data;			// Top-left pixel
+	int32_t			width;
+	int32_t			height;
+	ptrdiff_t		stride;			// Bytes from one row to the next, >= width * pixel size
+	cx_format		format;
+} cx_image;
+
+typedef struct {
+	uint64_t		frames;			// Successful cx_process calls
+	uint64_t		pixels;			// Pixels processed by them
+	double			lastMs;			// Wall time of the last frame
+	double			totalMs;		// Wall time of all frames
+	double			megapixelsPerSecond;	// pixels / totalMs
+	int32_t			threads;		// Worker threads of the context
+} cx_stats;
+
+typedef struct cx_context cx_context;
+
+CX_API int cx_api_version(void);
+CX_API const char* cx_status_string(cx_status status);
+
+// New context with the plugin's default parameters; threads <= 0 uses every
+// hardware thread. The pool is created here and reused by every frame.
+CX_API cx_status cx_context_create(cx_kernel kernel, int threads, cx_context **context);
+CX_API void cx_context_destroy(cx_context *context);
+
+// Numeric, checkbox (0/1) and popup (1-based) parameters
+CX_API cx_status cx_set_float(cx_context *context, const char *name, double value);
+CX_API cx_status cx_set_int(cx_context *context, const char *name, int value);
+// Colour parameters, channels 0.0-1.0
+CX_API cx_status cx_set_color(cx_context *context, const char *name, double red, double green, double blue);
+// Back to the plugin defaults, keeping the pool and stats (API version 2)
+CX_API void cx_reset_params(cx_context *context);
+
+// Processes src into dst (same size and format, must not overlap). prev and
+// next are the adjacent frames for ColorLines Temporal Fill, or NULL; they
+// must not overlap dst either.
+CX_API cx_status cx_process(cx_context *context, const cx_image *src, const cx_image *prev,
+							const cx_image *next, cx_image *dst);
+
+// Fills the first statsSize bytes of stats (pass sizeof(cx_stats))
+CX_API cx_status cx_get_stats(cx_context *context, cx_stats *stats, size_t statsSize);
+CX_API void cx_reset_stats(cx_context *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CX_KERNELS_H
@@ -0,0 +1,385 @@
+/*
+	cx_render.cpp
+
+	CX Animation Tools - command line renderer on libcx_kernels
+
+	Pipe mode streams raw RGBA frames from stdin to stdout, so the effects
+	slot into ffmpeg / oiiotool pipelines without files on disk:
+
+		ffmpeg -i plate.mov -f rawvideo -pix_fmt rgba - |
+			cx_render --kernel colorlines --size 1920x1080 --format rgba8 \
+				--color targetColor=0,0,0 --set colorTolerance=10 --stats |
+			ffmpeg -f rawvideo -pix_fmt rgba -s 1920x1080 -i - out.mov
+
+	Formats are interleaved RGBA: rgba8, rgba16 (native endian, 0-65535) and
+	rgbaf (float). Reading, RGBA <-> ARGB conversion and writing run on their
+	own threads, so frame N renders while N+1 is read and N-1 is written.
+
+	Serve mode (--serve <socket>) runs a long-lived local frame server with
+	warm contexts; frames are exchanged through shared memory (CXServe.h,
+	cx_client.cpp).
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "cx_kernels.h"
+#include "CXServe.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+	#include <fcntl.h>
+	#include <io.h>
+#endif
+
+// ============================================================================
+// Options
+// ============================================================================
+
+typedef struct {
+	cx_kernel					kernel;
+	int							width;
+	int							height;
+	cx_format					format;
+	int							threads;
+	int							stats;
+	const char					*serve;		// Socket path in serve mode
+	std::vector<CX_ServeParam>	params;
+} RenderOptions;
+
+static void Usage() {
+	fprintf(stderr,
+		"usage: cx_render --kernel colorlines|pencilline --size WxH --format rgba8|rgba16|rgbaf\n"
+		"                 [--set name=value]... [--color name=r,g,b]... [--threads N] [--stats]\n"
+		"       cx_render --serve <socket> [--threads N] [--stats]\n"
+		"\n"
+		"Reads raw RGBA frames from stdin and writes the processed frames to stdout,\n"
+		"or serves render jobs on a Unix socket (--stats logs every job).\n"
+		"Parameter names are the OpenFX scripting names (see capi/cx_kernels.h);\n"
+		"popups are 1-based, colours 0.0-1.0.\n");
+}
+
+static bool ParseParam(const char *arg, int isColor, CX_ServeParam *param) {
+	const char *equals = strchr(arg, '=');
+	if (!equals || equals == arg || (size_t)(equals - arg) >= sizeof(param->name)) return false;
+	memset(param, 0, sizeof(CX_ServeParam));
+	memcpy(param->name, arg, equals - arg);
+	param->isColor = isColor;
+	if (isColor) return sscanf(equals + 1, "%lf,%lf,%lf", &param->value[0], &param->value[1], &param->value[2]) == 3;
+	return sscanf(equals + 1, "%lf", &param->value[0]) == 1;
+}
+
+static bool ParseOptions(int argc, char **argv, RenderOptions *options) {
+	options->kernel = (cx_kernel)0;
+	options->width = options->height = 0;
+	options->format = (cx_format)0;
+	options->threads = 0;
+	options->stats = 0;
+	options->serve = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(arg, "--stats") == 0) {
+			options->stats = 1;
+			continue;
+		}
+		if (!value) return false;
+		i++;
+		if (strcmp(arg, "--kernel") == 0) {
+			if (strcmp(value, "colorlines") == 0) options->kernel = CX_KERNEL_COLORLINES;
+			else if (strcmp(value, "pencilline") == 0) options->kernel = CX_KERNEL_PENCILLINE;
+			else return false;
+		} else if (strcmp(arg, "--size") == 0) {
+			if (sscanf(value, "%dx%d", &options->width, &options->height) != 2) return false;
+		} else if (strcmp(arg, "--format") == 0) {
+			if (strcmp(value, "rgba8") == 0) options->format = CX_FORMAT_ARGB8;
+			else if (strcmp(value, "rgba16") == 0) options->format = CX_FORMAT_ARGB16;
+			else if (strcmp(value, "rgbaf") == 0) options->format = CX_FORMAT_ARGB32F;
+			else return false;
+		} else if (strcmp(arg, "--serve") == 0) {
+			options->serve = value;
+		} else if (strcmp(arg, "--threads") == 0) {
+			options->threads = atoi(value);
+		} else if (strcmp(arg, "--set") == 0 || strcmp(arg, "--color") == 0) {
+			CX_ServeParam param;
+			if (!ParseParam(value, arg[2] == 'c', &param)) return false;
+			options->params.push_back(param);
+		} else {
+			return false;
+		}
+	}
+	if (options->serve) return true;
+	return options->kernel && options->format && options->width > 0 && options->height > 0;
+}
+
+static bool IsTemporal(const RenderOptions *options) {
+	if (options->kernel != CX_KERNEL_COLORLINES) return false;
+	bool temporal = false;
+	for (const CX_ServeParam &param : options->params) {
+		if (strcmp(param.name, "temporalFill") == 0) temporal = param.value[0] != 0;
+	}
+	return temporal;
+}
+
+// ============================================================================
+// Pixel Conversion (RGBA stream <-> ARGB kernel layout, in place)
+// ============================================================================
+
+static size_t PixelBytes(cx_format format) {
+	switch (format) {
+		case CX_FORMAT_ARGB16: return 8;
+		case CX_FORMAT_ARGB32F: return 16;
+		default: return 4;
+	}
+}
+
+template <typename T>
+static void RgbaToArgb(T *p, size_t pixels) {
+	for (size_t i = 0; i < pixels; i++, p += 4) {
+		T a = p[3];
+		p[3] = p[2]; p[2] = p[1]; p[1] = p[0]; p[0] = a;
+	}
+}
+
+template <typename T>
+static void ArgbToRgba(T *p, size_t pixels) {
+	for (size_t i = 0; i < pixels; i++, p += 4) {
+		T a = p[0];
+		p[0] = p[1]; p[1] = p[2]; p[2] = p[3]; p[3] = a;
+	}
+}
+
+// 16-bit streams span 0-65535, the kernels 0-32768
+static void Scale16In(uint16_t *p, size_t values) {
+	for (size_t i = 0; i < values; i++) p[i] = (uint16_t)((p[i] * 32768u + 32767u) / 65535u);
+}
+
+static void Scale16Out(uint16_t *p, size_t values) {
+	for (size_t i = 0; i < values; i++) {
+		uint32_t v = p[i] > 32768 ? 32768 : p[i];
+		p[i] = (uint16_t)((v * 65535u + 16384u) / 32768u);
+	}
+}
+
+static void ImportFrame(void *data, size_t pixels, cx_format format) {
+	switch (format) {
+		case CX_FORMAT_ARGB8: RgbaToArgb((uint8_t*)data, pixels); break;
+		case CX_FORMAT_ARGB16: RgbaToArgb((uint16_t*)data, pixels); Scale16In((uint16_t*)data, pixels * 4); break;
+		case CX_FORMAT_ARGB32F: RgbaToArgb((float*)data, pixels); break;
+	}
+}
+
+static void ExportFrame(void *data, size_t pixels, cx_format format) {
+	switch (format) {
+		case CX_FORMAT_ARGB8: ArgbToRgba((uint8_t*)data, pixels); break;
+		case CX_FORMAT_ARGB16: Scale16Out((uint16_t*)data, pixels * 4); ArgbToRgba((uint16_t*)data, pixels); break;
+		case CX_FORMAT_ARGB32F: ArgbToRgba((float*)data, pixels); break;
+	}
+}
+
+// ============================================================================
+// Frame Queues
+// ============================================================================
+
+typedef std::vector<uint8_t> FrameBuffer;
+
+// Blocking FIFO of frame buffers; Pop returns NULL once closed and drained
+struct FrameQueue {
+	std::mutex					lock;
+	std::condition_variable		ready;
+	std::deque<FrameBuffer*>	frames;
+	bool						closed = false;
+
+	void Push(FrameBuffer *frame) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			frames.push_back(frame);
+		}
+		ready.notify_one();
+	}
+
+	FrameBuffer* Pop() {
+		std::unique_lock<std::mutex> guard(lock);
+		ready.wait(guard, [this] { return closed || !frames.empty(); });
+		if (frames.empty()) return NULL;
+		FrameBuffer *frame = frames.front();
+		frames.pop_front();
+		return frame;
+	}
+
+	void Close() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			closed = true;
+		}
+		ready.notify_all();
+	}
+};
+
+// ============================================================================
+// Pipe Mode
+// ============================================================================
+
+// Input buffers: previous, current and next frame for temporal fill plus
+// one being read; output buffers: one rendering plus one being written
+#define PIPE_INPUT_BUFFERS		4
+#define PIPE_OUTPUT_BUFFERS		2
+
+static bool ReadFrame(FILE *stream, FrameBuffer *frame, bool *failed) {
+	size_t got = fread(frame->data(), 1, frame->size(), stream);
+	if (got == frame->size()) return true;
+	if (got != 0) {
+		fprintf(stderr, "cx_render: truncated frame (%zu of %zu bytes)\n", got, frame->size());
+		*failed = true;
+	}
+	return false;
+}
+
+static int RunPipe(const RenderOptions *options, cx_context *context) {
+	const size_t pixels = (size_t)options->width * options->height;
+	const size_t frameBytes = pixels * PixelBytes(options->format);
+	const ptrdiff_t stride = (ptrdiff_t)options->width * PixelBytes(options->format);
+	const bool temporal = IsTemporal(options);
+
+#if defined(_WIN32)
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	std::vector<FrameBuffer> storage(PIPE_INPUT_BUFFERS + PIPE_OUTPUT_BUFFERS, FrameBuffer(frameBytes));
+	FrameQueue freeInput, freeOutput, readFrames, writeFrames;
+	for (int i = 0; i < PIPE_INPUT_BUFFERS; i++) freeInput.Push(&storage[i]);
+	for (int i = 0; i < PIPE_OUTPUT_BUFFERS; i++) freeOutput.Push(&storage[PIPE_INPUT_BUFFERS + i]);
+
+	bool readFailed = false;
+	std::atomic<bool> writeFailed(false);
+	unsigned long long framesWritten = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	std::thread reader([&] {
+		for (;;) {
+			FrameBuffer *frame = freeInput.Pop();
+			if (!frame || !ReadFrame(stdin, frame, &readFailed)) break;
+			ImportFrame(frame->data(), pixels, options->format);
+			readFrames.Push(frame);
+		}
+		readFrames.Close();
+	});
+
+	std::thread writer([&] {
+		for (;;) {
+			FrameBuffer *frame = writeFrames.Pop();
+			if (!frame) break;
+			if (!writeFailed) {
+				ExportFrame(frame->data(), pixels, options->format);
+				if (fwrite(frame->data(), 1, frameBytes, stdout) != frameBytes || fflush(stdout) != 0) {
+					fprintf(stderr, "cx_render: write failed\n");
+					writeFailed = true;
+				} else {
+					framesWritten++;
+				}
+			}
+			freeOutput.Push(frame);
+		}
+	});
+
+	// Input frames still needed: with temporal fill window[current - 1] is
+	// the previous frame, and a frame renders once its next one has arrived
+	cx_status status = CX_STATUS_OK;
+	std::deque<FrameBuffer*> window;
+	size_t current = 0;
+	auto render = [&](FrameBuffer *prev, FrameBuffer *next) {
+		FrameBuffer *output = freeOutput.Pop();
+		cx_image src = { window[current]->data(), options->width, options->height, stride, options->format };
+		cx_image dst = { output->data(), options->width, options->height, stride, options->format };
+		cx_image prevImage = src, nextImage = src;
+		if (prev) prevImage.data = prev->data();
+		if (next) nextImage.data = next->data();
+		status = cx_process(context, &src, prev ? &prevImage : NULL, next ? &nextImage : NULL, &dst);
+		writeFrames.Push(output);
+	};
+
+	while (status == CX_STATUS_OK && !writeFailed) {
+		FrameBuffer *frame = readFrames.Pop();
+		if (!frame) {
+			// End of stream: the last frame renders without a next one
+			if (temporal && window.size() > current) render(current ? window[current - 1] : NULL, NULL);
+			break;
+		}
+		window.push_back(frame);
+
+		if (!temporal) {
+			render(NULL, NULL);
+			freeInput.Push(window.front());
+			window.pop_front();
+		} else if (window.size() > current + 1) {
+			render(current ? window[current - 1] : NULL, window[current + 1]);
+			if (current) {
+				freeInput.Push(window.front());
+				window.pop_front();
+			} else {
+				current = 1;
+			}
+		}
+	}
+
+	// Unblock the reader if rendering stopped early, then drain
+	freeInput.Close();
+	writeFrames.Close();
+	reader.join();
+	writer.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (status != CX_STATUS_OK) fprintf(stderr, "cx_render: %s\n", cx_status_string(status));
+
+	if (options->stats) {
+		cx_stats stats;
+		cx_get_stats(context, &stats, sizeof(stats));
+		const double megapixels = (double)framesWritten * pixels / 1e6;
+		fprintf(stderr, "cx_render: %llu frames, %.2f s, end to end %.1f MPix/s (%.1f fps), "
+						"render only %.1f MPix/s, %d threads\n",
+				framesWritten, seconds, seconds > 0 ? megapixels / seconds : 0.0,
+				seconds > 0 ? framesWritten / seconds : 0.0, stats.megapixelsPerSecond, stats.threads);
+	}
+	return (status != CX_STATUS_OK || readFailed || writeFailed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char **argv) {
+	RenderOptions options;
+	if (!ParseOptions(argc, argv, &options)) {
+		Usage();
+		return EXIT_FAILURE;
+	}
+	if (options.serve) return CX_RunServer(options.serve, options.threads, options.stats != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+	cx_context *context = NULL;
+	cx_status status = cx_context_create(options.kernel, options.threads, &context);
+	for (size_t i = 0; !status && i < options.params.size(); i++) {
+		const CX_ServeParam &param = options.params[i];
+		status = param.isColor ? cx_set_color(context, param.name, param.value[0], param.value[1], param.value[2])
+							   : cx_set_float(context, param.name, param.value[0]);
+		if (status) fprintf(stderr, "cx_render: %s: %s\n", param.name, cx_status_string(status));
+	}
+	if (status) {
+		if (context) cx_context_destroy(context);
+		return EXIT_FAILURE;
+	}
+
+	int result = RunPipe(&options, context);
+	cx_context_destroy(context);
+	return result;
+}
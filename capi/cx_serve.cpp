@@ -0,0 +1,386 @@
+/*
+	cx_serve.cpp
+
+	CX Animation Tools - cx_render frame server (see CXServe.h)
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXServe.h"
+#include <stdio.h>
+
+#if defined(_WIN32)
+
+int CX_RunServer(const char *socketPath, int threads, bool verbose) {
+	(void)socketPath; (void)threads; (void)verbose;
+	fprintf(stderr, "cx_render: --serve needs Unix sockets and POSIX shared memory\n");
+	return 1;
+}
+
+#else
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double MsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// ============================================================================
+// Socket I/O
+// ============================================================================
+
+static bool ReadAll(int fd, void *data, size_t size) {
+	char *p = (char*)data;
+	while (size) {
+		ssize_t got = read(fd, p, size);
+		if (got < 0 && errno == EINTR) continue;
+		if (got <= 0) return false;
+		p += got;
+		size -= (size_t)got;
+	}
+	return true;
+}
+
+static bool WriteAll(int fd, const void *data, size_t size) {
+	const char *p = (const char*)data;
+	while (size) {
+		ssize_t put = send(fd, p, size, MSG_NOSIGNAL);
+		if (put < 0 && errno == EINTR) continue;
+		if (put <= 0) return false;
+		p += put;
+		size -= (size_t)put;
+	}
+	return true;
+}
+
+// ============================================================================
+// Server State
+// ============================================================================
+
+typedef struct ServeJob {
+	CX_ServeRequest				request;
+	std::vector<CX_ServeParam>	params;
+	Clock::time_point			received;
+	CX_ServeReply				reply;
+	bool						done;
+} ServeJob;
+
+struct ServeState {
+	int							threads;
+	bool						verbose;
+	Clock::time_point			started;
+
+	// Job queue, shared by all connections
+	std::mutex					lock;
+	std::condition_variable		queued;
+	std::condition_variable		finished;
+	std::deque<ServeJob*>		queue;
+	bool						stopping = false;
+
+	// Open client sockets; shut down on exit so blocked reads return
+	std::vector<int>			connections;
+	std::condition_variable		disconnected;
+
+	// Warm contexts, created on first use and kept for the server's lifetime;
+	// only the render thread touches them
+	cx_context					*contexts[3] = { NULL, NULL, NULL };
+
+	// Metrics (under lock)
+	uint64_t					jobs = 0;
+	uint64_t					failed = 0;
+	int32_t						maxQueueDepth = 0;
+	double						totalLatencyMs = 0.0;
+	double						maxLatencyMs = 0.0;
+	double						totalQueueMs = 0.0;
+	double						totalRenderMs = 0.0;
+};
+
+static std::atomic<bool> s_stopRequested(false);
+
+static void OnSignal(int) {
+	s_stopRequested = true;
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+static size_t PixelBytes(int32_t format) {
+	switch (format) {
+		case CX_FORMAT_ARGB8: return 4;
+		case CX_FORMAT_ARGB16: return 8;
+		case CX_FORMAT_ARGB32F: return 16;
+		default: return 0;
+	}
+}
+
+// Frame at offset inside a mapping of size bytes, or false when it does not fit
+static bool FrameInSegment(const CX_ServeRequest *request, uint64_t offset, void *base, size_t size, cx_image *image) {
+	const size_t pixelBytes = PixelBytes(request->format);
+	if (!pixelBytes || request->width <= 0 || request->height <= 0) return false;
+	if (request->stride < (int64_t)(request->width * pixelBytes)) return false;
+	const uint64_t span = (uint64_t)(request->height - 1) * (uint64_t)request->stride + (uint64_t)request->width * pixelBytes;
+	if (offset > size || span > size - offset) return false;
+
+	image->data = (char*)base + offset;
+	image->width = request->width;
+	image->height = request->height;
+	image->stride = (ptrdiff_t)request->stride;
+	image->format = (cx_format)request->format;
+	return true;
+}
+
+static cx_status RenderJob(ServeState *state, ServeJob *job) {
+	const CX_ServeRequest *request = &job->request;
+	if (request->kernel != CX_KERNEL_COLORLINES && request->kernel != CX_KERNEL_PENCILLINE) return CX_STATUS_INVALID_ARGUMENT;
+
+	cx_context *&context = state->contexts[request->kernel];
+	cx_status status = CX_STATUS_OK;
+	if (!context) status = cx_context_create((cx_kernel)request->kernel, state->threads, &context);
+	if (status) return status;
+
+	cx_reset_params(context);
+	for (const CX_ServeParam &param : job->params) {
+		status = param.isColor ? cx_set_color(context, param.name, param.value[0], param.value[1], param.value[2])
+							   : cx_set_float(context, param.name, param.value[0]);
+		if (status) return status;
+	}
+
+	char name[sizeof(request->shmName) + 1];
+	memcpy(name, request->shmName, sizeof(request->shmName));
+	name[sizeof(request->shmName)] = 0;
+	int fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0) return CX_STATUS_INVALID_ARGUMENT;
+
+	struct stat info;
+	void *base = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && info.st_size > 0) {
+		base = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (base == MAP_FAILED) return CX_STATUS_INVALID_ARGUMENT;
+
+	const size_t size = (size_t)info.st_size;
+	cx_image src, dst, prev, next;
+	bool hasPrev = false, hasNext = false;
+	if (!FrameInSegment(request, request->srcOffset, base, size, &src) ||
+		!FrameInSegment(request, request->dstOffset, base, size, &dst)) {
+		status = CX_STATUS_INVALID_ARGUMENT;
+	}
+	if (!status && request->prevOffset != CX_SERVE_NO_FRAME) {
+		hasPrev = FrameInSegment(request, request->prevOffset, base, size, &prev);
+		if (!hasPrev) status = CX_STATUS_INVALID_ARGUMENT;
+	}
+	if (!status && request->nextOffset != CX_SERVE_NO_FRAME) {
+		hasNext = FrameInSegment(request, request->nextOffset, base, size, &next);
+		if (!hasNext) status = CX_STATUS_INVALID_ARGUMENT;
+	}
+
+	if (!status) status = cx_process(context, &src, hasPrev ? &prev : NULL, hasNext ? &next : NULL, &dst);
+	munmap(base, size);
+	return status;
+}
+
+static void RenderThread(ServeState *state) {
+	for (;;) {
+		ServeJob *job = NULL;
+		{
+			std::unique_lock<std::mutex> guard(state->lock);
+			state->queued.wait(guard, [state] { return state->stopping || !state->queue.empty(); });
+			if (state->queue.empty()) return;
+			job = state->queue.front();
+			state->queue.pop_front();
+		}
+
+		const Clock::time_point start = Clock::now();
+		job->reply.queueMs = std::chrono::duration<double, std::milli>(start - job->received).count();
+		job->reply.status = RenderJob(state, job);
+		job->reply.renderMs = MsSince(start);
+		job->reply.latencyMs = MsSince(job->received);
+
+		if (state->verbose) {
+			fprintf(stderr, "cx_render: job %dx%d kernel %d: %s, queue %.2f ms, render %.2f ms, depth %d\n",
+					job->request.width, job->request.height, job->request.kernel, cx_status_string((cx_status)job->reply.status),
+					job->reply.queueMs, job->reply.renderMs, job->reply.queueDepth);
+		}
+
+		// The job lives on its connection thread, which may return once done is set
+		{
+			std::lock_guard<std::mutex> guard(state->lock);
+			state->jobs++;
+			if (job->reply.status) state->failed++;
+			state->totalLatencyMs += job->reply.latencyMs;
+			state->maxLatencyMs = std::max(state->maxLatencyMs, job->reply.latencyMs);
+			state->totalQueueMs += job->reply.queueMs;
+			state->totalRenderMs += job->reply.renderMs;
+			job->done = true;
+		}
+		state->finished.notify_all();
+	}
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+static CX_ServeStats Snapshot(ServeState *state) {
+	CX_ServeStats stats;
+	memset(&stats, 0, sizeof(stats));
+	std::lock_guard<std::mutex> guard(state->lock);
+	stats.jobs = state->jobs;
+	stats.failed = state->failed;
+	stats.queueDepth = (int32_t)state->queue.size();
+	stats.maxQueueDepth = state->maxQueueDepth;
+	if (state->jobs) {
+		stats.avgLatencyMs = state->totalLatencyMs / state->jobs;
+		stats.avgQueueMs = state->totalQueueMs / state->jobs;
+		stats.avgRenderMs = state->totalRenderMs / state->jobs;
+	}
+	stats.maxLatencyMs = state->maxLatencyMs;
+	stats.uptimeSeconds = MsSince(state->started) / 1000.0;
+	return stats;
+}
+
+static void ConnectionThread(ServeState *state, int fd) {
+	CX_ServeRequest request;
+	while (ReadAll(fd, &request, sizeof(request))) {
+		if (request.magic != CX_SERVE_MAGIC || request.version != CX_SERVE_VERSION) break;
+
+		if (request.type == CX_SERVE_STATS) {
+			CX_ServeStats stats = Snapshot(state);
+			if (!WriteAll(fd, &stats, sizeof(stats))) break;
+			continue;
+		}
+		if (request.type != CX_SERVE_JOB || request.paramCount > CX_SERVE_MAX_PARAMS) break;
+
+		ServeJob job;
+		job.request = request;
+		job.params.resize(request.paramCount);
+		if (request.paramCount && !ReadAll(fd, job.params.data(), request.paramCount * sizeof(CX_ServeParam))) break;
+		for (CX_ServeParam &param : job.params) param.name[sizeof(param.name) - 1] = 0;
+		memset(&job.reply, 0, sizeof(job.reply));
+		job.received = Clock::now();
+		job.done = false;
+
+		{
+			std::unique_lock<std::mutex> guard(state->lock);
+			if (state->stopping) {
+				job.reply.status = CX_STATUS_FAILED;
+			} else {
+				job.reply.queueDepth = (int32_t)state->queue.size();
+				state->queue.push_back(&job);
+				state->maxQueueDepth = std::max(state->maxQueueDepth, (int32_t)state->queue.size());
+				state->queued.notify_one();
+				state->finished.wait(guard, [&job] { return job.done; });
+			}
+		}
+		if (!WriteAll(fd, &job.reply, sizeof(job.reply))) break;
+	}
+
+	std::lock_guard<std::mutex> guard(state->lock);
+	state->connections.erase(std::find(state->connections.begin(), state->connections.end(), fd));
+	close(fd);
+	state->disconnected.notify_all();
+}
+
+// ============================================================================
+// Server
+// ============================================================================
+
+int CX_RunServer(const char *socketPath, int threads, bool verbose) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "cx_render: socket path too long\n");
+		return 1;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		perror("cx_render: socket");
+		return 1;
+	}
+
+	// A stale socket from a previous run is replaced; other files are not touched
+	struct stat existing;
+	if (lstat(socketPath, &existing) == 0 && S_ISSOCK(existing.st_mode)) unlink(socketPath);
+	if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+		perror("cx_render: bind");
+		close(listener);
+		return 1;
+	}
+	chmod(socketPath, 0600);
+
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	ServeState state;
+	state.threads = threads;
+	state.verbose = verbose;
+	state.started = Clock::now();
+	std::thread renderer(RenderThread, &state);
+	fprintf(stderr, "cx_render: serving on %s\n", socketPath);
+
+	while (!s_stopRequested) {
+		struct pollfd pending = { listener, POLLIN, 0 };
+		if (poll(&pending, 1, 250) <= 0) continue;
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0) continue;
+		{
+			std::lock_guard<std::mutex> guard(state.lock);
+			state.connections.push_back(fd);
+		}
+		std::thread(ConnectionThread, &state, fd).detach();
+	}
+
+	// Queued jobs still finish; then every connection thread has to leave
+	// before the state goes away
+	{
+		std::lock_guard<std::mutex> guard(state.lock);
+		state.stopping = true;
+		for (int fd : state.connections) shutdown(fd, SHUT_RDWR);
+	}
+	state.queued.notify_all();
+	renderer.join();
+	{
+		std::unique_lock<std::mutex> guard(state.lock);
+		state.disconnected.wait(guard, [&state] { return state.connections.empty(); });
+	}
+
+	CX_ServeStats stats = Snapshot(&state);
+	fprintf(stderr, "cx_render: %llu jobs (%llu failed), latency avg %.2f / max %.2f ms, "
+					"queue avg %.2f ms, render avg %.2f ms, max queue depth %d\n",
+			(unsigned long long)stats.jobs, (unsigned long long)stats.failed, stats.avgLatencyMs, stats.maxLatencyMs,
+			stats.avgQueueMs, stats.avgRenderMs, stats.maxQueueDepth);
+
+	close(listener);
+	unlink(socketPath);
+	for (cx_context *context : state.contexts) {
+		if (context) cx_context_destroy(context);
+	}
+	return 0;
+}
+
+#endif
@@ -0,0 +1,235 @@
+/*
+	cx_train.cpp
+
+	CX Animation Tools - training workload for profile-guided builds
+
+		cx_train [--size WxH] [--reps N] [--threads N]
+
+	Renders synthetic line-art shots through libcx_kernels with every
+	ColorLines Fill Mode at Search Radius 3 / 10 / 25 / 50, the draft fill,
+	Sample Blur and adjustments, each Output Mode, Distance Output,
+	Temporal Fill, several target colors and a Color Tolerance dial, and
+	PencilLine with one and several colors and each Output Mode, all at
+	8, 16 and 32 bits. The cases follow capi/tests/CXTestDriver.h.
+
+	Runs through the public C API, so the profile is of the library image
+	itself (MSVC keeps one per image). pgo.ps1 runs it on the instrumented
+	build for training, then with --reps on the plain and optimized builds:
+	the gain is the difference of the totals printed here.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "cx_kernels.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// ============================================================================
+// Cases
+// ============================================================================
+
+// Space separated name=value pairs; #rrggbb values go to cx_set_color.
+// dial: rendered again at other Color Tolerances, as while scrubbing.
+typedef struct {
+	const char	*name;
+	cx_kernel	kernel;
+	const char	*params;
+	bool		temporal;
+	bool		dial;
+} TrainCase;
+
+#define FOUR_COLORS		"useColor2=1 targetColor2=#406080 colorTolerance2=30 " \
+						"useColor3=1 targetColor3=#c0a040 colorTolerance3=25 " \
+						"useColor4=1 targetColor4=#808080 colorTolerance4=20"
+
+static const TrainCase kCases[] = {
+	{ "nearest r=3", CX_KERNEL_COLORLINES, "fillMode=1 searchRadius=3", false, false },
+	{ "nearest r=10", CX_KERNEL_COLORLINES, "fillMode=1 searchRadius=10", false, false },
+	{ "nearest r=25", CX_KERNEL_COLORLINES, "fillMode=1 searchRadius=25", false, false },
+	{ "nearest r=50", CX_KERNEL_COLORLINES, "fillMode=1 searchRadius=50", false, false },
+	{ "average r=3", CX_KERNEL_COLORLINES, "fillMode=2 searchRadius=3", false, false },
+	{ "average r=10", CX_KERNEL_COLORLINES, "fillMode=2 searchRadius=10", false, false },
+	{ "average r=25", CX_KERNEL_COLORLINES, "fillMode=2 searchRadius=25", false, false },
+	{ "weighted r=3", CX_KERNEL_COLORLINES, "fillMode=3 searchRadius=3", false, false },
+	{ "weighted r=10", CX_KERNEL_COLORLINES, "fillMode=3 searchRadius=10", false, false },
+	{ "weighted r=25", CX_KERNEL_COLORLINES, "fillMode=3 searchRadius=25", false, false },
+	{ "weighted draft r=25", CX_KERNEL_COLORLINES, "fillMode=3 searchRadius=25 draftQuality=1", false, false },
+	{ "weighted draft r=50", CX_KERNEL_COLORLINES, "fillMode=3 searchRadius=50 draftQuality=1", false, false },
+	{ "membrane r=3", CX_KERNEL_COLORLINES, "fillMode=4 searchRadius=3", false, false },
+	{ "membrane r=10", CX_KERNEL_COLORLINES, "fillMode=4 searchRadius=10", false, false },
+	{ "membrane r=50", CX_KERNEL_COLORLINES, "fillMode=4 searchRadius=50", false, false },
+	{ "blur adjust", CX_KERNEL_COLORLINES, "sampleBlur=35 brightness=10 contrast=20 saturation=-30", false, false },
+	{ "line only", CX_KERNEL_COLORLINES, "outputMode=2 ignoreTransparent=0", false, false },
+	{ "background only", CX_KERNEL_COLORLINES, "outputMode=3", false, false },
+	{ "line mask", CX_KERNEL_COLORLINES, "outputMode=4", false, true },
+	{ "distance", CX_KERNEL_COLORLINES, "distanceOutput=2 distanceChannel=2 distanceRange=40", false, false },
+	{ "distance source", CX_KERNEL_COLORLINES, "distanceOutput=3 distanceRange=10", false, false },
+	{ "temporal", CX_KERNEL_COLORLINES, "temporalFill=1 fillMode=2", true, true },
+	{ "four colors", CX_KERNEL_COLORLINES, "fillMode=2 " FOUR_COLORS, false, true },
+	{ "pencil", CX_KERNEL_PENCILLINE, "tolerance1=10 texture1=1 lineWidth1=3", false, false },
+	{ "pencil two colors", CX_KERNEL_PENCILLINE, "color2=1 color2Value=#406080 tolerance2=30 recolor2=1 recolor2Value=#c04020 lineWidth2=4 textureStrength=80", false, false },
+	{ "pencil line only", CX_KERNEL_PENCILLINE, "outputMode=2 lineDensity=20", false, false },
+	{ "pencil background only", CX_KERNEL_PENCILLINE, "outputMode=3", false, false }
+};
+
+#define TRAIN_CASE_COUNT	((int)(sizeof(kCases) / sizeof(kCases[0])))
+
+// Color Tolerances of a dial, after the case's own
+static const double kDial[] = { 14.0, 22.0, 30.0 };
+
+static bool ApplyParams(cx_context *context, const TrainCase *trainCase) {
+	char params[512];
+	strncpy(params, trainCase->params, sizeof(params) - 1);
+	params[sizeof(params) - 1] = '\0';
+	for (char *token = strtok(params, " "); token; token = strtok(NULL, " ")) {
+		char *value = strchr(token, '=');
+		if (!value) return false;
+		*value++ = '\0';
+
+		cx_status status;
+		if (*value == '#') {
+			unsigned rgb = (unsigned)strtoul(value + 1, NULL, 16);
+			status = cx_set_color(context, token, (rgb >> 16) / 255.0, ((rgb >> 8) & 0xFF) / 255.0, (rgb & 0xFF) / 255.0);
+		} else {
+			status = cx_set_float(context, token, atof(value));
+		}
+		if (status != CX_STATUS_OK) {
+			fprintf(stderr, "cx_train: %s: %s=%s: %s\n", trainCase->name, token, value, cx_status_string(status));
+			return false;
+		}
+	}
+	return true;
+}
+
+// ============================================================================
+// Frames
+// ============================================================================
+
+typedef struct {
+	cx_format	format;
+	const char	*name;
+	size_t		pixelSize;
+} TrainFormat;
+
+static const TrainFormat kFormats[] = {
+	{ CX_FORMAT_ARGB8, "8-bit", 4 },
+	{ CX_FORMAT_ARGB16, "16-bit", 8 },
+	{ CX_FORMAT_ARGB32F, "32-bit", 16 }
+};
+
+static void SetChannel(void *pixel, cx_format format, int c, int v) {
+	switch (format) {
+		case CX_FORMAT_ARGB8: ((uint8_t*)pixel)[c] = (uint8_t)v; break;
+		case CX_FORMAT_ARGB16: ((uint16_t*)pixel)[c] = (uint16_t)((v * 32768 + 127) / 255); break;
+		case CX_FORMAT_ARGB32F: ((float*)pixel)[c] = v / 255.0f; break;
+	}
+}
+
+// Noise crossed by black diagonal lines with a few semi-transparent and
+// near-black pixels, as CX_TestDrawFrame; phase moves the lines
+static void DrawFrame(std::vector<uint8_t> *pixels, const TrainFormat *format, int width, int height,
+					  int phase, unsigned seed) {
+	pixels->resize((size_t)width * height * format->pixelSize);
+	uint8_t *p = pixels->data();
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++, p += format->pixelSize) {
+			int u = x + phase;
+			bool line = (u * 3 + y * 2) % 37 < 3 || (u - y + 4096) % 53 < 2;
+			seed = seed * 1664525u + 1013904223u;
+			int ink = (seed >> 12) % 11 == 0 ? 6 : 0;
+			SetChannel(p, format->format, 0, line ? 255 : ((seed >> 4) % 97 == 0 ? 128 : 255));
+			SetChannel(p, format->format, 1, line ? ink : 64 + (int)((seed >> 24) % 192));
+			SetChannel(p, format->format, 2, line ? ink : 64 + (int)((seed >> 16) % 192));
+			SetChannel(p, format->format, 3, line ? ink : 64 + (int)((seed >> 8) % 192));
+		}
+	}
+}
+
+static cx_image MakeImage(std::vector<uint8_t> *pixels, const TrainFormat *format, int width, int height) {
+	cx_image image = { pixels->data(), width, height, (ptrdiff_t)(width * format->pixelSize), format->format };
+	return image;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+// Every case once at one depth, on a shot of its own (nothing cached from
+// another pass); *msP is the render time. False on the first failed render.
+static bool RunFormat(const TrainFormat *format, int width, int height, int threads, unsigned seed, double *msP) {
+	std::vector<uint8_t> prevPixels, srcPixels, nextPixels, dstPixels;
+	DrawFrame(&prevPixels, format, width, height, -2, seed * 3 + 11);
+	DrawFrame(&srcPixels, format, width, height, 0, seed * 3 + 12);
+	DrawFrame(&nextPixels, format, width, height, 2, seed * 3 + 13);
+	dstPixels.resize(srcPixels.size());
+	cx_image prev = MakeImage(&prevPixels, format, width, height);
+	cx_image src = MakeImage(&srcPixels, format, width, height);
+	cx_image next = MakeImage(&nextPixels, format, width, height);
+	cx_image dst = MakeImage(&dstPixels, format, width, height);
+
+	cx_context *contexts[3] = { NULL, NULL, NULL };
+	bool ok = true;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < TRAIN_CASE_COUNT && ok; i++) {
+		const TrainCase *trainCase = &kCases[i];
+		cx_context **context = &contexts[trainCase->kernel];
+		if (!*context) ok = cx_context_create(trainCase->kernel, threads, context) == CX_STATUS_OK;
+		if (!ok) break;
+		cx_reset_params(*context);
+		ok = ApplyParams(*context, trainCase);
+
+		const cx_image *prevP = trainCase->temporal ? &prev : NULL;
+		const cx_image *nextP = trainCase->temporal ? &next : NULL;
+		cx_status status = CX_STATUS_OK;
+		if (ok) status = cx_process(*context, &src, prevP, nextP, &dst);
+		for (int d = 0; ok && trainCase->dial && !status && d < (int)(sizeof(kDial) / sizeof(kDial[0])); d++) {
+			status = cx_set_float(*context, "colorTolerance", kDial[d]);
+			if (!status) status = cx_process(*context, &src, prevP, nextP, &dst);
+		}
+		if (status) {
+			fprintf(stderr, "cx_train: %s %s: %s\n", trainCase->name, format->name, cx_status_string(status));
+			ok = false;
+		}
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	*msP = elapsed.count();
+	for (cx_context *context : contexts) {
+		if (context) cx_context_destroy(context);
+	}
+	return ok;
+}
+
+int main(int argc, char **argv) {
+	int width = 960, height = 540, reps = 1, threads = 0;
+	for (int i = 1; i < argc; i++) {
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		bool parsed = value != NULL;
+		if (parsed && strcmp(argv[i], "--size") == 0) parsed = sscanf(value, "%dx%d", &width, &height) == 2;
+		else if (parsed && strcmp(argv[i], "--reps") == 0) reps = atoi(value);
+		else if (parsed && strcmp(argv[i], "--threads") == 0) threads = atoi(value);
+		else parsed = false;
+		if (!parsed || width <= 0 || height <= 0 || reps <= 0) {
+			fprintf(stderr, "usage: cx_train [--size WxH] [--reps N] [--threads N]\n");
+			return EXIT_FAILURE;
+		}
+		i++;
+	}
+
+	// Best of reps per depth, so one slow pass does not skew the comparison
+	double total = 0;
+	for (const TrainFormat& format : kFormats) {
+		double best = 0;
+		for (int rep = 0; rep < reps; rep++) {
+			double ms = 0;
+			if (!RunFormat(&format, width, height, threads, (unsigned)rep, &ms)) return EXIT_FAILURE;
+			if (rep == 0 || ms < best) best = ms;
+		}
+		printf("cx_train %-7s %10.1f ms\n", format.name, best);
+		total += best;
+	}
+	printf("cx_train total   %10.1f ms (%d cases, %dx%d)\n", total, TRAIN_CASE_COUNT, width, height);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+/*
+	CXTestCheck.h
+
+	CX Animation Tools - test checks
+	CX_CHECK counts and reports a failed condition and carries on, so one
+	run lists every failure; CX_TestResult turns the count into the exit
+	status ctest reads.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_TEST_CHECK_H
+#define CX_TEST_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+static int g_cxTestFailures = 0;
+
+#define CX_CHECK(COND, ...) \
+	do { \
+		if (!(COND)) { \
+			g_cxTestFailures++; \
+			fprintf(stderr, "%s:%d: check failed: ", __FILE__, __LINE__); \
+			fprintf(stderr, __VA_ARGS__); \
+			fputc('\n', stderr); \
+		} \
+	} while (0)
+
+// Process exit status; prints a one-line summary
+static inline int CX_TestResult(const char *program) {
+	if (g_cxTestFailures) {
+		fprintf(stderr, "%s: %d check(s) failed\n", program, g_cxTestFailures);
+		return EXIT_FAILURE;
+	}
+	printf("%s: all checks passed\n", program);
+	return EXIT_SUCCESS;
+}
+
+#endif // CX_TEST_CHECK_H
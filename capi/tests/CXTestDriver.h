@@ -0,0 +1,237 @@
+/*
+	CXTestDriver.h
+
+	CX Animation Tools - kernel test driver
+	Runs the ColorLines and PencilLine kernels through their CX_KernelOps
+	tables on stub hosts, outside AE and OpenFX: synthetic line-art frames
+	at every bit depth, parameter cases, render and hash helpers. Shared by
+	the ctest programs in this directory.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_TEST_DRIVER_H
+#define CX_TEST_DRIVER_H
+
+#include "CXKernelOps.h"
+#include "CXFrameCache.h"
+#include "CXTestCheck.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// ============================================================================
+// Stub Hosts
+// ============================================================================
+
+// One job after the other on thread 0, as a host without threads would
+static inline CX_Host CX_TestSerialHost() {
+	CX_Host host = { NULL, CX_SerialIterate };
+	return host;
+}
+
+// Jobs last to first, each under its own thread index: a job that depends on
+// another having run first, or on thread 0, gives a different image
+static inline PF_Err CX_TestReverseIterate(void *context, A_long count, void *refcon, CX_IterateFunc fn) {
+	PF_Err err = PF_Err_NONE;
+	for (A_long i = count - 1; i >= 0; i--) {
+		PF_Err jobErr = fn(refcon, count - 1 - i, i, count);
+		if (!err) err = jobErr;
+	}
+	return err;
+}
+
+static inline CX_Host CX_TestReverseHost() {
+	CX_Host host = { NULL, CX_TestReverseIterate };
+	return host;
+}
+
+// ============================================================================
+// Frames
+// ============================================================================
+
+typedef struct {
+	PF_PixelFormat	format;
+	const char		*name;
+	size_t			pixelSize;
+} CX_TestFormat;
+
+static const CX_TestFormat g_cxTestFormats[] = {
+	{ PF_PixelFormat_ARGB32, "8-bit", sizeof(PF_Pixel8) },
+	{ PF_PixelFormat_ARGB64, "16-bit", sizeof(PF_Pixel16) },
+	{ PF_PixelFormat_ARGB128, "32-bit", sizeof(PF_PixelFloat) }
+};
+
+#define CX_TEST_FORMAT_COUNT	((A_long)(sizeof(g_cxTestFormats) / sizeof(g_cxTestFormats[0])))
+
+// A world over its own buffer; rows carry padding so rowbytes is honoured
+struct CX_TestFrame {
+	PF_EffectWorld			world;
+	PF_PixelFormat			format;
+	std::vector<A_u_char>	storage;
+
+	CX_TestFrame(PF_PixelFormat pixelFormat, size_t pixelSize, A_long width, A_long height) : format(pixelFormat) {
+		AEFX_CLR_STRUCT(world);
+		world.width = width;
+		world.height = height;
+		world.rowbytes = (A_long)(width * pixelSize + 48);
+		world.extent_hint.right = width;
+		world.extent_hint.bottom = height;
+		storage.assign((size_t)world.rowbytes * height, 0xCD);
+		world.data = storage.data();
+	}
+};
+
+// 8-bit channel value v at PixelT's depth (integer FromUnit truncates, hence the half step)
+template <typename PixelT>
+static inline typename CX_PixelTraits<PixelT>::ChannelType CX_TestChannel(A_long v) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	return Traits::FromUnit((v + (Traits::kIsFloat ? 0.0 : 0.5)) / 255.0);
+}
+
+template <typename PixelT>
+static inline void CX_TestSetPixel(PixelT *pixel, A_long a, A_long r, A_long g, A_long b) {
+	pixel->alpha = CX_TestChannel<PixelT>(a);
+	pixel->red = CX_TestChannel<PixelT>(r);
+	pixel->green = CX_TestChannel<PixelT>(g);
+	pixel->blue = CX_TestChannel<PixelT>(b);
+}
+
+// Noise crossed by black diagonal lines, with a few semi-transparent and
+// near-black pixels; phase moves the lines (adjacent frames of a shot),
+// weight thickens them (1: about 12% of the pixels are line)
+template <typename PixelT>
+static void CX_TestDrawFrame(PF_EffectWorld *world, A_long phase, unsigned seed, A_long weight) {
+	for (A_long y = 0; y < world->height; y++) {
+		PixelT *row = CX_GetRow<PixelT>(world, y);
+		for (A_long x = 0; x < world->width; x++) {
+			A_long u = x + phase;
+			bool line = (u * 3 + y * 2) % 37 < 3 * weight || (u - y + 4096) % 53 < 2 * weight;
+			seed = seed * 1664525u + 1013904223u;
+			A_long alpha = (seed >> 4) % 97 == 0 ? 128 : 255;
+			if (line) {
+				A_long ink = (seed >> 12) % 11 == 0 ? 6 : 0;	// Within the default tolerance
+				CX_TestSetPixel(row + x, 255, ink, ink, ink);
+			} else {
+				CX_TestSetPixel(row + x, alpha, 64 + (seed >> 24) % 192, 64 + (seed >> 16) % 192, 64 + (seed >> 8) % 192);
+			}
+		}
+	}
+}
+
+static inline void CX_TestDraw(CX_TestFrame *frame, A_long phase, unsigned seed, A_long weight = 1) {
+	switch (frame->format) {
+		case PF_PixelFormat_ARGB32: CX_TestDrawFrame<PF_Pixel8>(&frame->world, phase, seed, weight); break;
+		case PF_PixelFormat_ARGB64: CX_TestDrawFrame<PF_Pixel16>(&frame->world, phase, seed, weight); break;
+		case PF_PixelFormat_ARGB128: CX_TestDrawFrame<PF_PixelFloat>(&frame->world, phase, seed, weight); break;
+	}
+}
+
+// Content hash of the pixels (row padding excluded)
+static inline A_u_longlong CX_TestHash(const CX_TestFrame *frame) {
+	switch (frame->format) {
+		case PF_PixelFormat_ARGB32: return CX_HashWorld<PF_Pixel8>(&frame->world, 0);
+		case PF_PixelFormat_ARGB64: return CX_HashWorld<PF_Pixel16>(&frame->world, 0);
+		case PF_PixelFormat_ARGB128: return CX_HashWorld<PF_PixelFloat>(&frame->world, 0);
+	}
+	return 0;
+}
+
+// Bytes of the pixels that differ between two frames of one shape
+static inline size_t CX_TestDiffBytes(const CX_TestFrame *a, const CX_TestFrame *b, size_t pixelSize) {
+	size_t diff = 0;
+	size_t rowSize = (size_t)a->world.width * pixelSize;
+	for (A_long y = 0; y < a->world.height; y++) {
+		const A_u_char *rowA = a->storage.data() + (size_t)y * a->world.rowbytes;
+		const A_u_char *rowB = b->storage.data() + (size_t)y * b->world.rowbytes;
+		for (size_t i = 0; i < rowSize; i++) diff += rowA[i] != rowB[i];
+	}
+	return diff;
+}
+
+// ============================================================================
+// Cases
+// ============================================================================
+
+// One kernel setup: space separated name=value pairs; #rrggbb values go to
+// setColor. temporal cases render with the adjacent frames.
+typedef struct {
+	const char			*name;
+	const CX_KernelOps	*ops;
+	const char			*params;
+	bool				temporal;
+} CX_TestCase;
+
+static const CX_TestCase g_cxTestCases[] = {
+	{ "ColorLines nearest", &g_cxColorLinesOps, "fillMode=1 searchRadius=6", false },
+	{ "ColorLines average", &g_cxColorLinesOps, "fillMode=2 searchRadius=4", false },
+	{ "ColorLines weighted", &g_cxColorLinesOps, "fillMode=3 searchRadius=9", false },
+	{ "ColorLines weighted draft", &g_cxColorLinesOps, "fillMode=3 searchRadius=24 draftQuality=1", false },
+	{ "ColorLines membrane", &g_cxColorLinesOps, "fillMode=4 searchRadius=5", false },
+	{ "ColorLines two colors", &g_cxColorLinesOps, "useColor2=1 targetColor2=#406080 colorTolerance2=30 fillMode=2", false },
+	{ "ColorLines blur adjust", &g_cxColorLinesOps, "sampleBlur=35 brightness=10 contrast=20 saturation=-30", false },
+	{ "ColorLines line only", &g_cxColorLinesOps, "outputMode=2 ignoreTransparent=0", false },
+	{ "ColorLines background only", &g_cxColorLinesOps, "outputMode=3", false },
+	{ "ColorLines line mask", &g_cxColorLinesOps, "outputMode=4", false },
+	{ "ColorLines distance", &g_cxColorLinesOps, "distanceOutput=2 distanceChannel=2 distanceRange=40", false },
+	{ "ColorLines temporal", &g_cxColorLinesOps, "temporalFill=1 fillMode=2", true },
+	{ "PencilLine full", &g_cxPencilLineOps, "tolerance1=10 texture1=1 lineWidth1=3", false },
+	{ "PencilLine two colors", &g_cxPencilLineOps, "color2=1 color2Value=#406080 tolerance2=30 recolor2=1 recolor2Value=#c04020 lineWidth2=4 textureStrength=80", false },
+	{ "PencilLine line only", &g_cxPencilLineOps, "outputMode=2 lineDensity=20", false },
+	{ "PencilLine background only", &g_cxPencilLineOps, "outputMode=3", false }
+};
+
+#define CX_TEST_CASE_COUNT	((A_long)(sizeof(g_cxTestCases) / sizeof(g_cxTestCases[0])))
+
+// Kernel defaults with the case's parameters applied; every name must be known
+static inline std::vector<A_u_char> CX_TestMakeInfo(const CX_TestCase *testCase) {
+	std::vector<A_u_char> info(testCase->ops->infoSize);
+	testCase->ops->initInfo(info.data());
+
+	char params[512];
+	strncpy(params, testCase->params, sizeof(params) - 1);
+	params[sizeof(params) - 1] = '\0';
+	for (char *token = strtok(params, " "); token; token = strtok(NULL, " ")) {
+		char *value = strchr(token, '=');
+		CX_CHECK(value != NULL, "%s: malformed parameter '%s'", testCase->name, token);
+		if (!value) continue;
+		*value++ = '\0';
+
+		cx_status status;
+		if (*value == '#') {
+			unsigned rgb = (unsigned)strtoul(value + 1, NULL, 16);
+			PF_Pixel color = { PF_MAX_CHAN8, (A_u_char)(rgb >> 16), (A_u_char)(rgb >> 8), (A_u_char)rgb };
+			status = testCase->ops->setColor(info.data(), token, color);
+		} else {
+			status = testCase->ops->setValue(info.data(), token, atof(value));
+		}
+		CX_CHECK(status == CX_STATUS_OK, "%s: parameter %s=%s rejected (%d)", testCase->name, token, value, (int)status);
+	}
+	return info;
+}
+
+// Renders src into dst with the case on host; prev / next only for temporal cases
+static inline PF_Err CX_TestRender(const CX_TestCase *testCase, const std::vector<A_u_char>& info, const CX_Host *host,
+								   CX_TestFrame *src, CX_TestFrame *prev, CX_TestFrame *next, CX_TestFrame *dst) {
+	return testCase->ops->render(host, info.data(), src->format, &src->world,
+								 testCase->temporal ? &prev->world : NULL,
+								 testCase->temporal ? &next->world : NULL, &dst->world);
+}
+
+// The source frame of a shot and its neighbours at one depth; shots with
+// another seed have other content (no cached masks or planes to reuse)
+struct CX_TestShot {
+	CX_TestFrame prev, src, next;
+
+	CX_TestShot(const CX_TestFormat *format, A_long width, A_long height, unsigned seed = 0, A_long weight = 1) :
+		prev(format->format, format->pixelSize, width, height),
+		src(format->format, format->pixelSize, width, height),
+		next(format->format, format->pixelSize, width, height) {
+		CX_TestDraw(&prev, -2, seed * 3 + 11, weight);
+		CX_TestDraw(&src, 0, seed * 3 + 12, weight);
+		CX_TestDraw(&next, 2, seed * 3 + 13, weight);
+	}
+};
+
+#endif // CX_TEST_DRIVER_H
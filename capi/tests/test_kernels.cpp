@@ -0,0 +1,101 @@
+/*
+	test_kernels.cpp
+
+	CX Animation Tools - kernel render test
+	Every case of CXTestDriver.h at 8, 16 and 32 bits on the stub hosts:
+	the render succeeds and changes the frame, jobs run in reverse order
+	give the same image, a render after a Color Tolerance change and back
+	(ColorLines' cached distance planes) gives the same image, rendering in
+	four extent_hint tiles gives the same image, and row padding is never
+	written.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXTestDriver.h"
+#include "ColorLinesKernels.h"
+
+#define TEST_WIDTH	160
+#define TEST_HEIGHT	120
+
+// Row padding still holds the fill CX_TestFrame started with
+static bool PaddingUntouched(const CX_TestFrame *frame, size_t pixelSize) {
+	size_t rowSize = (size_t)frame->world.width * pixelSize;
+	for (A_long y = 0; y < frame->world.height; y++) {
+		const A_u_char *row = frame->storage.data() + (size_t)y * frame->world.rowbytes;
+		for (size_t i = rowSize; i < (size_t)frame->world.rowbytes; i++) {
+			if (row[i] != 0xCD) return false;
+		}
+	}
+	return true;
+}
+
+static void TestCase(const CX_TestCase *testCase, const CX_TestFormat *format) {
+	CX_TestShot shot(format, TEST_WIDTH, TEST_HEIGHT);
+	std::vector<A_u_char> info = CX_TestMakeInfo(testCase);
+	CX_Host serial = CX_TestSerialHost();
+	CX_Host reverse = CX_TestReverseHost();
+
+	CX_TestFrame full(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	PF_Err err = CX_TestRender(testCase, info, &serial, &shot.src, &shot.prev, &shot.next, &full);
+	CX_CHECK(!err, "%s %s: render failed (%d)", testCase->name, format->name, (int)err);
+	if (err) return;
+	CX_CHECK(CX_TestHash(&full) != CX_TestHash(&shot.src), "%s %s: output equals input", testCase->name, format->name);
+	CX_CHECK(PaddingUntouched(&full, format->pixelSize), "%s %s: row padding written", testCase->name, format->name);
+
+	CX_TestFrame reversed(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	err = CX_TestRender(testCase, info, &reverse, &shot.src, &shot.prev, &shot.next, &reversed);
+	CX_CHECK(!err && CX_TestDiffBytes(&full, &reversed, format->pixelSize) == 0,
+			 "%s %s: reverse job order differs (%zu bytes)", testCase->name, format->name,
+			 CX_TestDiffBytes(&full, &reversed, format->pixelSize));
+
+	// Dialling the tolerance away and back: the reverse render above matched
+	// pixels (same thresholds as the one before it), this one thresholds the
+	// frame's distance planes
+	CX_TestFrame again(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	if (testCase->ops == &g_cxColorLinesOps) {
+		std::vector<A_u_char> scrubbed = info;
+		testCase->ops->setValue(scrubbed.data(), "colorTolerance", 45.0);
+		err = CX_TestRender(testCase, scrubbed, &serial, &shot.src, &shot.prev, &shot.next, &again);
+	}
+	if (!err) err = CX_TestRender(testCase, info, &serial, &shot.src, &shot.prev, &shot.next, &again);
+	CX_CHECK(!err && CX_TestDiffBytes(&full, &again, format->pixelSize) == 0,
+			 "%s %s: render after a tolerance change differs (%zu bytes)", testCase->name, format->name,
+			 CX_TestDiffBytes(&full, &again, format->pixelSize));
+
+	// Quadrants of uneven size, as a host rendering in tiles would request.
+	// Like the front-ends, each tile renders with its extent grown by the
+	// widest Sample Blur radius and only the tile itself is kept.
+	CX_TestFrame tiled(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	const A_long splitX = TEST_WIDTH / 2 - 7, splitY = TEST_HEIGHT / 2 + 5;
+	const A_long margin = (A_long)(SAMPLE_BLUR_MAX / 10.0);
+	const PF_LRect tiles[4] = {
+		{ 0, 0, splitX, splitY }, { splitX, 0, TEST_WIDTH, splitY },
+		{ 0, splitY, splitX, TEST_HEIGHT }, { splitX, splitY, TEST_WIDTH, TEST_HEIGHT }
+	};
+	for (A_long t = 0; t < 4 && !err; t++) {
+		CX_TestFrame tile(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+		tile.world.extent_hint.left = CX_MAX(tiles[t].left - margin, 0);
+		tile.world.extent_hint.top = CX_MAX(tiles[t].top - margin, 0);
+		tile.world.extent_hint.right = CX_MIN(tiles[t].right + margin, TEST_WIDTH);
+		tile.world.extent_hint.bottom = CX_MIN(tiles[t].bottom + margin, TEST_HEIGHT);
+		err = CX_TestRender(testCase, info, &serial, &shot.src, &shot.prev, &shot.next, &tile);
+		for (A_long y = tiles[t].top; y < tiles[t].bottom && !err; y++) {
+			size_t offset = (size_t)y * tile.world.rowbytes + tiles[t].left * format->pixelSize;
+			memcpy(tiled.storage.data() + offset, tile.storage.data() + offset,
+				   (tiles[t].right - tiles[t].left) * format->pixelSize);
+		}
+	}
+	CX_CHECK(!err && CX_TestDiffBytes(&full, &tiled, format->pixelSize) == 0,
+			 "%s %s: tiled render differs (%zu bytes)", testCase->name, format->name,
+			 CX_TestDiffBytes(&full, &tiled, format->pixelSize));
+}
+
+int main() {
+	for (A_long f = 0; f < CX_TEST_FORMAT_COUNT; f++) {
+		for (A_long c = 0; c < CX_TEST_CASE_COUNT; c++) {
+			TestCase(&g_cxTestCases[c], &g_cxTestFormats[f]);
+		}
+	}
+	return CX_TestResult("test_kernels");
+}
@@ -0,0 +1,189 @@
+/*
+	test_quality.cpp
+
+	CX Animation Tools - quality and speed of the fast paths
+	Each fast path of the ColorLines kernels against the exact path it
+	stands in for, on the synthetic shots of CXTestDriver.h at 8, 16 and
+	32 bits:
+	- the draft (sum-of-gaussians) Weighted fill against the exact one
+	- LUT and BITSET color matching against DIRECT
+	- distance plane thresholding (tolerance dialled) against matching
+	- the SIMD fill kernels (float FMA sums) against scalar
+	Prints PSNR, max absolute error, % of pixels differing and the speedup
+	as a table. Fails when an exact path differs at all or an approximation
+	falls below its PSNR floor; speed is reported only.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXTestDriver.h"
+#include "CXThreadPool.h"
+#include "CXCpu.h"
+#include <chrono>
+#include <math.h>
+#include <thread>
+
+#define QUALITY_WIDTH	640
+#define QUALITY_HEIGHT	360
+#define QUALITY_REPS	3
+
+// Extra target colors for the matcher rows: line art plus flat color areas
+#define FOUR_COLORS		"useColor2=1 targetColor2=#406080 colorTolerance2=30 " \
+						"useColor3=1 targetColor3=#c0a040 colorTolerance3=25 " \
+						"useColor4=1 targetColor4=#808080 colorTolerance4=20"
+#define EIGHT_COLORS	FOUR_COLORS " " \
+						"useColor5=1 targetColor5=#e0e0e0 colorTolerance5=15 " \
+						"useColor6=1 targetColor6=#60c060 colorTolerance6=35 " \
+						"useColor7=1 targetColor7=#a05050 colorTolerance7=10 " \
+						"useColor8=1 targetColor8=#5050a0 colorTolerance8=40"
+
+// A fast path and its exact reference. minPsnr INFINITY: must be identical.
+// dial: the fast renders follow a Color Tolerance change, as while scrubbing.
+// lineWeight: CX_TestShot weight; the draft fill only engages on heavy lines.
+// temporal: renders with the adjacent frames.
+typedef struct {
+	const char	*name;
+	const char	*exact;
+	const char	*fast;
+	double		minPsnr;
+	bool		dial;
+	A_long		lineWeight;
+	bool		temporal;
+} QualityCase;
+
+static const QualityCase kCases[] = {
+	{ "draft Weighted r=24", "fillMode=3 searchRadius=24", "fillMode=3 searchRadius=24 draftQuality=1", 50.0, false, 3 },
+	{ "draft Weighted r=32", "fillMode=3 searchRadius=32", "fillMode=3 searchRadius=32 draftQuality=1", 50.0, false, 3 },
+	{ "draft Weighted r=50", "fillMode=3 searchRadius=50", "fillMode=3 searchRadius=50 draftQuality=1", 50.0, false, 3 },
+	{ "LUT matcher, 4 colors", "outputMode=4 matchBackend=1 " FOUR_COLORS,
+	  "outputMode=4 matchBackend=2 " FOUR_COLORS, INFINITY, false, 1 },
+	{ "BITSET matcher, 8 colors", "outputMode=4 matchBackend=1 " EIGHT_COLORS,
+	  "outputMode=4 matchBackend=3 " EIGHT_COLORS, INFINITY, false, 1 },
+	{ "distance planes, line mask", "outputMode=4 " FOUR_COLORS, "outputMode=4 " FOUR_COLORS, INFINITY, true, 1 },
+	{ "distance planes, Average", "fillMode=2 " FOUR_COLORS, "fillMode=2 " FOUR_COLORS, INFINITY, true, 1 },
+	{ "distance planes, temporal", "temporalFill=1 fillMode=2 " FOUR_COLORS,
+	  "temporalFill=1 fillMode=2 " FOUR_COLORS, INFINITY, true, 1, true },
+	{ "SIMD Average r=12", "fillMode=2 searchRadius=12 scalarKernels=1", "fillMode=2 searchRadius=12", 60.0, false, 1 },
+	{ "SIMD Weighted r=12", "fillMode=3 searchRadius=12 scalarKernels=1", "fillMode=3 searchRadius=12", 60.0, false, 1 },
+	{ "SIMD draft Weighted r=32", "fillMode=3 searchRadius=32 draftQuality=1 scalarKernels=1",
+	  "fillMode=3 searchRadius=32 draftQuality=1", 60.0, false, 3 }
+};
+
+// ============================================================================
+// Error
+// ============================================================================
+
+// Channels in 0-1 (16-bit: 0-32768); maxError in 8-bit steps
+typedef struct {
+	double	psnr;			// INFINITY when identical
+	double	maxError;
+	double	differing;		// % of pixels with any channel different
+} QualityStats;
+
+template <typename PixelT>
+static void CompareFrames(const CX_TestFrame *exact, const CX_TestFrame *fast, QualityStats *stats) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	const double scale = 1.0 / Traits::kMaxChannel;
+	double sumSq = 0, maxError = 0;
+	size_t differing = 0;
+
+	for (A_long y = 0; y < exact->world.height; y++) {
+		const PixelT *a = CX_GetRow<PixelT>(&exact->world, y);
+		const PixelT *b = CX_GetRow<PixelT>(&fast->world, y);
+		for (A_long x = 0; x < exact->world.width; x++) {
+			const double d[4] = {
+				((double)a[x].alpha - b[x].alpha) * scale, ((double)a[x].red - b[x].red) * scale,
+				((double)a[x].green - b[x].green) * scale, ((double)a[x].blue - b[x].blue) * scale
+			};
+			bool differs = false;
+			for (A_long c = 0; c < 4; c++) {
+				sumSq += d[c] * d[c];
+				maxError = CX_MAX(maxError, fabs(d[c]));
+				differs |= d[c] != 0;
+			}
+			differing += differs;
+		}
+	}
+
+	const double pixels = (double)exact->world.width * exact->world.height;
+	const double mse = sumSq / (pixels * 4);
+	stats->psnr = mse > 0 ? 10.0 * log10(1.0 / mse) : INFINITY;
+	stats->maxError = maxError * 255.0;
+	stats->differing = 100.0 * differing / pixels;
+}
+
+static void Compare(const CX_TestFrame *exact, const CX_TestFrame *fast, QualityStats *stats) {
+	switch (exact->format) {
+		case PF_PixelFormat_ARGB32: CompareFrames<PF_Pixel8>(exact, fast, stats); break;
+		case PF_PixelFormat_ARGB64: CompareFrames<PF_Pixel16>(exact, fast, stats); break;
+		case PF_PixelFormat_ARGB128: CompareFrames<PF_PixelFloat>(exact, fast, stats); break;
+	}
+}
+
+// ============================================================================
+// Runs
+// ============================================================================
+
+// Best of QUALITY_REPS renders of params into dst, in ms. With dial, each
+// timed render follows an untimed one at another Color Tolerance.
+static double TimeRenders(const char *name, const char *params, bool dial, bool temporal, const CX_Host *host,
+						  CX_TestShot *shot, CX_TestFrame *dst, PF_Err *errP) {
+	CX_TestCase testCase = { name, &g_cxColorLinesOps, params, temporal };
+	std::vector<A_u_char> info = CX_TestMakeInfo(&testCase);
+	std::vector<A_u_char> dialled = info;
+	g_cxColorLinesOps.setValue(dialled.data(), "colorTolerance", 45.0);
+
+	double best = INFINITY;
+	for (A_long rep = 0; rep < QUALITY_REPS && !*errP; rep++) {
+		if (dial) *errP = CX_TestRender(&testCase, dialled, host, &shot->src, &shot->prev, &shot->next, dst);
+		auto start = std::chrono::steady_clock::now();
+		if (!*errP) *errP = CX_TestRender(&testCase, info, host, &shot->src, &shot->prev, &shot->next, dst);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = CX_MIN(best, elapsed.count());
+	}
+	return best;
+}
+
+static void RunCase(const QualityCase *qualityCase, const CX_TestFormat *format, const CX_Host *host, unsigned seed) {
+	CX_TestShot shot(format, QUALITY_WIDTH, QUALITY_HEIGHT, seed, qualityCase->lineWeight);
+	CX_TestFrame exact(format->format, format->pixelSize, QUALITY_WIDTH, QUALITY_HEIGHT);
+	CX_TestFrame fast(format->format, format->pixelSize, QUALITY_WIDTH, QUALITY_HEIGHT);
+
+	// Exact renders repeat their thresholds, so none reuses distance planes
+	PF_Err err = PF_Err_NONE;
+	double exactMs = TimeRenders(qualityCase->name, qualityCase->exact, false, qualityCase->temporal, host, &shot, &exact, &err);
+	double fastMs = TimeRenders(qualityCase->name, qualityCase->fast, qualityCase->dial, qualityCase->temporal, host, &shot, &fast, &err);
+	CX_CHECK(!err, "%s %s: render failed (%d)", qualityCase->name, format->name, (int)err);
+	if (err) return;
+
+	QualityStats stats = { 0, 0, 0 };
+	Compare(&exact, &fast, &stats);
+	printf("%-28s %-7s %8.2f %9.3g %9.3f %9.2f %9.2f %7.2fx\n", qualityCase->name, format->name,
+		   stats.psnr, stats.maxError, stats.differing, exactMs, fastMs, exactMs / fastMs);
+
+	if (qualityCase->minPsnr == INFINITY) {
+		CX_CHECK(stats.differing == 0, "%s %s: %.3f%% of pixels differ from the exact path",
+				 qualityCase->name, format->name, stats.differing);
+	} else {
+		CX_CHECK(stats.psnr >= qualityCase->minPsnr, "%s %s: PSNR %.2f dB, below %.0f dB",
+				 qualityCase->name, format->name, stats.psnr, qualityCase->minPsnr);
+	}
+}
+
+int main() {
+	static const char *levels[] = { "scalar", "avx2", "avx512" };
+	CX_ThreadPool pool(CX_MAX((A_long)std::thread::hardware_concurrency(), 1));
+	CX_Host host = pool.Host();
+
+	printf("test_quality: %dx%d, %d threads, %s, best of %d renders\n", QUALITY_WIDTH, QUALITY_HEIGHT,
+		   (int)pool.ThreadCount(), levels[CX_SimdLevel()], QUALITY_REPS);
+	printf("%-28s %-7s %8s %9s %9s %9s %9s %8s\n", "fast path", "depth", "PSNR dB", "max err",
+		   "differ %", "exact ms", "fast ms", "speedup");
+	for (A_long c = 0; c < (A_long)(sizeof(kCases) / sizeof(kCases[0])); c++) {
+		for (A_long f = 0; f < CX_TEST_FORMAT_COUNT; f++) {
+			RunCase(&kCases[c], &g_cxTestFormats[f], &host, (unsigned)(c * CX_TEST_FORMAT_COUNT + f + 1));
+		}
+	}
+	printf("max err in 8-bit steps; PSNR over all four channels in 0-1\n");
+	return CX_TestResult("test_quality");
+}
@@ -0,0 +1,117 @@
+/*
+	test_rounding.cpp
+
+	CX Animation Tools - float to 8-bit matching rounding
+	Float pixels are matched in 8-bit space, and ColorLines and PencilLine
+	rounded there differently before they shared CX_ColorMatcher:
+	- ColorLines: (A_long)(v * 255.0 + 0.5) in double, then clamped
+	- PencilLine: CX_CLAMP(v, 0, 1) * 255.0f + 0.5f in float
+	Every float within a few hundred ulps of each 8-bit rounding boundary
+	goes through both CX_MatchRounding modes (per pixel, matcher rows and
+	distance planes) and must land on the step its plugin's old formula
+	gives. The two formulas must still disagree somewhere, or the test no
+	longer tells them apart.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXColorMatch.h"
+#include "CXTestCheck.h"
+#include <math.h>
+#include <vector>
+
+#define BOUNDARY_ULPS	256
+
+// The formulas as the plugins had them, out-of-range values included
+static A_long OldColorLines8(float v) {
+	A_long c = (A_long)(v * 255.0 + 0.5);
+	return c < 0 ? 0 : (c > 255 ? 255 : c);
+}
+
+static A_long OldPencilLine8(float v) {
+	return (A_long)(CX_CLAMP(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Every float around each boundary (k + 0.5) / 255, plus the ends of the range
+static std::vector<float> BoundaryValues() {
+	std::vector<float> values;
+	for (A_long k = -1; k <= 255; k++) {
+		float v = (float)((k + 0.5) / 255.0);
+		for (A_long i = 0; i < BOUNDARY_ULPS; i++) v = nextafterf(v, -INFINITY);
+		for (A_long i = 0; i < 2 * BOUNDARY_ULPS; i++) {
+			values.push_back(v);
+			v = nextafterf(v, INFINITY);
+		}
+	}
+	static const float ends[] = { -1.0f, -0.0f, 0.0f, 1e-40f, 1.0f, 1.0001f, 2.0f };
+	values.insert(values.end(), ends, ends + sizeof(ends) / sizeof(ends[0]));
+	return values;
+}
+
+// A matcher that labels a pixel with its red step: entry k matches red k only
+static PF_Err InitStepMatcher(CX_ColorMatcher *m, A_long first, A_long rounding) {
+	CX_MatchEntry entries[CX_MATCH_MAX_ENTRIES];
+	for (A_long i = 0; i < CX_MATCH_MAX_ENTRIES; i++) {
+		PF_Pixel color = { PF_MAX_CHAN8, (A_u_char)(first + i), 0, 0 };
+		entries[i] = CX_MakeMatchEntry(color, 0.0, (A_u_char)(i + 1));
+	}
+	return CX_ColorMatcherInit(m, entries, CX_MATCH_MAX_ENTRIES, CX_MATCH_BACKEND_DIRECT, rounding);
+}
+
+static void TestRounding(A_long rounding, const char *name, A_long (*reference)(float), const std::vector<float>& values) {
+	typedef CX_PixelTraits<PF_PixelFloat> Traits;
+	const A_long width = (A_long)values.size();
+	std::vector<PF_PixelFloat> row(width);
+	for (A_long i = 0; i < width; i++) {
+		row[i].alpha = 1.0f;
+		row[i].red = values[i];
+		row[i].green = row[i].blue = 0.0f;
+	}
+
+	// Per value conversion
+	A_long bad = 0;
+	for (A_long i = 0; i < width; i++) {
+		A_long step = rounding == CX_MATCH_ROUND_DOUBLE ? Traits::ToMatch8Double(values[i]) : Traits::ToMatch8(values[i]);
+		bad += step != reference(values[i]);
+	}
+	CX_CHECK(bad == 0, "%s: %d values round to another step than the old formula", name, (int)bad);
+
+	// Matcher rows and single pixels, in blocks of CX_MATCH_MAX_ENTRIES steps
+	std::vector<A_u_char> labels(width);
+	bad = 0;
+	for (A_long first = 0; first < 256; first += CX_MATCH_MAX_ENTRIES) {
+		CX_ColorMatcher m;
+		PF_Err err = InitStepMatcher(&m, first, rounding);
+		CX_CHECK(!err, "%s: matcher init failed (%d)", name, (int)err);
+		if (err) return;
+		CX_MatchRowLabels(&m, row.data(), width, labels.data());
+		for (A_long i = 0; i < width; i++) {
+			A_long step = reference(values[i]);
+			A_u_char expected = (step >= first && step < first + CX_MATCH_MAX_ENTRIES) ? (A_u_char)(step - first + 1) : 0;
+			bad += labels[i] != expected || CX_MatchPixel(&m, &row[i]) != expected;
+		}
+		CX_ColorMatcherDispose(&m);
+	}
+	CX_CHECK(bad == 0, "%s: matcher labels differ from the old formula at %d pixels", name, (int)bad);
+
+	// Distance planes to black: the red step itself
+	std::vector<A_u_short> plane(width);
+	A_u_short *planes[1] = { plane.data() };
+	PF_Pixel black = { PF_MAX_CHAN8, 0, 0, 0 };
+	CX_MatchDistanceRow(row.data(), width, rounding, &black, 1, planes);
+	bad = 0;
+	for (A_long i = 0; i < width; i++) bad += plane[i] != reference(values[i]);
+	CX_CHECK(bad == 0, "%s: distance planes differ from the old formula at %d pixels", name, (int)bad);
+}
+
+int main() {
+	std::vector<float> values = BoundaryValues();
+	TestRounding(CX_MATCH_ROUND_DOUBLE, "ColorLines (double)", OldColorLines8, values);
+	TestRounding(CX_MATCH_ROUND_FLOAT, "PencilLine (float)", OldPencilLine8, values);
+
+	A_long differing = 0;
+	for (float v : values) differing += OldColorLines8(v) != OldPencilLine8(v);
+	printf("%d values checked, %d round differently in the two plugins\n", (int)values.size(), (int)differing);
+	CX_CHECK(differing > 0, "the old formulas agree on every boundary value; the test no longer separates them");
+	return CX_TestResult("test_rounding");
+}
@@ -0,0 +1,341 @@
+/*
+	test_simd.cpp
+
+	CX Animation Tools - SIMD and backend conformance test
+	Every dispatched variant against its scalar reference:
+	- CX_ColorMatcher LUT and BITSET against DIRECT, for every 8-bit color
+	  and for 8/16/32-bit rows with out-of-range and NaN channels, and the
+	  reuse of their tables for the same entries
+	- the Average / Weighted fill accumulation at each SIMD level this CPU
+	  runs (CX_SIMD does not apply), every window alignment and tail length
+	- the sum-of-gaussians tap pair step at each SIMD level
+	The matchers must give the DIRECT result bit for bit. The fill and tap
+	pair kernels sum in float with FMA, so they must stay within their error
+	bound of the scalar result (NaN and infinities exactly where it has them).
+	Sample Blur, color adjustments and the PencilLine texture have scalar
+	paths only and are covered by test_kernels.
+
+	The ColorLines kernels are included whole so their static SIMD entry
+	points can be called directly.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "ColorLinesKernels.cpp"
+#include "CXTestCheck.h"
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+static const char *LevelName(A_long level) {
+	return level == CX_SIMD_AVX512 ? "avx512" : level == CX_SIMD_AVX2 ? "avx2" : "scalar";
+}
+
+static const char *BackendName(A_long backend) {
+	return backend == CX_MATCH_BACKEND_BITSET ? "bitset" : backend == CX_MATCH_BACKEND_LUT ? "lut" : "direct";
+}
+
+// ============================================================================
+// Color Matcher Backends
+// ============================================================================
+
+typedef struct {
+	const char		*name;
+	CX_MatchEntry	entries[CX_MATCH_MAX_ENTRIES];
+	A_long			count;
+} MatchSet;
+
+static MatchSet MakeMatchSet(const char *name, A_long count, unsigned seed, PF_FpLong maxTolerance) {
+	MatchSet set;
+	set.name = name;
+	set.count = count;
+	for (A_long i = 0; i < count; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		PF_Pixel color = { PF_MAX_CHAN8, (A_u_char)(seed >> 24), (A_u_char)(seed >> 16), (A_u_char)(seed >> 8) };
+		PF_FpLong tolerance = (seed >> 4) % 1001 * maxTolerance / 1000.0;
+		A_long metric = (i % 3 == 2) ? CX_MATCH_METRIC_MAX_CHANNEL : CX_MATCH_METRIC_RGB;
+		set.entries[i] = CX_MakeMatchEntry(color, tolerance, (A_u_char)(i + 1), metric);
+	}
+	return set;
+}
+
+// A row of every class of channel value at PixelT's depth: the full 8-bit
+// range, integer values past PF_MAX_CHAN16, and negative, HDR and NaN floats
+template <typename PixelT>
+static std::vector<PixelT> MakeMatchRow(A_long width, unsigned seed) {
+	typedef typename CX_PixelTraits<PixelT>::ChannelType ChannelT;
+	std::vector<PixelT> row(width);
+	for (A_long i = 0; i < width; i++) {
+		ChannelT c[3];
+		for (A_long k = 0; k < 3; k++) {
+			seed = seed * 1664525u + 1013904223u;
+			A_long v = (A_long)(seed >> 24);
+			if constexpr (CX_PixelTraits<PixelT>::kIsFloat) {
+				static const float edges[] = { -0.5f, -0.0f, 1.0f, 1.0001f, 4.0f, NAN, INFINITY, 1e-40f };
+				c[k] = (seed & 0x700) == 0 ? edges[(seed >> 16) & 7] : (ChannelT)(v / 255.0f);
+			} else if constexpr (sizeof(ChannelT) == 2) {
+				c[k] = (seed & 0x700) == 0 ? (ChannelT)(seed >> 16) : (ChannelT)(v * PF_MAX_CHAN16 / 255 + (seed >> 12) % 64);
+			} else {
+				c[k] = (ChannelT)v;
+			}
+		}
+		row[i].alpha = CX_PixelTraits<PixelT>::kMaxChannel;
+		row[i].red = c[0];
+		row[i].green = c[1];
+		row[i].blue = c[2];
+	}
+	return row;
+}
+
+template <typename PixelT>
+static void TestMatchRows(const MatchSet *set, const CX_ColorMatcher *direct, const CX_ColorMatcher *m, const char *depth) {
+	const A_long width = 4000;	// Several conversion chunks and a partial one
+	for (unsigned seed = 1; seed <= 4; seed++) {
+		std::vector<PixelT> row = MakeMatchRow<PixelT>(width, seed);
+		std::vector<A_u_char> labels(width), mask(width);
+		CX_MatchRowLabels(m, row.data(), width, labels.data());
+		CX_MatchRowMask(m, row.data(), width, mask.data(), 7);
+		A_long bad = 0;
+		for (A_long i = 0; i < width; i++) {
+			A_u_char reference = CX_MatchPixel(direct, &row[i]);
+			bad += labels[i] != reference || mask[i] != (reference ? 7 : 0);
+		}
+		CX_CHECK(bad == 0, "matcher %s, %s rows: %s differs from per-pixel direct at %d pixels",
+				 set->name, depth, BackendName(m->backend), (int)bad);
+	}
+}
+
+static void TestMatcher(const MatchSet *set) {
+	CX_ColorMatcher direct, lut, bitset;
+	PF_Err err = CX_ColorMatcherInit(&direct, set->entries, set->count, CX_MATCH_BACKEND_DIRECT);
+	if (!err) err = CX_ColorMatcherInit(&lut, set->entries, set->count, CX_MATCH_BACKEND_LUT);
+	if (!err) err = CX_ColorMatcherInit(&bitset, set->entries, set->count, CX_MATCH_BACKEND_BITSET);
+	CX_CHECK(!err, "matcher %s: init failed (%d)", set->name, (int)err);
+	if (err) return;
+
+	// Same entries again: the built tables come from the cache
+	CX_ColorMatcher again;
+	err = CX_ColorMatcherInit(&again, set->entries, set->count, CX_MATCH_BACKEND_BITSET);
+	CX_CHECK(!err && again.cells == bitset.cells && again.bits == bitset.bits,
+			 "matcher %s: bitset tables rebuilt for the same entries", set->name);
+	CX_ColorMatcherDispose(&again);
+
+	// Every 8-bit color, labels and the mask-only lookup
+	A_long bad[2] = { 0, 0 };
+	const CX_ColorMatcher *tables[2] = { &lut, &bitset };
+	for (A_long r = 0; r < 256; r++) {
+		for (A_long g = 0; g < 256; g++) {
+			for (A_long b = 0; b < 256; b++) {
+				A_u_char reference = CX_MatchDirect(&direct, r, g, b);
+				for (A_long t = 0; t < 2; t++) {
+					bad[t] += CX_MatchRGB8(tables[t], r, g, b) != reference ||
+							  (CX_MatchLookup<false>(tables[t], r, g, b) != 0) != (reference != 0);
+				}
+			}
+		}
+	}
+	CX_CHECK(bad[0] == 0, "matcher %s: lut differs from direct for %d colors", set->name, (int)bad[0]);
+	CX_CHECK(bad[1] == 0, "matcher %s: bitset differs from direct for %d colors", set->name, (int)bad[1]);
+
+	const CX_ColorMatcher *all[3] = { &direct, &lut, &bitset };
+	for (A_long t = 0; t < 3; t++) {
+		TestMatchRows<PF_Pixel8>(set, &direct, all[t], "8-bit");
+		TestMatchRows<PF_Pixel16>(set, &direct, all[t], "16-bit");
+		TestMatchRows<PF_PixelFloat>(set, &direct, all[t], "32-bit");
+	}
+
+	CX_ColorMatcherDispose(&direct);
+	CX_ColorMatcherDispose(&lut);
+	CX_ColorMatcherDispose(&bitset);
+}
+
+// ============================================================================
+// Fill Accumulation
+// ============================================================================
+
+// Staged channel values to cycle through: every 8-bit value, 16-bit
+// boundaries, then negative, denormal and HDR floats
+static float EdgeValue(A_long i) {
+	static const float edges[] = {
+		256.0f, 16383.0f, 16384.0f, 32767.0f, 32768.0f, 65535.0f,
+		-0.0f, -1.0f, -255.5f, 1e-40f, 0.5f, 1.0f, 1.5e4f, 65504.0f, 3.0e6f
+	};
+	const A_long count = 256 + (A_long)(sizeof(edges) / sizeof(edges[0]));
+	i %= count;
+	return i < 256 ? (float)i : edges[i - 256];
+}
+
+// Within maxError * magnitude of the reference; any NaN matches any NaN
+// (payloads are not specified) and infinities must match exactly
+static bool Near(PF_FpLong reference, PF_FpLong result, PF_FpLong magnitude, PF_FpLong maxError) {
+	if (reference != reference) return result != result;
+	if (isinf(reference) || isinf(result)) return reference == result;
+	return fabs(reference - result) <= maxError * magnitude;
+}
+
+static bool NearSums(const FillSums *reference, const FillSums *result, const FillSums *magnitude) {
+	return Near(reference->red, result->red, magnitude->red, FILL_SIMD_MAX_ERROR) &&
+		   Near(reference->green, result->green, magnitude->green, FILL_SIMD_MAX_ERROR) &&
+		   Near(reference->blue, result->blue, magnitude->blue, FILL_SIMD_MAX_ERROR) &&
+		   Near(reference->alpha, result->alpha, magnitude->alpha, FILL_SIMD_MAX_ERROR) &&
+		   Near(reference->weight, result->weight, magnitude->weight, FILL_SIMD_MAX_ERROR);
+}
+
+// Sums of |term| over the window: the scale the fill error bound is relative to
+static void MagnitudeSums(const FillTile *tile, const PF_FpLong *weights, A_long x, A_long y,
+						  A_long radius, FillSums *sums) {
+	A_long size = radius * 2 + 1;
+	FillSums m = { 0, 0, 0, 0, 0 };
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		A_long offset = (y + dy - tile->y0) * tile->stride + (x - radius - tile->x0);
+		for (A_long k = 0; k < size; k++) {
+			PF_FpLong weight = fabs((weights ? weights[(dy + radius) * size + k] : 1.0) * tile->valid[offset + k]);
+			m.red += fabs(tile->red[offset + k] * weight);
+			m.green += fabs(tile->green[offset + k] * weight);
+			m.blue += fabs(tile->blue[offset + k] * weight);
+			m.alpha += fabs(tile->alpha[offset + k] * weight);
+			m.weight += weight;
+		}
+	}
+	*sums = m;
+}
+
+#if CX_HAS_X86_SIMD
+static void AccumulateTileLevel(A_long level, const FillTile *tile, const float *weights, A_long weightStride,
+								A_long x, A_long y, A_long radius, FillSums *sums) {
+	if (level == CX_SIMD_AVX512) AccumulateTileAVX512(tile, weights, weightStride, x, y, radius, sums);
+	else AccumulateTileAVX2(tile, weights, weightStride, x, y, radius, sums);
+}
+
+// Average and Weighted sums over every window alignment and tail length of
+// the radii, with all / some / no taps valid and one NaN or infinite sample
+static void TestFill(A_long level) {
+	static const A_long radii[] = { 1, 2, 3, 4, 5, 7, 8, 11, 12, 16, 23, SEARCH_RADIUS_MAX };
+	static const char *patterns[] = { "all valid", "every third valid", "none valid", "NaN sample", "infinite sample" };
+
+	for (A_long ri = 0; ri < (A_long)(sizeof(radii) / sizeof(radii[0])); ri++) {
+		const A_long radius = radii[ri];
+		const A_long size = radius * 2 + 1;
+		const A_long stride = (size + 16 + FILL_TILE_ALIGN - 1) / FILL_TILE_ALIGN * FILL_TILE_ALIGN;
+		const size_t planeSize = (size_t)stride * size;
+		const A_long bitStride = stride / 8;
+		const size_t bitsSize = (size_t)bitStride * size + sizeof(A_u_long);
+
+		std::vector<float> planes(planeSize * 5);
+		std::vector<A_u_char> bits(bitsSize);
+		std::vector<PF_FpLong> weights((size_t)size * size);
+		BuildInvDistWeights(weights.data(), radius);
+		const A_long tapStride = (size + FILL_TILE_ALIGN - 1) / FILL_TILE_ALIGN * FILL_TILE_ALIGN;
+		std::vector<float> tapWeights((size_t)tapStride * size);
+		for (A_long row = 0; row < size; row++) {
+			for (A_long k = 0; k < size; k++) tapWeights[row * tapStride + k] = (float)weights[row * size + k];
+		}
+
+		FillTile tile;
+		tile.x0 = tile.y0 = 0;
+		tile.stride = stride;
+		tile.red = planes.data();
+		tile.green = tile.red + planeSize;
+		tile.blue = tile.red + planeSize * 2;
+		tile.alpha = tile.red + planeSize * 3;
+		tile.valid = tile.red + planeSize * 4;
+		tile.validBits = bits.data();
+
+		for (A_long pattern = 0; pattern < 5; pattern++) {
+			memset(bits.data(), 0, bitsSize);
+			for (size_t i = 0; i < planeSize; i++) {
+				bool valid = pattern == 1 ? (i % 3 == 0) : pattern != 2;
+				float v[4];
+				for (A_long c = 0; c < 4; c++) v[c] = valid ? EdgeValue((A_long)i * 4 + c + ri * 7) : 0.0f;
+				if (pattern >= 3 && i == planeSize / 2) v[1] = pattern == 3 ? NAN : INFINITY;
+				tile.red[i] = v[0];
+				tile.green[i] = v[1];
+				tile.blue[i] = v[2];
+				tile.alpha[i] = v[3];
+				tile.valid[i] = valid ? 1.0f : 0.0f;
+				if (valid) bits[(i / stride) * bitStride + (i % stride) / 8] |= (A_u_char)(1 << ((i % stride) & 7));
+			}
+
+			A_long bad = 0;
+			for (A_long offset = 0; offset < 16; offset++) {
+				for (A_long weighted = 0; weighted < 2; weighted++) {
+					const PF_FpLong *w = weighted ? weights.data() : NULL;
+					FillSums reference, result, magnitude;
+					AccumulateTileScalar(&tile, w, radius + offset, radius, radius, &reference);
+					AccumulateTileLevel(level, &tile, weighted ? tapWeights.data() : NULL, tapStride,
+										radius + offset, radius, radius, &result);
+					MagnitudeSums(&tile, w, radius + offset, radius, radius, &magnitude);
+					bad += !NearSums(&reference, &result, &magnitude);
+				}
+			}
+			CX_CHECK(bad == 0, "fill %s, radius %d, %s: %d of 32 windows beyond the error bound of scalar",
+					 LevelName(level), (int)radius, patterns[pattern], (int)bad);
+		}
+	}
+}
+
+// ============================================================================
+// Sum-of-Gaussians Tap Pairs
+// ============================================================================
+
+// Tap pair step over every tail length, edge values and one NaN. The fused
+// multiply-add rounds once where scalar rounds twice: within an ulp of the
+// larger of out and g * (a + b).
+#define SOG_SIMD_MAX_ERROR	(2.0 * FLT_EPSILON)
+
+static void TestSoG(A_long level) {
+	const A_long maxLength = 67;
+	float a[maxLength], b[maxLength], reference[maxLength], result[maxLength];
+	static const float gains[] = { 0.0f, 1.0f, 0.3183099f, -2.5f, 1e-3f };
+
+	for (A_long n = 0; n <= maxLength; n++) {
+		for (A_long gi = 0; gi < (A_long)(sizeof(gains) / sizeof(gains[0])); gi++) {
+			for (A_long i = 0; i < maxLength; i++) {
+				a[i] = EdgeValue(i * 3 + n);
+				b[i] = (i & 1) ? -EdgeValue(i * 5 + gi) : EdgeValue(i + 100);
+				reference[i] = result[i] = EdgeValue(i * 7 + 11);
+			}
+			float before[maxLength];
+			memcpy(before, reference, sizeof(before));
+			if (n > 0) a[n / 2] = NAN;
+
+			SoGAddTapPairScalar(reference, a, b, gains[gi], n);
+			SoGAddTapPair(level, result, a, b, gains[gi], n);
+
+			A_long bad = 0;
+			for (A_long i = 0; i < maxLength; i++) {
+				// Elements past n must be untouched
+				bad += i >= n ? memcmp(&reference[i], &result[i], sizeof(float)) != 0
+							  : !Near(reference[i], result[i],
+									  CX_MAX(fabs(before[i]), fabs(gains[gi] * ((PF_FpLong)a[i] + b[i]))), SOG_SIMD_MAX_ERROR);
+			}
+			CX_CHECK(bad == 0, "sog %s, length %d, gain %g: %d elements beyond the error bound of scalar",
+					 LevelName(level), (int)n, gains[gi], (int)bad);
+		}
+	}
+}
+#endif
+
+int main() {
+	const MatchSet sets[] = {
+		MakeMatchSet("one color, tolerance 0", 1, 7, 0.0),
+		MakeMatchSet("one color", 1, 8, 20.0),
+		MakeMatchSet("three colors", 3, 9, 40.0),
+		MakeMatchSet("sixteen colors", 16, 10, 15.0),
+		MakeMatchSet("sixteen wide colors", 16, 11, 100.0)
+	};
+	for (const MatchSet& set : sets) TestMatcher(&set);
+
+	const A_long detected = CX_DetectSimdLevel();
+	for (A_long level = CX_SIMD_AVX2; level <= CX_SIMD_AVX512; level++) {
+		if (level > detected) {
+			printf("test_simd: %s not supported here, skipped\n", LevelName(level));
+			continue;
+		}
+#if CX_HAS_X86_SIMD
+		TestFill(level);
+		TestSoG(level);
+#endif
+	}
+	return CX_TestResult("test_simd");
+}
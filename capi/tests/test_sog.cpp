@@ -0,0 +1,62 @@
+/*
+	test_sog.cpp
+
+	CX Animation Tools - sum-of-gaussians fit test
+	Prints the fit of the draft Weighted fill for every radius it serves
+	(SOG_MIN_RADIUS to SEARCH_RADIUS_MAX) and checks it: the error is
+	recomputed against the exact fill's weight table and must agree with
+	the one the fit reports, stay within SOG_MAX_ERROR (worse fits drop the
+	draft path) and come with positive amplitudes. test_quality measures
+	what the fit error costs in the rendered image.
+
+	The ColorLines kernels are included whole to reach GetSoGFit.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "ColorLinesKernels.cpp"
+#include "CXTestCheck.h"
+#include <vector>
+
+// sum |fit - weight| / sum weight over the exact fill's window, center excluded
+static PF_FpLong WindowError(const SoGFit *fit, A_long radius) {
+	const A_long size = radius * 2 + 1;
+	std::vector<PF_FpLong> weights((size_t)size * size);
+	BuildInvDistWeights(weights.data(), radius);
+
+	PF_FpLong error = 0, total = 0;
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		for (A_long dx = -radius; dx <= radius; dx++) {
+			if (dx == 0 && dy == 0) continue;
+			PF_FpLong value = 0;
+			for (A_long i = 0; i < SOG_TERMS; i++) {
+				value += fit->amplitude[i] * exp(-(dx * dx + dy * dy) / (2.0 * fit->sigma[i] * fit->sigma[i]));
+			}
+			PF_FpLong weight = weights[(dy + radius) * size + (dx + radius)];
+			error += fabs(value - weight);
+			total += weight;
+		}
+	}
+	return error / total;
+}
+
+int main() {
+	printf("radius  error %%   sigmas\n");
+	for (A_long radius = SOG_MIN_RADIUS; radius <= SEARCH_RADIUS_MAX; radius++) {
+		const SoGFit *fit = GetSoGFit(radius);
+		const PF_FpLong window = WindowError(fit, radius);
+		printf("%6d  %7.3f  ", (int)radius, fit->error * 100.0);
+		for (A_long i = 0; i < SOG_TERMS; i++) printf(" %7.3f", fit->sigma[i]);
+		printf("\n");
+
+		CX_CHECK(fabs(window - fit->error) <= 1e-9 * window, "r=%d: fit reports %.6f, window error %.6f",
+				 (int)radius, fit->error, window);
+		CX_CHECK(fit->error <= SOG_MAX_ERROR, "r=%d: error %.4f above SOG_MAX_ERROR, draft falls back",
+				 (int)radius, fit->error);
+		for (A_long i = 0; i < SOG_TERMS; i++) {
+			CX_CHECK(fit->amplitude[i] >= 0 && fit->sigma[i] > 0, "r=%d: term %d has amplitude %g, sigma %g",
+					 (int)radius, (int)i, fit->amplitude[i], fit->sigma[i]);
+		}
+	}
+	return CX_TestResult("test_sog");
+}
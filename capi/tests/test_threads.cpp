@@ -0,0 +1,64 @@
+/*
+	test_threads.cpp
+
+	CX Animation Tools - thread count determinism test
+	Every case of CXTestDriver.h at 8, 16 and 32 bits, rendered on a
+	CX_ThreadPool of 1, 2, 8 and 64 threads: the output hash must equal the
+	serial host's. Each pool renders a shot of its own first (uncached line
+	masks), then again with the caches warm after a Color Tolerance change
+	and back (ColorLines' distance planes).
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXTestDriver.h"
+#include "CXThreadPool.h"
+
+#define TEST_WIDTH	256
+#define TEST_HEIGHT	192
+
+static const A_long kThreadCounts[] = { 1, 2, 8, 64 };
+
+static void TestCase(const CX_TestCase *testCase, const CX_TestFormat *format, CX_ThreadPool *pool, unsigned seed) {
+	CX_TestShot shot(format, TEST_WIDTH, TEST_HEIGHT, seed);
+	std::vector<A_u_char> info = CX_TestMakeInfo(testCase);
+	CX_Host threaded = pool->Host();
+	CX_Host serial = CX_TestSerialHost();
+	A_long threads = pool->ThreadCount();
+
+	CX_TestFrame first(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	CX_TestFrame reference(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	CX_TestFrame warm(format->format, format->pixelSize, TEST_WIDTH, TEST_HEIGHT);
+	PF_Err err = CX_TestRender(testCase, info, &threaded, &shot.src, &shot.prev, &shot.next, &first);
+	PF_Err serialErr = CX_TestRender(testCase, info, &serial, &shot.src, &shot.prev, &shot.next, &reference);
+	PF_Err warmErr = PF_Err_NONE;
+	if (testCase->ops == &g_cxColorLinesOps) {
+		std::vector<A_u_char> scrubbed = info;
+		testCase->ops->setValue(scrubbed.data(), "colorTolerance", 45.0);
+		warmErr = CX_TestRender(testCase, scrubbed, &threaded, &shot.src, &shot.prev, &shot.next, &warm);
+	}
+	if (!warmErr) warmErr = CX_TestRender(testCase, info, &threaded, &shot.src, &shot.prev, &shot.next, &warm);
+	CX_CHECK(!err && !serialErr && !warmErr, "%s %s, %d threads: render failed (%d %d %d)",
+			 testCase->name, format->name, (int)threads, (int)err, (int)serialErr, (int)warmErr);
+	if (err || serialErr || warmErr) return;
+
+	A_u_longlong expected = CX_TestHash(&reference);
+	CX_CHECK(CX_TestHash(&first) == expected, "%s %s, %d threads: hash %016llx, serial %016llx",
+			 testCase->name, format->name, (int)threads, (unsigned long long)CX_TestHash(&first), (unsigned long long)expected);
+	CX_CHECK(CX_TestHash(&warm) == expected, "%s %s, %d threads (cached): hash %016llx, serial %016llx",
+			 testCase->name, format->name, (int)threads, (unsigned long long)CX_TestHash(&warm), (unsigned long long)expected);
+}
+
+int main() {
+	for (A_long t = 0; t < (A_long)(sizeof(kThreadCounts) / sizeof(kThreadCounts[0])); t++) {
+		CX_ThreadPool pool(kThreadCounts[t]);
+		CX_CHECK(pool.ThreadCount() == kThreadCounts[t], "pool has %d threads, asked for %d",
+				 (int)pool.ThreadCount(), (int)kThreadCounts[t]);
+		for (A_long f = 0; f < CX_TEST_FORMAT_COUNT; f++) {
+			for (A_long c = 0; c < CX_TEST_CASE_COUNT; c++) {
+				TestCase(&g_cxTestCases[c], &g_cxTestFormats[f], &pool, (unsigned)(t + 1));
+			}
+		}
+	}
+	return CX_TestResult("test_threads");
+}
@@ -0,0 +1,390 @@
+/*
+	CXOfx.cpp
+
+	CX Animation Tools - OpenFX adapter and bundle entry points
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#include "CXOfx.h"
+#include <atomic>
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+CX_OfxSuites g_cxOfx;
+
+// ============================================================================
+// Host and Suites
+// ============================================================================
+
+void CX_OfxSetHost(OfxHost *host) {
+	AEFX_CLR_STRUCT(g_cxOfx);
+	g_cxOfx.host = host;
+	if (!host) return;
+	g_cxOfx.prop = (const OfxPropertySuiteV1*)host->fetchSuite(host->host, kOfxPropertySuite, 1);
+	g_cxOfx.effect = (const OfxImageEffectSuiteV1*)host->fetchSuite(host->host, kOfxImageEffectSuite, 1);
+	g_cxOfx.param = (const OfxParameterSuiteV1*)host->fetchSuite(host->host, kOfxParameterSuite, 1);
+	g_cxOfx.thread = (const OfxMultiThreadSuiteV1*)host->fetchSuite(host->host, kOfxMultiThreadSuite, 1);
+}
+
+OfxStatus CX_OfxLoad() {
+	if (!g_cxOfx.prop || !g_cxOfx.effect || !g_cxOfx.param) return kOfxStatErrMissingHostFeature;
+	return kOfxStatOK;
+}
+
+OfxStatus CX_OfxStatus(PF_Err err) {
+	switch (err) {
+		case PF_Err_NONE: return kOfxStatOK;
+		case PF_Err_OUT_OF_MEMORY: return kOfxStatErrMemory;
+		default: return kOfxStatFailed;
+	}
+}
+
+// Jobs are handed out from a shared counter, so threads that finish early
+// take more; the first error wins, remaining jobs still run like iterate_generic
+typedef struct {
+	A_long				count;
+	void				*refcon;
+	CX_IterateFunc		fn;
+	std::atomic<A_long>	next;
+	std::atomic<PF_Err>	err;
+} OfxIterateJob;
+
+static void OfxIterateThread(unsigned int threadIndex, unsigned int threadMax, void *customArg) {
+	OfxIterateJob *job = (OfxIterateJob*)customArg;
+	for (;;) {
+		A_long i = job->next++;
+		if (i >= job->count) break;
+		PF_Err err = job->fn(job->refcon, (A_long)threadIndex, i, job->count);
+		if (err) {
+			PF_Err none = PF_Err_NONE;
+			job->err.compare_exchange_strong(none, err);
+		}
+	}
+}
+
+static PF_Err OfxIterate(void *context, A_long count, void *refcon, CX_IterateFunc fn) {
+	unsigned int threads = 1;
+	if (!g_cxOfx.thread || g_cxOfx.thread->multiThreadNumCPUs(&threads) != kOfxStatOK) threads = 1;
+	if ((A_long)threads > count) threads = (unsigned int)count;
+	if (threads <= 1) return CX_SerialIterate(context, count, refcon, fn);
+
+	OfxIterateJob job;
+	job.count = count;
+	job.refcon = refcon;
+	job.fn = fn;
+	job.next = 0;
+	job.err = PF_Err_NONE;
+
+	// A host that refuses to spawn leaves the jobs to this thread
+	if (g_cxOfx.thread->multiThread(OfxIterateThread, threads, &job) != kOfxStatOK) {
+		OfxIterateThread(0, 1, &job);
+	}
+	return job.err;
+}
+
+CX_Host CX_MakeOfxHost() {
+	CX_Host host = { NULL, OfxIterate };
+	return host;
+}
+
+// ============================================================================
+// Description
+// ============================================================================
+
+OfxStatus CX_OfxDescribe(OfxImageEffectHandle effect, const char *label, bool temporalAccess) {
+	OfxPropertySetHandle props;
+	OfxStatus stat = g_cxOfx.effect->getPropertySet(effect, &props);
+	if (stat != kOfxStatOK) return stat;
+
+	const OfxPropertySuiteV1 *prop = g_cxOfx.prop;
+	prop->propSetString(props, kOfxPropLabel, 0, label);
+	prop->propSetString(props, kOfxImageEffectPluginPropGrouping, 0, CX_OFX_GROUPING);
+	prop->propSetString(props, kOfxImageEffectPropSupportedContexts, 0, kOfxImageEffectContextFilter);
+	prop->propSetString(props, kOfxImageEffectPropSupportedPixelDepths, 0, kOfxBitDepthByte);
+	prop->propSetString(props, kOfxImageEffectPropSupportedPixelDepths, 1, kOfxBitDepthShort);
+	prop->propSetString(props, kOfxImageEffectPropSupportedPixelDepths, 2, kOfxBitDepthFloat);
+	prop->propSetInt(props, kOfxImageEffectPropSupportsTiles, 0, 1);
+	prop->propSetInt(props, kOfxImageEffectPropSupportsMultiResolution, 0, 1);
+	prop->propSetInt(props, kOfxImageEffectPropSupportsMultipleClipDepths, 0, 0);
+	prop->propSetInt(props, kOfxImageEffectPropTemporalClipAccess, 0, temporalAccess ? 1 : 0);
+	prop->propSetString(props, kOfxImageEffectPluginRenderThreadSafety, 0, kOfxImageEffectRenderFullySafe);
+	prop->propSetInt(props, kOfxImageEffectPluginPropHostFrameThreading, 0, 0);
+	return kOfxStatOK;
+}
+
+OfxStatus CX_OfxDefineClips(OfxImageEffectHandle effect, bool temporalAccess) {
+	const OfxPropertySuiteV1 *prop = g_cxOfx.prop;
+	OfxPropertySetHandle props;
+
+	OfxStatus stat = g_cxOfx.effect->clipDefine(effect, CX_OFX_SOURCE_CLIP, &props);
+	if (stat != kOfxStatOK) return stat;
+	prop->propSetString(props, kOfxImageEffectPropSupportedComponents, 0, kOfxImageComponentRGBA);
+	prop->propSetInt(props, kOfxImageEffectPropSupportsTiles, 0, 1);
+	prop->propSetInt(props, kOfxImageEffectPropTemporalClipAccess, 0, temporalAccess ? 1 : 0);
+
+	stat = g_cxOfx.effect->clipDefine(effect, CX_OFX_OUTPUT_CLIP, &props);
+	if (stat != kOfxStatOK) return stat;
+	prop->propSetString(props, kOfxImageEffectPropSupportedComponents, 0, kOfxImageComponentRGBA);
+	prop->propSetInt(props, kOfxImageEffectPropSupportsTiles, 0, 1);
+	return kOfxStatOK;
+}
+
+static OfxPropertySetHandle DefineParam(OfxParamSetHandle params, const char *type, const char *name,
+										const char *label, const char *parent) {
+	OfxPropertySetHandle props = NULL;
+	if (g_cxOfx.param->paramDefine(params, type, name, &props) != kOfxStatOK) return NULL;
+	g_cxOfx.prop->propSetString(props, kOfxPropLabel, 0, label);
+	g_cxOfx.prop->propSetString(props, kOfxParamPropScriptName, 0, name);
+	if (parent) g_cxOfx.prop->propSetString(props, kOfxParamPropParent, 0, parent);
+	return props;
+}
+
+void CX_OfxDefineGroup(OfxParamSetHandle params, const char *name, const char *label, bool open) {
+	OfxPropertySetHandle props = DefineParam(params, kOfxParamTypeGroup, name, label, NULL);
+	if (props) g_cxOfx.prop->propSetInt(props, kOfxParamPropGroupOpen, 0, open ? 1 : 0);
+}
+
+void CX_OfxDefineDouble(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+						double min, double max, double displayMax, double dflt) {
+	OfxPropertySetHandle props = DefineParam(params, kOfxParamTypeDouble, name, label, parent);
+	if (!props) return;
+	const OfxPropertySuiteV1 *prop = g_cxOfx.prop;
+	prop->propSetDouble(props, kOfxParamPropDefault, 0, dflt);
+	prop->propSetDouble(props, kOfxParamPropMin, 0, min);
+	prop->propSetDouble(props, kOfxParamPropMax, 0, max);
+	prop->propSetDouble(props, kOfxParamPropDisplayMin, 0, min);
+	prop->propSetDouble(props, kOfxParamPropDisplayMax, 0, displayMax);
+	prop->propSetInt(props, kOfxParamPropDigits, 0, 1);
+}
+
+void CX_OfxDefineInt(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+					 int min, int max, int dflt) {
+	OfxPropertySetHandle props = DefineParam(params, kOfxParamTypeInteger, name, label, parent);
+	if (!props) return;
+	const OfxPropertySuiteV1 *prop = g_cxOfx.prop;
+	prop->propSetInt(props, kOfxParamPropDefault, 0, dflt);
+	prop->propSetInt(props, kOfxParamPropMin, 0, min);
+	prop->propSetInt(props, kOfxParamPropMax, 0, max);
+	prop->propSetInt(props, kOfxParamPropDisplayMin, 0, min);
+	prop->propSetInt(props, kOfxParamPropDisplayMax, 0, max);
+}
+
+void CX_OfxDefineBool(OfxParamSetHandle params, const char *name, const char *label, const char *parent, bool dflt) {
+	OfxPropertySetHandle props = DefineParam(params, kOfxParamTypeBoolean, name, label, parent);
+	if (props) g_cxOfx.prop->propSetInt(props, kOfxParamPropDefault, 0, dflt ? 1 : 0);
+}
+
+void CX_OfxDefineColor(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+					   double r, double g, double b) {
+	OfxPropertySetHandle props = DefineParam(params, kOfxParamTypeRGB, name, label, parent);
+	if (!props) return;
+	g_cxOfx.prop->propSetDouble(props, kOfxParamPropDefault, 0, r);
+	g_cxOfx.prop->propSetDouble(props, kOfxParamPropDefault, 1, g);
+	g_cxOfx.prop->propSetDouble(props, kOfxParamPropDefault, 2, b);
+}
+
+void CX_OfxDefineChoice(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+						const char *options, int dflt) {
+	OfxPropertySetHandle props = DefineParam(params, kOfxParamTypeChoice, name, label, parent);
+	if (!props) return;
+	char option[64];
+	int index = 0;
+	for (const char *p = options; ; p++) {
+		const char *end = strchr(p, '|');
+		size_t length = end ? (size_t)(end - p) : strlen(p);
+		length = CX_MIN(length, sizeof(option) - 1);
+		memcpy(option, p, length);
+		option[length] = 0;
+		g_cxOfx.prop->propSetString(props, kOfxParamPropChoiceOption, index++, option);
+		if (!end) break;
+		p = end;
+	}
+	g_cxOfx.prop->propSetInt(props, kOfxParamPropDefault, 0, dflt - 1);
+}
+
+static OfxParamHandle GetParam(OfxParamSetHandle params, const char *name) {
+	OfxParamHandle param = NULL;
+	g_cxOfx.param->paramGetHandle(params, name, &param, NULL);
+	return param;
+}
+
+double CX_OfxGetDouble(OfxParamSetHandle params, const char *name, OfxTime time) {
+	double value = 0.0;
+	OfxParamHandle param = GetParam(params, name);
+	if (param) g_cxOfx.param->paramGetValueAtTime(param, time, &value);
+	return value;
+}
+
+A_long CX_OfxGetInt(OfxParamSetHandle params, const char *name, OfxTime time) {
+	int value = 0;
+	OfxParamHandle param = GetParam(params, name);
+	if (param) g_cxOfx.param->paramGetValueAtTime(param, time, &value);
+	return value;
+}
+
+PF_Boolean CX_OfxGetBool(OfxParamSetHandle params, const char *name, OfxTime time) {
+	return CX_OfxGetInt(params, name, time) ? TRUE : FALSE;
+}
+
+A_long CX_OfxGetChoice(OfxParamSetHandle params, const char *name, OfxTime time) {
+	return CX_OfxGetInt(params, name, time) + 1;
+}
+
+PF_Pixel CX_OfxGetColor(OfxParamSetHandle params, const char *name, OfxTime time) {
+	double r = 0.0, g = 0.0, b = 0.0;
+	OfxParamHandle param = GetParam(params, name);
+	if (param) g_cxOfx.param->paramGetValueAtTime(param, time, &r, &g, &b);
+	PF_Pixel color;
+	color.alpha = PF_MAX_CHAN8;
+	color.red = CX_ClampByte(r * 255.0 + 0.5);
+	color.green = CX_ClampByte(g * 255.0 + 0.5);
+	color.blue = CX_ClampByte(b * 255.0 + 0.5);
+	return color;
+}
+
+// ============================================================================
+// Images
+// ============================================================================
+
+PF_Err CX_OfxFetchImage(OfxImageClipHandle clip, OfxTime time, CX_OfxImage *image) {
+	AEFX_CLR_STRUCT(*image);
+	OfxPropertySetHandle props = NULL;
+	if (g_cxOfx.effect->clipGetImage(clip, time, NULL, &props) != kOfxStatOK) return PF_Err_NONE;
+
+	const OfxPropertySuiteV1 *prop = g_cxOfx.prop;
+	char *depth = NULL, *components = NULL;
+	image->props = props;
+	prop->propGetPointer(props, kOfxImagePropData, 0, &image->data);
+	prop->propGetIntN(props, kOfxImagePropBounds, 4, &image->bounds.x1);
+	prop->propGetInt(props, kOfxImagePropRowBytes, 0, &image->rowBytes);
+	prop->propGetString(props, kOfxImageEffectPropPixelDepth, 0, &depth);
+	prop->propGetString(props, kOfxImageEffectPropComponents, 0, &components);
+
+	image->format = PF_PixelFormat_INVALID;
+	if (depth && strcmp(depth, kOfxBitDepthByte) == 0) image->format = PF_PixelFormat_ARGB32;
+	else if (depth && strcmp(depth, kOfxBitDepthShort) == 0) image->format = PF_PixelFormat_ARGB64;
+	else if (depth && strcmp(depth, kOfxBitDepthFloat) == 0) image->format = PF_PixelFormat_ARGB128;
+
+	if (!image->data || image->format == PF_PixelFormat_INVALID ||
+		!components || strcmp(components, kOfxImageComponentRGBA) != 0) {
+		CX_OfxReleaseImage(image);
+		return PF_Err_BAD_CALLBACK_PARAM;
+	}
+	return PF_Err_NONE;
+}
+
+void CX_OfxReleaseImage(CX_OfxImage *image) {
+	if (image->props) g_cxOfx.effect->clipReleaseImage(image->props);
+	AEFX_CLR_STRUCT(*image);
+}
+
+static A_long PixelBytes(PF_PixelFormat format) {
+	switch (format) {
+		case PF_PixelFormat_ARGB64: return sizeof(PF_Pixel16);
+		case PF_PixelFormat_ARGB128: return sizeof(PF_PixelFloat);
+		default: return sizeof(PF_Pixel8);
+	}
+}
+
+PF_Err CX_OfxNewWorld(A_long width, A_long height, PF_PixelFormat format, PF_EffectWorld *world) {
+	AEFX_CLR_STRUCT(*world);
+	world->width = width;
+	world->height = height;
+	world->rowbytes = width * PixelBytes(format);
+	world->extent_hint.right = width;
+	world->extent_hint.bottom = height;
+	world->data = malloc(CX_MAX((size_t)world->rowbytes * height, (size_t)1));
+	return world->data ? PF_Err_NONE : PF_Err_OUT_OF_MEMORY;
+}
+
+void CX_OfxDisposeWorld(PF_EffectWorld *world) {
+	free(world->data);
+	world->data = NULL;
+}
+
+PF_LRect CX_OfxWorldRect(const OfxRectI *origin, const OfxRectI *rect) {
+	PF_LRect r;
+	r.left = rect->x1 - origin->x1;
+	r.right = rect->x2 - origin->x1;
+	r.top = origin->y2 - rect->y2;
+	r.bottom = origin->y2 - rect->y1;
+	return r;
+}
+
+// OFX RGBA pixels; 16-bit spans 0-65535 where AE uses 0-32768
+template <typename T> struct OfxRGBA { T r, g, b, a; };
+
+static inline void ImportPixel(const OfxRGBA<A_u_char> &s, PF_Pixel8 *d) {
+	d->alpha = s.a; d->red = s.r; d->green = s.g; d->blue = s.b;
+}
+static inline A_u_short Import16(A_u_short v) { return (A_u_short)((v * (A_u_long)PF_MAX_CHAN16 + 32767) / 65535); }
+static inline void ImportPixel(const OfxRGBA<A_u_short> &s, PF_Pixel16 *d) {
+	d->alpha = Import16(s.a); d->red = Import16(s.r); d->green = Import16(s.g); d->blue = Import16(s.b);
+}
+static inline void ImportPixel(const OfxRGBA<float> &s, PF_PixelFloat *d) {
+	d->alpha = s.a; d->red = s.r; d->green = s.g; d->blue = s.b;
+}
+
+static inline void ExportPixel(const PF_Pixel8 &s, OfxRGBA<A_u_char> *d) {
+	d->r = s.red; d->g = s.green; d->b = s.blue; d->a = s.alpha;
+}
+static inline A_u_short Export16(A_u_short v) {
+	return (A_u_short)((CX_MIN(v, (A_u_short)PF_MAX_CHAN16) * (A_u_long)65535 + PF_MAX_CHAN16 / 2) / PF_MAX_CHAN16);
+}
+static inline void ExportPixel(const PF_Pixel16 &s, OfxRGBA<A_u_short> *d) {
+	d->r = Export16(s.red); d->g = Export16(s.green); d->b = Export16(s.blue); d->a = Export16(s.alpha);
+}
+static inline void ExportPixel(const PF_PixelFloat &s, OfxRGBA<float> *d) {
+	d->r = s.red; d->g = s.green; d->b = s.blue; d->a = s.alpha;
+}
+
+template <typename OfxT, typename PixelT>
+static void CopyRect(const CX_OfxImage *image, const OfxRectI *origin, const OfxRectI *rect,
+					 const PF_EffectWorld *world, bool import) {
+	for (int y = rect->y1; y < rect->y2; y++) {
+		char *imageRow = (char*)image->data + (ptrdiff_t)(y - image->bounds.y1) * image->rowBytes;
+		OfxT *ofx = (OfxT*)imageRow + (rect->x1 - image->bounds.x1);
+		PixelT *pixel = CX_GetRow<PixelT>(world, origin->y2 - 1 - y) + (rect->x1 - origin->x1);
+		for (int x = rect->x1; x < rect->x2; x++, ofx++, pixel++) {
+			if (import) ImportPixel(*ofx, pixel);
+			else ExportPixel(*pixel, ofx);
+		}
+	}
+}
+
+static void CopyRectAnyDepth(const CX_OfxImage *image, const OfxRectI *origin, const OfxRectI *rect,
+							 const PF_EffectWorld *world, bool import) {
+	OfxRectI r = CX_OfxIntersect(CX_OfxIntersect(*rect, image->bounds), *origin);
+	switch (image->format) {
+		case PF_PixelFormat_ARGB32: CopyRect<OfxRGBA<A_u_char>, PF_Pixel8>(image, origin, &r, world, import); break;
+		case PF_PixelFormat_ARGB64: CopyRect<OfxRGBA<A_u_short>, PF_Pixel16>(image, origin, &r, world, import); break;
+		case PF_PixelFormat_ARGB128: CopyRect<OfxRGBA<float>, PF_PixelFloat>(image, origin, &r, world, import); break;
+	}
+}
+
+void CX_OfxImportRect(const CX_OfxImage *image, const OfxRectI *origin, const OfxRectI *rect, PF_EffectWorld *world) {
+	CopyRectAnyDepth(image, origin, rect, world, true);
+}
+
+void CX_OfxExportRect(const PF_EffectWorld *world, const OfxRectI *origin, const OfxRectI *rect, const CX_OfxImage *image) {
+	CopyRectAnyDepth(image, origin, rect, world, false);
+}
+
+// ============================================================================
+// Bundle Entry Points
+// ============================================================================
+
+OfxExport int OfxGetNumberOfPlugins(void) {
+	return 2;
+}
+
+OfxExport OfxPlugin* OfxGetPlugin(int nth) {
+	switch (nth) {
+		case 0: return CX_ColorLinesOfxPlugin();
+		case 1: return CX_PencilLineOfxPlugin();
+		default: return NULL;
+	}
+}
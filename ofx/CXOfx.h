@@ -0,0 +1,127 @@
+/*
+	CXOfx.h
+
+	CX Animation Tools - OpenFX adapter shared by the OFX plugins
+	Suites, CX_Host on the multithread suite, parameter helpers, and image
+	conversion between OFX images (RGBA, bottom-up rows, 16-bit 0-65535) and
+	the worlds the kernels use (ARGB, top-down rows, 16-bit 0-32768).
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_OFX_H
+#define CX_OFX_H
+
+#include "CXCommon.h"
+#include "CXHost.h"
+
+#include "ofxCore.h"
+#include "ofxImageEffect.h"
+#include "ofxMultiThread.h"
+#include "ofxParam.h"
+#include "ofxProperty.h"
+
+#define CX_OFX_GROUPING		CX_TOOLS_CATEGORY
+#define CX_OFX_SOURCE_CLIP	kOfxImageEffectSimpleSourceClipName
+#define CX_OFX_OUTPUT_CLIP	kOfxImageEffectOutputClipName
+
+// ============================================================================
+// Host and Suites
+// ============================================================================
+
+typedef struct {
+	OfxHost						*host;
+	const OfxPropertySuiteV1	*prop;
+	const OfxImageEffectSuiteV1	*effect;
+	const OfxParameterSuiteV1	*param;
+	const OfxMultiThreadSuiteV1	*thread;	// Optional; renders run serially without it
+} CX_OfxSuites;
+
+extern CX_OfxSuites g_cxOfx;
+
+void CX_OfxSetHost(OfxHost *host);
+
+// kOfxActionLoad: fails when a required suite is missing
+OfxStatus CX_OfxLoad();
+
+// Kernel host running jobs on the multithread suite
+CX_Host CX_MakeOfxHost();
+
+OfxStatus CX_OfxStatus(PF_Err err);
+
+// ============================================================================
+// Description
+// ============================================================================
+
+// Effect properties shared by all plugins: filter context, 8/16/32 bit,
+// tiles, fully thread safe (the kernels thread internally); temporal access
+// when the render reads frames t +/- 1
+OfxStatus CX_OfxDescribe(OfxImageEffectHandle effect, const char *label, bool temporalAccess);
+
+// Source and Output clips, RGBA, tiled
+OfxStatus CX_OfxDefineClips(OfxImageEffectHandle effect, bool temporalAccess);
+
+// Parameter definitions; parent is a group name or NULL
+void CX_OfxDefineGroup(OfxParamSetHandle params, const char *name, const char *label, bool open);
+void CX_OfxDefineDouble(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+						double min, double max, double displayMax, double dflt);
+void CX_OfxDefineInt(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+					 int min, int max, int dflt);
+void CX_OfxDefineBool(OfxParamSetHandle params, const char *name, const char *label, const char *parent, bool dflt);
+void CX_OfxDefineColor(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+					   double r, double g, double b);
+// options separated by '|' like AE popups; dflt is the 1-based AE popup value
+void CX_OfxDefineChoice(OfxParamSetHandle params, const char *name, const char *label, const char *parent,
+						const char *options, int dflt);
+
+// Parameter values at a time; choices come back 1-based like AE popups
+double CX_OfxGetDouble(OfxParamSetHandle params, const char *name, OfxTime time);
+A_long CX_OfxGetInt(OfxParamSetHandle params, const char *name, OfxTime time);
+PF_Boolean CX_OfxGetBool(OfxParamSetHandle params, const char *name, OfxTime time);
+A_long CX_OfxGetChoice(OfxParamSetHandle params, const char *name, OfxTime time);
+PF_Pixel CX_OfxGetColor(OfxParamSetHandle params, const char *name, OfxTime time);
+
+// ============================================================================
+// Images
+// ============================================================================
+
+typedef struct {
+	OfxPropertySetHandle	props;		// NULL when no image was fetched
+	void					*data;
+	OfxRectI				bounds;
+	int						rowBytes;
+	PF_PixelFormat			format;
+} CX_OfxImage;
+
+// Fetches a clip image; PF_Err_NONE with props NULL when the host has none at that time
+PF_Err CX_OfxFetchImage(OfxImageClipHandle clip, OfxTime time, CX_OfxImage *image);
+void CX_OfxReleaseImage(CX_OfxImage *image);
+
+// World of width x height in the kernels' layout; extent_hint covers it all
+PF_Err CX_OfxNewWorld(A_long width, A_long height, PF_PixelFormat format, PF_EffectWorld *world);
+void CX_OfxDisposeWorld(PF_EffectWorld *world);
+
+// Copies rect (OFX pixel coordinates) between an image and a world whose top-left
+// pixel is OFX pixel (origin.x1, origin.y2 - 1); both must share the format
+void CX_OfxImportRect(const CX_OfxImage *image, const OfxRectI *origin, const OfxRectI *rect, PF_EffectWorld *world);
+void CX_OfxExportRect(const PF_EffectWorld *world, const OfxRectI *origin, const OfxRectI *rect, const CX_OfxImage *image);
+
+// World rect (top-down) of an OFX pixel rect relative to origin
+PF_LRect CX_OfxWorldRect(const OfxRectI *origin, const OfxRectI *rect);
+
+static inline OfxRectI CX_OfxIntersect(const OfxRectI &a, const OfxRectI &b) {
+	OfxRectI r = { CX_MAX(a.x1, b.x1), CX_MAX(a.y1, b.y1), CX_MIN(a.x2, b.x2), CX_MIN(a.y2, b.y2) };
+	if (r.x2 < r.x1) r.x2 = r.x1;
+	if (r.y2 < r.y1) r.y2 = r.y1;
+	return r;
+}
+
+// ============================================================================
+// Plugins in this bundle
+// ============================================================================
+
+OfxPlugin* CX_ColorLinesOfxPlugin();
+OfxPlugin* CX_PencilLineOfxPlugin();
+
+#endif // CX_OFX_H
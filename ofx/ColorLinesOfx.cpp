@@ -0,0 +1,251 @@
+/*
+	ColorLinesOfx.cpp
+
+	cx_ColorLines as an OpenFX filter. Same parameters and render core as the
+	AE plugin (ColorLinesKernels.cpp); this file only maps OFX params, clips
+	and render windows onto ColorLinesInfo and the kernels' worlds.
+*/
+
+#include "CXOfx.h"
+#include "ColorLinesKernels.h"
+#include <stdio.h>
+
+#define COLORLINES_OFX_ID		"com.cxanimationtools.ColorLines"
+#define COLORLINES_OFX_LABEL	"cx_ColorLines"
+
+// Per-clip properties of the RoI and frames-needed actions
+#define COLORLINES_OFX_SOURCE_ROI		kOfxImageClipPropRoI "_" kOfxImageEffectSimpleSourceClipName
+#define COLORLINES_OFX_SOURCE_FRAMES	kOfxImageClipPropFrameRange "_" kOfxImageEffectSimpleSourceClipName
+
+// ============================================================================
+// Parameters (names are the scripting names; labels match the AE plugin)
+// ============================================================================
+
+#define GROUP_COLOR			"colorSelection"
+#define GROUP_FILL			"fillSettings"
+#define GROUP_ADJUST		"colorAdjustments"
+#define GROUP_OUTPUT		"output"
+
+static void ColorParamNames(A_long n, char *enabled, char *color, char *tolerance) {
+	sprintf(enabled, "useColor%d", (int)n);
+	sprintf(color, "targetColor%d", (int)n);
+	sprintf(tolerance, "colorTolerance%d", (int)n);
+}
+
+static OfxStatus DescribeInContext(OfxImageEffectHandle effect) {
+	OfxStatus stat = CX_OfxDefineClips(effect, true);
+	if (stat != kOfxStatOK) return stat;
+
+	OfxParamSetHandle params;
+	stat = g_cxOfx.effect->getParamSet(effect, &params);
+	if (stat != kOfxStatOK) return stat;
+
+	CX_OfxDefineGroup(params, GROUP_COLOR, "Color Selection", true);
+	CX_OfxDefineColor(params, "targetColor", "Target Color", GROUP_COLOR, 0.0, 0.0, 0.0);
+	CX_OfxDefineDouble(params, "colorTolerance", "Color Tolerance", GROUP_COLOR, TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_MAX, TOLERANCE_DFLT);
+	for (A_long n = 2; n <= COLORLINES_MAX_COLORS; n++) {
+		char enabled[32], color[32], tolerance[32], label[32];
+		ColorParamNames(n, enabled, color, tolerance);
+		sprintf(label, "Use Color %d", (int)n);
+		CX_OfxDefineBool(params, enabled, label, GROUP_COLOR, false);
+		sprintf(label, "Target Color %d", (int)n);
+		CX_OfxDefineColor(params, color, label, GROUP_COLOR, 0.0, 0.0, 0.0);
+		sprintf(label, "Color Tolerance %d", (int)n);
+		CX_OfxDefineDouble(params, tolerance, label, GROUP_COLOR, TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_MAX, TOLERANCE_DFLT);
+	}
+
+	CX_OfxDefineGroup(params, GROUP_FILL, "Fill Settings", true);
+	CX_OfxDefineChoice(params, "fillMode", "Fill Mode", GROUP_FILL, "Nearest Pixel|Average|Weighted Average|Membrane", FILL_MODE_WEIGHTED);
+	CX_OfxDefineInt(params, "searchRadius", "Search Radius", GROUP_FILL, SEARCH_RADIUS_MIN, SEARCH_RADIUS_MAX, SEARCH_RADIUS_DFLT);
+	CX_OfxDefineBool(params, "ignoreTransparent", "Ignore Transparent", GROUP_FILL, true);
+	CX_OfxDefineDouble(params, "sampleBlur", "Sample Blur", GROUP_FILL, SAMPLE_BLUR_MIN, SAMPLE_BLUR_MAX, SAMPLE_BLUR_MAX, SAMPLE_BLUR_DFLT);
+	CX_OfxDefineBool(params, "temporalFill", "Temporal Fill", GROUP_FILL, false);
+
+	CX_OfxDefineGroup(params, GROUP_ADJUST, "Color Adjustments", false);
+	CX_OfxDefineDouble(params, "brightness", "Brightness", GROUP_ADJUST, BRIGHTNESS_MIN, BRIGHTNESS_MAX, BRIGHTNESS_MAX, BRIGHTNESS_DFLT);
+	CX_OfxDefineDouble(params, "contrast", "Contrast", GROUP_ADJUST, CONTRAST_MIN, CONTRAST_MAX, CONTRAST_MAX, CONTRAST_DFLT);
+	CX_OfxDefineDouble(params, "saturation", "Saturation", GROUP_ADJUST, SATURATION_MIN, SATURATION_MAX, SATURATION_MAX, SATURATION_DFLT);
+
+	CX_OfxDefineGroup(params, GROUP_OUTPUT, "Output", true);
+	CX_OfxDefineChoice(params, "outputMode", "Output Mode", GROUP_OUTPUT, "Full Image|Lines Only|Background Only|Line Mask", OUTPUT_MODE_FULL);
+	CX_OfxDefineChoice(params, "distanceOutput", "Distance Output", GROUP_OUTPUT, "Off|Distance to Line|Distance to Fill Source", DISTANCE_OUTPUT_OFF);
+	CX_OfxDefineChoice(params, "distanceChannel", "Distance Channel", GROUP_OUTPUT, "Alpha|Red|Green|Blue", DISTANCE_CHANNEL_ALPHA);
+	CX_OfxDefineDouble(params, "distanceRange", "Distance Range", GROUP_OUTPUT, DISTANCE_RANGE_MIN, DISTANCE_RANGE_MAX, 200.0, DISTANCE_RANGE_DFLT);
+	return kOfxStatOK;
+}
+
+static void GetParams(OfxImageEffectHandle effect, OfxTime time, ColorLinesInfo *info) {
+	OfxParamSetHandle params;
+	g_cxOfx.effect->getParamSet(effect, &params);
+
+	info->colors[0].enabled = TRUE;
+	info->colors[0].color = CX_OfxGetColor(params, "targetColor", time);
+	info->colors[0].tolerance = CX_OfxGetDouble(params, "colorTolerance", time);
+	for (A_long n = 2; n <= COLORLINES_MAX_COLORS; n++) {
+		char enabled[32], color[32], tolerance[32];
+		ColorParamNames(n, enabled, color, tolerance);
+		info->colors[n - 1].enabled = CX_OfxGetBool(params, enabled, time);
+		info->colors[n - 1].color = CX_OfxGetColor(params, color, time);
+		info->colors[n - 1].tolerance = CX_OfxGetDouble(params, tolerance, time);
+	}
+
+	info->fillMode = CX_OfxGetChoice(params, "fillMode", time);
+	info->searchRadius = CX_OfxGetInt(params, "searchRadius", time);
+	info->ignoreTransparent = CX_OfxGetBool(params, "ignoreTransparent", time);
+	info->sampleBlur = CX_OfxGetDouble(params, "sampleBlur", time);
+	info->temporalFill = CX_OfxGetBool(params, "temporalFill", time);
+	info->brightness = CX_OfxGetDouble(params, "brightness", time);
+	info->contrast = CX_OfxGetDouble(params, "contrast", time);
+	info->saturation = CX_OfxGetDouble(params, "saturation", time);
+	info->outputMode = CX_OfxGetChoice(params, "outputMode", time);
+	info->distanceOutput = CX_OfxGetChoice(params, "distanceOutput", time);
+	info->distanceChannel = CX_OfxGetChoice(params, "distanceChannel", time);
+	info->distanceRange = CX_OfxGetDouble(params, "distanceRange", time);
+
+	// Adjacent frames are only read by the fill (not Line Mask or Background Only)
+	ColorLinesStages stages;
+	ColorLinesPlanStages(info, &stages);
+	info->temporalFill = stages.temporal;
+}
+
+// ============================================================================
+// Actions
+// ============================================================================
+
+// Fill searches, the membrane solve and the distance field read the whole
+// source frame whatever the render window is
+static OfxStatus GetRegionsOfInterest(OfxImageEffectHandle effect, OfxPropertySetHandle inArgs, OfxPropertySetHandle outArgs) {
+	OfxTime time = 0;
+	g_cxOfx.prop->propGetDouble(inArgs, kOfxPropTime, 0, &time);
+
+	OfxImageClipHandle sourceClip;
+	OfxRectD rod;
+	OfxStatus stat = g_cxOfx.effect->clipGetHandle(effect, CX_OFX_SOURCE_CLIP, &sourceClip, NULL);
+	if (stat == kOfxStatOK) stat = g_cxOfx.effect->clipGetRegionOfDefinition(sourceClip, time, &rod);
+	if (stat != kOfxStatOK) return kOfxStatReplyDefault;
+	g_cxOfx.prop->propSetDoubleN(outArgs, COLORLINES_OFX_SOURCE_ROI, 4, &rod.x1);
+	return kOfxStatOK;
+}
+
+static OfxStatus GetFramesNeeded(OfxImageEffectHandle effect, OfxPropertySetHandle inArgs, OfxPropertySetHandle outArgs) {
+	OfxTime time = 0;
+	g_cxOfx.prop->propGetDouble(inArgs, kOfxPropTime, 0, &time);
+
+	ColorLinesInfo info;
+	AEFX_CLR_STRUCT(info);
+	GetParams(effect, time, &info);
+	if (!info.temporalFill) return kOfxStatReplyDefault;
+
+	double range[2] = { time - 1.0, time + 1.0 };
+	g_cxOfx.prop->propSetDoubleN(outArgs, COLORLINES_OFX_SOURCE_FRAMES, 2, range);
+	return kOfxStatOK;
+}
+
+// Adjacent frame for temporal fill; only frames matching the current one can be sampled
+static PF_Err FetchAdjacentFrame(OfxImageClipHandle clip, OfxTime time, const CX_OfxImage *source,
+								 CX_OfxImage *image, PF_EffectWorld *world, PF_EffectWorld **worldP) {
+	PF_Err err = CX_OfxFetchImage(clip, time, image);
+	if (err || !image->props) return PF_Err_NONE;
+
+	const OfxRectI &a = image->bounds, &b = source->bounds;
+	if (image->format == source->format && a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2) {
+		err = CX_OfxNewWorld(b.x2 - b.x1, b.y2 - b.y1, source->format, world);
+		if (!err) {
+			CX_OfxImportRect(image, &b, &b, world);
+			*worldP = world;
+		}
+	}
+	CX_OfxReleaseImage(image);
+	return err;
+}
+
+static OfxStatus Render(OfxImageEffectHandle effect, OfxPropertySetHandle inArgs) {
+	OfxTime time = 0;
+	OfxRectI window = { 0, 0, 0, 0 };
+	int draft = 0;
+	g_cxOfx.prop->propGetDouble(inArgs, kOfxPropTime, 0, &time);
+	g_cxOfx.prop->propGetIntN(inArgs, kOfxImageEffectPropRenderWindow, 4, &window.x1);
+	g_cxOfx.prop->propGetInt(inArgs, kOfxImageEffectPropRenderQualityDraft, 0, &draft);	// OFX 1.4; stays 0 on older hosts
+
+	ColorLinesInfo info;
+	AEFX_CLR_STRUCT(info);
+	GetParams(effect, time, &info);
+	info.quality = draft ? PF_Quality_LO : PF_Quality_HI;
+
+	OfxImageClipHandle sourceClip = NULL, outputClip = NULL;
+	g_cxOfx.effect->clipGetHandle(effect, CX_OFX_SOURCE_CLIP, &sourceClip, NULL);
+	g_cxOfx.effect->clipGetHandle(effect, CX_OFX_OUTPUT_CLIP, &outputClip, NULL);
+
+	CX_OfxImage source, output, adjacent;
+	PF_EffectWorld inWorld, outWorld, prevWorld, nextWorld;
+	AEFX_CLR_STRUCT(inWorld);
+	AEFX_CLR_STRUCT(outWorld);
+	AEFX_CLR_STRUCT(prevWorld);
+	AEFX_CLR_STRUCT(nextWorld);
+	AEFX_CLR_STRUCT(output);
+
+	PF_Err err = CX_OfxFetchImage(sourceClip, time, &source);
+	if (!err && !source.props) err = PF_Err_BAD_CALLBACK_PARAM;
+	if (!err) err = CX_OfxFetchImage(outputClip, time, &output);
+	if (!err && (!output.props || output.format != source.format)) err = PF_Err_BAD_CALLBACK_PARAM;
+
+	// Worlds span the whole source frame; only the render window is written back
+	const OfxRectI frame = source.bounds;
+	if (!err) err = CX_OfxNewWorld(frame.x2 - frame.x1, frame.y2 - frame.y1, source.format, &inWorld);
+	if (!err) err = CX_OfxNewWorld(frame.x2 - frame.x1, frame.y2 - frame.y1, source.format, &outWorld);
+	if (!err) CX_OfxImportRect(&source, &frame, &frame, &inWorld);
+
+	if (!err && info.temporalFill) {
+		err = FetchAdjacentFrame(sourceClip, time - 1.0, &source, &adjacent, &prevWorld, &info.prevWorld);
+		if (!err) err = FetchAdjacentFrame(sourceClip, time + 1.0, &source, &adjacent, &nextWorld, &info.nextWorld);
+	}
+
+	// Sample Blur averages filled pixels up to its radius away, so the
+	// kernels also fill that margin around the window when the blur runs
+	ColorLinesStages stages;
+	ColorLinesPlanStages(&info, &stages);
+	const OfxRectI render = CX_OfxIntersect(window, frame);
+	const A_long margin = stages.blurRadius;
+	const OfxRectI padded = { render.x1 - margin, render.y1 - margin, render.x2 + margin, render.y2 + margin };
+	const OfxRectI area = CX_OfxIntersect(padded, frame);
+	outWorld.extent_hint = CX_OfxWorldRect(&frame, &area);
+
+	if (!err && render.x2 > render.x1 && render.y2 > render.y1) {
+		CX_Host host = CX_MakeOfxHost();
+		err = ColorLinesRender(&host, &info, source.format, &inWorld, &outWorld);
+		if (!err) CX_OfxExportRect(&outWorld, &frame, &render, &output);
+	}
+
+	CX_OfxDisposeWorld(&inWorld);
+	CX_OfxDisposeWorld(&outWorld);
+	CX_OfxDisposeWorld(&prevWorld);
+	CX_OfxDisposeWorld(&nextWorld);
+	CX_OfxReleaseImage(&output);
+	CX_OfxReleaseImage(&source);
+	return CX_OfxStatus(err);
+}
+
+static OfxStatus ColorLinesMain(const char *action, const void *handle, OfxPropertySetHandle inArgs, OfxPropertySetHandle outArgs) {
+	OfxImageEffectHandle effect = (OfxImageEffectHandle)handle;
+	if (strcmp(action, kOfxActionLoad) == 0) return CX_OfxLoad();
+	if (strcmp(action, kOfxActionDescribe) == 0) return CX_OfxDescribe(effect, COLORLINES_OFX_LABEL, true);
+	if (strcmp(action, kOfxImageEffectActionDescribeInContext) == 0) return DescribeInContext(effect);
+	if (strcmp(action, kOfxImageEffectActionRender) == 0) return Render(effect, inArgs);
+	if (strcmp(action, kOfxImageEffectActionGetRegionsOfInterest) == 0) return GetRegionsOfInterest(effect, inArgs, outArgs);
+	if (strcmp(action, kOfxImageEffectActionGetFramesNeeded) == 0) return GetFramesNeeded(effect, inArgs, outArgs);
+	return kOfxStatReplyDefault;
+}
+
+static OfxPlugin s_colorLinesPlugin = {
+	kOfxImageEffectPluginApi,
+	1,
+	COLORLINES_OFX_ID,
+	CX_TOOLS_VERSION_MAJOR,
+	CX_TOOLS_VERSION_MINOR,
+	CX_OfxSetHost,
+	ColorLinesMain
+};
+
+OfxPlugin* CX_ColorLinesOfxPlugin() {
+	return &s_colorLinesPlugin;
+}
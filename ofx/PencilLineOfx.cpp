@@ -0,0 +1,213 @@
+/*
+ * PencilLineOfx.cpp
+ * cx_PencilLine as an OpenFX filter
+ *
+ * Same parameters and render core as the AE plugin (PencilLineKernels.cpp).
+ * The effect is pixel-local, so each render window is converted and
+ * processed on its own and the default region of interest applies; the
+ * window origin keeps the grain continuous across windows.
+ */
+
+#include "CXOfx.h"
+#include "PencilLineKernels.h"
+#include <cstdio>
+
+#define PENCILLINE_OFX_ID       "com.cxanimationtools.PencilLine"
+#define PENCILLINE_OFX_LABEL    "cx_PencilLine"
+
+#define GROUP_COLOR             "colorSelection"
+#define GROUP_TEXTURE           "pencilTexture"
+#define GROUP_OUTPUT            "output"
+
+// ============================================================================
+// Parameters (names are the scripting names; labels match the AE plugin)
+// ============================================================================
+
+static void ColorParamNames(A_long n, char* enabled, char* color, char* tolerance)
+{
+    snprintf(enabled, 32, "color%d", (int)n);
+    snprintf(color, 32, "color%dValue", (int)n);
+    snprintf(tolerance, 32, "tolerance%d", (int)n);
+}
+
+static void RecolorParamNames(A_long n, char* recolor, char* newColor)
+{
+    snprintf(recolor, 32, "recolor%d", (int)n);
+    snprintf(newColor, 32, "recolor%dValue", (int)n);
+}
+
+static void TextureParamNames(A_long n, char* custom, char* width, char* density, char* strength)
+{
+    snprintf(custom, 32, "texture%d", (int)n);
+    snprintf(width, 32, "lineWidth%d", (int)n);
+    snprintf(density, 32, "lineDensity%d", (int)n);
+    snprintf(strength, 32, "textureStrength%d", (int)n);
+}
+
+static OfxStatus DescribeInContext(OfxImageEffectHandle effect)
+{
+    OfxStatus stat = CX_OfxDefineClips(effect, false);
+    if (stat != kOfxStatOK) return stat;
+
+    OfxParamSetHandle params;
+    stat = g_cxOfx.effect->getParamSet(effect, &params);
+    if (stat != kOfxStatOK) return stat;
+
+    CX_OfxDefineGroup(params, GROUP_COLOR, "Color Selection", false);
+    for (A_long n = 1; n <= MAX_COLORS; ++n) {
+        char enabled[32], color[32], tolerance[32], recolor[32], newColor[32], label[32];
+        char custom[32], width[32], density[32], strength[32];
+        ColorParamNames(n, enabled, color, tolerance);
+        RecolorParamNames(n, recolor, newColor);
+        TextureParamNames(n, custom, width, density, strength);
+        snprintf(label, sizeof(label), "Color %d", (int)n);
+        CX_OfxDefineBool(params, enabled, label, GROUP_COLOR, n == 1);
+        snprintf(label, sizeof(label), "  Color %d", (int)n);
+        CX_OfxDefineColor(params, color, label, GROUP_COLOR, 0.0, 0.0, 0.0);
+        snprintf(label, sizeof(label), "  Tolerance %d", (int)n);
+        CX_OfxDefineDouble(params, tolerance, label, GROUP_COLOR, TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_MAX, DEFAULT_TOLERANCE);
+        snprintf(label, sizeof(label), "  Recolor %d", (int)n);
+        CX_OfxDefineBool(params, recolor, label, GROUP_COLOR, false);
+        snprintf(label, sizeof(label), "  New Color %d", (int)n);
+        CX_OfxDefineColor(params, newColor, label, GROUP_COLOR, 0.0, 0.0, 0.0);
+        snprintf(label, sizeof(label), "  Custom Texture %d", (int)n);
+        CX_OfxDefineBool(params, custom, label, GROUP_COLOR, false);
+        snprintf(label, sizeof(label), "  Line Width %d", (int)n);
+        CX_OfxDefineInt(params, width, label, GROUP_COLOR, LINE_WIDTH_MIN, LINE_WIDTH_MAX, DEFAULT_LINE_WIDTH);
+        snprintf(label, sizeof(label), "  Line Density %d", (int)n);
+        CX_OfxDefineDouble(params, density, label, GROUP_COLOR,
+                           LINE_DENSITY_MIN, LINE_DENSITY_MAX, LINE_DENSITY_MAX, DEFAULT_LINE_DENSITY);
+        snprintf(label, sizeof(label), "  Texture Strength %d", (int)n);
+        CX_OfxDefineDouble(params, strength, label, GROUP_COLOR,
+                           TEXTURE_STRENGTH_MIN, TEXTURE_STRENGTH_MAX, TEXTURE_STRENGTH_MAX, DEFAULT_CUSTOM_TEXTURE_STRENGTH);
+    }
+
+    CX_OfxDefineGroup(params, GROUP_TEXTURE, "Pencil Texture", false);
+    CX_OfxDefineInt(params, "lineWidth", "Line Width", GROUP_TEXTURE, LINE_WIDTH_MIN, LINE_WIDTH_MAX, DEFAULT_LINE_WIDTH);
+    CX_OfxDefineDouble(params, "lineDensity", "Line Density", GROUP_TEXTURE,
+                       LINE_DENSITY_MIN, LINE_DENSITY_MAX, LINE_DENSITY_MAX, DEFAULT_LINE_DENSITY);
+    // Not "textureStrength": 1.0 saved that at 50 while the texture was a no-op
+    CX_OfxDefineDouble(params, "globalTextureStrength", "Texture Strength", GROUP_TEXTURE,
+                       TEXTURE_STRENGTH_MIN, TEXTURE_STRENGTH_MAX, TEXTURE_STRENGTH_MAX, DEFAULT_TEXTURE_STRENGTH);
+
+    CX_OfxDefineGroup(params, GROUP_OUTPUT, "Output", false);
+    CX_OfxDefineChoice(params, "outputMode", "Output Mode", GROUP_OUTPUT, "Full|Line Only|Background Only", OUTPUT_MODE_FULL);
+    return kOfxStatOK;
+}
+
+static void GetParams(OfxImageEffectHandle effect, OfxTime time, PencilLineInfo* info)
+{
+    OfxParamSetHandle params;
+    g_cxOfx.effect->getParamSet(effect, &params);
+
+    info->colorCount = MAX_COLORS;
+    for (A_long i = 0; i < MAX_COLORS; ++i) {
+        char enabled[32], color[32], tolerance[32], recolor[32], newColor[32];
+        char custom[32], width[32], density[32], strength[32];
+        ColorParamNames(i + 1, enabled, color, tolerance);
+        RecolorParamNames(i + 1, recolor, newColor);
+        TextureParamNames(i + 1, custom, width, density, strength);
+        info->colors[i].enabled = CX_OfxGetBool(params, enabled, time);
+        info->colors[i].color = CX_OfxGetColor(params, color, time);
+        info->colors[i].tolerance = CX_OfxGetDouble(params, tolerance, time);
+        info->colors[i].toleranceSq = CX_ToleranceToDistSq(info->colors[i].tolerance);
+        info->colors[i].recolor = CX_OfxGetBool(params, recolor, time);
+        info->colors[i].newColor = CX_OfxGetColor(params, newColor, time);
+        info->colors[i].customTexture = CX_OfxGetBool(params, custom, time);
+        info->colors[i].lineWidth = CX_OfxGetInt(params, width, time);
+        info->colors[i].lineDensity = CX_OfxGetDouble(params, density, time);
+        info->colors[i].textureStrength = CX_OfxGetDouble(params, strength, time);
+    }
+
+    info->lineWidth = CX_OfxGetInt(params, "lineWidth", time);
+    info->lineDensity = CX_OfxGetDouble(params, "lineDensity", time);
+    info->textureStrength = CX_OfxGetDouble(params, "globalTextureStrength", time);
+    info->outputMode = CX_OfxGetChoice(params, "outputMode", time);
+}
+
+// ============================================================================
+// Actions
+// ============================================================================
+
+static OfxStatus Render(OfxImageEffectHandle effect, OfxPropertySetHandle inArgs)
+{
+    OfxTime time = 0;
+    OfxRectI window = { 0, 0, 0, 0 };
+    double scale[2] = { 1.0, 1.0 };
+    g_cxOfx.prop->propGetDouble(inArgs, kOfxPropTime, 0, &time);
+    g_cxOfx.prop->propGetIntN(inArgs, kOfxImageEffectPropRenderWindow, 4, &window.x1);
+    g_cxOfx.prop->propGetDoubleN(inArgs, kOfxImageEffectPropRenderScale, 2, scale);
+
+    PencilLineInfo info;
+    memset(&info, 0, sizeof(PencilLineInfo));
+    GetParams(effect, time, &info);
+
+    // Proxy renders pick the grain mip level from the render scale
+    info.downsampleX = scale[0] > 0.0 ? CX_MAX(1, static_cast<A_long>(1.0 / scale[0] + 0.5)) : 1;
+    info.downsampleY = scale[1] > 0.0 ? CX_MAX(1, static_cast<A_long>(1.0 / scale[1] + 0.5)) : 1;
+
+    OfxImageClipHandle sourceClip = nullptr, outputClip = nullptr;
+    g_cxOfx.effect->clipGetHandle(effect, CX_OFX_SOURCE_CLIP, &sourceClip, nullptr);
+    g_cxOfx.effect->clipGetHandle(effect, CX_OFX_OUTPUT_CLIP, &outputClip, nullptr);
+
+    CX_OfxImage source, output;
+    PF_EffectWorld inWorld, outWorld;
+    AEFX_CLR_STRUCT(inWorld);
+    AEFX_CLR_STRUCT(outWorld);
+    AEFX_CLR_STRUCT(output);
+
+    PF_Err err = CX_OfxFetchImage(sourceClip, time, &source);
+    if (!err && !source.props) err = PF_Err_BAD_CALLBACK_PARAM;
+    ERR(CX_OfxFetchImage(outputClip, time, &output));
+    if (!err && (!output.props || output.format != source.format)) err = PF_Err_BAD_CALLBACK_PARAM;
+
+    // Worlds cover just the render window
+    const OfxRectI render = CX_OfxIntersect(CX_OfxIntersect(window, source.bounds), output.bounds);
+    ERR(CX_OfxNewWorld(render.x2 - render.x1, render.y2 - render.y1, source.format, &inWorld));
+    ERR(CX_OfxNewWorld(render.x2 - render.x1, render.y2 - render.y1, source.format, &outWorld));
+
+    if (!err) {
+        // World rows run top-down from render.y2 - 1; keep the grain fixed to the image
+        info.originX = render.x1;
+        info.originY = 1 - render.y2;
+        CX_OfxImportRect(&source, &render, &render, &inWorld);
+        CX_Host host = CX_MakeOfxHost();
+        ERR(PencilLineRender(&host, &info, source.format, &inWorld, &outWorld));
+        if (!err) CX_OfxExportRect(&outWorld, &render, &render, &output);
+    }
+
+    CX_OfxDisposeWorld(&inWorld);
+    CX_OfxDisposeWorld(&outWorld);
+    CX_OfxReleaseImage(&output);
+    CX_OfxReleaseImage(&source);
+    return CX_OfxStatus(err);
+}
+
+static OfxStatus PencilLineMain(
+    const char*             action,
+    const void*             handle,
+    OfxPropertySetHandle    inArgs,
+    OfxPropertySetHandle    outArgs)
+{
+    OfxImageEffectHandle effect = (OfxImageEffectHandle)handle;
+    if (strcmp(action, kOfxActionLoad) == 0) return CX_OfxLoad();
+    if (strcmp(action, kOfxActionDescribe) == 0) return CX_OfxDescribe(effect, PENCILLINE_OFX_LABEL, false);
+    if (strcmp(action, kOfxImageEffectActionDescribeInContext) == 0) return DescribeInContext(effect);
+    if (strcmp(action, kOfxImageEffectActionRender) == 0) return Render(effect, inArgs);
+    return kOfxStatReplyDefault;
+}
+
+static OfxPlugin s_pencilLinePlugin = {
+    kOfxImageEffectPluginApi,
+    1,
+    PENCILLINE_OFX_ID,
+    CX_TOOLS_VERSION_MAJOR,
+    CX_TOOLS_VERSION_MINOR,
+    CX_OfxSetHost,
+    PencilLineMain
+};
+
+OfxPlugin* CX_PencilLineOfxPlugin()
+{
+    return &s_pencilLinePlugin;
+}
@@ -0,0 +1,239 @@
+# pgo.ps1
+# Builds profile-guided optimized Release kernels, trained on the committed cx_train workload
+#
+# Usage:
+#   powershell -ExecutionPolicy Bypass -File pgo.ps1
+#   powershell -ExecutionPolicy Bypass -File pgo.ps1 -Project train_8bpc.aep,train_16bpc.aep,train_32bpc.aep
+#
+# libcx_kernels (capi\) is built instrumented and trained with cx_train: synthetic line art
+# through every ColorLines Fill Mode at Search Radius 3 / 10 / 25 / 50, Sample Blur, each
+# Output Mode, Distance Output, Temporal Fill, a Color Tolerance dial and PencilLine, at
+# 8 / 16 / 32 bpc. cx_train then times the plain and the optimized library (best of -Reps),
+# so the gain is measured on the same workload. Output goes to build-pgo\.
+#
+# The .aex plugins keep their profile per image, so training them needs AE itself. With
+# -Project the script also trains them through aerender (the plugins must already be
+# deployed, deploy.ps1); the projects should queue comps covering the workload above,
+# one project per bit depth (bit depth is a project setting).
+
+param(
+    [string[]]$Project = @(),
+    [string]$AEVersion = "2025",
+    [int]$Iterations = 1,
+    [int]$Reps = 3,
+    [switch]$SkipBaseline
+)
+
+# Configuration
+$ScriptDir = Split-Path -Parent $MyInvocation.MyCommand.Path
+$Solution = Join-Path $ScriptDir "win\CX-AE-Plugins.sln"
+$CApiDir = Join-Path $ScriptDir "capi"
+$BuildDir = Join-Path $ScriptDir "build-pgo"
+$PgoDir = Join-Path $ScriptDir "pgo"
+$AERender = "C:\Program Files\Adobe\Adobe After Effects $AEVersion\Support Files\aerender.exe"
+
+Write-Host "============================================" -ForegroundColor Cyan
+Write-Host "  CX AE Plugins PGO Build" -ForegroundColor Cyan
+Write-Host "============================================" -ForegroundColor Cyan
+Write-Host ""
+
+# Locate MSBuild and the PGO runtime through vswhere
+$VsWhere = "${env:ProgramFiles(x86)}\Microsoft Visual Studio\Installer\vswhere.exe"
+if (-not (Test-Path $VsWhere)) {
+    Write-Host "ERROR: vswhere.exe not found. Is Visual Studio 2022 installed?" -ForegroundColor Red
+    exit 1
+}
+$VsPath = & $VsWhere -latest -requires Microsoft.VisualStudio.Component.VC.Tools.x86.x64 -property installationPath
+$MSBuild = Join-Path $VsPath "MSBuild\Current\Bin\MSBuild.exe"
+$PgoRuntime = Get-ChildItem -Path (Join-Path $VsPath "VC\Tools\MSVC") -Recurse -Filter "pgort140.dll" |
+    Where-Object { $_.DirectoryName -like "*Hostx64\x64" } | Select-Object -First 1
+
+if (-not (Get-Command cmake -ErrorAction SilentlyContinue)) {
+    Write-Host "ERROR: cmake not found on PATH" -ForegroundColor Red
+    exit 1
+}
+if (-not (Test-Path $MSBuild)) {
+    Write-Host "ERROR: MSBuild not found at: $MSBuild" -ForegroundColor Red
+    exit 1
+}
+if (-not $PgoRuntime) {
+    Write-Host "ERROR: pgort140.dll not found under: $VsPath" -ForegroundColor Red
+    exit 1
+}
+if ($Project.Count -gt 0 -and -not (Test-Path $AERender)) {
+    Write-Host "ERROR: aerender not found at: $AERender" -ForegroundColor Red
+    Write-Host "Use -AEVersion parameter to specify a different version." -ForegroundColor Yellow
+    exit 1
+}
+foreach ($proj in $Project) {
+    if (-not (Test-Path $proj)) {
+        Write-Host "ERROR: Training project not found: $proj" -ForegroundColor Red
+        exit 1
+    }
+}
+
+# Instrumented binaries need pgort140.dll on PATH
+$env:PATH = "$($PgoRuntime.DirectoryName);$env:PATH"
+
+# ============================================
+# Kernels: libcx_kernels trained with cx_train
+# ============================================
+
+function Invoke-CMakeBuild([string]$Dir, [string]$PgoMode) {
+    Write-Host "Building libcx_kernels Release (CX_PGO='$PgoMode')..." -ForegroundColor Yellow
+    & cmake -S $CApiDir -B $Dir -A x64 "-DCX_PGO=$PgoMode" -DCX_BUILD_TESTS=OFF | Out-Null
+    if ($LASTEXITCODE -eq 0) { & cmake --build $Dir --config Release --target cx_train -- /nologo /v:minimal /m }
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "ERROR: CMake build failed (CX_PGO='$PgoMode')" -ForegroundColor Red
+        exit 1
+    }
+}
+
+# Runs cx_train and returns its best times in ms per bit depth and "total"
+function Invoke-Train([string]$Dir, [string]$Label, [int]$Reps) {
+    Write-Host "  [$Label] cx_train --reps $Reps" -ForegroundColor Gray
+    $lines = & (Join-Path $Dir "Release\cx_train.exe") --reps $Reps
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "ERROR: cx_train failed ($Label)" -ForegroundColor Red
+        exit 1
+    }
+    $times = [ordered]@{}
+    foreach ($line in $lines) {
+        if ($line -match '^cx_train\s+(\S+)\s+([\d.]+) ms') { $times[$Matches[1]] = [double]$Matches[2] }
+    }
+    return $times
+}
+
+$BaseDir = Join-Path $BuildDir "base"
+$KernelDir = Join-Path $BuildDir "pgo"
+
+# 1. Baseline timings with the plain Release library
+$kernelBaseline = $null
+if (-not $SkipBaseline) {
+    Invoke-CMakeBuild $BaseDir ""
+    $kernelBaseline = Invoke-Train $BaseDir "baseline" $Reps
+}
+
+# 2. Instrumented library + training run (profiles land next to cx_kernels.dll)
+if (Test-Path $KernelDir) {
+    Get-ChildItem -Path $KernelDir -Include "*.pgc", "*.pgd" -Recurse | Remove-Item -Force
+}
+Invoke-CMakeBuild $KernelDir "Instrument"
+Invoke-Train $KernelDir "training" 1 | Out-Null
+
+$pgcCount = (Get-ChildItem -Path (Join-Path $KernelDir "Release") -Filter "*.pgc" | Measure-Object).Count
+if ($pgcCount -eq 0) {
+    Write-Host "ERROR: No .pgc profiles were written under: $KernelDir" -ForegroundColor Red
+    exit 1
+}
+Write-Host "Collected $pgcCount kernel profile(s)" -ForegroundColor Green
+
+# 3. Optimized library (same build directory, so the link finds the profiles)
+Invoke-CMakeBuild $KernelDir "Optimize"
+
+# 4. Gain on the training workload
+if ($kernelBaseline) {
+    $kernelOptimized = Invoke-Train $KernelDir "pgo" $Reps
+    Write-Host ""
+    Write-Host ("{0,-32} {1,12} {2,12} {3,8}" -f "cx_train", "Release (ms)", "PGO (ms)", "Gain") -ForegroundColor Cyan
+    foreach ($key in $kernelBaseline.Keys) {
+        $b = $kernelBaseline[$key]
+        $o = $kernelOptimized[$key]
+        $gain = ($b - $o) / $b * 100.0
+        Write-Host ("{0,-32} {1,12:F1} {2,12:F1} {3,7:F1}%" -f $key, $b, $o, $gain)
+    }
+    Write-Host ""
+}
+
+if ($Project.Count -eq 0) {
+    Write-Host ""
+    Write-Host "============================================" -ForegroundColor Cyan
+    Write-Host "  PGO Build Complete!" -ForegroundColor Green
+    Write-Host "  Optimized libcx_kernels is in build-pgo\pgo\Release\" -ForegroundColor Green
+    Write-Host "  Pass -Project to also train the .aex plugins through aerender" -ForegroundColor Green
+    Write-Host "============================================" -ForegroundColor Cyan
+    exit 0
+}
+
+# ============================================
+# AE plugins (optional): trained through aerender
+# ============================================
+
+function Invoke-Build([string]$PgoMode, [string]$Target) {
+    Write-Host "Building Release|x64 (CX_PGO='$PgoMode', $Target)..." -ForegroundColor Yellow
+    & $MSBuild $Solution /nologo /v:minimal /m "/t:$Target" /p:Configuration=Release /p:Platform=x64 "/p:CX_PGO=$PgoMode"
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "ERROR: Build failed (CX_PGO='$PgoMode')" -ForegroundColor Red
+        exit 1
+    }
+}
+
+# Renders every training project and returns wall-clock seconds per project
+function Invoke-Workload([string]$Label) {
+    $times = @{}
+    foreach ($proj in $Project) {
+        $best = [double]::MaxValue
+        for ($i = 0; $i -lt $Iterations; $i++) {
+            Write-Host "  [$Label] $([IO.Path]::GetFileName($proj)) ($($i + 1)/$Iterations)" -ForegroundColor Gray
+            $sw = [Diagnostics.Stopwatch]::StartNew()
+            & $AERender -project (Resolve-Path $proj) -sound OFF | Out-Null
+            $sw.Stop()
+            if ($LASTEXITCODE -ne 0) {
+                Write-Host "ERROR: aerender failed on: $proj" -ForegroundColor Red
+                exit 1
+            }
+            if ($sw.Elapsed.TotalSeconds -lt $best) { $best = $sw.Elapsed.TotalSeconds }
+        }
+        $times[$proj] = $best
+    }
+    return $times
+}
+
+# 5. Baseline timings with the plain Release build
+$baseline = $null
+if (-not $SkipBaseline) {
+    Invoke-Build "" "Rebuild"
+    $baseline = Invoke-Workload "baseline"
+}
+
+# 6. Instrumented build + training run
+if (-not (Test-Path $PgoDir)) {
+    New-Item -ItemType Directory -Path $PgoDir -Force | Out-Null
+}
+Get-ChildItem -Path $PgoDir -Include "*.pgc", "*.pgd" -Recurse | Remove-Item -Force
+Invoke-Build "Instrument" "Rebuild"
+
+Invoke-Workload "training" | Out-Null
+
+$pgcCount = (Get-ChildItem -Path $PgoDir -Filter "*.pgc" | Measure-Object).Count
+if ($pgcCount -eq 0) {
+    Write-Host "ERROR: No .pgc profiles were written to: $PgoDir" -ForegroundColor Red
+    Write-Host "Check that AE loaded the plugins from output\ (run deploy.ps1)." -ForegroundColor Yellow
+    exit 1
+}
+Write-Host "Collected $pgcCount plugin profile(s)" -ForegroundColor Green
+
+# 7. Optimized build (Build, not Rebuild: a clean would delete the .pgd)
+Invoke-Build "Optimize" "Build"
+
+# 8. Report gain over the non-PGO build
+if ($baseline) {
+    $optimized = Invoke-Workload "pgo"
+    Write-Host ""
+    Write-Host ("{0,-32} {1,12} {2,12} {3,8}" -f "Project", "Release (s)", "PGO (s)", "Gain") -ForegroundColor Cyan
+    foreach ($proj in $Project) {
+        $b = $baseline[$proj]
+        $o = $optimized[$proj]
+        $gain = ($b - $o) / $b * 100.0
+        Write-Host ("{0,-32} {1,12:F2} {2,12:F2} {3,7:F1}%" -f [IO.Path]::GetFileName($proj), $b, $o, $gain)
+    }
+    Write-Host ""
+    Write-Host "Times include aerender startup; use -Iterations and long comps for stable numbers." -ForegroundColor Yellow
+}
+
+Write-Host ""
+Write-Host "============================================" -ForegroundColor Cyan
+Write-Host "  PGO Build Complete!" -ForegroundColor Green
+Write-Host "  Optimized libcx_kernels is in build-pgo\pgo\Release\" -ForegroundColor Green
+Write-Host "  Optimized plugins are in output\" -ForegroundColor Green
+Write-Host "============================================" -ForegroundColor Cyan
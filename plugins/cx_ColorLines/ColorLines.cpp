@@ -4,985 +4,12 @@
 	AE Plugin for Animation Composition - Color Line Extraction and Fill
 	Supports 8-bit, 16-bit, and 32-bit float color processing
 
-	Optimized for performance:
-	- Precomputed lookup tables for distance weights
-	- Squared distance comparisons (avoid sqrt)
-	- Cached row pointers for faster pixel access
-	- Precomputed color adjustment factors
+	Parameters, pre-render and layer checkout; the render itself lives in
+	ColorLinesKernels.cpp and runs on the AE iterate suite through CX_Host.
 */
 
 #include "ColorLines.h"
-#include <math.h>
-#include <stdlib.h>
-#include <string.h>
-
-// ============================================================================
-// Precomputed Tables and Constants
-// ============================================================================
-
-// Maximum search radius for weight table
-#define MAX_WEIGHT_TABLE_RADIUS 50
-#define WEIGHT_TABLE_SIZE ((MAX_WEIGHT_TABLE_RADIUS * 2 + 1) * (MAX_WEIGHT_TABLE_RADIUS * 2 + 1))
-
-// Precomputed inverse distance weights for weighted average mode
-// Index: (dy + radius) * (radius * 2 + 1) + (dx + radius)
-static PF_FpLong g_invDistWeights[WEIGHT_TABLE_SIZE];
-static PF_FpLong g_gaussianWeights[WEIGHT_TABLE_SIZE];
-static A_long g_currentWeightRadius = 0;
-static A_long g_currentBlurRadius = 0;
-
-// Precompute inverse distance weight table
-static void PrecomputeInvDistWeights(A_long radius) {
-	if (radius == g_currentWeightRadius) return;
-	if (radius > MAX_WEIGHT_TABLE_RADIUS) radius = MAX_WEIGHT_TABLE_RADIUS;
-
-	A_long size = radius * 2 + 1;
-	for (A_long dy = -radius; dy <= radius; dy++) {
-		for (A_long dx = -radius; dx <= radius; dx++) {
-			A_long idx = (dy + radius) * size + (dx + radius);
-			if (dx == 0 && dy == 0) {
-				g_invDistWeights[idx] = 0.0;
-			} else {
-				PF_FpLong dist = sqrt((PF_FpLong)(dx * dx + dy * dy));
-				g_invDistWeights[idx] = 1.0 / (dist + 0.1);
-			}
-		}
-	}
-	g_currentWeightRadius = radius;
-}
-
-// Precompute gaussian weight table for blur
-static void PrecomputeGaussianWeights(A_long blurRadius) {
-	if (blurRadius == g_currentBlurRadius) return;
-	if (blurRadius > MAX_WEIGHT_TABLE_RADIUS) blurRadius = MAX_WEIGHT_TABLE_RADIUS;
-
-	A_long size = blurRadius * 2 + 1;
-	PF_FpLong sigma2 = 2.0 * blurRadius * blurRadius;
-
-	for (A_long dy = -blurRadius; dy <= blurRadius; dy++) {
-		for (A_long dx = -blurRadius; dx <= blurRadius; dx++) {
-			A_long idx = (dy + blurRadius) * size + (dx + blurRadius);
-			A_long distSq = dx * dx + dy * dy;
-			g_gaussianWeights[idx] = exp(-(PF_FpLong)distSq / sigma2);
-		}
-	}
-	g_currentBlurRadius = blurRadius;
-}
-
-// ============================================================================
-// Optimized Utility Functions
-// ============================================================================
-
-static inline A_u_char ClampByte(PF_FpLong value) {
-	return (A_u_char)(value < 0 ? 0 : (value > 255 ? 255 : value));
-}
-
-static inline A_u_short Clamp16(PF_FpLong value) {
-	return (A_u_short)(value < 0 ? 0 : (value > PF_MAX_CHAN16 ? PF_MAX_CHAN16 : value));
-}
-
-static inline PF_FpLong Clamp01(PF_FpLong value) {
-	return value < 0.0 ? 0.0 : (value > 1.0 ? 1.0 : value);
-}
-
-static void UnionLRect(const PF_LRect *src, PF_LRect *dst) {
-	if (src->left < dst->left) dst->left = src->left;
-	if (src->top < dst->top) dst->top = src->top;
-	if (src->right > dst->right) dst->right = src->right;
-	if (src->bottom > dst->bottom) dst->bottom = src->bottom;
-}
-
-// Fast mask access - no bounds check (caller ensures bounds)
-static inline A_u_char GetMaskAtFast(ColorLinesInfo *info, A_long x, A_long y) {
-	return info->lineMask[y * info->maskRowBytes + x];
-}
-
-static inline void SetMaskAtFast(ColorLinesInfo *info, A_long x, A_long y, A_u_char value) {
-	info->lineMask[y * info->maskRowBytes + x] = value;
-}
-
-// Safe mask access with bounds check
-static inline A_u_char GetMaskAt(ColorLinesInfo *info, A_long x, A_long y) {
-	if (x < 0 || x >= info->maskWidth || y < 0 || y >= info->maskHeight) return 0;
-	return info->lineMask[y * info->maskRowBytes + x];
-}
-
-// ============================================================================
-// Optimized Pixel Access - Direct pointer arithmetic
-// ============================================================================
-
-// Get row pointer once, then access pixels directly
-static inline PF_Pixel8* GetRow8(PF_EffectWorld *world, A_long y) {
-	return (PF_Pixel8*)((char*)world->data + y * world->rowbytes);
-}
-
-static inline PF_Pixel16* GetRow16(PF_EffectWorld *world, A_long y) {
-	return (PF_Pixel16*)((char*)world->data + y * world->rowbytes);
-}
-
-static inline PF_PixelFloat* GetRowFloat(PF_EffectWorld *world, A_long y) {
-	return (PF_PixelFloat*)((char*)world->data + y * world->rowbytes);
-}
-
-// ============================================================================
-// RGB <-> HSL Conversion (optimized)
-// ============================================================================
-
-static inline PF_FpLong HueToRGB(PF_FpLong p, PF_FpLong q, PF_FpLong t) {
-	if (t < 0.0) t += 1.0;
-	else if (t > 1.0) t -= 1.0;
-
-	if (t < 0.166666667) return p + (q - p) * 6.0 * t;
-	if (t < 0.5) return q;
-	if (t < 0.666666667) return p + (q - p) * (0.666666667 - t) * 6.0;
-	return p;
-}
-
-static void RGBtoHSL(PF_FpLong r, PF_FpLong g, PF_FpLong b, PF_FpLong *h, PF_FpLong *s, PF_FpLong *l) {
-	PF_FpLong maxVal = r > g ? (r > b ? r : b) : (g > b ? g : b);
-	PF_FpLong minVal = r < g ? (r < b ? r : b) : (g < b ? g : b);
-	PF_FpLong delta = maxVal - minVal;
-
-	*l = (maxVal + minVal) * 0.5;
-
-	if (delta < 0.00001) {
-		*h = 0.0;
-		*s = 0.0;
-	} else {
-		*s = (*l > 0.5) ? delta / (2.0 - maxVal - minVal) : delta / (maxVal + minVal);
-		if (maxVal == r) {
-			*h = (g - b) / delta + (g < b ? 6.0 : 0.0);
-		} else if (maxVal == g) {
-			*h = (b - r) / delta + 2.0;
-		} else {
-			*h = (r - g) / delta + 4.0;
-		}
-		*h *= 0.166666667;
-	}
-}
-
-static void HSLtoRGB(PF_FpLong h, PF_FpLong s, PF_FpLong l, PF_FpLong *r, PF_FpLong *g, PF_FpLong *b) {
-	if (s < 0.00001) {
-		*r = *g = *b = l;
-	} else {
-		PF_FpLong q = l < 0.5 ? l * (1.0 + s) : l + s - l * s;
-		PF_FpLong p = 2.0 * l - q;
-		*r = HueToRGB(p, q, h + 0.333333333);
-		*g = HueToRGB(p, q, h);
-		*b = HueToRGB(p, q, h - 0.333333333);
-	}
-}
-
-// ============================================================================
-// Optimized Color Matching - Use squared distance
-// ============================================================================
-
-// All color matching is done in 8-bit space to match AE color picker behavior
-static inline PF_Boolean IsTargetColor8Fast(PF_Pixel8 *pixel, A_long targetR, A_long targetG, A_long targetB, A_long toleranceSq) {
-	A_long dr = (A_long)pixel->red - targetR;
-	A_long dg = (A_long)pixel->green - targetG;
-	A_long db = (A_long)pixel->blue - targetB;
-	A_long distSq = dr * dr + dg * dg + db * db;
-	return (distSq <= toleranceSq);
-}
-
-// 16-bit version: convert 16-bit pixel to 8-bit space for comparison
-static inline PF_Boolean IsTargetColor16Fast(PF_Pixel16 *pixel, A_long targetR8, A_long targetG8, A_long targetB8, A_long toleranceSq8) {
-	A_long r8 = (A_long)((double)pixel->red / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
-	A_long g8 = (A_long)((double)pixel->green / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
-	A_long b8 = (A_long)((double)pixel->blue / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
-	A_long dr = r8 - targetR8;
-	A_long dg = g8 - targetG8;
-	A_long db = b8 - targetB8;
-	A_long distSq = dr * dr + dg * dg + db * db;
-	return (distSq <= toleranceSq8);
-}
-
-// 32-bit float: convert to 8-bit space for comparison
-static inline PF_Boolean IsTargetColorFloatFast(PF_PixelFloat *pixel, A_long targetR8, A_long targetG8, A_long targetB8, A_long toleranceSq8) {
-	A_long r8 = (A_long)(pixel->red * 255.0 + 0.5);
-	A_long g8 = (A_long)(pixel->green * 255.0 + 0.5);
-	A_long b8 = (A_long)(pixel->blue * 255.0 + 0.5);
-	if (r8 < 0) r8 = 0; else if (r8 > 255) r8 = 255;
-	if (g8 < 0) g8 = 0; else if (g8 > 255) g8 = 255;
-	if (b8 < 0) b8 = 0; else if (b8 > 255) b8 = 255;
-	A_long dr = r8 - targetR8;
-	A_long dg = g8 - targetG8;
-	A_long db = b8 - targetB8;
-	A_long distSq = dr * dr + dg * dg + db * db;
-	return (distSq <= toleranceSq8);
-}
-
-// ============================================================================
-// Precomputed Color Adjustment Factors
-// ============================================================================
-
-typedef struct {
-	PF_Boolean needsAdjustment;
-	PF_Boolean needsBrightness;
-	PF_Boolean needsContrast;
-	PF_Boolean needsSaturation;
-	PF_FpLong brightnessFactor;
-	PF_FpLong contrastFactor;
-	PF_FpLong saturationFactor;
-} ColorAdjustParams;
-
-static void InitColorAdjustParams(ColorAdjustParams *adj, ColorLinesInfo *info) {
-	adj->needsBrightness = (info->brightness != 0.0);
-	adj->needsContrast = (info->contrast != 0.0);
-	adj->needsSaturation = (info->saturation != 0.0);
-	adj->needsAdjustment = adj->needsBrightness || adj->needsContrast || adj->needsSaturation;
-
-	if (adj->needsBrightness) {
-		adj->brightnessFactor = info->brightness / 100.0;
-	}
-	if (adj->needsContrast) {
-		adj->contrastFactor = (100.0 + info->contrast) / 100.0;
-		adj->contrastFactor *= adj->contrastFactor;
-	}
-	if (adj->needsSaturation) {
-		adj->saturationFactor = (100.0 + info->saturation) / 100.0;
-	}
-}
-
-static inline void ApplyColorAdjustments8Fast(PF_Pixel8 *pixel, const ColorAdjustParams *adj) {
-	if (!adj->needsAdjustment) return;
-
-	PF_FpLong r = pixel->red * 0.00392156863;  // / 255.0
-	PF_FpLong g = pixel->green * 0.00392156863;
-	PF_FpLong b = pixel->blue * 0.00392156863;
-
-	if (adj->needsBrightness) {
-		r = Clamp01(r + adj->brightnessFactor);
-		g = Clamp01(g + adj->brightnessFactor);
-		b = Clamp01(b + adj->brightnessFactor);
-	}
-
-	if (adj->needsContrast) {
-		r = Clamp01(0.5 + (r - 0.5) * adj->contrastFactor);
-		g = Clamp01(0.5 + (g - 0.5) * adj->contrastFactor);
-		b = Clamp01(0.5 + (b - 0.5) * adj->contrastFactor);
-	}
-
-	if (adj->needsSaturation) {
-		PF_FpLong h, s, l;
-		RGBtoHSL(r, g, b, &h, &s, &l);
-		s = Clamp01(s * adj->saturationFactor);
-		HSLtoRGB(h, s, l, &r, &g, &b);
-	}
-
-	pixel->red = ClampByte(r * 255.0);
-	pixel->green = ClampByte(g * 255.0);
-	pixel->blue = ClampByte(b * 255.0);
-}
-
-static inline void ApplyColorAdjustments16Fast(PF_Pixel16 *pixel, const ColorAdjustParams *adj) {
-	if (!adj->needsAdjustment) return;
-
-	const PF_FpLong invMax = 1.0 / PF_MAX_CHAN16;
-	PF_FpLong r = pixel->red * invMax;
-	PF_FpLong g = pixel->green * invMax;
-	PF_FpLong b = pixel->blue * invMax;
-
-	if (adj->needsBrightness) {
-		r = Clamp01(r + adj->brightnessFactor);
-		g = Clamp01(g + adj->brightnessFactor);
-		b = Clamp01(b + adj->brightnessFactor);
-	}
-
-	if (adj->needsContrast) {
-		r = Clamp01(0.5 + (r - 0.5) * adj->contrastFactor);
-		g = Clamp01(0.5 + (g - 0.5) * adj->contrastFactor);
-		b = Clamp01(0.5 + (b - 0.5) * adj->contrastFactor);
-	}
-
-	if (adj->needsSaturation) {
-		PF_FpLong h, s, l;
-		RGBtoHSL(r, g, b, &h, &s, &l);
-		s = Clamp01(s * adj->saturationFactor);
-		HSLtoRGB(h, s, l, &r, &g, &b);
-	}
-
-	pixel->red = Clamp16(r * PF_MAX_CHAN16);
-	pixel->green = Clamp16(g * PF_MAX_CHAN16);
-	pixel->blue = Clamp16(b * PF_MAX_CHAN16);
-}
-
-static inline void ApplyColorAdjustmentsFloatFast(PF_PixelFloat *pixel, const ColorAdjustParams *adj) {
-	if (!adj->needsAdjustment) return;
-
-	PF_FpLong r = pixel->red;
-	PF_FpLong g = pixel->green;
-	PF_FpLong b = pixel->blue;
-
-	if (adj->needsBrightness) {
-		r += adj->brightnessFactor;
-		g += adj->brightnessFactor;
-		b += adj->brightnessFactor;
-	}
-
-	if (adj->needsContrast) {
-		r = 0.5 + (r - 0.5) * adj->contrastFactor;
-		g = 0.5 + (g - 0.5) * adj->contrastFactor;
-		b = 0.5 + (b - 0.5) * adj->contrastFactor;
-	}
-
-	if (adj->needsSaturation) {
-		PF_FpLong h, s, l;
-		RGBtoHSL(Clamp01(r), Clamp01(g), Clamp01(b), &h, &s, &l);
-		s = Clamp01(s * adj->saturationFactor);
-		HSLtoRGB(h, s, l, &r, &g, &b);
-	}
-
-	pixel->red = (PF_FpShort)r;
-	pixel->green = (PF_FpShort)g;
-	pixel->blue = (PF_FpShort)b;
-}
-
-// ============================================================================
-// Optimized Fill Functions
-// ============================================================================
-
-static void FillLinePixel8(ColorLinesInfo *info, A_long x, A_long y, PF_Pixel8 *inP, PF_Pixel8 *outP,
-                           A_long targetR, A_long targetG, A_long targetB, A_long toleranceSq,
-                           const ColorAdjustParams *adj) {
-	A_long radius = info->searchRadius;
-	A_long width = info->srcWorld->width;
-	A_long height = info->srcWorld->height;
-	A_long weightSize = radius * 2 + 1;
-
-	if (info->fillMode == FILL_MODE_NEAREST) {
-		// Find nearest non-target pixel
-		A_long nearestDistSq = 999999;
-		PF_Pixel8 *nearestPixel = NULL;
-
-		// Search in expanding rings for early termination
-		for (A_long ring = 1; ring <= radius && nearestDistSq > 1; ring++) {
-			A_long ringSq = ring * ring;
-			if (ringSq >= nearestDistSq) break;  // Can't find closer
-
-			for (A_long dy = -ring; dy <= ring; dy++) {
-				A_long ny = y + dy;
-				if (ny < 0 || ny >= height) continue;
-
-				PF_Pixel8 *rowPtr = GetRow8(info->srcWorld, ny);
-
-				for (A_long dx = -ring; dx <= ring; dx++) {
-					// Only process ring boundary
-					if (dy != -ring && dy != ring && dx != -ring && dx != ring) continue;
-
-					A_long nx = x + dx;
-					if (nx < 0 || nx >= width) continue;
-
-					PF_Pixel8 *neighbor = rowPtr + nx;
-					if (info->ignoreTransparent && neighbor->alpha < 255) continue;
-					if (IsTargetColor8Fast(neighbor, targetR, targetG, targetB, toleranceSq)) continue;
-
-					A_long distSq = dx * dx + dy * dy;
-					if (distSq < nearestDistSq) {
-						nearestDistSq = distSq;
-						nearestPixel = neighbor;
-						if (distSq == 1) goto found_nearest;  // Can't get closer
-					}
-				}
-			}
-		}
-		found_nearest:
-
-		if (nearestPixel) {
-			*outP = *nearestPixel;
-		} else {
-			*outP = *inP;
-		}
-	} else {
-		// Average or Weighted mode
-		PF_FpLong totalWeight = 0;
-		PF_FpLong sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-		PF_Boolean isAverage = (info->fillMode == FILL_MODE_AVERAGE);
-
-		for (A_long dy = -radius; dy <= radius; dy++) {
-			A_long ny = y + dy;
-			if (ny < 0 || ny >= height) continue;
-
-			PF_Pixel8 *rowPtr = GetRow8(info->srcWorld, ny);
-			A_long weightRowOffset = (dy + radius) * weightSize;
-
-			for (A_long dx = -radius; dx <= radius; dx++) {
-				if (dx == 0 && dy == 0) continue;
-
-				A_long nx = x + dx;
-				if (nx < 0 || nx >= width) continue;
-
-				PF_Pixel8 *neighbor = rowPtr + nx;
-				if (info->ignoreTransparent && neighbor->alpha < 255) continue;
-				if (IsTargetColor8Fast(neighbor, targetR, targetG, targetB, toleranceSq)) continue;
-
-				PF_FpLong weight = isAverage ? 1.0 : g_invDistWeights[weightRowOffset + dx + radius];
-				sumR += neighbor->red * weight;
-				sumG += neighbor->green * weight;
-				sumB += neighbor->blue * weight;
-				sumA += neighbor->alpha * weight;
-				totalWeight += weight;
-			}
-		}
-
-		if (totalWeight > 0) {
-			PF_FpLong invWeight = 1.0 / totalWeight;
-			outP->red = ClampByte(sumR * invWeight);
-			outP->green = ClampByte(sumG * invWeight);
-			outP->blue = ClampByte(sumB * invWeight);
-			outP->alpha = ClampByte(sumA * invWeight);
-		} else {
-			*outP = *inP;
-		}
-	}
-	ApplyColorAdjustments8Fast(outP, adj);
-}
-
-static void FillLinePixel16(ColorLinesInfo *info, A_long x, A_long y, PF_Pixel16 *inP, PF_Pixel16 *outP,
-                            A_long targetR8, A_long targetG8, A_long targetB8, A_long toleranceSq8,
-                            const ColorAdjustParams *adj) {
-	A_long radius = info->searchRadius;
-	A_long width = info->srcWorld->width;
-	A_long height = info->srcWorld->height;
-	A_long weightSize = radius * 2 + 1;
-
-	if (info->fillMode == FILL_MODE_NEAREST) {
-		A_long nearestDistSq = 999999;
-		PF_Pixel16 *nearestPixel = NULL;
-
-		for (A_long ring = 1; ring <= radius && nearestDistSq > 1; ring++) {
-			A_long ringSq = ring * ring;
-			if (ringSq >= nearestDistSq) break;
-
-			for (A_long dy = -ring; dy <= ring; dy++) {
-				A_long ny = y + dy;
-				if (ny < 0 || ny >= height) continue;
-
-				PF_Pixel16 *rowPtr = GetRow16(info->srcWorld, ny);
-
-				for (A_long dx = -ring; dx <= ring; dx++) {
-					if (dy != -ring && dy != ring && dx != -ring && dx != ring) continue;
-
-					A_long nx = x + dx;
-					if (nx < 0 || nx >= width) continue;
-
-					PF_Pixel16 *neighbor = rowPtr + nx;
-					if (info->ignoreTransparent && neighbor->alpha < PF_MAX_CHAN16) continue;
-					if (IsTargetColor16Fast(neighbor, targetR8, targetG8, targetB8, toleranceSq8)) continue;
-
-					A_long distSq = dx * dx + dy * dy;
-					if (distSq < nearestDistSq) {
-						nearestDistSq = distSq;
-						nearestPixel = neighbor;
-						if (distSq == 1) goto found_nearest16;
-					}
-				}
-			}
-		}
-		found_nearest16:
-
-		if (nearestPixel) {
-			*outP = *nearestPixel;
-		} else {
-			*outP = *inP;
-		}
-	} else {
-		PF_FpLong totalWeight = 0;
-		PF_FpLong sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-		PF_Boolean isAverage = (info->fillMode == FILL_MODE_AVERAGE);
-
-		for (A_long dy = -radius; dy <= radius; dy++) {
-			A_long ny = y + dy;
-			if (ny < 0 || ny >= height) continue;
-
-			PF_Pixel16 *rowPtr = GetRow16(info->srcWorld, ny);
-			A_long weightRowOffset = (dy + radius) * weightSize;
-
-			for (A_long dx = -radius; dx <= radius; dx++) {
-				if (dx == 0 && dy == 0) continue;
-
-				A_long nx = x + dx;
-				if (nx < 0 || nx >= width) continue;
-
-				PF_Pixel16 *neighbor = rowPtr + nx;
-				if (info->ignoreTransparent && neighbor->alpha < PF_MAX_CHAN16) continue;
-				if (IsTargetColor16Fast(neighbor, targetR8, targetG8, targetB8, toleranceSq8)) continue;
-
-				PF_FpLong weight = isAverage ? 1.0 : g_invDistWeights[weightRowOffset + dx + radius];
-				sumR += neighbor->red * weight;
-				sumG += neighbor->green * weight;
-				sumB += neighbor->blue * weight;
-				sumA += neighbor->alpha * weight;
-				totalWeight += weight;
-			}
-		}
-
-		if (totalWeight > 0) {
-			PF_FpLong invWeight = 1.0 / totalWeight;
-			outP->red = Clamp16(sumR * invWeight);
-			outP->green = Clamp16(sumG * invWeight);
-			outP->blue = Clamp16(sumB * invWeight);
-			outP->alpha = Clamp16(sumA * invWeight);
-		} else {
-			*outP = *inP;
-		}
-	}
-	ApplyColorAdjustments16Fast(outP, adj);
-}
-
-static void FillLinePixelFloat(ColorLinesInfo *info, A_long x, A_long y, PF_PixelFloat *inP, PF_PixelFloat *outP,
-                               A_long targetR8, A_long targetG8, A_long targetB8, A_long toleranceSq8,
-                               const ColorAdjustParams *adj) {
-	A_long radius = info->searchRadius;
-	A_long width = info->srcWorld->width;
-	A_long height = info->srcWorld->height;
-	A_long weightSize = radius * 2 + 1;
-
-	if (info->fillMode == FILL_MODE_NEAREST) {
-		A_long nearestDistSq = 999999;
-		PF_PixelFloat *nearestPixel = NULL;
-
-		for (A_long ring = 1; ring <= radius && nearestDistSq > 1; ring++) {
-			A_long ringSq = ring * ring;
-			if (ringSq >= nearestDistSq) break;
-
-			for (A_long dy = -ring; dy <= ring; dy++) {
-				A_long ny = y + dy;
-				if (ny < 0 || ny >= height) continue;
-
-				PF_PixelFloat *rowPtr = GetRowFloat(info->srcWorld, ny);
-
-				for (A_long dx = -ring; dx <= ring; dx++) {
-					if (dy != -ring && dy != ring && dx != -ring && dx != ring) continue;
-
-					A_long nx = x + dx;
-					if (nx < 0 || nx >= width) continue;
-
-					PF_PixelFloat *neighbor = rowPtr + nx;
-					if (info->ignoreTransparent && neighbor->alpha < 1.0f) continue;
-					if (IsTargetColorFloatFast(neighbor, targetR8, targetG8, targetB8, toleranceSq8)) continue;
-
-					A_long distSq = dx * dx + dy * dy;
-					if (distSq < nearestDistSq) {
-						nearestDistSq = distSq;
-						nearestPixel = neighbor;
-						if (distSq == 1) goto found_nearestF;
-					}
-				}
-			}
-		}
-		found_nearestF:
-
-		if (nearestPixel) {
-			*outP = *nearestPixel;
-		} else {
-			*outP = *inP;
-		}
-	} else {
-		PF_FpLong totalWeight = 0;
-		PF_FpLong sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-		PF_Boolean isAverage = (info->fillMode == FILL_MODE_AVERAGE);
-
-		for (A_long dy = -radius; dy <= radius; dy++) {
-			A_long ny = y + dy;
-			if (ny < 0 || ny >= height) continue;
-
-			PF_PixelFloat *rowPtr = GetRowFloat(info->srcWorld, ny);
-			A_long weightRowOffset = (dy + radius) * weightSize;
-
-			for (A_long dx = -radius; dx <= radius; dx++) {
-				if (dx == 0 && dy == 0) continue;
-
-				A_long nx = x + dx;
-				if (nx < 0 || nx >= width) continue;
-
-				PF_PixelFloat *neighbor = rowPtr + nx;
-				if (info->ignoreTransparent && neighbor->alpha < 1.0f) continue;
-				if (IsTargetColorFloatFast(neighbor, targetR8, targetG8, targetB8, toleranceSq8)) continue;
-
-				PF_FpLong weight = isAverage ? 1.0 : g_invDistWeights[weightRowOffset + dx + radius];
-				sumR += neighbor->red * weight;
-				sumG += neighbor->green * weight;
-				sumB += neighbor->blue * weight;
-				sumA += neighbor->alpha * weight;
-				totalWeight += weight;
-			}
-		}
-
-		if (totalWeight > 0) {
-			PF_FpLong invWeight = 1.0 / totalWeight;
-			outP->red = (PF_FpShort)(sumR * invWeight);
-			outP->green = (PF_FpShort)(sumG * invWeight);
-			outP->blue = (PF_FpShort)(sumB * invWeight);
-			outP->alpha = (PF_FpShort)(sumA * invWeight);
-		} else {
-			*outP = *inP;
-		}
-	}
-	ApplyColorAdjustmentsFloatFast(outP, adj);
-}
-
-// ============================================================================
-// Extended Info for Optimized Processing
-// ============================================================================
-
-typedef struct {
-	ColorLinesInfo *info;
-	// All bit depths use 8-bit color space for comparison
-	A_long targetR8, targetG8, targetB8;
-	A_long toleranceSq8;
-	ColorAdjustParams colorAdj;
-	A_long edgeMargin;
-	A_long width, height;
-} ProcessingContext;
-
-static void InitProcessingContext(ProcessingContext *ctx, ColorLinesInfo *info) {
-	ctx->info = info;
-	ctx->edgeMargin = info->searchRadius;
-	ctx->width = info->srcWorld->width;
-	ctx->height = info->srcWorld->height;
-
-	// All bit depths use 8-bit target color (matches AE color picker)
-	ctx->targetR8 = info->targetColor.red;
-	ctx->targetG8 = info->targetColor.green;
-	ctx->targetB8 = info->targetColor.blue;
-	A_long maxDist8 = (A_long)(info->tolerance * 4.4167 + 0.5);
-	ctx->toleranceSq8 = maxDist8 * maxDist8;
-
-	// Color adjustments
-	InitColorAdjustParams(&ctx->colorAdj, info);
-
-	// Precompute weight tables if needed
-	if (info->fillMode == FILL_MODE_WEIGHTED) {
-		PrecomputeInvDistWeights(info->searchRadius);
-	}
-}
-
-// ============================================================================
-// Optimized Pixel Processing Callbacks
-// ============================================================================
-
-static PF_Err FillAndMask8_Optimized(void *refcon, A_long xL, A_long yL, PF_Pixel8 *inP, PF_Pixel8 *outP) {
-	ProcessingContext *ctx = (ProcessingContext*)refcon;
-	ColorLinesInfo *info = ctx->info;
-
-	// Skip edge pixels
-	if (xL < ctx->edgeMargin || yL < ctx->edgeMargin ||
-		xL >= ctx->width - ctx->edgeMargin ||
-		yL >= ctx->height - ctx->edgeMargin) {
-		*outP = *inP;
-		SetMaskAtFast(info, xL, yL, 0);
-		return PF_Err_NONE;
-	}
-
-	PF_Boolean isLine = IsTargetColor8Fast(inP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8);
-	SetMaskAtFast(info, xL, yL, isLine ? 255 : 0);
-
-	switch (info->outputMode) {
-		case OUTPUT_MODE_FULL:
-			if (isLine) {
-				FillLinePixel8(info, xL, yL, inP, outP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8, &ctx->colorAdj);
-			} else {
-				*outP = *inP;
-			}
-			break;
-		case OUTPUT_MODE_LINE_ONLY:
-			if (isLine) {
-				FillLinePixel8(info, xL, yL, inP, outP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8, &ctx->colorAdj);
-				outP->alpha = 255;
-			} else {
-				outP->alpha = 0;
-				outP->red = 0;
-				outP->green = 0;
-				outP->blue = 0;
-			}
-			break;
-		case OUTPUT_MODE_BG_ONLY:
-			if (isLine) {
-				outP->alpha = 0;
-				outP->red = 0;
-				outP->green = 0;
-				outP->blue = 0;
-			} else {
-				*outP = *inP;
-			}
-			break;
-		default:
-			*outP = *inP;
-			break;
-	}
-	return PF_Err_NONE;
-}
-
-static PF_Err FillAndMask16_Optimized(void *refcon, A_long xL, A_long yL, PF_Pixel16 *inP, PF_Pixel16 *outP) {
-	ProcessingContext *ctx = (ProcessingContext*)refcon;
-	ColorLinesInfo *info = ctx->info;
-
-	if (xL < ctx->edgeMargin || yL < ctx->edgeMargin ||
-		xL >= ctx->width - ctx->edgeMargin ||
-		yL >= ctx->height - ctx->edgeMargin) {
-		*outP = *inP;
-		SetMaskAtFast(info, xL, yL, 0);
-		return PF_Err_NONE;
-	}
-
-	PF_Boolean isLine = IsTargetColor16Fast(inP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8);
-	SetMaskAtFast(info, xL, yL, isLine ? 255 : 0);
-
-	switch (info->outputMode) {
-		case OUTPUT_MODE_FULL:
-			if (isLine) {
-				FillLinePixel16(info, xL, yL, inP, outP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8, &ctx->colorAdj);
-			} else {
-				*outP = *inP;
-			}
-			break;
-		case OUTPUT_MODE_LINE_ONLY:
-			if (isLine) {
-				FillLinePixel16(info, xL, yL, inP, outP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8, &ctx->colorAdj);
-				outP->alpha = PF_MAX_CHAN16;
-			} else {
-				outP->alpha = 0;
-				outP->red = 0;
-				outP->green = 0;
-				outP->blue = 0;
-			}
-			break;
-		case OUTPUT_MODE_BG_ONLY:
-			if (isLine) {
-				outP->alpha = 0;
-				outP->red = 0;
-				outP->green = 0;
-				outP->blue = 0;
-			} else {
-				*outP = *inP;
-			}
-			break;
-		default:
-			*outP = *inP;
-			break;
-	}
-	return PF_Err_NONE;
-}
-
-static PF_Err FillAndMaskFloat_Optimized(void *refcon, A_long xL, A_long yL, PF_PixelFloat *inP, PF_PixelFloat *outP) {
-	ProcessingContext *ctx = (ProcessingContext*)refcon;
-	ColorLinesInfo *info = ctx->info;
-
-	if (xL < ctx->edgeMargin || yL < ctx->edgeMargin ||
-		xL >= ctx->width - ctx->edgeMargin ||
-		yL >= ctx->height - ctx->edgeMargin) {
-		*outP = *inP;
-		SetMaskAtFast(info, xL, yL, 0);
-		return PF_Err_NONE;
-	}
-
-	PF_Boolean isLine = IsTargetColorFloatFast(inP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8);
-	SetMaskAtFast(info, xL, yL, isLine ? 255 : 0);
-
-	switch (info->outputMode) {
-		case OUTPUT_MODE_FULL:
-			if (isLine) {
-				FillLinePixelFloat(info, xL, yL, inP, outP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8, &ctx->colorAdj);
-			} else {
-				*outP = *inP;
-			}
-			break;
-		case OUTPUT_MODE_LINE_ONLY:
-			if (isLine) {
-				FillLinePixelFloat(info, xL, yL, inP, outP, ctx->targetR8, ctx->targetG8, ctx->targetB8, ctx->toleranceSq8, &ctx->colorAdj);
-				outP->alpha = 1.0f;
-			} else {
-				outP->alpha = 0;
-				outP->red = 0;
-				outP->green = 0;
-				outP->blue = 0;
-			}
-			break;
-		case OUTPUT_MODE_BG_ONLY:
-			if (isLine) {
-				outP->alpha = 0;
-				outP->red = 0;
-				outP->green = 0;
-				outP->blue = 0;
-			} else {
-				*outP = *inP;
-			}
-			break;
-		default:
-			*outP = *inP;
-			break;
-	}
-	return PF_Err_NONE;
-}
-
-// ============================================================================
-// Optimized Blur Pass with Precomputed Weights
-// ============================================================================
-
-typedef struct {
-	ColorLinesInfo *info;
-	PF_EffectWorld *tempWorld;
-	A_long blurRadius;
-	A_long blurSize;
-} BlurContext;
-
-static PF_Err BlurPass8_Optimized(void *refcon, A_long xL, A_long yL, PF_Pixel8 *inP, PF_Pixel8 *outP) {
-	BlurContext *ctx = (BlurContext*)refcon;
-	ColorLinesInfo *info = ctx->info;
-
-	if (GetMaskAt(info, xL, yL) == 0) {
-		*outP = *inP;
-		return PF_Err_NONE;
-	}
-
-	A_long blurRadius = ctx->blurRadius;
-	A_long blurSize = ctx->blurSize;
-	PF_FpLong sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-	PF_FpLong totalWeight = 0;
-
-	for (A_long dy = -blurRadius; dy <= blurRadius; dy++) {
-		A_long ny = yL + dy;
-		if (ny < 0 || ny >= info->maskHeight) continue;
-
-		if (GetMaskAt(info, xL, ny) == 0) {
-			// Quick check: if center of row is not masked, likely skip
-			PF_Boolean hasAnyMask = FALSE;
-			for (A_long dx = -blurRadius; dx <= blurRadius; dx++) {
-				if (GetMaskAt(info, xL + dx, ny) != 0) {
-					hasAnyMask = TRUE;
-					break;
-				}
-			}
-			if (!hasAnyMask) continue;
-		}
-
-		PF_Pixel8 *rowPtr = GetRow8(ctx->tempWorld, ny);
-		A_long weightRowOffset = (dy + blurRadius) * blurSize;
-
-		for (A_long dx = -blurRadius; dx <= blurRadius; dx++) {
-			A_long nx = xL + dx;
-			if (nx < 0 || nx >= info->maskWidth) continue;
-			if (GetMaskAt(info, nx, ny) == 0) continue;
-
-			PF_Pixel8 *neighbor = rowPtr + nx;
-			PF_FpLong weight = g_gaussianWeights[weightRowOffset + dx + blurRadius];
-			sumR += neighbor->red * weight;
-			sumG += neighbor->green * weight;
-			sumB += neighbor->blue * weight;
-			sumA += neighbor->alpha * weight;
-			totalWeight += weight;
-		}
-	}
-
-	if (totalWeight > 0) {
-		PF_FpLong invWeight = 1.0 / totalWeight;
-		outP->red = ClampByte(sumR * invWeight);
-		outP->green = ClampByte(sumG * invWeight);
-		outP->blue = ClampByte(sumB * invWeight);
-		outP->alpha = ClampByte(sumA * invWeight);
-	} else {
-		*outP = *inP;
-	}
-	return PF_Err_NONE;
-}
-
-static PF_Err BlurPass16_Optimized(void *refcon, A_long xL, A_long yL, PF_Pixel16 *inP, PF_Pixel16 *outP) {
-	BlurContext *ctx = (BlurContext*)refcon;
-	ColorLinesInfo *info = ctx->info;
-
-	if (GetMaskAt(info, xL, yL) == 0) {
-		*outP = *inP;
-		return PF_Err_NONE;
-	}
-
-	A_long blurRadius = ctx->blurRadius;
-	A_long blurSize = ctx->blurSize;
-	PF_FpLong sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-	PF_FpLong totalWeight = 0;
-
-	for (A_long dy = -blurRadius; dy <= blurRadius; dy++) {
-		A_long ny = yL + dy;
-		if (ny < 0 || ny >= info->maskHeight) continue;
-
-		PF_Pixel16 *rowPtr = GetRow16(ctx->tempWorld, ny);
-		A_long weightRowOffset = (dy + blurRadius) * blurSize;
-
-		for (A_long dx = -blurRadius; dx <= blurRadius; dx++) {
-			A_long nx = xL + dx;
-			if (nx < 0 || nx >= info->maskWidth) continue;
-			if (GetMaskAt(info, nx, ny) == 0) continue;
-
-			PF_Pixel16 *neighbor = rowPtr + nx;
-			PF_FpLong weight = g_gaussianWeights[weightRowOffset + dx + blurRadius];
-			sumR += neighbor->red * weight;
-			sumG += neighbor->green * weight;
-			sumB += neighbor->blue * weight;
-			sumA += neighbor->alpha * weight;
-			totalWeight += weight;
-		}
-	}
-
-	if (totalWeight > 0) {
-		PF_FpLong invWeight = 1.0 / totalWeight;
-		outP->red = Clamp16(sumR * invWeight);
-		outP->green = Clamp16(sumG * invWeight);
-		outP->blue = Clamp16(sumB * invWeight);
-		outP->alpha = Clamp16(sumA * invWeight);
-	} else {
-		*outP = *inP;
-	}
-	return PF_Err_NONE;
-}
-
-static PF_Err BlurPassFloat_Optimized(void *refcon, A_long xL, A_long yL, PF_PixelFloat *inP, PF_PixelFloat *outP) {
-	BlurContext *ctx = (BlurContext*)refcon;
-	ColorLinesInfo *info = ctx->info;
-
-	if (GetMaskAt(info, xL, yL) == 0) {
-		*outP = *inP;
-		return PF_Err_NONE;
-	}
-
-	A_long blurRadius = ctx->blurRadius;
-	A_long blurSize = ctx->blurSize;
-	PF_FpLong sumR = 0, sumG = 0, sumB = 0, sumA = 0;
-	PF_FpLong totalWeight = 0;
-
-	for (A_long dy = -blurRadius; dy <= blurRadius; dy++) {
-		A_long ny = yL + dy;
-		if (ny < 0 || ny >= info->maskHeight) continue;
-
-		PF_PixelFloat *rowPtr = GetRowFloat(ctx->tempWorld, ny);
-		A_long weightRowOffset = (dy + blurRadius) * blurSize;
-
-		for (A_long dx = -blurRadius; dx <= blurRadius; dx++) {
-			A_long nx = xL + dx;
-			if (nx < 0 || nx >= info->maskWidth) continue;
-			if (GetMaskAt(info, nx, ny) == 0) continue;
-
-			PF_PixelFloat *neighbor = rowPtr + nx;
-			PF_FpLong weight = g_gaussianWeights[weightRowOffset + dx + blurRadius];
-			sumR += neighbor->red * weight;
-			sumG += neighbor->green * weight;
-			sumB += neighbor->blue * weight;
-			sumA += neighbor->alpha * weight;
-			totalWeight += weight;
-		}
-	}
-
-	if (totalWeight > 0) {
-		PF_FpLong invWeight = 1.0 / totalWeight;
-		outP->red = (PF_FpShort)(sumR * invWeight);
-		outP->green = (PF_FpShort)(sumG * invWeight);
-		outP->blue = (PF_FpShort)(sumB * invWeight);
-		outP->alpha = (PF_FpShort)(sumA * invWeight);
-	} else {
-		*outP = *inP;
-	}
-	return PF_Err_NONE;
-}
+#include "CXFrameCache.h"
 
 // ============================================================================
 // Plugin Entry Points
@@ -995,8 +22,10 @@ static PF_Err About(PF_InData *in_data, PF_OutData *out_data, PF_ParamDef *param
 
 static PF_Err GlobalSetup(PF_InData *in_dataP, PF_OutData *out_data, PF_ParamDef *params[], PF_LayerDef *output) {
 	out_data->my_version = PF_VERSION(MAJOR_VERSION, MINOR_VERSION, BUG_VERSION, STAGE_VERSION, BUILD_VERSION);
-	out_data->out_flags = PF_OutFlag_DEEP_COLOR_AWARE;
-	out_data->out_flags2 = PF_OutFlag2_FLOAT_COLOR_AWARE | PF_OutFlag2_SUPPORTS_SMART_RENDER | PF_OutFlag2_SUPPORTS_THREADED_RENDERING;
+	// Automatic wide time: AE takes the time dependency from the frames PreRender
+	// checks out, so only instances with Temporal Fill lose per-frame caching
+	out_data->out_flags = PF_OutFlag_DEEP_COLOR_AWARE | PF_OutFlag_WIDE_TIME_INPUT;
+	out_data->out_flags2 = PF_OutFlag2_FLOAT_COLOR_AWARE | PF_OutFlag2_SUPPORTS_SMART_RENDER | PF_OutFlag2_AUTOMATIC_WIDE_TIME_INPUT | PF_OutFlag2_SUPPORTS_THREADED_RENDERING;
 	return PF_Err_NONE;
 }
 
@@ -1013,6 +42,23 @@ static PF_Err ParamsSetup(PF_InData *in_data, PF_OutData *out_data, PF_ParamDef
 	AEFX_CLR_STRUCT(def);
 	PF_ADD_FLOAT_SLIDERX("Color Tolerance", TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_DFLT, PF_Precision_TENTHS, PF_ValueDisplayFlag_PERCENT, 0, COLOR_TOLERANCE_DISK_ID);
 
+	// Additional line colors, removed in the same pass as Target Color
+	for (A_long n = 2; n <= COLORLINES_MAX_COLORS; n++) {
+		char name[32];
+
+		AEFX_CLR_STRUCT(def);
+		PF_SPRINTF(name, "Use Color %d", (int)n);
+		PF_ADD_CHECKBOX(name, "", FALSE, 0, COLOR_ENABLED_DISK_ID(n));
+
+		AEFX_CLR_STRUCT(def);
+		PF_SPRINTF(name, "Target Color %d", (int)n);
+		PF_ADD_COLOR(name, 0, 0, 0, COLOR_DISK_ID(n));
+
+		AEFX_CLR_STRUCT(def);
+		PF_SPRINTF(name, "Color Tolerance %d", (int)n);
+		PF_ADD_FLOAT_SLIDERX(name, TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_MIN, TOLERANCE_MAX, TOLERANCE_DFLT, PF_Precision_TENTHS, PF_ValueDisplayFlag_PERCENT, 0, COLOR_TOLERANCE_DISK_ID(n));
+	}
+
 	AEFX_CLR_STRUCT(def);
 	PF_END_TOPIC(COLOR_GROUP_END_DISK_ID);
 
@@ -1020,7 +66,7 @@ static PF_Err ParamsSetup(PF_InData *in_data, PF_OutData *out_data, PF_ParamDef
 	PF_ADD_TOPIC("Fill Settings", FILL_GROUP_START_DISK_ID);
 
 	AEFX_CLR_STRUCT(def);
-	PF_ADD_POPUP("Fill Mode", FILL_MODE_NUM_MODES - 1, FILL_MODE_WEIGHTED, "Nearest Pixel|Average|Weighted Average", FILL_MODE_DISK_ID);
+	PF_ADD_POPUP("Fill Mode", FILL_MODE_NUM_MODES - 1, FILL_MODE_WEIGHTED, "Nearest Pixel|Average|Weighted Average|Membrane", FILL_MODE_DISK_ID);
 
 	AEFX_CLR_STRUCT(def);
 	PF_ADD_SLIDER("Search Radius", SEARCH_RADIUS_MIN, SEARCH_RADIUS_MAX, SEARCH_RADIUS_MIN, SEARCH_RADIUS_MAX, SEARCH_RADIUS_DFLT, SEARCH_RADIUS_DISK_ID);
@@ -1031,6 +77,9 @@ static PF_Err ParamsSetup(PF_InData *in_data, PF_OutData *out_data, PF_ParamDef
 	AEFX_CLR_STRUCT(def);
 	PF_ADD_FLOAT_SLIDERX("Sample Blur", SAMPLE_BLUR_MIN, SAMPLE_BLUR_MAX, SAMPLE_BLUR_MIN, SAMPLE_BLUR_MAX, SAMPLE_BLUR_DFLT, PF_Precision_TENTHS, PF_ValueDisplayFlag_NONE, 0, SAMPLE_BLUR_DISK_ID);
 
+	AEFX_CLR_STRUCT(def);
+	PF_ADD_CHECKBOX("Temporal Fill", "", FALSE, 0, TEMPORAL_FILL_DISK_ID);
+
 	AEFX_CLR_STRUCT(def);
 	PF_END_TOPIC(FILL_GROUP_END_DISK_ID);
 
@@ -1053,7 +102,16 @@ static PF_Err ParamsSetup(PF_InData *in_data, PF_OutData *out_data, PF_ParamDef
 	PF_ADD_TOPIC("Output", OUTPUT_GROUP_START_DISK_ID);
 
 	AEFX_CLR_STRUCT(def);
-	PF_ADD_POPUP("Output Mode", OUTPUT_MODE_NUM_MODES - 1, OUTPUT_MODE_FULL, "Full Image|Lines Only|Background Only", OUTPUT_MODE_DISK_ID);
+	PF_ADD_POPUP("Output Mode", OUTPUT_MODE_NUM_MODES - 1, OUTPUT_MODE_FULL, "Full Image|Lines Only|Background Only|Line Mask", OUTPUT_MODE_DISK_ID);
+
+	AEFX_CLR_STRUCT(def);
+	PF_ADD_POPUP("Distance Output", DISTANCE_OUTPUT_NUM_MODES - 1, DISTANCE_OUTPUT_OFF, "Off|Distance to Line|Distance to Fill Source", DISTANCE_OUTPUT_DISK_ID);
+
+	AEFX_CLR_STRUCT(def);
+	PF_ADD_POPUP("Distance Channel", DISTANCE_CHANNEL_NUM_CHANNELS - 1, DISTANCE_CHANNEL_ALPHA, "Alpha|Red|Green|Blue", DISTANCE_CHANNEL_DISK_ID);
+
+	AEFX_CLR_STRUCT(def);
+	PF_ADD_FLOAT_SLIDERX("Distance Range", DISTANCE_RANGE_MIN, DISTANCE_RANGE_MAX, DISTANCE_RANGE_MIN, 200.0, DISTANCE_RANGE_DFLT, PF_Precision_TENTHS, PF_ValueDisplayFlag_NONE, 0, DISTANCE_RANGE_DISK_ID);
 
 	AEFX_CLR_STRUCT(def);
 	PF_END_TOPIC(OUTPUT_GROUP_END_DISK_ID);
@@ -1062,6 +120,25 @@ static PF_Err ParamsSetup(PF_InData *in_data, PF_OutData *out_data, PF_ParamDef
 	return err;
 }
 
+// Line mask ring key of the input at time: the layer's state over the frame
+// (AE folds in everything upstream), the time and the region checked out
+static PF_Err GetLayerFrameKey(PF_InData *in_dataP, AEFX_SuiteScoper<PF_ParamUtilsSuite3>& paramSuite, A_long time,
+							   const PF_LRect *rect, A_u_longlong *keyP) {
+	A_Time start = { time, in_dataP->time_scale };
+	A_Time duration = { in_dataP->time_step, in_dataP->time_scale };
+	PF_State state;
+	AEFX_CLR_STRUCT(state);
+	PF_Err err = paramSuite->PF_GetCurrentState(in_dataP->effect_ref, COLORLINES_INPUT, &start, &duration, &state);
+	if (!err) {
+		A_u_longlong key = CX_HashBytes(CX_HashMix(time, in_dataP->time_scale), &state, sizeof(state));
+		key = CX_HashMix(key, ((A_u_longlong)(A_u_long)rect->left << 32) | (A_u_long)rect->top);
+		key = CX_HashMix(key, ((A_u_longlong)(A_u_long)rect->right << 32) | (A_u_long)rect->bottom);
+		key = CX_HashMix(key, ((A_u_longlong)in_dataP->downsample_x.den << 32) | in_dataP->downsample_y.den);
+		*keyP = key | 1;	// 0 is no key
+	}
+	return err;
+}
+
 static PF_Err PreRender(PF_InData *in_dataP, PF_OutData *out_dataP, PF_PreRenderExtra *extraP) {
 	PF_Err err = PF_Err_NONE;
 	PF_RenderRequest req = extraP->input->output_request;
@@ -1080,11 +157,28 @@ static PF_Err PreRender(PF_InData *in_dataP, PF_OutData *out_dataP, PF_PreRender
 
 			AEFX_CLR_STRUCT(param);
 			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_TARGET_COLOR, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
-			if (!err) infoP->targetColor = param.u.cd.value;
+			if (!err) infoP->colors[0].color = param.u.cd.value;
+			infoP->colors[0].enabled = TRUE;
 
 			AEFX_CLR_STRUCT(param);
 			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_COLOR_TOLERANCE, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
-			if (!err) infoP->tolerance = param.u.fs_d.value;
+			if (!err) infoP->colors[0].tolerance = param.u.fs_d.value;
+
+			for (A_long n = 2; n <= COLORLINES_MAX_COLORS; n++) {
+				ColorLinesTarget *target = &infoP->colors[n - 1];
+
+				AEFX_CLR_STRUCT(param);
+				if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_COLOR_ENABLED_PARAM(n), in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+				if (!err) target->enabled = param.u.bd.value;
+
+				AEFX_CLR_STRUCT(param);
+				if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_COLOR_PARAM(n), in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+				if (!err) target->color = param.u.cd.value;
+
+				AEFX_CLR_STRUCT(param);
+				if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_COLOR_TOLERANCE_PARAM(n), in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+				if (!err) target->tolerance = param.u.fs_d.value;
+			}
 
 			AEFX_CLR_STRUCT(param);
 			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_FILL_MODE, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
@@ -1102,6 +196,10 @@ static PF_Err PreRender(PF_InData *in_dataP, PF_OutData *out_dataP, PF_PreRender
 			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_SAMPLE_BLUR, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
 			if (!err) infoP->sampleBlur = param.u.fs_d.value;
 
+			AEFX_CLR_STRUCT(param);
+			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_TEMPORAL_FILL, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+			if (!err) infoP->temporalFill = param.u.bd.value;
+
 			AEFX_CLR_STRUCT(param);
 			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_BRIGHTNESS, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
 			if (!err) infoP->brightness = param.u.fs_d.value;
@@ -1118,13 +216,52 @@ static PF_Err PreRender(PF_InData *in_dataP, PF_OutData *out_dataP, PF_PreRender
 			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_OUTPUT_MODE, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
 			if (!err) infoP->outputMode = param.u.pd.value;
 
+			AEFX_CLR_STRUCT(param);
+			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_DISTANCE_OUTPUT, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+			if (!err) infoP->distanceOutput = param.u.pd.value;
+
+			AEFX_CLR_STRUCT(param);
+			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_DISTANCE_CHANNEL, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+			if (!err) infoP->distanceChannel = param.u.pd.value;
+
+			AEFX_CLR_STRUCT(param);
+			if (!err) err = PF_CHECKOUT_PARAM(in_dataP, COLORLINES_DISTANCE_RANGE, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &param);
+			if (!err) infoP->distanceRange = param.u.fs_d.value;
+
+			// Adjacent frames are only read by the fill (not Line Mask or Background Only)
+			ColorLinesStages stages;
+			ColorLinesPlanStages(infoP, &stages);
+			infoP->temporalFill = stages.temporal;
+
 			if (!err) {
 				req.field = PF_Field_FRAME;
 				err = extraP->cb->checkout_layer(in_dataP->effect_ref, COLORLINES_INPUT, COLORLINES_INPUT, &req, in_dataP->current_time, in_dataP->time_step, in_dataP->time_scale, &in_result);
 			}
 			if (!err) {
-				UnionLRect(&in_result.result_rect, &extraP->output->result_rect);
-				UnionLRect(&in_result.max_result_rect, &extraP->output->max_result_rect);
+				CX_UnionLRect(&in_result.result_rect, &extraP->output->result_rect);
+				CX_UnionLRect(&in_result.max_result_rect, &extraP->output->max_result_rect);
+			}
+
+			// The frame key names the input for the mask caches, so they skip hashing it
+			if (!err && in_dataP->time_step != 0) {
+				AEFX_SuiteScoper<PF_ParamUtilsSuite3> paramSuite = AEFX_SuiteScoper<PF_ParamUtilsSuite3>(in_dataP, kPFParamUtilsSuite, kPFParamUtilsSuiteVersion3, out_dataP);
+				err = GetLayerFrameKey(in_dataP, paramSuite, in_dataP->current_time, &in_result.result_rect, &infoP->srcFrameKey);
+			}
+
+			// Temporal fill reads the same region one frame before and after;
+			// frames outside the layer come back with an empty result rect
+			if (!err && infoP->temporalFill && in_dataP->time_step != 0) {
+				AEFX_SuiteScoper<PF_ParamUtilsSuite3> paramSuite = AEFX_SuiteScoper<PF_ParamUtilsSuite3>(in_dataP, kPFParamUtilsSuite, kPFParamUtilsSuiteVersion3, out_dataP);
+				A_long prevTime = in_dataP->current_time - in_dataP->time_step;
+				A_long nextTime = in_dataP->current_time + in_dataP->time_step;
+				PF_CheckoutResult adjacent_result;
+
+				err = extraP->cb->checkout_layer(in_dataP->effect_ref, COLORLINES_INPUT, CHECKOUT_ID_PREV_FRAME, &req, prevTime, in_dataP->time_step, in_dataP->time_scale, &adjacent_result);
+				if (!err) infoP->hasPrevFrame = !CX_IsEmptyRect(&adjacent_result.result_rect);
+				if (!err && infoP->hasPrevFrame) err = GetLayerFrameKey(in_dataP, paramSuite, prevTime, &adjacent_result.result_rect, &infoP->prevFrameKey);
+				if (!err) err = extraP->cb->checkout_layer(in_dataP->effect_ref, COLORLINES_INPUT, CHECKOUT_ID_NEXT_FRAME, &req, nextTime, in_dataP->time_step, in_dataP->time_scale, &adjacent_result);
+				if (!err) infoP->hasNextFrame = !CX_IsEmptyRect(&adjacent_result.result_rect);
+				if (!err && infoP->hasNextFrame) err = GetLayerFrameKey(in_dataP, paramSuite, nextTime, &adjacent_result.result_rect, &infoP->nextFrameKey);
 			}
 			handleSuite->host_unlock_handle(infoH);
 		}
@@ -1137,8 +274,6 @@ static PF_Err PreRender(PF_InData *in_dataP, PF_OutData *out_dataP, PF_PreRender
 static PF_Err SmartRender(PF_InData *in_data, PF_OutData *out_data, PF_SmartRenderExtra *extraP) {
 	PF_Err err = PF_Err_NONE;
 	PF_EffectWorld *input_worldP = NULL, *output_worldP = NULL;
-	PF_EffectWorld tempWorld;
-	PF_Boolean tempWorldAllocated = FALSE;
 
 	AEFX_SuiteScoper<PF_HandleSuite1> handleSuite = AEFX_SuiteScoper<PF_HandleSuite1>(in_data, kPFHandleSuite, kPFHandleSuiteVersion1, out_data);
 	ColorLinesInfo *infoP = reinterpret_cast<ColorLinesInfo*>(handleSuite->host_lock_handle(reinterpret_cast<PF_Handle>(extraP->input->pre_render_data)));
@@ -1148,111 +283,33 @@ static PF_Err SmartRender(PF_InData *in_data, PF_OutData *out_data, PF_SmartRend
 		if (!err) err = extraP->cb->checkout_output(in_data->effect_ref, &output_worldP);
 
 		if (!err && input_worldP && output_worldP) {
-			infoP->srcWorld = input_worldP;
-			infoP->in_data = in_data;
-
-			// Allocate line mask
-			infoP->maskWidth = output_worldP->width;
-			infoP->maskHeight = output_worldP->height;
-			infoP->maskRowBytes = output_worldP->width;
-			infoP->lineMask = (A_u_char*)malloc(infoP->maskWidth * infoP->maskHeight);
-			if (infoP->lineMask) {
-				memset(infoP->lineMask, 0, infoP->maskWidth * infoP->maskHeight);
-			}
-
-			// Initialize processing context with precomputed values
-			ProcessingContext ctx;
-			InitProcessingContext(&ctx, infoP);
+			infoP->quality = in_data->quality;
 
 			PF_PixelFormat format = PF_PixelFormat_INVALID;
 			AEFX_SuiteScoper<PF_WorldSuite2> wsP = AEFX_SuiteScoper<PF_WorldSuite2>(in_data, kPFWorldSuite, kPFWorldSuiteVersion2, out_data);
 			if (!err) err = wsP->PF_GetPixelFormat(input_worldP, &format);
 
-			// First pass: Fill line pixels and build mask
-			if (!err) {
-				switch (format) {
-					case PF_PixelFormat_ARGB32: {
-						AEFX_SuiteScoper<PF_Iterate8Suite2> iterSuite = AEFX_SuiteScoper<PF_Iterate8Suite2>(in_data, kPFIterate8Suite, kPFIterate8SuiteVersion2, out_data);
-						err = iterSuite->iterate(in_data, 0, output_worldP->height, input_worldP, &output_worldP->extent_hint, (void*)&ctx, FillAndMask8_Optimized, output_worldP);
-						break;
-					}
-					case PF_PixelFormat_ARGB64: {
-						AEFX_SuiteScoper<PF_iterate16Suite2> iterSuite = AEFX_SuiteScoper<PF_iterate16Suite2>(in_data, kPFIterate16Suite, kPFIterate16SuiteVersion2, out_data);
-						err = iterSuite->iterate(in_data, 0, output_worldP->height, input_worldP, &output_worldP->extent_hint, (void*)&ctx, FillAndMask16_Optimized, output_worldP);
-						break;
-					}
-					case PF_PixelFormat_ARGB128: {
-						AEFX_SuiteScoper<PF_iterateFloatSuite2> iterSuite = AEFX_SuiteScoper<PF_iterateFloatSuite2>(in_data, kPFIterateFloatSuite, kPFIterateFloatSuiteVersion2, out_data);
-						err = iterSuite->iterate(in_data, 0, output_worldP->height, input_worldP, &output_worldP->extent_hint, (void*)&ctx, FillAndMaskFloat_Optimized, output_worldP);
-						break;
-					}
-					default:
-						err = PF_Err_BAD_CALLBACK_PARAM;
-						break;
-				}
+			// Adjacent frames for temporal fill; only same-sized frames can be sampled
+			infoP->prevWorld = infoP->nextWorld = NULL;
+			PF_EffectWorld *adjacentP = NULL;
+			if (!err && infoP->temporalFill && infoP->hasPrevFrame) err = extraP->cb->checkout_layer_pixels(in_data->effect_ref, CHECKOUT_ID_PREV_FRAME, &adjacentP);
+			if (!err && adjacentP && adjacentP->width == input_worldP->width && adjacentP->height == input_worldP->height) {
+				infoP->prevWorld = adjacentP;
 			}
 
-			// Second pass: Apply blur if sampleBlur > 0
-			A_long blurRadius = (A_long)(infoP->sampleBlur / 10.0);
-			if (!err && blurRadius >= 1 && infoP->lineMask) {
-				// Precompute gaussian weights
-				PrecomputeGaussianWeights(blurRadius);
-
-				AEFX_SuiteScoper<PF_WorldSuite2> worldSuite = AEFX_SuiteScoper<PF_WorldSuite2>(in_data, kPFWorldSuite, kPFWorldSuiteVersion2, out_data);
-				err = worldSuite->PF_NewWorld(in_data->effect_ref, output_worldP->width, output_worldP->height, FALSE, format, &tempWorld);
-
-				if (!err) {
-					tempWorldAllocated = TRUE;
-
-					// Copy output to temp world
-					for (A_long y = 0; y < output_worldP->height; y++) {
-						char *srcRow = (char*)output_worldP->data + y * output_worldP->rowbytes;
-						char *dstRow = (char*)tempWorld.data + y * tempWorld.rowbytes;
-						memcpy(dstRow, srcRow, output_worldP->rowbytes);
-					}
-
-					// Setup blur context
-					BlurContext blurCtx;
-					blurCtx.info = infoP;
-					blurCtx.tempWorld = &tempWorld;
-					blurCtx.blurRadius = blurRadius;
-					blurCtx.blurSize = blurRadius * 2 + 1;
-
-					// Run blur pass
-					switch (format) {
-						case PF_PixelFormat_ARGB32: {
-							AEFX_SuiteScoper<PF_Iterate8Suite2> iterSuite = AEFX_SuiteScoper<PF_Iterate8Suite2>(in_data, kPFIterate8Suite, kPFIterate8SuiteVersion2, out_data);
-							err = iterSuite->iterate(in_data, 0, output_worldP->height, &tempWorld, &output_worldP->extent_hint, (void*)&blurCtx, BlurPass8_Optimized, output_worldP);
-							break;
-						}
-						case PF_PixelFormat_ARGB64: {
-							AEFX_SuiteScoper<PF_iterate16Suite2> iterSuite = AEFX_SuiteScoper<PF_iterate16Suite2>(in_data, kPFIterate16Suite, kPFIterate16SuiteVersion2, out_data);
-							err = iterSuite->iterate(in_data, 0, output_worldP->height, &tempWorld, &output_worldP->extent_hint, (void*)&blurCtx, BlurPass16_Optimized, output_worldP);
-							break;
-						}
-						case PF_PixelFormat_ARGB128: {
-							AEFX_SuiteScoper<PF_iterateFloatSuite2> iterSuite = AEFX_SuiteScoper<PF_iterateFloatSuite2>(in_data, kPFIterateFloatSuite, kPFIterateFloatSuiteVersion2, out_data);
-							err = iterSuite->iterate(in_data, 0, output_worldP->height, &tempWorld, &output_worldP->extent_hint, (void*)&blurCtx, BlurPassFloat_Optimized, output_worldP);
-							break;
-						}
-						default:
-							err = PF_Err_BAD_CALLBACK_PARAM;
-							break;
-					}
-				}
-
-				if (tempWorldAllocated) {
-					worldSuite->PF_DisposeWorld(in_data->effect_ref, &tempWorld);
-				}
+			adjacentP = NULL;
+			if (!err && infoP->temporalFill && infoP->hasNextFrame) err = extraP->cb->checkout_layer_pixels(in_data->effect_ref, CHECKOUT_ID_NEXT_FRAME, &adjacentP);
+			if (!err && adjacentP && adjacentP->width == input_worldP->width && adjacentP->height == input_worldP->height) {
+				infoP->nextWorld = adjacentP;
 			}
 
-			// Free line mask
-			if (infoP->lineMask) {
-				free(infoP->lineMask);
-				infoP->lineMask = NULL;
-			}
+			CX_AEHostContext hostContext = { in_data, out_data };
+			CX_Host host = CX_MakeAEHost(&hostContext);
+			if (!err) err = ColorLinesRender(&host, infoP, format, input_worldP, output_worldP);
 		}
 		extraP->cb->checkin_layer_pixels(in_data->effect_ref, COLORLINES_INPUT);
+		if (infoP->hasPrevFrame) extraP->cb->checkin_layer_pixels(in_data->effect_ref, CHECKOUT_ID_PREV_FRAME);
+		if (infoP->hasNextFrame) extraP->cb->checkin_layer_pixels(in_data->effect_ref, CHECKOUT_ID_NEXT_FRAME);
 	}
 	return err;
 }
@@ -28,6 +28,8 @@
 #include "Param_Utils.h"
 #include "Smart_Utils.h"
 
+#include "ColorLinesKernels.h"
+
 #ifdef AE_OS_WIN
 	#include <Windows.h>
 #endif
@@ -49,6 +51,28 @@ enum {
 	COLORLINES_COLOR_GROUP_START,
 	COLORLINES_TARGET_COLOR,
 	COLORLINES_COLOR_TOLERANCE,
+	// Additional target colors 2-8 (each has: Enabled, Color, Tolerance)
+	COLORLINES_COLOR2_ENABLED,
+	COLORLINES_COLOR2,
+	COLORLINES_COLOR2_TOLERANCE,
+	COLORLINES_COLOR3_ENABLED,
+	COLORLINES_COLOR3,
+	COLORLINES_COLOR3_TOLERANCE,
+	COLORLINES_COLOR4_ENABLED,
+	COLORLINES_COLOR4,
+	COLORLINES_COLOR4_TOLERANCE,
+	COLORLINES_COLOR5_ENABLED,
+	COLORLINES_COLOR5,
+	COLORLINES_COLOR5_TOLERANCE,
+	COLORLINES_COLOR6_ENABLED,
+	COLORLINES_COLOR6,
+	COLORLINES_COLOR6_TOLERANCE,
+	COLORLINES_COLOR7_ENABLED,
+	COLORLINES_COLOR7,
+	COLORLINES_COLOR7_TOLERANCE,
+	COLORLINES_COLOR8_ENABLED,
+	COLORLINES_COLOR8,
+	COLORLINES_COLOR8_TOLERANCE,
 	COLORLINES_COLOR_GROUP_END,
 
 	// Fill Settings Group
@@ -57,6 +81,7 @@ enum {
 	COLORLINES_SEARCH_RADIUS,
 	COLORLINES_IGNORE_TRANSPARENT,
 	COLORLINES_SAMPLE_BLUR,
+	COLORLINES_TEMPORAL_FILL,
 	COLORLINES_FILL_GROUP_END,
 
 	// Color Adjustments Group
@@ -69,6 +94,9 @@ enum {
 	// Output Group
 	COLORLINES_OUTPUT_GROUP_START,
 	COLORLINES_OUTPUT_MODE,
+	COLORLINES_DISTANCE_OUTPUT,
+	COLORLINES_DISTANCE_CHANNEL,
+	COLORLINES_DISTANCE_RANGE,
 	COLORLINES_OUTPUT_GROUP_END,
 
 	COLORLINES_NUM_PARAMS
@@ -96,49 +124,59 @@ enum {
 
 	OUTPUT_GROUP_START_DISK_ID,
 	OUTPUT_MODE_DISK_ID,
-	OUTPUT_GROUP_END_DISK_ID
-};
+	OUTPUT_GROUP_END_DISK_ID,
 
-// Fill mode options
-enum FillMode {
-	FILL_MODE_NEAREST = 1,
-	FILL_MODE_AVERAGE,
-	FILL_MODE_WEIGHTED,
-	FILL_MODE_NUM_MODES
-};
+	// Additional target colors 2-8 (10 IDs reserved per color)
+	COLOR2_ENABLED_DISK_ID = 100,
+	COLOR2_DISK_ID,
+	COLOR2_TOLERANCE_DISK_ID,
 
-// Output mode options
-enum OutputMode {
-	OUTPUT_MODE_FULL = 1,
-	OUTPUT_MODE_LINE_ONLY,
-	OUTPUT_MODE_BG_ONLY,
-	OUTPUT_MODE_NUM_MODES
-};
+	COLOR3_ENABLED_DISK_ID = 110,
+	COLOR3_DISK_ID,
+	COLOR3_TOLERANCE_DISK_ID,
 
-// Parameter defaults and ranges
-#define TOLERANCE_MIN		0.0
-#define TOLERANCE_MAX		100.0
-#define TOLERANCE_DFLT		0.0
+	COLOR4_ENABLED_DISK_ID = 120,
+	COLOR4_DISK_ID,
+	COLOR4_TOLERANCE_DISK_ID,
 
-#define SEARCH_RADIUS_MIN	1
-#define SEARCH_RADIUS_MAX	50
-#define SEARCH_RADIUS_DFLT	5
+	COLOR5_ENABLED_DISK_ID = 130,
+	COLOR5_DISK_ID,
+	COLOR5_TOLERANCE_DISK_ID,
 
-#define SAMPLE_BLUR_MIN		0.0
-#define SAMPLE_BLUR_MAX		100.0
-#define SAMPLE_BLUR_DFLT	0.0
+	COLOR6_ENABLED_DISK_ID = 140,
+	COLOR6_DISK_ID,
+	COLOR6_TOLERANCE_DISK_ID,
 
-#define BRIGHTNESS_MIN		-100.0
-#define BRIGHTNESS_MAX		100.0
-#define BRIGHTNESS_DFLT		0.0
+	COLOR7_ENABLED_DISK_ID = 150,
+	COLOR7_DISK_ID,
+	COLOR7_TOLERANCE_DISK_ID,
 
-#define CONTRAST_MIN		-100.0
-#define CONTRAST_MAX		100.0
-#define CONTRAST_DFLT		0.0
+	COLOR8_ENABLED_DISK_ID = 160,
+	COLOR8_DISK_ID,
+	COLOR8_TOLERANCE_DISK_ID,
 
-#define SATURATION_MIN		-100.0
-#define SATURATION_MAX		100.0
-#define SATURATION_DFLT		0.0
+	// Fill Settings additions
+	TEMPORAL_FILL_DISK_ID = 200,
+
+	// Output additions
+	DISTANCE_OUTPUT_DISK_ID = 210,
+	DISTANCE_CHANNEL_DISK_ID,
+	DISTANCE_RANGE_DISK_ID
+};
+
+// Layer checkout IDs; the current frame is checked out as COLORLINES_INPUT
+enum {
+	CHECKOUT_ID_PREV_FRAME = COLORLINES_NUM_PARAMS,
+	CHECKOUT_ID_NEXT_FRAME
+};
+
+// Param index and disk ID helpers for Color n (n = 2..COLORLINES_MAX_COLORS)
+#define COLORLINES_COLOR_ENABLED_PARAM(n)	(COLORLINES_COLOR2_ENABLED + ((n) - 2) * 3)
+#define COLORLINES_COLOR_PARAM(n)			(COLORLINES_COLOR2 + ((n) - 2) * 3)
+#define COLORLINES_COLOR_TOLERANCE_PARAM(n)	(COLORLINES_COLOR2_TOLERANCE + ((n) - 2) * 3)
+#define COLOR_ENABLED_DISK_ID(n)			(COLOR2_ENABLED_DISK_ID + ((n) - 2) * 10)
+#define COLOR_DISK_ID(n)					(COLOR2_DISK_ID + ((n) - 2) * 10)
+#define COLOR_TOLERANCE_DISK_ID(n)			(COLOR2_TOLERANCE_DISK_ID + ((n) - 2) * 10)
 
 
 extern "C" {
@@ -155,41 +193,6 @@ extern "C" {
 
 }
 
-// Plugin processing info structure
-typedef struct ColorLinesInfo {
-	// Color selection
-	PF_Pixel		targetColor;
-	PF_FpLong		tolerance;
-
-	// Fill settings
-	A_long			fillMode;
-	A_long			searchRadius;
-	PF_Boolean		ignoreTransparent;
-	PF_FpLong		sampleBlur;
-
-	// Color adjustments
-	PF_FpLong		brightness;
-	PF_FpLong		contrast;
-	PF_FpLong		saturation;
-
-	// Output
-	A_long			outputMode;
-
-	// Source image info for neighbor lookup
-	PF_EffectWorld	*srcWorld;
-	PF_InData		*in_data;
-
-	// Extent offset for coordinate mapping
-	A_long			x_offset;
-	A_long			y_offset;
-
-	// Line mask for multi-pass processing
-	A_u_char		*lineMask;
-	A_long			maskWidth;
-	A_long			maskHeight;
-	A_long			maskRowBytes;
-} ColorLinesInfo, *ColorLinesInfoP, **ColorLinesInfoH;
-
 // Pixel format structures for Premiere compatibility
 typedef struct {
 	A_u_char	blue, green, red, alpha;
@@ -0,0 +1,2428 @@
+/*
+	ColorLinesKernels.cpp
+
+	Color Line Extraction and Fill - render core shared by the AE and OpenFX
+	plugins. Supports 8-bit, 16-bit, and 32-bit float color processing.
+	Only talks to the host through CX_Host, so it builds with or without the
+	AE SDK (CX_PORTABLE).
+
+	Optimized for performance:
+	- Precomputed lookup tables for distance weights
+	- Squared distance comparisons (avoid sqrt)
+	- Cached row pointers for faster pixel access
+	- Precomputed color adjustment factors
+*/
+
+#include "ColorLinesKernels.h"
+#include "CXColorMatch.h"
+#include "CXFrameCache.h"
+#include "CXCpu.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// ============================================================================
+// Precomputed Tables and Constants
+// ============================================================================
+
+// Cached line masks for temporal fill: t-1, t, t+1 for two concurrent renders
+#define LINE_MASK_RING_SIZE 6
+
+// Cached distance planes (2 bytes per pixel each), bounded by bytes: 8 colors
+// of four 1080p frames. A frame's planes are built only if those of the three
+// frames a temporal fill render masks fit together.
+#define DISTANCE_PLANE_RING_SIZE 32
+#define DISTANCE_PLANE_CACHE_BYTES (128 << 20)
+#define DISTANCE_PLANE_FRAME_BYTES (DISTANCE_PLANE_CACHE_BYTES / 3)
+
+// Recently masked frames and the colors and thresholds they were masked with
+#define MASKED_FRAME_RING_SIZE 16
+
+// Distance output: column pass strip width, row pass band height, and the
+// column distance of pixels whose column has no feature (frames are < 2^16 px)
+#define DISTANCE_COLUMN_STRIP 256
+#define DISTANCE_ROW_BAND 16
+#define DISTANCE_NONE 0xFFFF
+
+// Weight tables: (2r+1)^2 entries, index (dy + r) * (r * 2 + 1) + (dx + r).
+// Each render builds its own table into its context; a shared table rebuilt
+// per radius would race under MFR and make output depend on render timing.
+
+// Fill an inverse distance weight table for weighted average mode
+static void BuildInvDistWeights(PF_FpLong *weights, A_long radius) {
+	A_long size = radius * 2 + 1;
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		for (A_long dx = -radius; dx <= radius; dx++) {
+			A_long idx = (dy + radius) * size + (dx + radius);
+			if (dx == 0 && dy == 0) {
+				weights[idx] = 0.0;
+			} else {
+				PF_FpLong dist = sqrt((PF_FpLong)(dx * dx + dy * dy));
+				weights[idx] = 1.0 / (dist + 0.1);
+			}
+		}
+	}
+}
+
+// Fill a gaussian weight table for blur
+static void BuildGaussianWeights(PF_FpLong *weights, A_long blurRadius) {
+	A_long size = blurRadius * 2 + 1;
+	PF_FpLong sigma2 = 2.0 * blurRadius * blurRadius;
+
+	for (A_long dy = -blurRadius; dy <= blurRadius; dy++) {
+		for (A_long dx = -blurRadius; dx <= blurRadius; dx++) {
+			A_long idx = (dy + blurRadius) * size + (dx + blurRadius);
+			A_long distSq = dx * dx + dy * dy;
+			weights[idx] = exp(-(PF_FpLong)distSq / sigma2);
+		}
+	}
+}
+
+// ============================================================================
+// Sum-of-Gaussians Kernel Fit (draft Weighted fill)
+// ============================================================================
+
+// The 1/(d+0.1) kernel is not separable. A fitted sum of gaussians truncated
+// to the same square window is, so draft renders at large radii run the
+// weighted fill as one horizontal and one vertical pass per term: O(r) per
+// pixel instead of O(r^2) per line pixel.
+#define SOG_TERMS			4
+#define SOG_MIN_RADIUS		16		// Below this the exact fill is cheap enough
+#define SOG_MAX_ERROR		0.05	// Worse fits fall back to the exact fill
+#define SOG_TAP_COST		2.5		// Cost of a separable tap pair relative to an exact tap (measured)
+
+typedef struct {
+	PF_FpLong	amplitude[SOG_TERMS];
+	PF_FpLong	sigma[SOG_TERMS];
+	PF_FpLong	error;		// sum |fit - kernel| / sum kernel over the window
+} SoGFit;
+
+// Least-squares amplitudes for fixed sigmas over the (2r+1)^2 window without
+// its center; tapCount[d2] is the number of taps at squared distance d2.
+// Returns the relative L1 error, or a huge value when the system is singular
+// or an amplitude goes negative (weights must stay positive).
+static PF_FpLong FitSoGAmplitudes(A_long radius, const A_long *tapCount, const PF_FpLong *sigma, PF_FpLong *amplitude) {
+	const PF_FpLong kRejected = 1e30;
+	const A_long maxD2 = 2 * radius * radius;
+	PF_FpLong normal[SOG_TERMS][SOG_TERMS + 1] = { { 0 } };
+
+	for (A_long d2 = 1; d2 <= maxD2; d2++) {
+		if (!tapCount[d2]) continue;
+		PF_FpLong kernel = 1.0 / (sqrt((PF_FpLong)d2) + 0.1);
+		PF_FpLong g[SOG_TERMS];
+		for (A_long i = 0; i < SOG_TERMS; i++) g[i] = exp(-d2 / (2.0 * sigma[i] * sigma[i]));
+		for (A_long i = 0; i < SOG_TERMS; i++) {
+			for (A_long j = 0; j < SOG_TERMS; j++) normal[i][j] += tapCount[d2] * g[i] * g[j];
+			normal[i][SOG_TERMS] += tapCount[d2] * g[i] * kernel;
+		}
+	}
+
+	// Gauss-Jordan with partial pivoting
+	for (A_long i = 0; i < SOG_TERMS; i++) {
+		A_long pivot = i;
+		for (A_long j = i + 1; j < SOG_TERMS; j++) {
+			if (fabs(normal[j][i]) > fabs(normal[pivot][i])) pivot = j;
+		}
+		if (fabs(normal[pivot][i]) < 1e-300) return kRejected;
+		for (A_long k = 0; k <= SOG_TERMS; k++) {
+			PF_FpLong t = normal[i][k];
+			normal[i][k] = normal[pivot][k];
+			normal[pivot][k] = t;
+		}
+		for (A_long j = 0; j < SOG_TERMS; j++) {
+			if (j == i) continue;
+			PF_FpLong f = normal[j][i] / normal[i][i];
+			for (A_long k = i; k <= SOG_TERMS; k++) normal[j][k] -= f * normal[i][k];
+		}
+	}
+	for (A_long i = 0; i < SOG_TERMS; i++) {
+		amplitude[i] = normal[i][SOG_TERMS] / normal[i][i];
+		if (amplitude[i] < 0) return kRejected;
+	}
+
+	PF_FpLong error = 0, total = 0;
+	for (A_long d2 = 1; d2 <= maxD2; d2++) {
+		if (!tapCount[d2]) continue;
+		PF_FpLong kernel = 1.0 / (sqrt((PF_FpLong)d2) + 0.1);
+		PF_FpLong fit = 0;
+		for (A_long i = 0; i < SOG_TERMS; i++) fit += amplitude[i] * exp(-d2 / (2.0 * sigma[i] * sigma[i]));
+		error += tapCount[d2] * fabs(fit - kernel);
+		total += tapCount[d2] * kernel;
+	}
+	return error / total;
+}
+
+// Sigmas by coordinate descent in log space from a geometric spread over the radius
+static void FitSoGKernel(A_long radius, SoGFit *fit) {
+	std::vector<A_long> tapCount(2 * radius * radius + 1, 0);
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		for (A_long dx = -radius; dx <= radius; dx++) {
+			if (dx != 0 || dy != 0) tapCount[dx * dx + dy * dy]++;
+		}
+	}
+
+	for (A_long i = 0; i < SOG_TERMS; i++) {
+		fit->sigma[i] = 0.6 * pow(radius / 0.6, (PF_FpLong)i / (SOG_TERMS - 1));
+	}
+	fit->error = FitSoGAmplitudes(radius, tapCount.data(), fit->sigma, fit->amplitude);
+
+	const PF_FpLong steps[] = { 0.3, 0.1, 0.03 };
+	for (A_long s = 0; s < 3; s++) {
+		PF_Boolean improved = TRUE;
+		for (A_long iter = 0; iter < 20 && improved; iter++) {
+			improved = FALSE;
+			for (A_long i = 0; i < SOG_TERMS; i++) {
+				for (A_long dir = -1; dir <= 1; dir += 2) {
+					PF_FpLong sigma[SOG_TERMS], amplitude[SOG_TERMS];
+					memcpy(sigma, fit->sigma, sizeof(sigma));
+					sigma[i] *= exp(dir * steps[s]);
+					PF_FpLong error = FitSoGAmplitudes(radius, tapCount.data(), sigma, amplitude);
+					if (error < fit->error) {
+						fit->error = error;
+						memcpy(fit->sigma, sigma, sizeof(sigma));
+						memcpy(fit->amplitude, amplitude, sizeof(amplitude));
+						improved = TRUE;
+					}
+				}
+			}
+		}
+	}
+}
+
+// Fitted once per radius on first use; immutable afterwards, so render threads share it
+static const SoGFit* GetSoGFit(A_long radius) {
+	static std::once_flag once[SEARCH_RADIUS_MAX + 1];
+	static SoGFit fits[SEARCH_RADIUS_MAX + 1];
+	radius = CX_CLAMP(radius, SEARCH_RADIUS_MIN, SEARCH_RADIUS_MAX);
+	std::call_once(once[radius], [radius] { FitSoGKernel(radius, &fits[radius]); });
+	return &fits[radius];
+}
+
+// ============================================================================
+// Line Mask Access
+// ============================================================================
+
+// One mask, built once per frame from all target colors, drives both passes:
+// the fill samples LINE_MASK_VALID pixels only, the blur touches LINE_MASK_FILLED only
+enum {
+	LINE_MASK_VALID = 0,		// Background, usable as fill source
+	LINE_MASK_TRANSPARENT,		// Background skipped by Ignore Transparent
+	LINE_MASK_EDGE,				// Line pixel inside the edge margin, left unchanged
+	LINE_MASK_FILLED = 255		// Line pixel replaced by the fill
+};
+
+// Fast mask access - no bounds check (caller ensures bounds)
+static inline A_u_char GetMaskAtFast(ColorLinesInfo *info, A_long x, A_long y) {
+	return info->lineMask[y * info->maskRowBytes + x];
+}
+
+// ============================================================================
+// Precomputed Color Adjustment Factors
+// ============================================================================
+
+typedef struct {
+	PF_Boolean needsBrightness;
+	PF_Boolean needsContrast;
+	PF_Boolean needsSaturation;
+	PF_FpLong brightnessFactor;
+	PF_FpLong contrastFactor;
+	PF_FpLong saturationFactor;
+} ColorAdjustParams;
+
+static void InitColorAdjustParams(ColorAdjustParams *adj, ColorLinesInfo *info) {
+	adj->needsBrightness = (info->brightness != 0.0);
+	adj->needsContrast = (info->contrast != 0.0);
+	adj->needsSaturation = (info->saturation != 0.0);
+
+	if (adj->needsBrightness) {
+		adj->brightnessFactor = info->brightness / 100.0;
+	}
+	if (adj->needsContrast) {
+		adj->contrastFactor = (100.0 + info->contrast) / 100.0;
+		adj->contrastFactor *= adj->contrastFactor;
+	}
+	if (adj->needsSaturation) {
+		adj->saturationFactor = (100.0 + info->saturation) / 100.0;
+	}
+}
+
+// Shared by all bit depths; integer depths clamp after every step, float keeps HDR values.
+// Only instantiated into the fill when the adjust stage runs.
+template <typename PixelT>
+static inline void ApplyColorAdjustments(PixelT *pixel, const ColorAdjustParams *adj) {
+	typedef CX_PixelTraits<PixelT> Traits;
+
+	PF_FpLong r = Traits::ToUnit(pixel->red);
+	PF_FpLong g = Traits::ToUnit(pixel->green);
+	PF_FpLong b = Traits::ToUnit(pixel->blue);
+
+	if (adj->needsBrightness) {
+		r = Traits::ClampUnit(r + adj->brightnessFactor);
+		g = Traits::ClampUnit(g + adj->brightnessFactor);
+		b = Traits::ClampUnit(b + adj->brightnessFactor);
+	}
+
+	if (adj->needsContrast) {
+		r = Traits::ClampUnit(0.5 + (r - 0.5) * adj->contrastFactor);
+		g = Traits::ClampUnit(0.5 + (g - 0.5) * adj->contrastFactor);
+		b = Traits::ClampUnit(0.5 + (b - 0.5) * adj->contrastFactor);
+	}
+
+	if (adj->needsSaturation) {
+		PF_FpLong h, s, l;
+		CX_RGBtoHSL(CX_Clamp01(r), CX_Clamp01(g), CX_Clamp01(b), &h, &s, &l);
+		s = CX_Clamp01(s * adj->saturationFactor);
+		CX_HSLtoRGB(h, s, l, &r, &g, &b);
+	}
+
+	pixel->red = Traits::FromUnit(r);
+	pixel->green = Traits::FromUnit(g);
+	pixel->blue = Traits::FromUnit(b);
+}
+
+// ============================================================================
+// Extended Info for Optimized Processing
+// ============================================================================
+
+// Sum-of-gaussians fill results, one entry per LINE_MASK_FILLED pixel in row-major order
+typedef struct {
+	A_long *rowStart;		// height + 1 offsets into x[] and the sums
+	A_long *x;				// Column of each line pixel
+	float *sums[5];			// red, green, blue, alpha and weight
+} SoGFill;
+
+// Nearest search accelerator: 1 where a block holds a LINE_MASK_VALID pixel
+typedef struct {
+	A_u_char *blocks4;		// 4x4 blocks, width4 per row
+	A_u_char *blocks16;		// 16x16 blocks, width16 per row
+	A_long width4, width16;
+} ValidBlocks;
+
+// One multigrid level of the membrane solve. Cells with diag == 0 are not
+// solved (outside the line pixels, or their coarse blocks). Arrays have a
+// zero row of padding either side, so neighbor reads need no bounds checks.
+typedef struct {
+	A_long width, height;
+	float *diag;			// Sum of couplings incl. fixed neighbors
+	float *right, *down;	// Coupling to the cell at x + 1 / y + 1
+	float *value;			// red, green, blue, alpha per cell
+	float *rhs;				// red, green, blue, alpha per cell
+	A_long *rowStart;		// height + 1 offsets into cellX
+	A_long *cellX;			// Column of each solved cell, row-major
+} MembraneLevel;
+
+#define MEMBRANE_MAX_LEVELS	16
+
+// Membrane fill solution; level 0 covers bounds (source pixels) one to one
+typedef struct {
+	PF_LRect bounds;
+	A_long levelCount;
+	MembraneLevel levels[MEMBRANE_MAX_LEVELS];
+	float *buffer;			// All level arrays, one allocation
+	A_long *index;			// All level rowStart / cellX arrays
+} MembraneFill;
+
+typedef struct {
+	ColorLinesInfo *info;
+	ColorLinesStages stages;
+	// All bit depths use 8-bit color space for comparison
+	CX_ColorMatcher matcher;
+	ColorAdjustParams colorAdj;	// Adjust stage only
+	PF_FpLong *invDistWeights;	// Weighted mode only, owned by the context
+	float *tapWeights;			// Float copy for the SIMD fill, rows padded to tapStride
+	A_long tapStride;
+	A_long simdLevel;			// CX_SimdLevel() at render start
+	const SoGFit *sogFit;		// Draft Weighted fill at large radii, else NULL
+	SoGFill sog;
+	MembraneFill membrane;		// Membrane mode only
+	ValidBlocks validBlocks;	// Nearest mode only
+	A_long edgeMargin;
+	A_long width, height;
+} ProcessingContext;
+
+// ============================================================================
+// Optimized Fill Functions
+// ============================================================================
+
+// Temporal fill: co-located valid background in the previous / next frame
+// (averaged when both have it). Returns FALSE when neither frame can help.
+template <typename PixelT>
+static PF_Boolean FillFromAdjacentFrames(ColorLinesInfo *info, A_long x, A_long y, PixelT *outP) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	typedef typename Traits::AccumType AccumT;
+	const PixelT *samples[2];
+	A_long count = 0;
+	A_long offset = y * info->maskRowBytes + x;
+
+	if (info->prevMask && info->prevMask[offset] == LINE_MASK_VALID) {
+		samples[count++] = CX_GetRow<PixelT>(info->prevWorld, y) + x;
+	}
+	if (info->nextMask && info->nextMask[offset] == LINE_MASK_VALID) {
+		samples[count++] = CX_GetRow<PixelT>(info->nextWorld, y) + x;
+	}
+
+	if (count == 0) return FALSE;
+	if (count == 1) {
+		*outP = *samples[0];
+	} else {
+		outP->red = Traits::FromAccum(((AccumT)samples[0]->red + samples[1]->red) * 0.5);
+		outP->green = Traits::FromAccum(((AccumT)samples[0]->green + samples[1]->green) * 0.5);
+		outP->blue = Traits::FromAccum(((AccumT)samples[0]->blue + samples[1]->blue) * 0.5);
+		outP->alpha = Traits::FromAccum(((AccumT)samples[0]->alpha + samples[1]->alpha) * 0.5);
+	}
+	return TRUE;
+}
+
+// ============================================================================
+// Tile Staging for Average / Weighted Fill
+// ============================================================================
+
+// Output tile edge; the tile plus a radius-50 halo stays around 512KB of planes
+#define FILL_TILE_SIZE		64
+#define FILL_TILE_ALIGN		16	// Plane row stride in floats (64 bytes)
+
+// One output tile plus its search halo, staged as float planes. Samples that
+// are not LINE_MASK_VALID are staged as zero with valid = 0, so every tap can
+// be accumulated without branches and adds exactly what skipping them did.
+typedef struct {
+	A_long x0, y0;		// Source coordinates of plane element 0
+	A_long stride;		// Floats per plane row
+	float *red, *green, *blue, *alpha, *valid;
+	A_u_char *validBits;	// valid as bits, stride / 8 bytes per row
+} FillTile;
+
+// Window sums; weight is the sum of the weights of valid taps
+typedef struct {
+	PF_FpLong red, green, blue, alpha, weight;
+} FillSums;
+
+// The scalar sums are accumulated in FILL_LANES double lanes: tap k of every
+// window row goes to lane k % FILL_LANES, and the lanes are folded in one
+// fixed order
+#define FILL_LANES		8
+
+// ((l0 + l4) + (l2 + l6)) + ((l1 + l5) + (l3 + l7))
+static inline PF_FpLong FoldFillLanes(const PF_FpLong *l) {
+	return ((l[0] + l[4]) + (l[2] + l[6])) + ((l[1] + l[5]) + (l[3] + l[7]));
+}
+
+// Reference path; weights == NULL means Average
+static void AccumulateTileScalar(const FillTile *tile, const PF_FpLong *weights, A_long x, A_long y,
+                                 A_long radius, FillSums *sums) {
+	A_long size = radius * 2 + 1;
+	PF_FpLong sumR[FILL_LANES] = { 0 }, sumG[FILL_LANES] = { 0 }, sumB[FILL_LANES] = { 0 };
+	PF_FpLong sumA[FILL_LANES] = { 0 }, sumW[FILL_LANES] = { 0 };
+
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		A_long offset = (y + dy - tile->y0) * tile->stride + (x - radius - tile->x0);
+		const float *r = tile->red + offset;
+		const float *g = tile->green + offset;
+		const float *b = tile->blue + offset;
+		const float *a = tile->alpha + offset;
+		const float *v = tile->valid + offset;
+		const PF_FpLong *w = weights ? weights + (dy + radius) * size : NULL;
+
+		for (A_long k0 = 0; k0 < size; k0 += FILL_LANES) {
+			A_long lanes = CX_MIN(size - k0, FILL_LANES);
+			for (A_long lane = 0; lane < lanes; lane++) {
+				A_long k = k0 + lane;
+				PF_FpLong weight = w ? w[k] * v[k] : v[k];
+				sumR[lane] += r[k] * weight;
+				sumG[lane] += g[k] * weight;
+				sumB[lane] += b[k] * weight;
+				sumA[lane] += a[k] * weight;
+				sumW[lane] += weight;
+			}
+		}
+	}
+
+	sums->red = FoldFillLanes(sumR);
+	sums->green = FoldFillLanes(sumG);
+	sums->blue = FoldFillLanes(sumB);
+	sums->alpha = FoldFillLanes(sumA);
+	sums->weight = FoldFillLanes(sumW);
+}
+
+#if CX_HAS_X86_SIMD
+// SIMD paths accumulate in float lanes with float weights and FMA (weights
+// == NULL means Average), then fold the lanes in one fixed order. A pixel's
+// sums depend only on its window, never on threads or tiling, and stay within
+// FILL_SIMD_MAX_ERROR of the scalar sums, relative to the sum of |terms|.
+#define FILL_SIMD_MAX_ERROR	1e-5
+
+// Lanes 0-3 + 4-7, then the pairs, then the last two
+CX_TARGET_AVX2
+static inline float FillHorizontalSum(__m256 v) {
+	__m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+	lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+	return _mm_cvtss_f32(lo);
+}
+
+// Lanes 0-7 + 8-15, then as FillHorizontalSum. Halves are taken with
+// zero-masking extracts: GCC 12 warns on the 512 to 256 bit casts and plain
+// extracts, which pass an undefined source.
+CX_TARGET_AVX512
+static inline float FillHorizontalSumAVX512(__m512 v) {
+	__m512d d = _mm512_castps_pd(v);
+	__m256 lo = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d, 0));
+	__m256 hi = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d, 1));
+	return FillHorizontalSum(_mm256_add_ps(lo, hi));
+}
+
+// 16 valid bits of a staged bit row, starting at bit pos
+static inline A_u_long FillTileBits16(const A_u_char *bits, A_long pos) {
+	A_u_long word;
+	memcpy(&word, bits + (pos >> 3), sizeof(word));
+	return (word >> (pos & 7)) & 0xFFFF;
+}
+
+// 16 taps per step: the valid bits are the FMA mask, loads outside it are suppressed
+CX_TARGET_AVX512
+static void AccumulateTileAVX512(const FillTile *tile, const float *weights, A_long weightStride,
+                                 A_long x, A_long y, A_long radius, FillSums *sums) {
+	A_long size = radius * 2 + 1;
+	A_long bitStride = tile->stride / 8;
+	const __m512 ones = _mm512_set1_ps(1.0f);
+	__m512 sumR = _mm512_setzero_ps();
+	__m512 sumG = _mm512_setzero_ps();
+	__m512 sumB = _mm512_setzero_ps();
+	__m512 sumA = _mm512_setzero_ps();
+	__m512 sumW = _mm512_setzero_ps();
+
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		A_long row = y + dy - tile->y0;
+		A_long col = x - radius - tile->x0;
+		A_long offset = row * tile->stride + col;
+		const A_u_char *bits = tile->validBits + row * bitStride;
+		const float *w = weights ? weights + (dy + radius) * weightStride : NULL;
+
+		for (A_long k = 0; k < size; k += 16) {
+			A_u_long lanes = FillTileBits16(bits, col + k);
+			if (size - k < 16) lanes &= (1u << (size - k)) - 1;
+			if (!lanes) continue;
+			__mmask16 m = (__mmask16)lanes;
+
+			__m512 wv = w ? _mm512_maskz_loadu_ps(m, w + k) : _mm512_maskz_mov_ps(m, ones);
+			sumR = _mm512_mask3_fmadd_ps(_mm512_maskz_loadu_ps(m, tile->red + offset + k), wv, sumR, m);
+			sumG = _mm512_mask3_fmadd_ps(_mm512_maskz_loadu_ps(m, tile->green + offset + k), wv, sumG, m);
+			sumB = _mm512_mask3_fmadd_ps(_mm512_maskz_loadu_ps(m, tile->blue + offset + k), wv, sumB, m);
+			sumA = _mm512_mask3_fmadd_ps(_mm512_maskz_loadu_ps(m, tile->alpha + offset + k), wv, sumA, m);
+			sumW = _mm512_add_ps(sumW, wv);
+		}
+	}
+
+	sums->red = FillHorizontalSumAVX512(sumR);
+	sums->green = FillHorizontalSumAVX512(sumG);
+	sums->blue = FillHorizontalSumAVX512(sumB);
+	sums->alpha = FillHorizontalSumAVX512(sumA);
+	sums->weight = FillHorizontalSumAVX512(sumW);
+}
+
+// 8 taps per step: weights are blended to zero where the valid plane is zero
+CX_TARGET_AVX2
+static void AccumulateTileAVX2(const FillTile *tile, const float *weights, A_long weightStride,
+                               A_long x, A_long y, A_long radius, FillSums *sums) {
+	A_long size = radius * 2 + 1;
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 ones = _mm256_set1_ps(1.0f);
+	const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256 sumR = zero, sumG = zero, sumB = zero, sumA = zero, sumW = zero;
+
+	for (A_long dy = -radius; dy <= radius; dy++) {
+		A_long offset = (y + dy - tile->y0) * tile->stride + (x - radius - tile->x0);
+		const float *w = weights ? weights + (dy + radius) * weightStride : NULL;
+
+		for (A_long k = 0; k < size; k += 8) {
+			__m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(size - k), laneIndex);
+			__m256 valid = _mm256_cmp_ps(_mm256_maskload_ps(tile->valid + offset + k, tail), zero, _CMP_GT_OQ);
+			__m256 wv = _mm256_blendv_ps(zero, w ? _mm256_maskload_ps(w + k, tail) : ones, valid);
+
+			sumR = _mm256_fmadd_ps(_mm256_maskload_ps(tile->red + offset + k, tail), wv, sumR);
+			sumG = _mm256_fmadd_ps(_mm256_maskload_ps(tile->green + offset + k, tail), wv, sumG);
+			sumB = _mm256_fmadd_ps(_mm256_maskload_ps(tile->blue + offset + k, tail), wv, sumB);
+			sumA = _mm256_fmadd_ps(_mm256_maskload_ps(tile->alpha + offset + k, tail), wv, sumA);
+			sumW = _mm256_add_ps(sumW, wv);
+		}
+	}
+
+	sums->red = FillHorizontalSum(sumR);
+	sums->green = FillHorizontalSum(sumG);
+	sums->blue = FillHorizontalSum(sumB);
+	sums->alpha = FillHorizontalSum(sumA);
+	sums->weight = FillHorizontalSum(sumW);
+}
+#endif
+
+// Average or inverse distance weighted fill over the window around (x, y),
+// on the widest kernel the CPU supports; the window must lie inside the halo
+template <typename PixelT>
+static void AccumulateFromTile(const ProcessingContext *ctx, const FillTile *tile, A_long x, A_long y,
+                               PixelT *inP, PixelT *outP) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	A_long radius = ctx->info->searchRadius;
+	FillSums sums;
+
+	switch (ctx->simdLevel) {
+#if CX_HAS_X86_SIMD
+		case CX_SIMD_AVX512:
+			AccumulateTileAVX512(tile, ctx->tapWeights, ctx->tapStride, x, y, radius, &sums);
+			break;
+		case CX_SIMD_AVX2:
+			AccumulateTileAVX2(tile, ctx->tapWeights, ctx->tapStride, x, y, radius, &sums);
+			break;
+#endif
+		default:
+			AccumulateTileScalar(tile, ctx->invDistWeights, x, y, radius, &sums);
+			break;
+	}
+
+	if (sums.weight > 0) {
+		PF_FpLong invWeight = 1.0 / sums.weight;
+		outP->red = Traits::FromAccum(sums.red * invWeight);
+		outP->green = Traits::FromAccum(sums.green * invWeight);
+		outP->blue = Traits::FromAccum(sums.blue * invWeight);
+		outP->alpha = Traits::FromAccum(sums.alpha * invWeight);
+	} else {
+		*outP = *inP;
+	}
+}
+
+// Stage the tile rect plus its search halo (clipped to the source) into
+// aligned planes carved from *scratchP; the caller frees *scratchP
+template <typename PixelT>
+static PF_Err StageFillTile(const ColorLinesInfo *info, const PF_LRect *rect, FillTile *tile, void **scratchP) {
+	const CX_ImageView<PixelT> src = CX_MakeView<PixelT>(info->srcWorld);
+	A_long radius = info->searchRadius;
+	A_long left = CX_MAX(rect->left - radius, 0);
+	A_long top = CX_MAX(rect->top - radius, 0);
+	A_long right = CX_MIN(rect->right + radius, src.width);
+	A_long bottom = CX_MIN(rect->bottom + radius, src.height);
+
+	tile->x0 = left;
+	tile->y0 = top;
+	tile->stride = (right - left + FILL_TILE_ALIGN - 1) / FILL_TILE_ALIGN * FILL_TILE_ALIGN;
+	size_t planeSize = (size_t)tile->stride * (bottom - top);
+
+	A_long bitStride = tile->stride / 8;
+	size_t bitsSize = (size_t)bitStride * (bottom - top) + sizeof(A_u_long);	// Slack for 32-bit bit reads
+
+	*scratchP = malloc(planeSize * 5 * sizeof(float) + FILL_TILE_ALIGN * sizeof(float) + bitsSize);
+	if (!*scratchP) return PF_Err_OUT_OF_MEMORY;
+	const size_t alignBytes = FILL_TILE_ALIGN * sizeof(float);
+	float *planes = (float*)(((size_t)*scratchP + alignBytes - 1) / alignBytes * alignBytes);
+	tile->red = planes;
+	tile->green = planes + planeSize;
+	tile->blue = planes + planeSize * 2;
+	tile->alpha = planes + planeSize * 3;
+	tile->valid = planes + planeSize * 4;
+	tile->validBits = (A_u_char*)(planes + planeSize * 5);
+	memset(tile->validBits, 0, bitsSize);
+
+	for (A_long sy = top; sy < bottom; sy++) {
+		const PixelT *row = src.Row(sy);
+		const A_u_char *maskRow = info->lineMask + sy * info->maskRowBytes;
+		A_long offset = (sy - top) * tile->stride - left;
+		A_u_char *bitRow = tile->validBits + (sy - top) * bitStride;
+		for (A_long sx = left; sx < right; sx++) {
+			A_long i = offset + sx;
+			if (maskRow[sx] == LINE_MASK_VALID) {
+				bitRow[(sx - left) >> 3] |= (A_u_char)(1 << ((sx - left) & 7));
+				tile->red[i] = (float)row[sx].red;
+				tile->green[i] = (float)row[sx].green;
+				tile->blue[i] = (float)row[sx].blue;
+				tile->alpha[i] = (float)row[sx].alpha;
+				tile->valid[i] = 1.0f;
+			} else {
+				tile->red[i] = tile->green[i] = tile->blue[i] = tile->alpha[i] = 0.0f;
+				tile->valid[i] = 0.0f;
+			}
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Draft Weighted fill from the sum-of-gaussians pass results
+template <typename PixelT>
+static void FillFromSoG(const ProcessingContext *ctx, A_long x, A_long y, PixelT *inP, PixelT *outP) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	const SoGFill *sog = &ctx->sog;
+	const A_long *first = sog->x + sog->rowStart[y];
+	const A_long *last = sog->x + sog->rowStart[y + 1];
+	A_long j = (A_long)(std::lower_bound(first, last, x) - sog->x);
+	PF_FpLong weight = sog->sums[4][j];
+
+	if (weight > 0) {
+		PF_FpLong invWeight = 1.0 / weight;
+		outP->red = Traits::FromAccum(sog->sums[0][j] * invWeight);
+		outP->green = Traits::FromAccum(sog->sums[1][j] * invWeight);
+		outP->blue = Traits::FromAccum(sog->sums[2][j] * invWeight);
+		outP->alpha = Traits::FromAccum(sog->sums[3][j] * invWeight);
+	} else {
+		*outP = *inP;
+	}
+}
+
+#define NEAREST_BLOCK_MIN_RING	4		// Rings below this scan without the block flags
+
+// First column in [x, last] whose 4x4 block holds a valid pixel, last + 1 if none
+static inline A_long NextValidColumn(const ValidBlocks *vb, A_long y, A_long x, A_long last) {
+	const A_u_char *row16 = vb->blocks16 + (y >> 4) * vb->width16;
+	const A_u_char *row4 = vb->blocks4 + (y >> 2) * vb->width4;
+	while (x <= last) {
+		if (!row16[x >> 4]) x = ((x >> 4) + 1) << 4;
+		else if (!row4[x >> 2]) x = ((x >> 2) + 1) << 2;
+		else return x;
+	}
+	return last + 1;
+}
+
+// Whether any 4x4 block along column x, rows [top, bottom], holds a valid pixel
+static inline PF_Boolean HasValidInColumn(const ValidBlocks *vb, A_long x, A_long top, A_long bottom,
+                                          A_long width, A_long height) {
+	if (x < 0 || x >= width) return FALSE;
+	top = CX_MAX(top, 0);
+	bottom = CX_MIN(bottom, height - 1);
+	for (A_long y = top; y <= bottom; ) {
+		if (!vb->blocks16[(y >> 4) * vb->width16 + (x >> 4)]) y = ((y >> 4) + 1) << 4;
+		else if (!vb->blocks4[(y >> 2) * vb->width4 + (x >> 2)]) y = ((y >> 2) + 1) << 2;
+		else return TRUE;
+	}
+	return FALSE;
+}
+
+// Nearest candidate in search order; TRUE once nothing closer can exist
+template <typename PixelT>
+static inline PF_Boolean TakeNearest(A_long distSq, PixelT *pixel, A_long *nearestDistSq, PixelT **nearestPixel) {
+	if (distSq >= *nearestDistSq) return FALSE;
+	*nearestDistSq = distSq;
+	*nearestPixel = pixel;
+	return distSq == 1;
+}
+
+// Membrane fill from the solved level 0; line pixels no valid pixel
+// reaches through other line pixels keep their input
+template <typename PixelT>
+static void FillFromMembrane(const ProcessingContext *ctx, A_long x, A_long y, PixelT *inP, PixelT *outP) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	const MembraneFill *mg = &ctx->membrane;
+	const MembraneLevel *level = &mg->levels[0];
+	A_long i = (y - mg->bounds.top) * level->width + (x - mg->bounds.left);
+
+	if (level->diag[i] > 0) {
+		const float *value = level->value + i * 4;
+		outP->red = Traits::FromAccum(value[0]);
+		outP->green = Traits::FromAccum(value[1]);
+		outP->blue = Traits::FromAccum(value[2]);
+		outP->alpha = Traits::FromAccum(value[3]);
+	} else {
+		*outP = *inP;
+	}
+}
+
+// tile: staged planes for Average / Weighted, NULL for Nearest / Membrane
+template <bool kAdjust, typename PixelT>
+static void FillLinePixel(const ProcessingContext *ctx, A_long x, A_long y, PixelT *inP, PixelT *outP,
+                          const FillTile *tile) {
+	ColorLinesInfo *info = ctx->info;
+
+	// Adjacent frames first, spatial fill where they show line or nothing
+	if (info->temporalFill && FillFromAdjacentFrames(info, x, y, outP)) {
+		if (kAdjust) ApplyColorAdjustments(outP, &ctx->colorAdj);
+		return;
+	}
+
+	const CX_ImageView<PixelT> src = CX_MakeView<PixelT>(info->srcWorld);
+	A_long radius = info->searchRadius;
+	A_long width = src.width;
+	A_long height = src.height;
+
+	if (info->fillMode == FILL_MODE_NEAREST) {
+		// Find nearest non-target pixel. Ties keep the first hit in scan order
+		// (ring by ring, rows top to bottom, columns left to right within a row),
+		// so the result never depends on how the frame was split across threads.
+		// Blocks without a valid pixel are skipped; the remaining candidates are
+		// visited in the same order, so skipping never changes the result.
+		const ValidBlocks *vb = &ctx->validBlocks;
+		A_long nearestDistSq = 999999;
+		PixelT *nearestPixel = NULL;
+
+		// Search in expanding rings for early termination
+		for (A_long ring = 1; ring <= radius && nearestDistSq > 1; ring++) {
+			A_long ringSq = ring * ring;
+			if (ringSq >= nearestDistSq) break;  // Can't find closer
+
+			// Small rings are cheaper to probe than to look up
+			PF_Boolean useBlocks = (ring >= NEAREST_BLOCK_MIN_RING);
+
+			// Side columns of the ring, between its top and bottom rows
+			PF_Boolean probeLeft = (x - ring >= 0);
+			PF_Boolean probeRight = (x + ring < width);
+			if (useBlocks) {
+				probeLeft = HasValidInColumn(vb, x - ring, y - ring + 1, y + ring - 1, width, height);
+				probeRight = HasValidInColumn(vb, x + ring, y - ring + 1, y + ring - 1, width, height);
+			}
+
+			// Ring rows inside the frame; columns are clipped per row below
+			A_long dyLast = CX_MIN(ring, height - 1 - y);
+			for (A_long dy = CX_MAX(-ring, -y); dy <= dyLast; dy++) {
+				A_long ny = y + dy;
+
+				PixelT *rowPtr = src.Row(ny);
+				const A_u_char *maskRow = info->lineMask + ny * info->maskRowBytes;
+				A_long dySq = dy * dy;
+
+				if (dy != -ring && dy != ring) {
+					if (probeLeft && maskRow[x - ring] == LINE_MASK_VALID &&
+						TakeNearest(ringSq + dySq, rowPtr + x - ring, &nearestDistSq, &nearestPixel)) goto found_nearest;
+					if (probeRight && maskRow[x + ring] == LINE_MASK_VALID &&
+						TakeNearest(ringSq + dySq, rowPtr + x + ring, &nearestDistSq, &nearestPixel)) goto found_nearest;
+					continue;
+				}
+
+				// Top and bottom rows of the ring, one 4x4 block at a time
+				A_long last = CX_MIN(x + ring, width - 1);
+				A_long nx = CX_MAX(x - ring, 0);
+				if (useBlocks) nx = NextValidColumn(vb, ny, nx, last);
+				while (nx <= last) {
+					A_long runLast = useBlocks ? CX_MIN(nx | 3, last) : last;
+					for (; nx <= runLast; nx++) {
+						if (maskRow[nx] != LINE_MASK_VALID) continue;
+						A_long dx = nx - x;
+						if (TakeNearest(dx * dx + dySq, rowPtr + nx, &nearestDistSq, &nearestPixel)) goto found_nearest;
+					}
+					if (useBlocks) nx = NextValidColumn(vb, ny, nx, last);
+				}
+			}
+		}
+		found_nearest:
+
+		if (nearestPixel) {
+			*outP = *nearestPixel;
+		} else {
+			*outP = *inP;
+		}
+	} else if (info->fillMode == FILL_MODE_MEMBRANE) {
+		FillFromMembrane(ctx, x, y, inP, outP);
+	} else {
+		// Average or Weighted mode
+		if (ctx->sogFit) {
+			FillFromSoG(ctx, x, y, inP, outP);
+		} else {
+			AccumulateFromTile(ctx, tile, x, y, inP, outP);
+		}
+	}
+	if (kAdjust) ApplyColorAdjustments(outP, &ctx->colorAdj);
+}
+
+// ============================================================================
+// Render Stages
+// ============================================================================
+
+// A stage runs only when its result reaches the output. Line Mask output is
+// the mask pass alone. Background Only still needs the mask to clear line
+// pixels, but never fills them, so fill prep, adjust and blur are all
+// skipped (the blur would only average cleared pixels).
+void ColorLinesPlanStages(const ColorLinesInfo *info, ColorLinesStages *stages) {
+	stages->maskOutput = (info->outputMode == OUTPUT_MODE_LINE_MASK);
+	stages->fill = (info->outputMode == OUTPUT_MODE_FULL || info->outputMode == OUTPUT_MODE_LINE_ONLY);
+	stages->temporal = stages->fill && info->temporalFill;
+	stages->adjust = stages->fill &&
+		(info->brightness != 0.0 || info->contrast != 0.0 || info->saturation != 0.0);
+	stages->blurRadius = stages->fill ? (A_long)(info->sampleBlur / 10.0) : 0;
+	stages->distance = !stages->maskOutput && info->distanceOutput != DISTANCE_OUTPUT_OFF;
+}
+
+static PF_Err InitProcessingContext(ProcessingContext *ctx, ColorLinesInfo *info) {
+	ctx->info = info;
+	ColorLinesPlanStages(info, &ctx->stages);
+	ctx->edgeMargin = info->searchRadius;
+	ctx->width = info->srcWorld->width;
+	ctx->height = info->srcWorld->height;
+
+	// All bit depths use 8-bit target colors (matches AE color picker)
+	CX_MatchEntry entries[COLORLINES_MAX_COLORS];
+	A_long count = 0;
+	for (A_long i = 0; i < COLORLINES_MAX_COLORS; i++) {
+		if (!info->colors[i].enabled) continue;
+		entries[count++] = CX_MakeMatchEntry(info->colors[i].color, info->colors[i].tolerance, LINE_MASK_FILLED);
+	}
+
+	// Color adjustments
+	if (ctx->stages.adjust) InitColorAdjustParams(&ctx->colorAdj, info);
+
+	// Weight tables and the SIMD level serve the fill only
+	if (!ctx->stages.fill) {
+		return CX_ColorMatcherInit(&ctx->matcher, entries, count, info->matchBackend, CX_MATCH_ROUND_DOUBLE);
+	}
+
+	// Precompute weight table if needed
+	ctx->invDistWeights = NULL;
+	if (info->fillMode == FILL_MODE_WEIGHTED) {
+		A_long size = info->searchRadius * 2 + 1;
+		ctx->invDistWeights = (PF_FpLong*)malloc(size * size * sizeof(PF_FpLong));
+		if (!ctx->invDistWeights) return PF_Err_OUT_OF_MEMORY;
+		BuildInvDistWeights(ctx->invDistWeights, info->searchRadius);
+	}
+
+	// Draft renders approximate large-radius Weighted fill with separable passes
+	ctx->sogFit = NULL;
+	if (info->fillMode == FILL_MODE_WEIGHTED && info->quality == PF_Quality_LO &&
+		info->searchRadius >= SOG_MIN_RADIUS) {
+		const SoGFit *fit = GetSoGFit(info->searchRadius);
+		if (fit->error <= SOG_MAX_ERROR) ctx->sogFit = fit;
+	}
+
+	// SIMD fill kernels read float weight rows padded to a whole vector
+	ctx->simdLevel = info->scalarKernels ? CX_SIMD_SCALAR : CX_SimdLevel();
+	ctx->tapWeights = NULL;
+	if (ctx->invDistWeights && ctx->simdLevel != CX_SIMD_SCALAR) {
+		A_long size = info->searchRadius * 2 + 1;
+		ctx->tapStride = (size + FILL_TILE_ALIGN - 1) / FILL_TILE_ALIGN * FILL_TILE_ALIGN;
+		ctx->tapWeights = (float*)calloc((size_t)ctx->tapStride * size, sizeof(float));
+		if (!ctx->tapWeights) return PF_Err_OUT_OF_MEMORY;
+		for (A_long row = 0; row < size; row++) {
+			for (A_long k = 0; k < size; k++) {
+				ctx->tapWeights[row * ctx->tapStride + k] = (float)ctx->invDistWeights[row * size + k];
+			}
+		}
+	}
+
+	return CX_ColorMatcherInit(&ctx->matcher, entries, count, info->matchBackend, CX_MATCH_ROUND_DOUBLE);
+}
+
+// ============================================================================
+// Distance Plane Cache (tolerance scrubbing)
+// ============================================================================
+
+// While Color Tolerance is dialled the same frames render again and again with
+// only the thresholds changed. From a frame's second mask pass under changed
+// thresholds on, the pass thresholds cached per-color distance planes instead
+// of matching pixels.
+static CX_FrameRing g_distancePlaneRing(DISTANCE_PLANE_RING_SIZE, DISTANCE_PLANE_CACHE_BYTES);
+
+// Per frame key: the MaskedFrameParams of its last mask pass. Kept per frame,
+// so instances, MFR threads and the frames of one temporal render each see
+// their own previous pass.
+static CX_FrameRing g_maskedFrameRing(MASKED_FRAME_RING_SIZE);
+
+typedef struct {
+	A_u_longlong colorsKey;
+	A_u_longlong thresholdsKey;
+} MaskedFrameParams;
+
+// Records this pass's colors and thresholds for the frame; true if the frame
+// was masked before with the same colors under other thresholds
+static PF_Boolean ThresholdsChanged(const ColorLinesInfo *info, A_u_longlong frameKey) {
+	CX_FrameBufferP params = CX_NewFrameBuffer(sizeof(MaskedFrameParams));
+	if (!params) return FALSE;
+	MaskedFrameParams *current = (MaskedFrameParams*)params->data();
+	current->colorsKey = current->thresholdsKey = 0;
+	for (A_long i = 0; i < COLORLINES_MAX_COLORS; i++) {
+		const ColorLinesTarget *target = &info->colors[i];
+		if (!target->enabled) continue;
+		current->colorsKey = CX_HashMix(current->colorsKey, i);
+		current->colorsKey = CX_HashMix(current->colorsKey, (target->color.red << 16) | (target->color.green << 8) | target->color.blue);
+		current->thresholdsKey = CX_HashMix(current->thresholdsKey, CX_ToleranceToDistSq(target->tolerance));
+	}
+
+	CX_FrameBufferP previousP = g_maskedFrameRing.Exchange(frameKey, params);
+	if (!previousP) return FALSE;
+	const MaskedFrameParams *previous = (const MaskedFrameParams*)previousP->data();
+	return previous->colorsKey == current->colorsKey && previous->thresholdsKey != current->thresholdsKey;
+}
+
+// Plane build job: the missing planes of one frame, built in one pass
+typedef struct {
+	PF_EffectWorld *world;
+	PF_Pixel colors[COLORLINES_MAX_COLORS];
+	A_u_short *planes[COLORLINES_MAX_COLORS];
+	A_long count;
+} DistancePlaneJob;
+
+template <typename PixelT>
+static PF_Err BuildDistancePlaneRow(void *refcon, A_long thread_idx, A_long yL, A_long iterations) {
+	DistancePlaneJob *job = (DistancePlaneJob*)refcon;
+	A_long width = job->world->width;
+	A_u_short *rows[COLORLINES_MAX_COLORS];
+	for (A_long k = 0; k < job->count; k++) rows[k] = job->planes[k] + yL * width;
+	CX_MatchDistanceRow(CX_GetRow<PixelT>(job->world, yL), width, CX_MATCH_ROUND_DOUBLE, job->colors, job->count, rows);
+	return PF_Err_NONE;
+}
+
+// Row job for the frame content key
+typedef struct {
+	PF_EffectWorld *world;
+	A_u_longlong *rowHashes;
+} RowHashJob;
+
+template <typename PixelT>
+static PF_Err HashWorldRow(void *refcon, A_long thread_idx, A_long yL, A_long iterations) {
+	RowHashJob *job = (RowHashJob*)refcon;
+	job->rowHashes[yL] = CX_HashWorldRow<PixelT>(job->world, yL);
+	return PF_Err_NONE;
+}
+
+// Content key of a source frame (pixels, size and format)
+static PF_Err HashFrame(const CX_Host *host, PF_PixelFormat format,
+                        PF_EffectWorld *world, A_u_longlong *keyP) {
+	PF_Err err = PF_Err_NONE;
+	A_u_longlong *rowHashes = (A_u_longlong*)malloc(CX_MAX(world->height, 1) * sizeof(A_u_longlong));
+	if (!rowHashes) return PF_Err_OUT_OF_MEMORY;
+
+	RowHashJob job = { world, rowHashes };
+	switch (format) {
+		case PF_PixelFormat_ARGB32: err = CX_HostIterate(host, world->height, (void*)&job, HashWorldRow<PF_Pixel8>); break;
+		case PF_PixelFormat_ARGB64: err = CX_HostIterate(host, world->height, (void*)&job, HashWorldRow<PF_Pixel16>); break;
+		case PF_PixelFormat_ARGB128: err = CX_HostIterate(host, world->height, (void*)&job, HashWorldRow<PF_PixelFloat>); break;
+		default: err = PF_Err_BAD_CALLBACK_PARAM; break;
+	}
+	*keyP = CX_HashWorldRows(world, rowHashes, format);
+	free(rowHashes);
+	return err;
+}
+
+// Distance planes of the enabled colors and their tolerance radii, for a
+// frame masked before while the thresholds change (*countP = 0 otherwise);
+// planes keeps the buffers alive. frameKeyP is the frame's key when the
+// caller has it, NULL to hash the pixels here.
+static PF_Err GetDistancePlanes(const CX_Host *host, ColorLinesInfo *info, PF_PixelFormat format,
+                                PF_EffectWorld *world, const A_u_longlong *frameKeyP, CX_FrameBufferP *planes,
+                                const A_u_short **planeData, A_long *planeRadius, A_long *countP) {
+	PF_Err err = PF_Err_NONE;
+	*countP = 0;
+
+	A_long enabled = 0;
+	for (A_long i = 0; i < COLORLINES_MAX_COLORS; i++) enabled += info->colors[i].enabled != 0;
+	if ((size_t)enabled * world->width * world->height * sizeof(A_u_short) > DISTANCE_PLANE_FRAME_BYTES) return err;
+
+	A_u_longlong frameKey = 0;
+	if (frameKeyP) frameKey = CX_HashMix(*frameKeyP, format);
+	else err = HashFrame(host, format, world, &frameKey);
+	if (err || !ThresholdsChanged(info, frameKey)) return err;
+
+	// Cached planes, and new buffers for the rest
+	A_u_longlong keys[COLORLINES_MAX_COLORS];
+	A_long missing[COLORLINES_MAX_COLORS];
+	DistancePlaneJob job;
+	AEFX_CLR_STRUCT(job);
+	job.world = world;
+	A_long count = 0;
+	for (A_long i = 0; i < COLORLINES_MAX_COLORS; i++) {
+		const ColorLinesTarget *target = &info->colors[i];
+		if (!target->enabled) continue;
+
+		const PF_Pixel *color = &target->color;
+		keys[count] = CX_HashMix(frameKey, (color->red << 16) | (color->green << 8) | color->blue);
+		planes[count] = g_distancePlaneRing.Find(keys[count]);
+		if (!planes[count]) {
+			planes[count] = CX_NewFrameBuffer((size_t)world->width * world->height * sizeof(A_u_short));
+			if (!planes[count]) return PF_Err_OUT_OF_MEMORY;
+			job.colors[job.count] = *color;
+			job.planes[job.count] = (A_u_short*)planes[count]->data();
+			missing[job.count++] = count;
+		}
+		// Tolerance radius: squared threshold is a perfect square
+		planeRadius[count] = CX_CeilSqrt(CX_ToleranceToDistSq(target->tolerance));
+		count++;
+	}
+
+	if (job.count > 0) {
+		switch (format) {
+			case PF_PixelFormat_ARGB32: err = CX_HostIterate(host, world->height, (void*)&job, BuildDistancePlaneRow<PF_Pixel8>); break;
+			case PF_PixelFormat_ARGB64: err = CX_HostIterate(host, world->height, (void*)&job, BuildDistancePlaneRow<PF_Pixel16>); break;
+			case PF_PixelFormat_ARGB128: err = CX_HostIterate(host, world->height, (void*)&job, BuildDistancePlaneRow<PF_PixelFloat>); break;
+			default: err = PF_Err_BAD_CALLBACK_PARAM; break;
+		}
+		if (err) return err;
+		for (A_long k = 0; k < job.count; k++) {
+			planes[missing[k]] = g_distancePlaneRing.Insert(keys[missing[k]], planes[missing[k]]);
+		}
+	}
+
+	for (A_long k = 0; k < count; k++) planeData[k] = (const A_u_short*)planes[k]->data();
+	*countP = count;
+	return err;
+}
+
+// ============================================================================
+// Line Mask Pass
+// ============================================================================
+
+// Mask pass job: one source world and the mask it writes (world->width bytes per row)
+typedef struct {
+	ProcessingContext *ctx;
+	PF_EffectWorld *world;
+	A_u_char *mask;
+	// Cached distance planes of the enabled colors, thresholded instead of
+	// running the matcher when planeCount > 0
+	const A_u_short *planes[COLORLINES_MAX_COLORS];
+	A_long planeRadius[COLORLINES_MAX_COLORS];
+	A_long planeCount;
+} LineMaskJob;
+
+// Mask pass (iterate_generic row job): classify one source row against all target colors
+template <typename PixelT>
+static PF_Err BuildLineMask(void *refcon, A_long thread_idx, A_long yL, A_long iterations) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	LineMaskJob *job = (LineMaskJob*)refcon;
+	ProcessingContext *ctx = job->ctx;
+	const PixelT *row = CX_GetRow<PixelT>(job->world, yL);
+	A_long width = job->world->width;
+	A_long height = job->world->height;
+	A_u_char *maskRow = job->mask + yL * width;
+	A_long margin = ctx->edgeMargin;
+
+	if (job->planeCount > 0) {
+		memset(maskRow, 0, width);
+		for (A_long i = 0; i < job->planeCount; i++) {
+			CX_MatchThresholdRow(job->planes[i] + yL * width, width, job->planeRadius[i], maskRow, LINE_MASK_FILLED);
+		}
+	} else {
+		CX_MatchRowMask(&ctx->matcher, row, width, maskRow, LINE_MASK_FILLED);
+	}
+
+	// Lines within the search radius of the frame edge are kept as is
+	PF_Boolean edgeRow = (yL < margin || yL >= height - margin);
+	A_long interiorLeft = edgeRow ? width : CX_MIN(margin, width);
+	A_long interiorRight = edgeRow ? width : CX_MAX(width - margin, interiorLeft);
+	for (A_long x = 0; x < interiorLeft; x++) {
+		if (maskRow[x] == LINE_MASK_FILLED) maskRow[x] = LINE_MASK_EDGE;
+	}
+	for (A_long x = interiorRight; x < width; x++) {
+		if (maskRow[x] == LINE_MASK_FILLED) maskRow[x] = LINE_MASK_EDGE;
+	}
+
+	if (ctx->info->ignoreTransparent) {
+		for (A_long x = 0; x < width; x++) {
+			if (maskRow[x] == LINE_MASK_VALID && row[x].alpha < Traits::kMaxChannel) maskRow[x] = LINE_MASK_TRANSPARENT;
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Mask pass over world; frameKeyP is its frame key if known (see GetDistancePlanes)
+static PF_Err RunLineMaskPass(const CX_Host *host, ProcessingContext *ctx, PF_PixelFormat format,
+                              PF_EffectWorld *world, const A_u_longlong *frameKeyP, A_u_char *mask) {
+	PF_Err err = PF_Err_NONE;
+	LineMaskJob job;
+	AEFX_CLR_STRUCT(job);
+	job.ctx = ctx;
+	job.world = world;
+	job.mask = mask;
+
+	CX_FrameBufferP planes[COLORLINES_MAX_COLORS];
+	err = GetDistancePlanes(host, ctx->info, format, world, frameKeyP, planes,
+	                        job.planes, job.planeRadius, &job.planeCount);
+	if (err) return err;
+
+	switch (format) {
+		case PF_PixelFormat_ARGB32:
+			err = CX_HostIterate(host, world->height, (void*)&job, BuildLineMask<PF_Pixel8>);
+			break;
+		case PF_PixelFormat_ARGB64:
+			err = CX_HostIterate(host, world->height, (void*)&job, BuildLineMask<PF_Pixel16>);
+			break;
+		case PF_PixelFormat_ARGB128:
+			err = CX_HostIterate(host, world->height, (void*)&job, BuildLineMask<PF_PixelFloat>);
+			break;
+		default:
+			err = PF_Err_BAD_CALLBACK_PARAM;
+			break;
+	}
+	return err;
+}
+
+// Valid block flags (iterate_generic job): one row of 4x4 blocks
+static PF_Err MarkValidBlocksRow(void *refcon, A_long thread_idx, A_long by, A_long iterations) {
+	ProcessingContext *ctx = (ProcessingContext*)refcon;
+	ColorLinesInfo *info = ctx->info;
+	ValidBlocks *vb = &ctx->validBlocks;
+	A_u_char *blockRow = vb->blocks4 + by * vb->width4;
+
+	for (A_long y = by * 4; y < CX_MIN(by * 4 + 4, ctx->height); y++) {
+		const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+		for (A_long x = 0; x < ctx->width; x++) {
+			blockRow[x >> 2] |= (maskRow[x] == LINE_MASK_VALID);
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Nearest search accelerator over the finished line mask
+static PF_Err BuildValidBlocks(const CX_Host *host, ProcessingContext *ctx) {
+	ValidBlocks *vb = &ctx->validBlocks;
+	A_long height4 = (ctx->height + 3) >> 2;
+	A_long height16 = (ctx->height + 15) >> 4;
+	vb->width4 = (ctx->width + 3) >> 2;
+	vb->width16 = (ctx->width + 15) >> 4;
+
+	vb->blocks4 = (A_u_char*)calloc((size_t)vb->width4 * height4 + (size_t)vb->width16 * height16, 1);
+	if (!vb->blocks4) return PF_Err_OUT_OF_MEMORY;
+	vb->blocks16 = vb->blocks4 + (size_t)vb->width4 * height4;
+
+	PF_Err err = CX_HostIterate(host, height4, (void*)ctx, MarkValidBlocksRow);
+
+	for (A_long by = 0; by < height4 && !err; by++) {
+		for (A_long bx = 0; bx < vb->width4; bx++) {
+			if (vb->blocks4[by * vb->width4 + bx]) vb->blocks16[(by >> 2) * vb->width16 + (bx >> 2)] = 1;
+		}
+	}
+	return err;
+}
+
+// ============================================================================
+// Line Mask Ring (temporal fill)
+// ============================================================================
+
+// Temporal fill uses each frame's mask three times (as t-1, t and t+1).
+// Masks are shared across render threads and keyed by frame, so a frame is
+// classified once however the renders are scheduled. The host's frame key
+// (layer time and upstream state) names the frame; without one the pixels
+// are hashed.
+static CX_FrameRing g_lineMaskRing(LINE_MASK_RING_SIZE);
+
+// Everything the mask depends on besides the pixels
+static A_u_longlong LineMaskParamsKey(const ColorLinesInfo *info, PF_PixelFormat format) {
+	A_u_longlong key = CX_HashMix(format, info->searchRadius);
+	key = CX_HashMix(key, info->ignoreTransparent);
+	for (A_long i = 0; i < COLORLINES_MAX_COLORS; i++) {
+		const ColorLinesTarget *target = &info->colors[i];
+		if (!target->enabled) continue;
+		key = CX_HashMix(key, i);
+		key = CX_HashMix(key, (target->color.red << 16) | (target->color.green << 8) | target->color.blue);
+		key = CX_HashMix(key, CX_ToleranceToDistSq(target->tolerance));
+	}
+	return key;
+}
+
+static PF_Err GetCachedLineMask(const CX_Host *host, ProcessingContext *ctx, PF_PixelFormat format,
+                                PF_EffectWorld *world, A_u_longlong frameKey, A_u_longlong paramsKey,
+                                CX_FrameBufferP *maskP) {
+	PF_Err err = PF_Err_NONE;
+	if (!frameKey) err = HashFrame(host, format, world, &frameKey);
+	if (err) return err;
+
+	A_u_longlong key = CX_HashMix(frameKey, paramsKey);
+	*maskP = g_lineMaskRing.Find(key);
+	if (*maskP) return PF_Err_NONE;
+
+	CX_FrameBufferP mask = CX_NewFrameBuffer((size_t)world->width * world->height);
+	if (!mask) return PF_Err_OUT_OF_MEMORY;
+	err = RunLineMaskPass(host, ctx, format, world, &frameKey, mask->data());
+	if (!err) *maskP = g_lineMaskRing.Insert(key, mask);
+	return err;
+}
+
+// ============================================================================
+// Line Mask Output
+// ============================================================================
+
+// Line Mask output job: the mask pass writing a matte straight into the output
+typedef struct {
+	LineMaskJob mask;
+	PF_EffectWorld *output;
+	PF_LRect area;
+} MaskOutputJob;
+
+// Line Mask output (iterate_generic row job): opaque white where any target
+// color matches, transparent elsewhere. Lines in the edge margin and
+// transparent pixels are shown too, since nothing is filled.
+template <typename PixelT>
+static PF_Err MaskOutputRow(void *refcon, A_long thread_idx, A_long i, A_long iterations) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	MaskOutputJob *job = (MaskOutputJob*)refcon;
+	const LineMaskJob *maskJob = &job->mask;
+	A_long y = job->area.top + i;
+	A_long width = maskJob->world->width;
+	const PixelT *row = CX_GetRow<PixelT>(maskJob->world, y);
+	PixelT *outRow = CX_GetRow<PixelT>(job->output, y);
+
+	PixelT line;
+	line.alpha = line.red = line.green = line.blue = Traits::kMaxChannel;
+	const PixelT background = PixelT();
+
+	A_u_char hits[CX_MATCH_CHUNK];
+	for (A_long x0 = job->area.left; x0 < job->area.right; x0 += CX_MATCH_CHUNK) {
+		A_long n = CX_MIN(CX_MATCH_CHUNK, job->area.right - x0);
+		if (maskJob->planeCount > 0) {
+			memset(hits, 0, n);
+			for (A_long k = 0; k < maskJob->planeCount; k++) {
+				CX_MatchThresholdRow(maskJob->planes[k] + y * width + x0, n, maskJob->planeRadius[k], hits, 1);
+			}
+		} else {
+			CX_MatchRowMask(&maskJob->ctx->matcher, row + x0, n, hits, 1);
+		}
+		for (A_long x = 0; x < n; x++) {
+			outRow[x0 + x] = hits[x] ? line : background;
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Line Mask output over the output extent; no mask buffer, fill, adjustment or blur
+static PF_Err RunMaskOutputPass(const CX_Host *host, ProcessingContext *ctx, PF_PixelFormat format,
+                                PF_EffectWorld *input, const A_u_longlong *frameKeyP, PF_EffectWorld *output) {
+	PF_Err err = PF_Err_NONE;
+	MaskOutputJob job;
+	AEFX_CLR_STRUCT(job);
+	job.mask.ctx = ctx;
+	job.mask.world = input;
+	job.output = output;
+	job.area = output->extent_hint;
+	job.area.left = CX_MAX(job.area.left, 0);
+	job.area.top = CX_MAX(job.area.top, 0);
+	job.area.right = CX_MIN(job.area.right, CX_MIN(input->width, output->width));
+	job.area.bottom = CX_MIN(job.area.bottom, CX_MIN(input->height, output->height));
+	A_long rows = job.area.bottom - job.area.top;
+	if (job.area.right <= job.area.left || rows <= 0) return err;
+
+	// Tolerance scrubbing on the matte reuses the distance planes too
+	CX_FrameBufferP planes[COLORLINES_MAX_COLORS];
+	err = GetDistancePlanes(host, ctx->info, format, input, frameKeyP, planes,
+	                        job.mask.planes, job.mask.planeRadius, &job.mask.planeCount);
+	if (err) return err;
+
+	switch (format) {
+		case PF_PixelFormat_ARGB32:
+			err = CX_HostIterate(host, rows, (void*)&job, MaskOutputRow<PF_Pixel8>);
+			break;
+		case PF_PixelFormat_ARGB64:
+			err = CX_HostIterate(host, rows, (void*)&job, MaskOutputRow<PF_Pixel16>);
+			break;
+		case PF_PixelFormat_ARGB128:
+			err = CX_HostIterate(host, rows, (void*)&job, MaskOutputRow<PF_PixelFloat>);
+			break;
+		default:
+			err = PF_Err_BAD_CALLBACK_PARAM;
+			break;
+	}
+	return err;
+}
+
+// ============================================================================
+// Optimized Pixel Processing Callbacks
+// ============================================================================
+
+// Fill pass: replace masked line pixels, route the rest per output mode
+template <bool kAdjust, typename PixelT>
+static void FillOutputPixel(const ProcessingContext *ctx, A_long xL, A_long yL, PixelT *inP, PixelT *outP,
+                            const FillTile *tile) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	ColorLinesInfo *info = ctx->info;
+
+	// Skip edge pixels
+	if (xL < ctx->edgeMargin || yL < ctx->edgeMargin ||
+		xL >= ctx->width - ctx->edgeMargin ||
+		yL >= ctx->height - ctx->edgeMargin) {
+		*outP = *inP;
+		return;
+	}
+
+	PF_Boolean isLine = (GetMaskAtFast(info, xL, yL) == LINE_MASK_FILLED);
+
+	switch (info->outputMode) {
+		case OUTPUT_MODE_FULL:
+			if (isLine) {
+				FillLinePixel<kAdjust>(ctx, xL, yL, inP, outP, tile);
+			} else {
+				*outP = *inP;
+			}
+			break;
+		case OUTPUT_MODE_LINE_ONLY:
+			if (isLine) {
+				FillLinePixel<kAdjust>(ctx, xL, yL, inP, outP, tile);
+				outP->alpha = Traits::kMaxChannel;
+			} else {
+				*outP = PixelT();
+			}
+			break;
+		case OUTPUT_MODE_BG_ONLY:
+			if (isLine) {
+				*outP = PixelT();
+			} else {
+				*outP = *inP;
+			}
+			break;
+		default:
+			*outP = *inP;
+			break;
+	}
+}
+
+// Fill pass job: the output extent split into FILL_TILE_SIZE tiles
+typedef struct {
+	ProcessingContext *ctx;
+	PF_EffectWorld *input;
+	PF_EffectWorld *output;
+	PF_LRect area;
+	A_long tilesX;
+} FillTileJob;
+
+// Fill pass (iterate_generic tile job); Average / Weighted tiles holding line
+// pixels are staged first so the window sums read contiguous planes
+template <bool kAdjust, typename PixelT>
+static PF_Err FillLinesTile(void *refcon, A_long thread_idx, A_long i, A_long iterations) {
+	PF_Err err = PF_Err_NONE;
+	FillTileJob *job = (FillTileJob*)refcon;
+	ProcessingContext *ctx = job->ctx;
+	ColorLinesInfo *info = ctx->info;
+
+	PF_LRect rect;
+	rect.left = job->area.left + (i % job->tilesX) * FILL_TILE_SIZE;
+	rect.top = job->area.top + (i / job->tilesX) * FILL_TILE_SIZE;
+	rect.right = CX_MIN(rect.left + FILL_TILE_SIZE, job->area.right);
+	rect.bottom = CX_MIN(rect.top + FILL_TILE_SIZE, job->area.bottom);
+
+	PF_Boolean hasLine = FALSE;
+	if (ctx->stages.fill && (info->fillMode == FILL_MODE_AVERAGE || info->fillMode == FILL_MODE_WEIGHTED) &&
+		!ctx->sogFit) {
+		for (A_long y = rect.top; y < rect.bottom && !hasLine; y++) {
+			const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+			for (A_long x = rect.left; x < rect.right; x++) {
+				if (maskRow[x] == LINE_MASK_FILLED) {
+					hasLine = TRUE;
+					break;
+				}
+			}
+		}
+	}
+
+	FillTile tile;
+	void *scratch = NULL;
+	if (hasLine) err = StageFillTile<PixelT>(info, &rect, &tile, &scratch);
+
+	if (!err) {
+		for (A_long y = rect.top; y < rect.bottom; y++) {
+			PixelT *inRow = CX_GetRow<PixelT>(job->input, y);
+			PixelT *outRow = CX_GetRow<PixelT>(job->output, y);
+			for (A_long x = rect.left; x < rect.right; x++) {
+				FillOutputPixel<kAdjust>(ctx, x, y, inRow + x, outRow + x, hasLine ? &tile : (const FillTile*)NULL);
+			}
+		}
+	}
+
+	if (scratch) {
+		free(scratch);
+	}
+	return err;
+}
+
+static PF_Err RunFillPass(const CX_Host *host, ProcessingContext *ctx,
+                          PF_PixelFormat format, PF_EffectWorld *input, PF_EffectWorld *output) {
+	PF_Err err = PF_Err_NONE;
+	FillTileJob job = { ctx, input, output, output->extent_hint, 0 };
+	A_long areaWidth = job.area.right - job.area.left;
+	A_long areaHeight = job.area.bottom - job.area.top;
+	if (areaWidth <= 0 || areaHeight <= 0) return err;
+
+	job.tilesX = (areaWidth + FILL_TILE_SIZE - 1) / FILL_TILE_SIZE;
+	A_long tileCount = job.tilesX * ((areaHeight + FILL_TILE_SIZE - 1) / FILL_TILE_SIZE);
+	PF_Boolean adjust = ctx->stages.adjust;
+	switch (format) {
+		case PF_PixelFormat_ARGB32:
+			err = CX_HostIterate(host, tileCount, (void*)&job, adjust ? FillLinesTile<true, PF_Pixel8> : FillLinesTile<false, PF_Pixel8>);
+			break;
+		case PF_PixelFormat_ARGB64:
+			err = CX_HostIterate(host, tileCount, (void*)&job, adjust ? FillLinesTile<true, PF_Pixel16> : FillLinesTile<false, PF_Pixel16>);
+			break;
+		case PF_PixelFormat_ARGB128:
+			err = CX_HostIterate(host, tileCount, (void*)&job, adjust ? FillLinesTile<true, PF_PixelFloat> : FillLinesTile<false, PF_PixelFloat>);
+			break;
+		default:
+			err = PF_Err_BAD_CALLBACK_PARAM;
+			break;
+	}
+	return err;
+}
+
+// ============================================================================
+// Sum-of-Gaussians Passes (draft Weighted fill)
+// ============================================================================
+
+// One gaussian term: rows are filtered horizontally into planes, then the
+// line pixels of each row gather those planes vertically into the sums
+typedef struct {
+	ProcessingContext *ctx;
+	PF_EffectWorld *world;
+	float *planes[5];		// Horizontal pass output, world->width floats per row
+	const float *taps;		// g[0..r] of the term, symmetric
+	float amplitude;
+} SoGTermJob;
+
+// out[i] += g * (a[i] + b[i]): the symmetric tap pair step of both passes.
+// The SIMD levels fuse the multiply and add, within an ulp of this one.
+static void SoGAddTapPairScalar(float *out, const float *a, const float *b, float g, A_long n) {
+	for (A_long i = 0; i < n; i++) out[i] += g * (a[i] + b[i]);
+}
+
+#if CX_HAS_X86_SIMD
+CX_TARGET_AVX2
+static void SoGAddTapPairAVX2(float *out, const float *a, const float *b, float g, A_long n) {
+	const __m256 gv = _mm256_set1_ps(g);
+	A_long i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 pair = _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+		_mm256_storeu_ps(out + i, _mm256_fmadd_ps(gv, pair, _mm256_loadu_ps(out + i)));
+	}
+	for (; i < n; i++) out[i] += g * (a[i] + b[i]);
+}
+
+CX_TARGET_AVX512
+static void SoGAddTapPairAVX512(float *out, const float *a, const float *b, float g, A_long n) {
+	const __m512 gv = _mm512_set1_ps(g);
+	for (A_long i = 0; i < n; i += 16) {
+		__mmask16 m = (n - i >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+		__m512 pair = _mm512_add_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+		_mm512_mask_storeu_ps(out + i, m, _mm512_fmadd_ps(gv, pair, _mm512_maskz_loadu_ps(m, out + i)));
+	}
+}
+#endif
+
+static inline void SoGAddTapPair(A_long simdLevel, float *out, const float *a, const float *b, float g, A_long n) {
+	switch (simdLevel) {
+#if CX_HAS_X86_SIMD
+		case CX_SIMD_AVX512: SoGAddTapPairAVX512(out, a, b, g, n); break;
+		case CX_SIMD_AVX2: SoGAddTapPairAVX2(out, a, b, g, n); break;
+#endif
+		default: SoGAddTapPairScalar(out, a, b, g, n); break;
+	}
+}
+
+// Horizontal pass (iterate_generic row job). Only columns [r, width - r) are
+// needed: line pixels never lie within the search radius of the frame edge.
+template <typename PixelT>
+static PF_Err SoGHorizontalRow(void *refcon, A_long thread_idx, A_long y, A_long iterations) {
+	SoGTermJob *job = (SoGTermJob*)refcon;
+	const ColorLinesInfo *info = job->ctx->info;
+	const SoGFill *sog = &job->ctx->sog;
+	A_long width = job->world->width;
+	A_long height = job->world->height;
+	A_long radius = info->searchRadius;
+
+	// Skip rows no line pixel reaches
+	A_long lineBegin = sog->rowStart[CX_MAX(y - radius, 0)];
+	A_long lineEnd = sog->rowStart[CX_MIN(y + radius + 1, height)];
+	if (lineBegin == lineEnd || width <= 2 * radius) return PF_Err_NONE;
+
+	float *source = (float*)malloc(width * 5 * sizeof(float));
+	if (!source) return PF_Err_OUT_OF_MEMORY;
+
+	// Valid-weighted channels and the valid plane itself
+	const PixelT *row = CX_GetRow<PixelT>(job->world, y);
+	const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+	for (A_long x = 0; x < width; x++) {
+		PF_Boolean valid = (maskRow[x] == LINE_MASK_VALID);
+		source[x] = valid ? (float)row[x].red : 0.0f;
+		source[width + x] = valid ? (float)row[x].green : 0.0f;
+		source[width * 2 + x] = valid ? (float)row[x].blue : 0.0f;
+		source[width * 3 + x] = valid ? (float)row[x].alpha : 0.0f;
+		source[width * 4 + x] = valid ? 1.0f : 0.0f;
+	}
+
+	A_long span = width - 2 * radius;
+	for (A_long c = 0; c < 5; c++) {
+		const float *in = source + width * c + radius;
+		float *out = job->planes[c] + y * width + radius;
+		for (A_long i = 0; i < span; i++) out[i] = job->taps[0] * in[i];
+		for (A_long k = 1; k <= radius; k++) {
+			SoGAddTapPair(job->ctx->simdLevel, out, in - k, in + k, job->taps[k], span);
+		}
+	}
+
+	free(source);
+	return PF_Err_NONE;
+}
+
+// Vertical pass (iterate_generic row job): filter the row's span of line
+// pixels as whole rows (contiguous, vectorizable), then add this term at
+// the line pixels
+static PF_Err SoGVerticalRow(void *refcon, A_long thread_idx, A_long y, A_long iterations) {
+	SoGTermJob *job = (SoGTermJob*)refcon;
+	const SoGFill *sog = &job->ctx->sog;
+	A_long width = job->world->width;
+	A_long radius = job->ctx->info->searchRadius;
+	A_long begin = sog->rowStart[y];
+	A_long end = sog->rowStart[y + 1];
+	if (begin == end) return PF_Err_NONE;
+
+	A_long left = sog->x[begin];
+	A_long span = sog->x[end - 1] - left + 1;
+	float *filtered = (float*)malloc(span * sizeof(float));
+	if (!filtered) return PF_Err_OUT_OF_MEMORY;
+
+	for (A_long c = 0; c < 5; c++) {
+		const float *center = job->planes[c] + y * width + left;
+		for (A_long i = 0; i < span; i++) filtered[i] = job->taps[0] * center[i];
+		for (A_long k = 1; k <= radius; k++) {
+			SoGAddTapPair(job->ctx->simdLevel, filtered, center - k * width, center + k * width, job->taps[k], span);
+		}
+
+		float *sums = sog->sums[c];
+		for (A_long j = begin; j < end; j++) sums[j] += job->amplitude * filtered[sog->x[j] - left];
+	}
+
+	free(filtered);
+	return PF_Err_NONE;
+}
+
+static void DisposeSoGFill(SoGFill *sog) {
+	free(sog->rowStart);
+	free(sog->x);
+	for (A_long c = 0; c < 5; c++) free(sog->sums[c]);
+	memset(sog, 0, sizeof(*sog));
+}
+
+// Index the line pixels, then accumulate every fitted term into ctx->sog
+static PF_Err RunSoGPass(const CX_Host *host, ProcessingContext *ctx,
+                         PF_PixelFormat format, PF_EffectWorld *world) {
+	PF_Err err = PF_Err_NONE;
+	ColorLinesInfo *info = ctx->info;
+	SoGFill *sog = &ctx->sog;
+	A_long width = world->width;
+	A_long height = world->height;
+	A_long radius = info->searchRadius;
+
+	sog->rowStart = (A_long*)malloc((height + 1) * sizeof(A_long));
+	if (!sog->rowStart) return PF_Err_OUT_OF_MEMORY;
+	A_long count = 0;
+	for (A_long y = 0; y < height; y++) {
+		sog->rowStart[y] = count;
+		const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+		for (A_long x = 0; x < width; x++) count += (maskRow[x] == LINE_MASK_FILLED);
+	}
+	sog->rowStart[height] = count;
+
+	sog->x = (A_long*)malloc(CX_MAX(count, 1) * sizeof(A_long));
+	if (!sog->x) err = PF_Err_OUT_OF_MEMORY;
+	for (A_long c = 0; c < 5 && !err; c++) {
+		sog->sums[c] = (float*)calloc(CX_MAX(count, 1), sizeof(float));
+		if (!sog->sums[c]) err = PF_Err_OUT_OF_MEMORY;
+	}
+	if (err || count == 0) return err;
+
+	for (A_long y = 0, j = 0; y < height; y++) {
+		const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+		for (A_long x = 0; x < width; x++) {
+			if (maskRow[x] == LINE_MASK_FILLED) sog->x[j++] = x;
+		}
+	}
+
+	// The separable passes touch every row near a line; with few line pixels
+	// the exact fill is cheaper, so compare tap counts before committing
+	A_u_longlong exactTaps = (A_u_longlong)count * (2 * radius + 1) * (2 * radius + 1);
+	A_u_longlong sogTaps = 0;
+	for (A_long y = 0; y < height; y++) {
+		if (sog->rowStart[CX_MIN(y + radius + 1, height)] > sog->rowStart[CX_MAX(y - radius, 0)]) {
+			sogTaps += CX_MAX(width - 2 * radius, 0);
+		}
+		if (sog->rowStart[y + 1] > sog->rowStart[y]) {
+			sogTaps += sog->x[sog->rowStart[y + 1] - 1] - sog->x[sog->rowStart[y]] + 1;
+		}
+	}
+	if ((PF_FpLong)sogTaps * SOG_TERMS * (radius + 1) * SOG_TAP_COST >= (PF_FpLong)exactTaps) {
+		DisposeSoGFill(sog);
+		ctx->sogFit = NULL;
+		return err;
+	}
+
+	SoGTermJob job;
+	memset(&job, 0, sizeof(job));
+	job.ctx = ctx;
+	job.world = world;
+	float *planes = (float*)malloc((size_t)width * height * 5 * sizeof(float));
+	float *taps = (float*)malloc((radius + 1) * sizeof(float));
+	if (!planes || !taps) err = PF_Err_OUT_OF_MEMORY;
+
+	for (A_long term = 0; term < SOG_TERMS && !err; term++) {
+		PF_FpLong sigma = ctx->sogFit->sigma[term];
+		for (A_long k = 0; k <= radius; k++) taps[k] = (float)exp(-(PF_FpLong)(k * k) / (2.0 * sigma * sigma));
+		for (A_long c = 0; c < 5; c++) job.planes[c] = planes + (size_t)width * height * c;
+		job.taps = taps;
+		job.amplitude = (float)ctx->sogFit->amplitude[term];
+
+		switch (format) {
+			case PF_PixelFormat_ARGB32:
+				err = CX_HostIterate(host, height, (void*)&job, SoGHorizontalRow<PF_Pixel8>);
+				break;
+			case PF_PixelFormat_ARGB64:
+				err = CX_HostIterate(host, height, (void*)&job, SoGHorizontalRow<PF_Pixel16>);
+				break;
+			case PF_PixelFormat_ARGB128:
+				err = CX_HostIterate(host, height, (void*)&job, SoGHorizontalRow<PF_PixelFloat>);
+				break;
+			default:
+				err = PF_Err_BAD_CALLBACK_PARAM;
+				break;
+		}
+		if (!err) err = CX_HostIterate(host, height, (void*)&job, SoGVerticalRow);
+	}
+
+	free(planes);
+	free(taps);
+	return err;
+}
+
+// ============================================================================
+// Membrane Fill (multigrid Laplace solve)
+// ============================================================================
+
+// Line pixels are unknowns of the discrete Laplace equation: each equals the
+// mean of its valid and line 4-neighbors. Valid pixels are fixed boundary
+// values; transparent and edge pixels are left out (zero flux). Coarse levels
+// use the Galerkin operator of piecewise constant 2x2 blocks, so they stay
+// consistent with the fine masks whatever their shape. A fixed cycle count
+// keeps the result independent of threading.
+
+#define MEMBRANE_CYCLES			6
+#define MEMBRANE_SWEEPS			2		// Red-black sweeps before and after each coarse correction
+#define MEMBRANE_COARSE_SWEEPS	30		// Coarsest level, a few cells
+#define MEMBRANE_CORRECTION		1.25f	// Over-correction offsets the constant prolongation (measured)
+#define MEMBRANE_PARALLEL_CELLS	16384	// Smaller levels run on the calling thread
+
+typedef struct {
+	MembraneFill *mg;
+	A_long level;
+	A_long parity;			// Relax: cells with (x + y) & 1 == parity
+} MembraneJob;
+
+// Coupling-weighted sum of a cell's four neighbors, added to sum
+static inline void MembraneAddNeighbors(const MembraneLevel *L, A_long i, float *sum) {
+	const float wLeft = L->right[i - 1], wRight = L->right[i];
+	const float wUp = L->down[i - L->width], wDown = L->down[i];
+	const float *left = L->value + (i - 1) * 4;
+	const float *right = L->value + (i + 1) * 4;
+	const float *up = L->value + (i - L->width) * 4;
+	const float *down = L->value + (i + L->width) * 4;
+	for (A_long c = 0; c < 4; c++) {
+		sum[c] += wLeft * left[c] + wRight * right[c] + wUp * up[c] + wDown * down[c];
+	}
+}
+
+// Gauss-Seidel update of one color of a row (iterate_generic row job); cells
+// of one color only read the other, so rows are independent
+static PF_Err MembraneRelaxRow(void *refcon, A_long thread_idx, A_long y, A_long iterations) {
+	MembraneJob *job = (MembraneJob*)refcon;
+	const MembraneLevel *L = &job->mg->levels[job->level];
+	A_long width = L->width;
+
+	for (A_long j = L->rowStart[y]; j < L->rowStart[y + 1]; j++) {
+		A_long x = L->cellX[j];
+		if (((x + y) & 1) != job->parity) continue;
+		A_long i = y * width + x;
+
+		float sum[4];
+		for (A_long c = 0; c < 4; c++) sum[c] = L->rhs[i * 4 + c];
+		MembraneAddNeighbors(L, i, sum);
+
+		float invDiag = 1.0f / L->diag[i];
+		for (A_long c = 0; c < 4; c++) L->value[i * 4 + c] = sum[c] * invDiag;
+	}
+	return PF_Err_NONE;
+}
+
+// Residual of rows 2Y and 2Y + 1 summed into coarse row Y (iterate_generic
+// row job over the coarse level); also clears the coarse correction
+static PF_Err MembraneRestrictRow(void *refcon, A_long thread_idx, A_long Y, A_long iterations) {
+	MembraneJob *job = (MembraneJob*)refcon;
+	const MembraneLevel *L = &job->mg->levels[job->level];
+	const MembraneLevel *C = &job->mg->levels[job->level + 1];
+	A_long width = L->width;
+
+	memset(C->value + Y * C->width * 4, 0, C->width * 4 * sizeof(float));
+	memset(C->rhs + Y * C->width * 4, 0, C->width * 4 * sizeof(float));
+
+	for (A_long y = Y * 2; y < CX_MIN(Y * 2 + 2, L->height); y++) {
+		for (A_long j = L->rowStart[y]; j < L->rowStart[y + 1]; j++) {
+			A_long x = L->cellX[j];
+			A_long i = y * width + x;
+
+			float residual[4];
+			for (A_long c = 0; c < 4; c++) residual[c] = L->rhs[i * 4 + c] - L->diag[i] * L->value[i * 4 + c];
+			MembraneAddNeighbors(L, i, residual);
+
+			float *coarse = C->rhs + (Y * C->width + x / 2) * 4;
+			for (A_long c = 0; c < 4; c++) coarse[c] += residual[c];
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Add the coarse correction to one fine row (iterate_generic row job)
+static PF_Err MembraneProlongRow(void *refcon, A_long thread_idx, A_long y, A_long iterations) {
+	MembraneJob *job = (MembraneJob*)refcon;
+	const MembraneLevel *L = &job->mg->levels[job->level];
+	const MembraneLevel *C = &job->mg->levels[job->level + 1];
+
+	for (A_long j = L->rowStart[y]; j < L->rowStart[y + 1]; j++) {
+		A_long x = L->cellX[j];
+		A_long i = y * L->width + x;
+		const float *correction = C->value + ((y / 2) * C->width + x / 2) * 4;
+		for (A_long c = 0; c < 4; c++) L->value[i * 4 + c] += MEMBRANE_CORRECTION * correction[c];
+	}
+	return PF_Err_NONE;
+}
+
+static PF_Err MembraneRows(const CX_Host *host, MembraneJob *job, A_long rows,
+                           PF_Err (*fn)(void*, A_long, A_long, A_long)) {
+	const MembraneLevel *L = &job->mg->levels[job->level];
+	if (L->width * L->height >= MEMBRANE_PARALLEL_CELLS) {
+		return CX_HostIterate(host, rows, (void*)job, fn);
+	}
+	for (A_long y = 0; y < rows; y++) fn((void*)job, 0, y, rows);
+	return PF_Err_NONE;
+}
+
+static PF_Err MembraneRelax(const CX_Host *host, MembraneFill *mg, A_long level, A_long sweeps) {
+	PF_Err err = PF_Err_NONE;
+	MembraneJob job = { mg, level, 0 };
+	for (A_long s = 0; s < sweeps && !err; s++) {
+		for (job.parity = 0; job.parity < 2 && !err; job.parity++) {
+			err = MembraneRows(host, &job, mg->levels[level].height, MembraneRelaxRow);
+		}
+	}
+	return err;
+}
+
+static PF_Err MembraneVCycle(const CX_Host *host, MembraneFill *mg, A_long level) {
+	PF_Err err = PF_Err_NONE;
+	if (level == mg->levelCount - 1) return MembraneRelax(host, mg, level, MEMBRANE_COARSE_SWEEPS);
+
+	MembraneJob job = { mg, level, 0 };
+	err = MembraneRelax(host, mg, level, MEMBRANE_SWEEPS);
+	if (!err) err = MembraneRows(host, &job, mg->levels[level + 1].height, MembraneRestrictRow);
+	if (!err) err = MembraneVCycle(host, mg, level + 1);
+	if (!err) err = MembraneRows(host, &job, mg->levels[level].height, MembraneProlongRow);
+	if (!err) err = MembraneRelax(host, mg, level, MEMBRANE_SWEEPS);
+	return err;
+}
+
+static void DisposeMembraneFill(MembraneFill *mg) {
+	free(mg->buffer);
+	free(mg->index);
+	memset(mg, 0, sizeof(*mg));
+}
+
+// Level 0 over the line pixels' bounding box (plus their valid neighbors):
+// line pixels connected to a valid pixel become unknowns, fixed neighbors
+// move to the right-hand side
+template <typename PixelT>
+static PF_Err SetupMembraneLevel(ProcessingContext *ctx, PF_EffectWorld *world) {
+	ColorLinesInfo *info = ctx->info;
+	MembraneFill *mg = &ctx->membrane;
+	MembraneLevel *L = &mg->levels[0];
+	A_long left = mg->bounds.left, top = mg->bounds.top;
+	A_long width = L->width, height = L->height;
+
+	// Flood from line pixels touching a valid pixel; the rest have no boundary
+	// value and would make the system singular
+	A_long *queue = (A_long*)malloc((size_t)width * height * sizeof(A_long));
+	if (!queue) return PF_Err_OUT_OF_MEMORY;
+	A_long head = 0, tail = 0;
+	const A_long dx[4] = { -1, 1, 0, 0 };
+	const A_long dy[4] = { 0, 0, -1, 1 };
+
+	for (A_long y = 0; y < height; y++) {
+		for (A_long x = 0; x < width; x++) {
+			if (GetMaskAtFast(info, left + x, top + y) != LINE_MASK_FILLED) continue;
+			for (A_long n = 0; n < 4; n++) {
+				if (GetMaskAtFast(info, left + x + dx[n], top + y + dy[n]) == LINE_MASK_VALID) {
+					L->diag[y * width + x] = 1.0f;
+					queue[tail++] = y * width + x;
+					break;
+				}
+			}
+		}
+	}
+	while (head < tail) {
+		A_long i = queue[head++];
+		A_long x = i % width, y = i / width;
+		for (A_long n = 0; n < 4; n++) {
+			A_long j = i + dy[n] * width + dx[n];
+			if (L->diag[j] == 0 && GetMaskAtFast(info, left + x + dx[n], top + y + dy[n]) == LINE_MASK_FILLED) {
+				L->diag[j] = 1.0f;
+				queue[tail++] = j;
+			}
+		}
+	}
+	free(queue);
+
+	// Line pixels never touch the frame edge, so their neighbors are in bounds
+	for (A_long y = 0; y < height; y++) {
+		for (A_long x = 0; x < width; x++) {
+			A_long i = y * width + x;
+			if (L->diag[i] == 0) continue;
+
+			float diag = 0;
+			float *rhs = L->rhs + i * 4;
+			for (A_long n = 0; n < 4; n++) {
+				A_long nx = left + x + dx[n], ny = top + y + dy[n];
+				A_u_char mask = GetMaskAtFast(info, nx, ny);
+				if (mask == LINE_MASK_VALID) {
+					const PixelT *p = CX_GetRow<PixelT>(world, ny) + nx;
+					rhs[0] += (float)p->red;
+					rhs[1] += (float)p->green;
+					rhs[2] += (float)p->blue;
+					rhs[3] += (float)p->alpha;
+					diag += 1.0f;
+				} else if (mask == LINE_MASK_FILLED) {
+					diag += 1.0f;
+				}
+			}
+			L->diag[i] = diag;
+			if (GetMaskAtFast(info, left + x + 1, top + y) == LINE_MASK_FILLED) L->right[i] = 1.0f;
+			if (GetMaskAtFast(info, left + x, top + y + 1) == LINE_MASK_FILLED) L->down[i] = 1.0f;
+
+			// Start from the mean of the fixed neighbors
+			for (A_long c = 0; c < 4; c++) L->value[i * 4 + c] = rhs[c] / diag;
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Galerkin coarsening: a block's diagonal sums its cells' minus twice the
+// couplings inside it; couplings crossing blocks add up
+static void BuildMembraneCoarseLevel(const MembraneLevel *L, MembraneLevel *C) {
+	for (A_long y = 0; y < L->height; y++) {
+		for (A_long x = 0; x < L->width; x++) {
+			A_long i = y * L->width + x;
+			if (L->diag[i] == 0) continue;
+
+			A_long I = (y / 2) * C->width + x / 2;
+			C->diag[I] += L->diag[i];
+			if (L->right[i] != 0) {
+				if ((x & 1) == 0) C->diag[I] -= 2 * L->right[i];
+				else C->right[I] += L->right[i];
+			}
+			if (L->down[i] != 0) {
+				if ((y & 1) == 0) C->diag[I] -= 2 * L->down[i];
+				else C->down[I] += L->down[i];
+			}
+		}
+	}
+}
+
+// List the solved cells of a level row by row; cellX has room for every cell
+static void IndexMembraneLevel(MembraneLevel *L, A_long *rowStart, A_long *cellX) {
+	A_long count = 0;
+	L->rowStart = rowStart;
+	L->cellX = cellX;
+	for (A_long y = 0; y < L->height; y++) {
+		rowStart[y] = count;
+		const float *diagRow = L->diag + y * L->width;
+		for (A_long x = 0; x < L->width; x++) {
+			if (diagRow[x] != 0) cellX[count++] = x;
+		}
+	}
+	rowStart[L->height] = count;
+}
+
+// Solve the membrane over the line pixels into ctx->membrane
+static PF_Err RunMembranePass(const CX_Host *host, ProcessingContext *ctx,
+                              PF_PixelFormat format, PF_EffectWorld *world) {
+	PF_Err err = PF_Err_NONE;
+	ColorLinesInfo *info = ctx->info;
+	MembraneFill *mg = &ctx->membrane;
+
+	// Bounding box of the line pixels, grown by their fixed neighbors
+	PF_LRect bounds = { world->width, world->height, 0, 0 };
+	for (A_long y = 0; y < world->height; y++) {
+		const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+		for (A_long x = 0; x < world->width; x++) {
+			if (maskRow[x] != LINE_MASK_FILLED) continue;
+			bounds.left = CX_MIN(bounds.left, x - 1);
+			bounds.top = CX_MIN(bounds.top, y - 1);
+			bounds.right = CX_MAX(bounds.right, x + 2);
+			bounds.bottom = CX_MAX(bounds.bottom, y + 2);
+		}
+	}
+	if (bounds.right <= bounds.left) return err;
+	mg->bounds = bounds;
+
+	// Level sizes, halving down to a few cells
+	size_t cells = 0, rows = 0;
+	A_long width = bounds.right - bounds.left;
+	A_long height = bounds.bottom - bounds.top;
+	for (mg->levelCount = 0; mg->levelCount < MEMBRANE_MAX_LEVELS; mg->levelCount++) {
+		mg->levels[mg->levelCount].width = width;
+		mg->levels[mg->levelCount].height = height;
+		cells += (size_t)width * (height + 2) + 2;
+		rows += height + 1;
+		if (width <= 2 || height <= 2) {
+			mg->levelCount++;
+			break;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	mg->buffer = (float*)calloc(cells * 11, sizeof(float));
+	mg->index = (A_long*)malloc((cells + rows) * sizeof(A_long));
+	if (!mg->buffer || !mg->index) return PF_Err_OUT_OF_MEMORY;
+	float *next = mg->buffer;
+	for (A_long l = 0; l < mg->levelCount; l++) {
+		MembraneLevel *L = &mg->levels[l];
+		size_t pad = L->width + 1;
+		size_t n = (size_t)L->width * L->height + pad * 2;
+		L->diag = next + pad;
+		L->right = next + n + pad;
+		L->down = next + n * 2 + pad;
+		L->value = next + n * 3 + pad * 4;
+		L->rhs = next + n * 7 + pad * 4;
+		next += n * 11;
+	}
+
+	switch (format) {
+		case PF_PixelFormat_ARGB32:
+			err = SetupMembraneLevel<PF_Pixel8>(ctx, world);
+			break;
+		case PF_PixelFormat_ARGB64:
+			err = SetupMembraneLevel<PF_Pixel16>(ctx, world);
+			break;
+		case PF_PixelFormat_ARGB128:
+			err = SetupMembraneLevel<PF_PixelFloat>(ctx, world);
+			break;
+		default:
+			err = PF_Err_BAD_CALLBACK_PARAM;
+			break;
+	}
+	A_long *nextIndex = mg->index;
+	for (A_long l = 0; l < mg->levelCount && !err; l++) {
+		MembraneLevel *L = &mg->levels[l];
+		if (l > 0) BuildMembraneCoarseLevel(&mg->levels[l - 1], L);
+		IndexMembraneLevel(L, nextIndex, nextIndex + L->height + 1);
+		nextIndex += L->height + 1 + (size_t)L->width * L->height;
+	}
+
+	for (A_long cycle = 0; cycle < MEMBRANE_CYCLES && !err; cycle++) {
+		err = MembraneVCycle(host, mg, 0);
+	}
+	return err;
+}
+
+// ============================================================================
+// Distance Output (exact Euclidean distance transform)
+// ============================================================================
+
+// Separable transform after Felzenszwalb & Huttenlocher: the column pass finds
+// each pixel's distance g to the nearest feature in its column, the row pass
+// takes the lower envelope of the parabolas (x - q)^2 + g(q)^2 along the row.
+// Exact and independent of Search Radius, unlike the Nearest ring search.
+typedef struct {
+	const ColorLinesInfo *info;
+	A_u_char isFeature[256];	// By mask value: 1 for the pixels distances are measured to
+	A_u_short *columnDist;	// g per mask pixel, DISTANCE_NONE where a column has no feature
+	PF_EffectWorld *output;
+	PF_LRect area;
+	PF_FpLong scale;		// 1 / Distance Range
+	A_long reach;			// Columns whose g exceeds the range only give full-value distances
+} DistanceJob;
+
+// Column pass (iterate_generic job): one strip of DISTANCE_COLUMN_STRIP columns,
+// swept down then up a row at a time so reads stay row-major
+static PF_Err DistanceColumnStrip(void *refcon, A_long thread_idx, A_long i, A_long iterations) {
+	DistanceJob *job = (DistanceJob*)refcon;
+	const ColorLinesInfo *info = job->info;
+	A_long width = info->maskWidth;
+	A_long height = info->maskHeight;
+	A_long left = i * DISTANCE_COLUMN_STRIP;
+	A_long right = CX_MIN(left + DISTANCE_COLUMN_STRIP, width);
+
+	A_u_short *distRow = job->columnDist;
+	for (A_long x = left; x < right; x++) {
+		distRow[x] = job->isFeature[info->lineMask[x]] ? 0 : DISTANCE_NONE;
+	}
+	for (A_long y = 1; y < height; y++) {
+		const A_u_char *maskRow = info->lineMask + y * info->maskRowBytes;
+		const A_u_short *aboveRow = distRow;
+		distRow += width;
+		for (A_long x = left; x < right; x++) {
+			distRow[x] = job->isFeature[maskRow[x]] ? 0 : (A_u_short)CX_MIN(aboveRow[x] + 1, DISTANCE_NONE);
+		}
+	}
+	for (A_long y = height - 2; y >= 0; y--) {
+		const A_u_short *belowRow = distRow;
+		distRow -= width;
+		for (A_long x = left; x < right; x++) {
+			distRow[x] = (A_u_short)CX_MIN(distRow[x], belowRow[x] + 1);
+		}
+	}
+	return PF_Err_NONE;
+}
+
+// Distance channel of an output pixel
+template <typename PixelT>
+static inline typename CX_PixelTraits<PixelT>::ChannelType *DistanceChannel(PixelT *pixel, A_long channel) {
+	switch (channel) {
+		case DISTANCE_CHANNEL_RED: return &pixel->red;
+		case DISTANCE_CHANNEL_GREEN: return &pixel->green;
+		case DISTANCE_CHANNEL_BLUE: return &pixel->blue;
+		default: return &pixel->alpha;
+	}
+}
+
+// Row pass (iterate_generic job): DISTANCE_ROW_BAND output rows sharing one
+// envelope scratch; distance / range, clamped to 1, replaces the selected channel
+template <typename PixelT>
+static PF_Err DistanceRowBand(void *refcon, A_long thread_idx, A_long i, A_long iterations) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	typedef typename Traits::ChannelType ChannelType;
+	const DistanceJob *job = (const DistanceJob*)refcon;
+	const A_long width = job->info->maskWidth;
+	const A_long channel = job->info->distanceChannel;
+	const A_long reach = job->reach;
+	const PF_FpLong scale = job->scale;
+	const PF_FpLong rangeSq = 1.0 / (scale * scale);
+	const PF_LRect area = job->area;
+	A_long top = area.top + i * DISTANCE_ROW_BAND;
+	A_long bottom = CX_MIN(top + DISTANCE_ROW_BAND, area.bottom);
+
+	// Envelope parabolas: vertex column v and h = g(v)^2 + v^2. Intersections
+	// are compared cross-multiplied, exact in doubles for any AE frame size.
+	A_long *v = (A_long*)malloc(width * sizeof(A_long));
+	PF_FpLong *h = (PF_FpLong*)malloc(width * sizeof(PF_FpLong));
+	if (!v || !h) {
+		free(v);
+		free(h);
+		return PF_Err_OUT_OF_MEMORY;
+	}
+
+	for (A_long y = top; y < bottom; y++) {
+		const A_u_short *g = job->columnDist + (size_t)y * width;
+
+		// Lower envelope: q hides v[k] when it overtakes v[k] no later than
+		// v[k] overtakes v[k - 1]
+		A_long k = -1;
+		for (A_long q = 0; q < width; q++) {
+			if (g[q] > reach) continue;
+			PF_FpLong hq = (PF_FpLong)g[q] * g[q] + (PF_FpLong)q * q;
+			while (k >= 1 && (hq - h[k]) * (v[k] - v[k - 1]) <= (h[k] - h[k - 1]) * (q - v[k])) {
+				k--;
+			}
+			k++;
+			v[k] = q;
+			h[k] = hq;
+		}
+
+		// Envelope order is x order: the next parabola takes over once it is no higher
+		ChannelType *out = DistanceChannel(CX_GetRow<PixelT>(job->output, y) + area.left, channel);
+		A_long j = 0;
+		for (A_long x = area.left; x < area.right; x++, out += sizeof(PixelT) / sizeof(ChannelType)) {
+			PF_FpLong dist = 1.0;
+			if (k >= 0) {
+				while (j < k && h[j + 1] - 2.0 * x * v[j + 1] <= h[j] - 2.0 * x * v[j]) j++;
+				PF_FpLong distSq = h[j] - 2.0 * x * v[j] + (PF_FpLong)x * x;
+				if (distSq < rangeSq) dist = sqrt(distSq) * scale;
+			}
+			*out = Traits::FromUnit(dist);
+		}
+	}
+
+	free(v);
+	free(h);
+	return PF_Err_NONE;
+}
+
+// Distance output over the output extent, after the fill and blur passes
+static PF_Err RunDistancePass(const CX_Host *host, ColorLinesInfo *info,
+                              PF_PixelFormat format, PF_EffectWorld *output) {
+	PF_Err err = PF_Err_NONE;
+	DistanceJob job;
+	AEFX_CLR_STRUCT(job);
+	job.info = info;
+	job.output = output;
+	job.area = output->extent_hint;
+	job.area.left = CX_MAX(job.area.left, 0);
+	job.area.top = CX_MAX(job.area.top, 0);
+	job.area.right = CX_MIN(job.area.right, CX_MIN(info->maskWidth, output->width));
+	job.area.bottom = CX_MIN(job.area.bottom, CX_MIN(info->maskHeight, output->height));
+	job.scale = 1.0 / info->distanceRange;
+	job.reach = (A_long)ceil(info->distanceRange);
+	for (A_long m = 0; m < 256; m++) {
+		job.isFeature[m] = (info->distanceOutput == DISTANCE_OUTPUT_TO_LINE) ?
+			(m == LINE_MASK_FILLED || m == LINE_MASK_EDGE) : (m == LINE_MASK_VALID);
+	}
+	A_long rows = job.area.bottom - job.area.top;
+	if (job.area.right <= job.area.left || rows <= 0) return err;
+
+	job.columnDist = (A_u_short*)malloc((size_t)info->maskWidth * info->maskHeight * sizeof(A_u_short));
+	if (!job.columnDist) return PF_Err_OUT_OF_MEMORY;
+
+	A_long strips = (info->maskWidth + DISTANCE_COLUMN_STRIP - 1) / DISTANCE_COLUMN_STRIP;
+	err = CX_HostIterate(host, strips, (void*)&job, DistanceColumnStrip);
+
+	A_long bands = (rows + DISTANCE_ROW_BAND - 1) / DISTANCE_ROW_BAND;
+	if (!err) {
+		switch (format) {
+			case PF_PixelFormat_ARGB32:
+				err = CX_HostIterate(host, bands, (void*)&job, DistanceRowBand<PF_Pixel8>);
+				break;
+			case PF_PixelFormat_ARGB64:
+				err = CX_HostIterate(host, bands, (void*)&job, DistanceRowBand<PF_Pixel16>);
+				break;
+			case PF_PixelFormat_ARGB128:
+				err = CX_HostIterate(host, bands, (void*)&job, DistanceRowBand<PF_PixelFloat>);
+				break;
+			default:
+				err = PF_Err_BAD_CALLBACK_PARAM;
+				break;
+		}
+	}
+
+	free(job.columnDist);
+	return err;
+}
+
+// ============================================================================
+// Optimized Blur Pass with Precomputed Weights
+// ============================================================================
+
+// The blur reads a staged copy of the filled output with a blurRadius border
+// on every side. Only LINE_MASK_FILLED pixels are staged and flagged; the
+// border is never flagged, so taps need no bounds checks. Unflagged taps are
+// still skipped: lines are thin, and skipping them beat multiplying by zero
+// from radius 2 up.
+typedef struct {
+	A_long blurRadius;
+	A_long blurSize;
+	const PF_FpLong *weights;
+	A_long width;			// Staged area: output and mask overlap
+	A_long height;
+	A_long stride;			// Staged pixels per row, width + 2 * blurRadius
+	void *pixels;			// PixelT, (height + 2 * blurRadius) rows
+	A_u_char *filled;		// 1 where the staged pixel is a filled line pixel
+} BlurContext;
+
+// Blur staging and blur rows over one world, one job per row
+typedef struct {
+	BlurContext *blur;
+	ColorLinesInfo *info;
+	PF_EffectWorld *output;
+	PF_LRect area;
+} BlurJob;
+
+// Stage one output row (iterate_generic row job)
+template <typename PixelT>
+static PF_Err StageBlurRow(void *refcon, A_long thread_idx, A_long y, A_long iterations) {
+	BlurJob *job = (BlurJob*)refcon;
+	const BlurContext *blur = job->blur;
+	const A_u_char *maskRow = job->info->lineMask + y * job->info->maskRowBytes;
+	const PixelT *outRow = CX_GetRow<PixelT>(job->output, y);
+	size_t offset = (size_t)(y + blur->blurRadius) * blur->stride + blur->blurRadius;
+	PixelT *stagedRow = (PixelT*)blur->pixels + offset;
+	A_u_char *filledRow = blur->filled + offset;
+
+	for (A_long x = 0; x < blur->width; x++) {
+		if (maskRow[x] != LINE_MASK_FILLED) continue;
+		stagedRow[x] = outRow[x];
+		filledRow[x] = 1;
+	}
+	return PF_Err_NONE;
+}
+
+template <typename PixelT>
+static void BlurPass_Optimized(const BlurContext *ctx, A_long xL, A_long yL, PixelT *outP) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	typedef typename Traits::AccumType AccumT;
+	A_long blurSize = ctx->blurSize;
+	AccumT sumR = 0, sumG = 0, sumB = 0, sumA = 0;
+	PF_FpLong totalWeight = 0;
+
+	// Window top-left in staged coordinates is (xL, yL)
+	const PixelT *rowPtr = (const PixelT*)ctx->pixels + (size_t)yL * ctx->stride + xL;
+	const A_u_char *filledRow = ctx->filled + (size_t)yL * ctx->stride + xL;
+	const PF_FpLong *weightRow = ctx->weights;
+
+	for (A_long row = 0; row < blurSize; row++) {
+		for (A_long k = 0; k < blurSize; k++) {
+			if (!filledRow[k]) continue;
+			const PixelT *neighbor = rowPtr + k;
+			PF_FpLong weight = weightRow[k];
+			sumR += neighbor->red * weight;
+			sumG += neighbor->green * weight;
+			sumB += neighbor->blue * weight;
+			sumA += neighbor->alpha * weight;
+			totalWeight += weight;
+		}
+		rowPtr += ctx->stride;
+		filledRow += ctx->stride;
+		weightRow += blurSize;
+	}
+
+	if (totalWeight > 0) {
+		PF_FpLong invWeight = 1.0 / totalWeight;
+		outP->red = Traits::FromAccum(sumR * invWeight);
+		outP->green = Traits::FromAccum(sumG * invWeight);
+		outP->blue = Traits::FromAccum(sumB * invWeight);
+		outP->alpha = Traits::FromAccum(sumA * invWeight);
+	}
+}
+
+// Blur the filled pixels of one row in place; the rest already hold the fill output
+template <typename PixelT>
+static PF_Err BlurRow(void *refcon, A_long thread_idx, A_long i, A_long iterations) {
+	BlurJob *job = (BlurJob*)refcon;
+	const BlurContext *blur = job->blur;
+	A_long y = job->area.top + i;
+	PixelT *outRow = CX_GetRow<PixelT>(job->output, y);
+	const A_u_char *filledRow = blur->filled + (size_t)(y + blur->blurRadius) * blur->stride + blur->blurRadius;
+	A_long right = CX_MIN(job->area.right, blur->width);
+	for (A_long x = job->area.left; x < right; x++) {
+		if (filledRow[x]) BlurPass_Optimized<PixelT>(blur, x, y, outRow + x);
+	}
+	return PF_Err_NONE;
+}
+
+template <typename PixelT>
+static PF_Err RunBlurRows(const CX_Host *host, BlurJob *job) {
+	PF_Err err = CX_HostIterate(host, job->blur->height, (void*)job, StageBlurRow<PixelT>);
+	if (!err) {
+		job->area.top = CX_MAX(job->area.top, 0);
+		job->area.bottom = CX_MIN(job->area.bottom, job->blur->height);
+		A_long rows = job->area.bottom - job->area.top;
+		if (rows > 0) err = CX_HostIterate(host, rows, (void*)job, BlurRow<PixelT>);
+	}
+	return err;
+}
+
+static PF_Err RunBlurPass(const CX_Host *host, ColorLinesInfo *info, PF_PixelFormat format,
+                          PF_EffectWorld *output, A_long blurRadius) {
+	PF_Err err = PF_Err_NONE;
+
+	size_t pixelSize;
+	switch (format) {
+		case PF_PixelFormat_ARGB32:		pixelSize = sizeof(PF_Pixel8); break;
+		case PF_PixelFormat_ARGB64:		pixelSize = sizeof(PF_Pixel16); break;
+		case PF_PixelFormat_ARGB128:	pixelSize = sizeof(PF_PixelFloat); break;
+		default:						return PF_Err_BAD_CALLBACK_PARAM;
+	}
+
+	// Precompute gaussian weights
+	A_long blurSize = blurRadius * 2 + 1;
+	PF_FpLong *blurWeights = (PF_FpLong*)malloc(blurSize * blurSize * sizeof(PF_FpLong));
+	if (!blurWeights) return PF_Err_OUT_OF_MEMORY;
+	BuildGaussianWeights(blurWeights, blurRadius);
+
+	// Blur reads the filled output, so it works from a staged copy
+	BlurContext blurCtx;
+	blurCtx.blurRadius = blurRadius;
+	blurCtx.blurSize = blurSize;
+	blurCtx.weights = blurWeights;
+	blurCtx.width = CX_MIN(output->width, info->maskWidth);
+	blurCtx.height = CX_MIN(output->height, info->maskHeight);
+	blurCtx.stride = blurCtx.width + blurRadius * 2;
+	size_t stagedCount = (size_t)blurCtx.stride * (blurCtx.height + blurRadius * 2);
+	blurCtx.pixels = malloc(stagedCount * pixelSize);
+	blurCtx.filled = (A_u_char*)calloc(stagedCount, 1);
+	if (!blurCtx.pixels || !blurCtx.filled) err = PF_Err_OUT_OF_MEMORY;
+
+	if (!err) {
+		BlurJob job;
+		job.blur = &blurCtx;
+		job.info = info;
+		job.output = output;
+		job.area = output->extent_hint;
+
+		switch (format) {
+			case PF_PixelFormat_ARGB32:
+				err = RunBlurRows<PF_Pixel8>(host, &job);
+				break;
+			case PF_PixelFormat_ARGB64:
+				err = RunBlurRows<PF_Pixel16>(host, &job);
+				break;
+			case PF_PixelFormat_ARGB128:
+				err = RunBlurRows<PF_PixelFloat>(host, &job);
+				break;
+		}
+	}
+
+	free(blurCtx.pixels);
+	free(blurCtx.filled);
+	free(blurWeights);
+	return err;
+}
+
+// ============================================================================
+// Render
+// ============================================================================
+
+PF_Err ColorLinesRender(const CX_Host *host, ColorLinesInfo *infoP, PF_PixelFormat format,
+						PF_EffectWorld *input_worldP, PF_EffectWorld *output_worldP) {
+	PF_Err err = PF_Err_NONE;
+	infoP->srcWorld = input_worldP;
+
+	// Line mask covers the source world, written in full by the mask pass
+	infoP->maskWidth = input_worldP->width;
+	infoP->maskHeight = input_worldP->height;
+	infoP->maskRowBytes = input_worldP->width;
+
+	// Initialize processing context with precomputed values and the stage plan
+	ProcessingContext ctx;
+	AEFX_CLR_STRUCT(ctx);
+	err = InitProcessingContext(&ctx, infoP);
+	const ColorLinesStages *stages = &ctx.stages;
+
+	// Mask pass: one classification of every source pixel against all target colors
+	CX_FrameBufferP frameMask, prevMask, nextMask;
+	const A_u_longlong *srcFrameKeyP = infoP->srcFrameKey ? &infoP->srcFrameKey : NULL;
+	if (!err && stages->maskOutput) {
+		err = RunMaskOutputPass(host, &ctx, format, input_worldP, srcFrameKeyP, output_worldP);
+	} else if (!err && stages->temporal) {
+		// Shared through the ring so neighbouring renders reuse them
+		A_u_longlong paramsKey = LineMaskParamsKey(infoP, format);
+		err = GetCachedLineMask(host, &ctx, format, input_worldP, infoP->srcFrameKey, paramsKey, &frameMask);
+		if (!err) infoP->lineMask = frameMask->data();
+
+		if (!err && infoP->prevWorld) {
+			err = GetCachedLineMask(host, &ctx, format, infoP->prevWorld, infoP->prevFrameKey, paramsKey, &prevMask);
+			if (!err) infoP->prevMask = prevMask->data();
+		}
+		if (!err && infoP->nextWorld) {
+			err = GetCachedLineMask(host, &ctx, format, infoP->nextWorld, infoP->nextFrameKey, paramsKey, &nextMask);
+			if (!err) infoP->nextMask = nextMask->data();
+		}
+	} else if (!err) {
+		infoP->lineMask = (A_u_char*)malloc(infoP->maskWidth * infoP->maskHeight);
+		if (!infoP->lineMask) err = PF_Err_OUT_OF_MEMORY;
+		if (!err) err = RunLineMaskPass(host, &ctx, format, input_worldP, srcFrameKeyP, infoP->lineMask);
+	}
+	CX_ColorMatcherDispose(&ctx.matcher);
+
+	// Fill pass: replace line pixels from valid neighbors (Background Only
+	// clears them instead, so it needs none of the fill prep)
+	if (!err && stages->fill && infoP->fillMode == FILL_MODE_NEAREST) err = BuildValidBlocks(host, &ctx);
+	if (!err && ctx.sogFit) err = RunSoGPass(host, &ctx, format, input_worldP);
+	if (!err && stages->fill && infoP->fillMode == FILL_MODE_MEMBRANE) err = RunMembranePass(host, &ctx, format, input_worldP);
+	if (!err && !stages->maskOutput) err = RunFillPass(host, &ctx, format, input_worldP, output_worldP);
+	DisposeSoGFill(&ctx.sog);
+	DisposeMembraneFill(&ctx.membrane);
+	if (ctx.validBlocks.blocks4) {
+		free(ctx.validBlocks.blocks4);
+	}
+
+	// Blur pass: Sample Blur over the filled pixels
+	if (!err && stages->blurRadius >= 1) {
+		err = RunBlurPass(host, infoP, format, output_worldP, stages->blurRadius);
+	}
+
+	// Distance pass: replaces one channel with the distance field of the mask
+	if (!err && stages->distance) {
+		err = RunDistancePass(host, infoP, format, output_worldP);
+	}
+
+	if (ctx.invDistWeights) {
+		free(ctx.invDistWeights);
+	}
+	if (ctx.tapWeights) {
+		free(ctx.tapWeights);
+	}
+
+	// Free line mask (ring masks are released with their references)
+	if (infoP->lineMask && !frameMask) {
+		free(infoP->lineMask);
+	}
+	infoP->lineMask = NULL;
+	infoP->prevMask = infoP->nextMask = NULL;
+	return err;
+}
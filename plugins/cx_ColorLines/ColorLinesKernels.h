@@ -0,0 +1,165 @@
+/*
+	ColorLinesKernels.h
+
+	Color Line Extraction and Fill - host-neutral render core
+	Everything below the parameter UI: option enums, ranges, the render info
+	and the full render (mask, fill, adjust, blur, distance output). The AE
+	plugin and the OpenFX plugin both fill a ColorLinesInfo from their own
+	params and call ColorLinesRender with their CX_Host.
+*/
+
+#pragma once
+#ifndef COLOR_LINES_KERNELS_H
+#define COLOR_LINES_KERNELS_H
+
+#include "CXCommon.h"
+#include "CXHost.h"
+
+// Target color count: Target Color plus Color 2-8
+#define COLORLINES_MAX_COLORS	8
+
+// Fill mode options
+enum FillMode {
+	FILL_MODE_NEAREST = 1,
+	FILL_MODE_AVERAGE,
+	FILL_MODE_WEIGHTED,
+	FILL_MODE_MEMBRANE,		// Smooth Laplace interpolation across the whole line
+	FILL_MODE_NUM_MODES
+};
+
+// Output mode options
+enum OutputMode {
+	OUTPUT_MODE_FULL = 1,
+	OUTPUT_MODE_LINE_ONLY,
+	OUTPUT_MODE_BG_ONLY,
+	OUTPUT_MODE_LINE_MASK,	// Matte of the matched line pixels, no fill
+	OUTPUT_MODE_NUM_MODES
+};
+
+// Distance output options: Euclidean distance field written into one channel
+enum DistanceOutput {
+	DISTANCE_OUTPUT_OFF = 1,
+	DISTANCE_OUTPUT_TO_LINE,		// Distance to the nearest matched line pixel
+	DISTANCE_OUTPUT_TO_SOURCE,		// Distance to the nearest valid fill source
+	DISTANCE_OUTPUT_NUM_MODES
+};
+
+enum DistanceChannel {
+	DISTANCE_CHANNEL_ALPHA = 1,
+	DISTANCE_CHANNEL_RED,
+	DISTANCE_CHANNEL_GREEN,
+	DISTANCE_CHANNEL_BLUE,
+	DISTANCE_CHANNEL_NUM_CHANNELS
+};
+
+// Parameter defaults and ranges
+#define TOLERANCE_MIN		0.0
+#define TOLERANCE_MAX		100.0
+#define TOLERANCE_DFLT		0.0
+
+#define SEARCH_RADIUS_MIN	1
+#define SEARCH_RADIUS_MAX	50
+#define SEARCH_RADIUS_DFLT	5
+
+#define SAMPLE_BLUR_MIN		0.0
+#define SAMPLE_BLUR_MAX		100.0
+#define SAMPLE_BLUR_DFLT	0.0
+
+#define BRIGHTNESS_MIN		-100.0
+#define BRIGHTNESS_MAX		100.0
+#define BRIGHTNESS_DFLT		0.0
+
+#define CONTRAST_MIN		-100.0
+#define CONTRAST_MAX		100.0
+#define CONTRAST_DFLT		0.0
+
+#define SATURATION_MIN		-100.0
+#define SATURATION_MAX		100.0
+#define SATURATION_DFLT		0.0
+
+// Distance (px) written as full channel value; farther pixels clamp to it at every depth
+#define DISTANCE_RANGE_MIN	1.0
+#define DISTANCE_RANGE_MAX	1000.0
+#define DISTANCE_RANGE_DFLT	32.0
+
+// One target line color
+typedef struct {
+	PF_Boolean		enabled;
+	PF_Pixel		color;
+	PF_FpLong		tolerance;
+} ColorLinesTarget;
+
+// Plugin processing info structure
+typedef struct ColorLinesInfo {
+	// Color selection (colors[0] is Target Color, always enabled)
+	ColorLinesTarget	colors[COLORLINES_MAX_COLORS];
+
+	// Fill settings
+	A_long			fillMode;
+	A_long			searchRadius;
+	PF_Boolean		ignoreTransparent;
+	PF_FpLong		sampleBlur;
+	PF_Boolean		temporalFill;
+
+	// Temporal fill: adjacent frames (PreRender) and their line masks (SmartRender)
+	PF_Boolean		hasPrevFrame;
+	PF_Boolean		hasNextFrame;
+	PF_EffectWorld	*prevWorld;
+	PF_EffectWorld	*nextWorld;
+	A_u_longlong	srcFrameKey;	// Host key per frame, changing whenever its pixels could; 0 hashes them
+	A_u_longlong	prevFrameKey;
+	A_u_longlong	nextFrameKey;
+	const A_u_char	*prevMask;
+	const A_u_char	*nextMask;
+
+	// Color adjustments
+	PF_FpLong		brightness;
+	PF_FpLong		contrast;
+	PF_FpLong		saturation;
+
+	// Output
+	A_long			outputMode;
+	A_long			distanceOutput;
+	A_long			distanceChannel;
+	PF_FpLong		distanceRange;
+
+	// Source image info for neighbor lookup
+	PF_EffectWorld	*srcWorld;
+	A_long			quality;		// PF_Quality_LO enables draft approximations
+
+	// Engine overrides for benchmarks (libcx_kernels); zero keeps the automatic choice
+	A_long			matchBackend;	// CX_MATCH_BACKEND_*
+	PF_Boolean		scalarKernels;	// Scalar fill kernels instead of the CPU's SIMD level
+
+	// Extent offset for coordinate mapping
+	A_long			x_offset;
+	A_long			y_offset;
+
+	// Line mask for multi-pass processing
+	A_u_char		*lineMask;
+	A_long			maskWidth;
+	A_long			maskHeight;
+	A_long			maskRowBytes;
+} ColorLinesInfo, *ColorLinesInfoP, **ColorLinesInfoH;
+
+// Render stages the params need: mask -> fill -> adjust -> blur -> distance.
+// ColorLinesRender runs and allocates for these stages only; hosts use them
+// to skip fetching what no stage reads (adjacent frames, the blur margin).
+typedef struct {
+	PF_Boolean		maskOutput;		// Line Mask output: the mask pass writes the output, nothing else runs
+	PF_Boolean		fill;			// Line pixels filled (Full Image, Lines Only)
+	PF_Boolean		temporal;		// Fill from adjacent frames and their masks
+	PF_Boolean		adjust;			// Brightness / Contrast / Saturation on filled pixels
+	A_long			blurRadius;		// Sample Blur over filled pixels, 0 when off
+	PF_Boolean		distance;		// Distance output into one channel
+} ColorLinesStages;
+
+void ColorLinesPlanStages(const ColorLinesInfo *info, ColorLinesStages *stages);
+
+// Renders input into output over output->extent_hint. input is the full
+// source frame (fill searches read outside the written area); temporal fill
+// reads info->prevWorld / nextWorld, which must match the input size or be NULL.
+PF_Err ColorLinesRender(const CX_Host *host, ColorLinesInfo *info, PF_PixelFormat format,
+						PF_EffectWorld *input, PF_EffectWorld *output);
+
+#endif // COLOR_LINES_KERNELS_H
@@ -4,245 +4,12 @@
  *
  * Extracts multiple target colors and applies pencil line texture processing.
  * Uses SmartFX architecture with multi-bit-depth support (8/16/32-bit).
+ * Parameters and layer checkout; the render is in PencilLineKernels.cpp.
  */
 
 #include "PencilLine.h"
 #include <cstdio>
 
-// ============================================================================
-// Color matching functions (checks against all enabled colors)
-// Uses CX_IsTargetColor* from CXCommon.h
-// ============================================================================
-
-// Check if pixel matches any enabled target color (8-bit)
-static inline bool IsTargetColor8(const PF_Pixel8* pixel, const PencilLineInfo* info) {
-    for (A_long i = 0; i < info->colorCount; ++i) {
-        const ColorEntry& entry = info->colors[i];
-        if (!entry.enabled) continue;
-        if (CX_IsTargetColor8(pixel, entry.color.red, entry.color.green, entry.color.blue, entry.toleranceSq)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Check if pixel matches any enabled target color (16-bit)
-static inline bool IsTargetColor16(const PF_Pixel16* pixel, const PencilLineInfo* info) {
-    for (A_long i = 0; i < info->colorCount; ++i) {
-        const ColorEntry& entry = info->colors[i];
-        if (!entry.enabled) continue;
-        if (CX_IsTargetColor16(pixel, entry.color.red, entry.color.green, entry.color.blue, entry.toleranceSq)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// Check if pixel matches any enabled target color (32-bit float)
-static inline bool IsTargetColorFloat(const PF_PixelFloat* pixel, const PencilLineInfo* info) {
-    for (A_long i = 0; i < info->colorCount; ++i) {
-        const ColorEntry& entry = info->colors[i];
-        if (!entry.enabled) continue;
-        if (CX_IsTargetColorFloat(pixel, entry.color.red, entry.color.green, entry.color.blue, entry.toleranceSq)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-// ============================================================================
-// Pencil texture processing (placeholder - to be implemented)
-// ============================================================================
-
-static inline void ApplyPencilTexture8(
-    PF_Pixel8* outP,
-    const PF_Pixel8* inP,
-    const PencilLineInfo* info,
-    A_long x,
-    A_long y)
-{
-    // Placeholder: Currently just copies the input
-    // Will be replaced with pencil texture algorithm
-    outP->alpha = inP->alpha;
-    outP->red = inP->red;
-    outP->green = inP->green;
-    outP->blue = inP->blue;
-}
-
-static inline void ApplyPencilTexture16(
-    PF_Pixel16* outP,
-    const PF_Pixel16* inP,
-    const PencilLineInfo* info,
-    A_long x,
-    A_long y)
-{
-    outP->alpha = inP->alpha;
-    outP->red = inP->red;
-    outP->green = inP->green;
-    outP->blue = inP->blue;
-}
-
-static inline void ApplyPencilTextureFloat(
-    PF_PixelFloat* outP,
-    const PF_PixelFloat* inP,
-    const PencilLineInfo* info,
-    A_long x,
-    A_long y)
-{
-    outP->alpha = inP->alpha;
-    outP->red = inP->red;
-    outP->green = inP->green;
-    outP->blue = inP->blue;
-}
-
-// ============================================================================
-// Main processing functions (per bit depth)
-// ============================================================================
-
-PF_Err ProcessPencilLine8(
-    void*           refcon,
-    A_long          x,
-    A_long          y,
-    PF_Pixel8*      inP,
-    PF_Pixel8*      outP)
-{
-    PencilLineInfo* info = static_cast<PencilLineInfo*>(refcon);
-
-    // Use inP directly - iterate callback provides correct input pixel
-    bool isTargetColor = IsTargetColor8(inP, info);
-
-    switch (info->outputMode) {
-        case OUTPUT_MODE_LINE_ONLY:
-            if (isTargetColor) {
-                ApplyPencilTexture8(outP, inP, info, x, y);
-            } else {
-                outP->alpha = 0;
-                outP->red = 0;
-                outP->green = 0;
-                outP->blue = 0;
-            }
-            break;
-
-        case OUTPUT_MODE_BG_ONLY:
-            if (isTargetColor) {
-                outP->alpha = 0;
-                outP->red = 0;
-                outP->green = 0;
-                outP->blue = 0;
-            } else {
-                *outP = *inP;
-            }
-            break;
-
-        case OUTPUT_MODE_FULL:
-        default:
-            if (isTargetColor) {
-                ApplyPencilTexture8(outP, inP, info, x, y);
-            } else {
-                *outP = *inP;
-            }
-            break;
-    }
-
-    return PF_Err_NONE;
-}
-
-PF_Err ProcessPencilLine16(
-    void*           refcon,
-    A_long          x,
-    A_long          y,
-    PF_Pixel16*     inP,
-    PF_Pixel16*     outP)
-{
-    PencilLineInfo* info = static_cast<PencilLineInfo*>(refcon);
-
-    // Use inP directly - iterate callback provides correct input pixel
-    bool isTargetColor = IsTargetColor16(inP, info);
-
-    switch (info->outputMode) {
-        case OUTPUT_MODE_LINE_ONLY:
-            if (isTargetColor) {
-                ApplyPencilTexture16(outP, inP, info, x, y);
-            } else {
-                outP->alpha = 0;
-                outP->red = 0;
-                outP->green = 0;
-                outP->blue = 0;
-            }
-            break;
-
-        case OUTPUT_MODE_BG_ONLY:
-            if (isTargetColor) {
-                outP->alpha = 0;
-                outP->red = 0;
-                outP->green = 0;
-                outP->blue = 0;
-            } else {
-                *outP = *inP;
-            }
-            break;
-
-        case OUTPUT_MODE_FULL:
-        default:
-            if (isTargetColor) {
-                ApplyPencilTexture16(outP, inP, info, x, y);
-            } else {
-                *outP = *inP;
-            }
-            break;
-    }
-
-    return PF_Err_NONE;
-}
-
-PF_Err ProcessPencilLineFloat(
-    void*           refcon,
-    A_long          x,
-    A_long          y,
-    PF_PixelFloat*  inP,
-    PF_PixelFloat*  outP)
-{
-    PencilLineInfo* info = static_cast<PencilLineInfo*>(refcon);
-
-    // Use inP directly - iterate callback provides correct input pixel
-    bool isTargetColor = IsTargetColorFloat(inP, info);
-
-    switch (info->outputMode) {
-        case OUTPUT_MODE_LINE_ONLY:
-            if (isTargetColor) {
-                ApplyPencilTextureFloat(outP, inP, info, x, y);
-            } else {
-                outP->alpha = 0.0f;
-                outP->red = 0.0f;
-                outP->green = 0.0f;
-                outP->blue = 0.0f;
-            }
-            break;
-
-        case OUTPUT_MODE_BG_ONLY:
-            if (isTargetColor) {
-                outP->alpha = 0.0f;
-                outP->red = 0.0f;
-                outP->green = 0.0f;
-                outP->blue = 0.0f;
-            } else {
-                *outP = *inP;
-            }
-            break;
-
-        case OUTPUT_MODE_FULL:
-        default:
-            if (isTargetColor) {
-                ApplyPencilTextureFloat(outP, inP, info, x, y);
-            } else {
-                *outP = *inP;
-            }
-            break;
-    }
-
-    return PF_Err_NONE;
-}
-
 // ============================================================================
 // Plugin entry points
 // ============================================================================
@@ -264,10 +31,7 @@ PF_Err GlobalSetup(
 static PF_Err AddColorParams(
     PF_InData* in_data,
     A_long colorIndex,          // 1-based index
-    PF_Boolean defaultEnabled,  // Whether checkbox is checked by default
-    A_long diskIdEnabled,
-    A_long diskIdColor,
-    A_long diskIdTolerance)
+    PF_Boolean defaultEnabled)  // Whether checkbox is checked by default
 {
     PF_Err err = PF_Err_NONE;
     PF_ParamDef def;
@@ -276,7 +40,7 @@ static PF_Err AddColorParams(
     // Enabled checkbox
     AEFX_CLR_STRUCT(def);
     snprintf(name, sizeof(name), "Color %ld", colorIndex);
-    PF_ADD_CHECKBOX(name, "", defaultEnabled, 0, diskIdEnabled);
+    PF_ADD_CHECKBOX(name, "", defaultEnabled, 0, COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_ENABLED));
 
     // Color picker
     AEFX_CLR_STRUCT(def);
@@ -288,7 +52,7 @@ static PF_Err AddColorParams(
     def.u.cd.value.blue = 0;
     def.u.cd.value.alpha = 255;
     def.u.cd.dephault = def.u.cd.value;
-    def.uu.id = diskIdColor;
+    def.uu.id = COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1);
     if ((err = PF_ADD_PARAM(in_data, -1, &def)) != PF_Err_NONE) return err;
 
     // Tolerance slider
@@ -303,9 +67,65 @@ static PF_Err AddColorParams(
     def.u.fs_d.value = DEFAULT_TOLERANCE;
     def.u.fs_d.dephault = DEFAULT_TOLERANCE;
     def.u.fs_d.precision = 1;
-    def.uu.id = diskIdTolerance;
+    def.uu.id = COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_TOLERANCE);
+    if ((err = PF_ADD_PARAM(in_data, -1, &def)) != PF_Err_NONE) return err;
+
+    // Recolor checkbox
+    AEFX_CLR_STRUCT(def);
+    snprintf(name, sizeof(name), "  Recolor %ld", colorIndex);
+    PF_ADD_CHECKBOX(name, "", FALSE, 0, COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_RECOLOR));
+
+    // Replacement color picker
+    AEFX_CLR_STRUCT(def);
+    def.param_type = PF_Param_COLOR;
+    snprintf(name, sizeof(name), "  New Color %ld", colorIndex);
+    PF_STRCPY(def.name, name);
+    def.u.cd.value.red = 0;
+    def.u.cd.value.green = 0;
+    def.u.cd.value.blue = 0;
+    def.u.cd.value.alpha = 255;
+    def.u.cd.dephault = def.u.cd.value;
+    def.uu.id = COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_NEW_COLOR);
     if ((err = PF_ADD_PARAM(in_data, -1, &def)) != PF_Err_NONE) return err;
 
+    // Custom texture checkbox (off: the Pencil Texture group applies)
+    AEFX_CLR_STRUCT(def);
+    snprintf(name, sizeof(name), "  Custom Texture %ld", colorIndex);
+    PF_ADD_CHECKBOX(name, "", FALSE, 0, COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_CUSTOM_TEXTURE));
+
+    // Line Width
+    AEFX_CLR_STRUCT(def);
+    snprintf(name, sizeof(name), "  Line Width %ld", colorIndex);
+    PF_ADD_SLIDER(name,
+                  LINE_WIDTH_MIN, LINE_WIDTH_MAX,
+                  LINE_WIDTH_MIN, LINE_WIDTH_MAX,
+                  DEFAULT_LINE_WIDTH,
+                  COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_LINE_WIDTH));
+
+    // Line Density
+    AEFX_CLR_STRUCT(def);
+    snprintf(name, sizeof(name), "  Line Density %ld", colorIndex);
+    PF_ADD_FLOAT_SLIDERX(name,
+                         LINE_DENSITY_MIN, LINE_DENSITY_MAX,
+                         LINE_DENSITY_MIN, LINE_DENSITY_MAX,
+                         DEFAULT_LINE_DENSITY,
+                         PF_Precision_TENTHS,
+                         0,
+                         0,
+                         COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_LINE_DENSITY));
+
+    // Texture Strength
+    AEFX_CLR_STRUCT(def);
+    snprintf(name, sizeof(name), "  Texture Strength %ld", colorIndex);
+    PF_ADD_FLOAT_SLIDERX(name,
+                         TEXTURE_STRENGTH_MIN, TEXTURE_STRENGTH_MAX,
+                         TEXTURE_STRENGTH_MIN, TEXTURE_STRENGTH_MAX,
+                         DEFAULT_CUSTOM_TEXTURE_STRENGTH,
+                         PF_Precision_TENTHS,
+                         0,
+                         0,
+                         COLOR_DISK_ID(colorIndex, DISK_ID_COLOR1_TEXTURE_STRENGTH));
+
     return err;
 }
 
@@ -322,22 +142,9 @@ PF_Err ParamsSetup(
     PF_ADD_TOPIC("Color Selection", DISK_ID_COLOR_GROUP);
 
     // Add all 16 color parameters (first color enabled by default)
-    ERR(AddColorParams(in_data, 1,  TRUE,  DISK_ID_COLOR1_ENABLED,  DISK_ID_COLOR1,  DISK_ID_COLOR1_TOLERANCE));
-    ERR(AddColorParams(in_data, 2,  FALSE, DISK_ID_COLOR2_ENABLED,  DISK_ID_COLOR2,  DISK_ID_COLOR2_TOLERANCE));
-    ERR(AddColorParams(in_data, 3,  FALSE, DISK_ID_COLOR3_ENABLED,  DISK_ID_COLOR3,  DISK_ID_COLOR3_TOLERANCE));
-    ERR(AddColorParams(in_data, 4,  FALSE, DISK_ID_COLOR4_ENABLED,  DISK_ID_COLOR4,  DISK_ID_COLOR4_TOLERANCE));
-    ERR(AddColorParams(in_data, 5,  FALSE, DISK_ID_COLOR5_ENABLED,  DISK_ID_COLOR5,  DISK_ID_COLOR5_TOLERANCE));
-    ERR(AddColorParams(in_data, 6,  FALSE, DISK_ID_COLOR6_ENABLED,  DISK_ID_COLOR6,  DISK_ID_COLOR6_TOLERANCE));
-    ERR(AddColorParams(in_data, 7,  FALSE, DISK_ID_COLOR7_ENABLED,  DISK_ID_COLOR7,  DISK_ID_COLOR7_TOLERANCE));
-    ERR(AddColorParams(in_data, 8,  FALSE, DISK_ID_COLOR8_ENABLED,  DISK_ID_COLOR8,  DISK_ID_COLOR8_TOLERANCE));
-    ERR(AddColorParams(in_data, 9,  FALSE, DISK_ID_COLOR9_ENABLED,  DISK_ID_COLOR9,  DISK_ID_COLOR9_TOLERANCE));
-    ERR(AddColorParams(in_data, 10, FALSE, DISK_ID_COLOR10_ENABLED, DISK_ID_COLOR10, DISK_ID_COLOR10_TOLERANCE));
-    ERR(AddColorParams(in_data, 11, FALSE, DISK_ID_COLOR11_ENABLED, DISK_ID_COLOR11, DISK_ID_COLOR11_TOLERANCE));
-    ERR(AddColorParams(in_data, 12, FALSE, DISK_ID_COLOR12_ENABLED, DISK_ID_COLOR12, DISK_ID_COLOR12_TOLERANCE));
-    ERR(AddColorParams(in_data, 13, FALSE, DISK_ID_COLOR13_ENABLED, DISK_ID_COLOR13, DISK_ID_COLOR13_TOLERANCE));
-    ERR(AddColorParams(in_data, 14, FALSE, DISK_ID_COLOR14_ENABLED, DISK_ID_COLOR14, DISK_ID_COLOR14_TOLERANCE));
-    ERR(AddColorParams(in_data, 15, FALSE, DISK_ID_COLOR15_ENABLED, DISK_ID_COLOR15, DISK_ID_COLOR15_TOLERANCE));
-    ERR(AddColorParams(in_data, 16, FALSE, DISK_ID_COLOR16_ENABLED, DISK_ID_COLOR16, DISK_ID_COLOR16_TOLERANCE));
+    for (A_long i = 1; i <= MAX_COLORS && !err; ++i) {
+        ERR(AddColorParams(in_data, i, i == 1));
+    }
 
     PF_END_TOPIC(DISK_ID_COLOR_GROUP_END);
 
@@ -398,6 +205,23 @@ PF_Err ParamsSetup(
     return err;
 }
 
+// Greys out a parameter in the Effect Controls panel
+static PF_Err SetParamEnabled(
+    PF_InData*                          in_data,
+    AEFX_SuiteScoper<PF_ParamUtilsSuite3>& paramSuite,
+    PF_ParamDef*                        params[],
+    A_long                              index,
+    PF_Boolean                          enabled)
+{
+    PF_ParamDef paramCopy = *params[index];
+    if (enabled) {
+        paramCopy.ui_flags &= ~PF_PUI_DISABLED;
+    } else {
+        paramCopy.ui_flags |= PF_PUI_DISABLED;
+    }
+    return paramSuite->PF_UpdateParamUI(in_data->effect_ref, index, &paramCopy);
+}
+
 PF_Err UpdateParameterUI(
     PF_InData*      in_data,
     PF_OutData*     out_data,
@@ -408,37 +232,34 @@ PF_Err UpdateParameterUI(
     AEFX_SuiteScoper<PF_ParamUtilsSuite3> paramSuite = AEFX_SuiteScoper<PF_ParamUtilsSuite3>(
         in_data, kPFParamUtilsSuite, kPFParamUtilsSuiteVersion3, out_data);
 
-    // Update enabled state for each color's Color and Tolerance based on checkbox
+    // Update enabled state for each color's params based on the checkboxes
     for (A_long i = 1; i <= MAX_COLORS; ++i) {
-        A_long enabledIdx = COLOR_ENABLED_PARAM(i);
-        A_long colorIdx = COLOR_PARAM(i);
-        A_long toleranceIdx = COLOR_TOLERANCE_PARAM(i);
-
         // Check if this color is enabled (checkbox checked)
-        PF_Boolean isEnabled = params[enabledIdx]->u.bd.value;
-
-        // Update color picker enabled state
-        PF_ParamDef paramCopy = *params[colorIdx];
-        if (isEnabled) {
-            paramCopy.ui_flags &= ~PF_PUI_DISABLED;
-        } else {
-            paramCopy.ui_flags |= PF_PUI_DISABLED;
-        }
-        ERR(paramSuite->PF_UpdateParamUI(in_data->effect_ref, colorIdx, &paramCopy));
-
-        // Update tolerance slider enabled state
-        paramCopy = *params[toleranceIdx];
-        if (isEnabled) {
-            paramCopy.ui_flags &= ~PF_PUI_DISABLED;
-        } else {
-            paramCopy.ui_flags |= PF_PUI_DISABLED;
-        }
-        ERR(paramSuite->PF_UpdateParamUI(in_data->effect_ref, toleranceIdx, &paramCopy));
+        PF_Boolean isEnabled = params[COLOR_ENABLED_PARAM(i)]->u.bd.value;
+        PF_Boolean isRecolored = isEnabled && params[COLOR_RECOLOR_PARAM(i)]->u.bd.value;
+        PF_Boolean isCustomTexture = isEnabled && params[COLOR_CUSTOM_TEXTURE_PARAM(i)]->u.bd.value;
+
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_PARAM(i), isEnabled));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_TOLERANCE_PARAM(i), isEnabled));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_RECOLOR_PARAM(i), isEnabled));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_NEW_COLOR_PARAM(i), isRecolored));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_CUSTOM_TEXTURE_PARAM(i), isEnabled));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_LINE_WIDTH_PARAM(i), isCustomTexture));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_LINE_DENSITY_PARAM(i), isCustomTexture));
+        ERR(SetParamEnabled(in_data, paramSuite, params, COLOR_TEXTURE_STRENGTH_PARAM(i), isCustomTexture));
     }
 
     return err;
 }
 
+// Full-resolution pixels per rendered pixel along one axis, e.g. 2 at Half
+static A_long DownsampleFactor(const PF_RationalScale& scale)
+{
+    if (scale.num <= 0) return 1;
+    const A_u_long num = static_cast<A_u_long>(scale.num);
+    return CX_MAX(1, static_cast<A_long>((scale.den + num / 2) / num));
+}
+
 PF_Err PreRender(
     PF_InData*              in_data,
     PF_OutData*             out_data,
@@ -465,10 +286,17 @@ PF_Err PreRender(
 
     // Checkout all color parameters
     for (A_long i = 0; i < MAX_COLORS; ++i) {
-        PF_ParamDef enabledParam, colorParam, toleranceParam;
+        PF_ParamDef enabledParam, colorParam, toleranceParam, recolorParam, newColorParam;
+        PF_ParamDef customTextureParam, lineWidthParam, lineDensityParam, textureStrengthParam;
         AEFX_CLR_STRUCT(enabledParam);
         AEFX_CLR_STRUCT(colorParam);
         AEFX_CLR_STRUCT(toleranceParam);
+        AEFX_CLR_STRUCT(recolorParam);
+        AEFX_CLR_STRUCT(newColorParam);
+        AEFX_CLR_STRUCT(customTextureParam);
+        AEFX_CLR_STRUCT(lineWidthParam);
+        AEFX_CLR_STRUCT(lineDensityParam);
+        AEFX_CLR_STRUCT(textureStrengthParam);
 
         A_long colorNum = i + 1;  // 1-based
 
@@ -478,6 +306,18 @@ PF_Err PreRender(
                               in_data->time_step, in_data->time_scale, &colorParam));
         ERR(PF_CHECKOUT_PARAM(in_data, COLOR_TOLERANCE_PARAM(colorNum), in_data->current_time,
                               in_data->time_step, in_data->time_scale, &toleranceParam));
+        ERR(PF_CHECKOUT_PARAM(in_data, COLOR_RECOLOR_PARAM(colorNum), in_data->current_time,
+                              in_data->time_step, in_data->time_scale, &recolorParam));
+        ERR(PF_CHECKOUT_PARAM(in_data, COLOR_NEW_COLOR_PARAM(colorNum), in_data->current_time,
+                              in_data->time_step, in_data->time_scale, &newColorParam));
+        ERR(PF_CHECKOUT_PARAM(in_data, COLOR_CUSTOM_TEXTURE_PARAM(colorNum), in_data->current_time,
+                              in_data->time_step, in_data->time_scale, &customTextureParam));
+        ERR(PF_CHECKOUT_PARAM(in_data, COLOR_LINE_WIDTH_PARAM(colorNum), in_data->current_time,
+                              in_data->time_step, in_data->time_scale, &lineWidthParam));
+        ERR(PF_CHECKOUT_PARAM(in_data, COLOR_LINE_DENSITY_PARAM(colorNum), in_data->current_time,
+                              in_data->time_step, in_data->time_scale, &lineDensityParam));
+        ERR(PF_CHECKOUT_PARAM(in_data, COLOR_TEXTURE_STRENGTH_PARAM(colorNum), in_data->current_time,
+                              in_data->time_step, in_data->time_scale, &textureStrengthParam));
 
         if (!err) {
             info->colors[i].enabled = enabledParam.u.bd.value;
@@ -486,11 +326,25 @@ PF_Err PreRender(
 
             // Precompute squared tolerance using common helper
             info->colors[i].toleranceSq = CX_ToleranceToDistSq(info->colors[i].tolerance);
+
+            info->colors[i].recolor = recolorParam.u.bd.value;
+            info->colors[i].newColor = newColorParam.u.cd.value;
+
+            info->colors[i].customTexture = customTextureParam.u.bd.value;
+            info->colors[i].lineWidth = lineWidthParam.u.sd.value;
+            info->colors[i].lineDensity = lineDensityParam.u.fs_d.value;
+            info->colors[i].textureStrength = textureStrengthParam.u.fs_d.value;
         }
 
         PF_CHECKIN_PARAM(in_data, &enabledParam);
         PF_CHECKIN_PARAM(in_data, &colorParam);
         PF_CHECKIN_PARAM(in_data, &toleranceParam);
+        PF_CHECKIN_PARAM(in_data, &recolorParam);
+        PF_CHECKIN_PARAM(in_data, &newColorParam);
+        PF_CHECKIN_PARAM(in_data, &customTextureParam);
+        PF_CHECKIN_PARAM(in_data, &lineWidthParam);
+        PF_CHECKIN_PARAM(in_data, &lineDensityParam);
+        PF_CHECKIN_PARAM(in_data, &textureStrengthParam);
     }
 
     // Checkout texture and output parameters
@@ -533,8 +387,16 @@ PF_Err PreRender(
                                   &in_result));
 
     // Set max result rect
-    UnionLRect(&in_result.result_rect, &extra->output->result_rect);
-    UnionLRect(&in_result.max_result_rect, &extra->output->max_result_rect);
+    CX_UnionLRect(&in_result.result_rect, &extra->output->result_rect);
+    CX_UnionLRect(&in_result.max_result_rect, &extra->output->max_result_rect);
+
+    // Layer position of the output's top-left pixel, so the grain stays put between renders
+    info->originX = extra->output->result_rect.left;
+    info->originY = extra->output->result_rect.top;
+
+    // Previews pick the grain mip level from the downsample factor
+    info->downsampleX = DownsampleFactor(in_data->downsample_x);
+    info->downsampleY = DownsampleFactor(in_data->downsample_y);
 
     // Store custom data handle
     extra->output->pre_render_data = infoH;
@@ -576,58 +438,9 @@ PF_Err SmartRender(
                 in_data, kPFWorldSuite, kPFWorldSuiteVersion2, out_data);
             ERR(wsP->PF_GetPixelFormat(input_worldP, &format));
 
-            if (!err) {
-                switch (format) {
-                    case PF_PixelFormat_ARGB128:
-                        {
-                            AEFX_SuiteScoper<PF_iterateFloatSuite2> iterSuite = AEFX_SuiteScoper<PF_iterateFloatSuite2>(
-                                in_data, kPFIterateFloatSuite, kPFIterateFloatSuiteVersion2, out_data);
-                            ERR(iterSuite->iterate(
-                                in_data,
-                                0,
-                                output_worldP->height,
-                                input_worldP,
-                                nullptr,
-                                info,
-                                ProcessPencilLineFloat,
-                                output_worldP));
-                        }
-                        break;
-
-                    case PF_PixelFormat_ARGB64:
-                        {
-                            AEFX_SuiteScoper<PF_iterate16Suite2> iterSuite = AEFX_SuiteScoper<PF_iterate16Suite2>(
-                                in_data, kPFIterate16Suite, kPFIterate16SuiteVersion2, out_data);
-                            ERR(iterSuite->iterate(
-                                in_data,
-                                0,
-                                output_worldP->height,
-                                input_worldP,
-                                nullptr,
-                                info,
-                                ProcessPencilLine16,
-                                output_worldP));
-                        }
-                        break;
-
-                    case PF_PixelFormat_ARGB32:
-                    default:
-                        {
-                            AEFX_SuiteScoper<PF_Iterate8Suite2> iterSuite = AEFX_SuiteScoper<PF_Iterate8Suite2>(
-                                in_data, kPFIterate8Suite, kPFIterate8SuiteVersion2, out_data);
-                            ERR(iterSuite->iterate(
-                                in_data,
-                                0,
-                                output_worldP->height,
-                                input_worldP,
-                                nullptr,
-                                info,
-                                ProcessPencilLine8,
-                                output_worldP));
-                        }
-                        break;
-                }
-            }
+            CX_AEHostContext hostContext = { in_data, out_data };
+            CX_Host host = CX_MakeAEHost(&hostContext);
+            ERR(PencilLineRender(&host, info, format, input_worldP, output_worldP));
         }
     }
 
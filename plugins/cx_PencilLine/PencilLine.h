@@ -3,7 +3,8 @@
  * cx_PencilLine - Pencil Line Texture Effect for After Effects
  *
  * Extracts multiple target colors and applies pencil line texture processing.
- * Supports up to 16 colors, each with individual enable/disable and tolerance.
+ * Supports up to 16 colors, each with individual enable/disable, tolerance,
+ * an optional replacement color and optional texture settings.
  */
 
 #pragma once
@@ -21,7 +22,7 @@
 #include "AEFX_SuiteHelper.h"
 #include "Smart_Utils.h"
 
-#include "CXCommon.h"
+#include "PencilLineKernels.h"
 
 #ifdef AE_OS_WIN
     #include <Windows.h>
@@ -35,97 +36,185 @@
 
 // Version info
 #define MAJOR_VERSION           1
-#define MINOR_VERSION           0
+#define MINOR_VERSION           1
 #define BUG_VERSION             0
 #define STAGE_VERSION           PF_Stage_DEVELOP
 #define BUILD_VERSION           1
 
-// Maximum number of colors supported
-constexpr A_long MAX_COLORS = 16;
-
-// Output modes
-enum OutputMode {
-    OUTPUT_MODE_FULL = 1,       // Full image with processed lines
-    OUTPUT_MODE_LINE_ONLY,      // Only extracted lines with texture
-    OUTPUT_MODE_BG_ONLY         // Only background (no lines)
-};
-
 // Parameter IDs (UI order)
-// Each color has 3 params: Enabled (checkbox), Color, Tolerance
+// Each color has 9 params: Enabled (checkbox), Color, Tolerance, Recolor (checkbox), New Color,
+// Custom Texture (checkbox), Line Width, Line Density, Texture Strength
 enum {
     PENCILLINE_INPUT = 0,
 
     // Color Selection Group
     PENCILLINE_COLOR_GROUP,
 
-    // Color 1-16 (each has: Enabled, Color, Tolerance)
+    // Color 1-16 (each has: Enabled, Color, Tolerance, Recolor, New Color, Custom Texture,
+    // Line Width, Line Density, Texture Strength)
     PENCILLINE_COLOR1_ENABLED,
     PENCILLINE_COLOR1,
     PENCILLINE_COLOR1_TOLERANCE,
+    PENCILLINE_COLOR1_RECOLOR,
+    PENCILLINE_COLOR1_NEW_COLOR,
+    PENCILLINE_COLOR1_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR1_LINE_WIDTH,
+    PENCILLINE_COLOR1_LINE_DENSITY,
+    PENCILLINE_COLOR1_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR2_ENABLED,
     PENCILLINE_COLOR2,
     PENCILLINE_COLOR2_TOLERANCE,
+    PENCILLINE_COLOR2_RECOLOR,
+    PENCILLINE_COLOR2_NEW_COLOR,
+    PENCILLINE_COLOR2_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR2_LINE_WIDTH,
+    PENCILLINE_COLOR2_LINE_DENSITY,
+    PENCILLINE_COLOR2_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR3_ENABLED,
     PENCILLINE_COLOR3,
     PENCILLINE_COLOR3_TOLERANCE,
+    PENCILLINE_COLOR3_RECOLOR,
+    PENCILLINE_COLOR3_NEW_COLOR,
+    PENCILLINE_COLOR3_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR3_LINE_WIDTH,
+    PENCILLINE_COLOR3_LINE_DENSITY,
+    PENCILLINE_COLOR3_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR4_ENABLED,
     PENCILLINE_COLOR4,
     PENCILLINE_COLOR4_TOLERANCE,
+    PENCILLINE_COLOR4_RECOLOR,
+    PENCILLINE_COLOR4_NEW_COLOR,
+    PENCILLINE_COLOR4_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR4_LINE_WIDTH,
+    PENCILLINE_COLOR4_LINE_DENSITY,
+    PENCILLINE_COLOR4_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR5_ENABLED,
     PENCILLINE_COLOR5,
     PENCILLINE_COLOR5_TOLERANCE,
+    PENCILLINE_COLOR5_RECOLOR,
+    PENCILLINE_COLOR5_NEW_COLOR,
+    PENCILLINE_COLOR5_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR5_LINE_WIDTH,
+    PENCILLINE_COLOR5_LINE_DENSITY,
+    PENCILLINE_COLOR5_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR6_ENABLED,
     PENCILLINE_COLOR6,
     PENCILLINE_COLOR6_TOLERANCE,
+    PENCILLINE_COLOR6_RECOLOR,
+    PENCILLINE_COLOR6_NEW_COLOR,
+    PENCILLINE_COLOR6_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR6_LINE_WIDTH,
+    PENCILLINE_COLOR6_LINE_DENSITY,
+    PENCILLINE_COLOR6_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR7_ENABLED,
     PENCILLINE_COLOR7,
     PENCILLINE_COLOR7_TOLERANCE,
+    PENCILLINE_COLOR7_RECOLOR,
+    PENCILLINE_COLOR7_NEW_COLOR,
+    PENCILLINE_COLOR7_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR7_LINE_WIDTH,
+    PENCILLINE_COLOR7_LINE_DENSITY,
+    PENCILLINE_COLOR7_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR8_ENABLED,
     PENCILLINE_COLOR8,
     PENCILLINE_COLOR8_TOLERANCE,
+    PENCILLINE_COLOR8_RECOLOR,
+    PENCILLINE_COLOR8_NEW_COLOR,
+    PENCILLINE_COLOR8_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR8_LINE_WIDTH,
+    PENCILLINE_COLOR8_LINE_DENSITY,
+    PENCILLINE_COLOR8_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR9_ENABLED,
     PENCILLINE_COLOR9,
     PENCILLINE_COLOR9_TOLERANCE,
+    PENCILLINE_COLOR9_RECOLOR,
+    PENCILLINE_COLOR9_NEW_COLOR,
+    PENCILLINE_COLOR9_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR9_LINE_WIDTH,
+    PENCILLINE_COLOR9_LINE_DENSITY,
+    PENCILLINE_COLOR9_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR10_ENABLED,
     PENCILLINE_COLOR10,
     PENCILLINE_COLOR10_TOLERANCE,
+    PENCILLINE_COLOR10_RECOLOR,
+    PENCILLINE_COLOR10_NEW_COLOR,
+    PENCILLINE_COLOR10_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR10_LINE_WIDTH,
+    PENCILLINE_COLOR10_LINE_DENSITY,
+    PENCILLINE_COLOR10_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR11_ENABLED,
     PENCILLINE_COLOR11,
     PENCILLINE_COLOR11_TOLERANCE,
+    PENCILLINE_COLOR11_RECOLOR,
+    PENCILLINE_COLOR11_NEW_COLOR,
+    PENCILLINE_COLOR11_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR11_LINE_WIDTH,
+    PENCILLINE_COLOR11_LINE_DENSITY,
+    PENCILLINE_COLOR11_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR12_ENABLED,
     PENCILLINE_COLOR12,
     PENCILLINE_COLOR12_TOLERANCE,
+    PENCILLINE_COLOR12_RECOLOR,
+    PENCILLINE_COLOR12_NEW_COLOR,
+    PENCILLINE_COLOR12_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR12_LINE_WIDTH,
+    PENCILLINE_COLOR12_LINE_DENSITY,
+    PENCILLINE_COLOR12_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR13_ENABLED,
     PENCILLINE_COLOR13,
     PENCILLINE_COLOR13_TOLERANCE,
+    PENCILLINE_COLOR13_RECOLOR,
+    PENCILLINE_COLOR13_NEW_COLOR,
+    PENCILLINE_COLOR13_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR13_LINE_WIDTH,
+    PENCILLINE_COLOR13_LINE_DENSITY,
+    PENCILLINE_COLOR13_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR14_ENABLED,
     PENCILLINE_COLOR14,
     PENCILLINE_COLOR14_TOLERANCE,
+    PENCILLINE_COLOR14_RECOLOR,
+    PENCILLINE_COLOR14_NEW_COLOR,
+    PENCILLINE_COLOR14_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR14_LINE_WIDTH,
+    PENCILLINE_COLOR14_LINE_DENSITY,
+    PENCILLINE_COLOR14_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR15_ENABLED,
     PENCILLINE_COLOR15,
     PENCILLINE_COLOR15_TOLERANCE,
+    PENCILLINE_COLOR15_RECOLOR,
+    PENCILLINE_COLOR15_NEW_COLOR,
+    PENCILLINE_COLOR15_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR15_LINE_WIDTH,
+    PENCILLINE_COLOR15_LINE_DENSITY,
+    PENCILLINE_COLOR15_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR16_ENABLED,
     PENCILLINE_COLOR16,
     PENCILLINE_COLOR16_TOLERANCE,
+    PENCILLINE_COLOR16_RECOLOR,
+    PENCILLINE_COLOR16_NEW_COLOR,
+    PENCILLINE_COLOR16_CUSTOM_TEXTURE,
+    PENCILLINE_COLOR16_LINE_WIDTH,
+    PENCILLINE_COLOR16_LINE_DENSITY,
+    PENCILLINE_COLOR16_TEXTURE_STRENGTH,
 
     PENCILLINE_COLOR_GROUP_END,
 
-    // Pencil Texture Group (placeholder for future parameters)
+    // Pencil Texture Group (defaults for colors without custom texture)
     PENCILLINE_TEXTURE_GROUP,
     PENCILLINE_LINE_WIDTH,
     PENCILLINE_LINE_DENSITY,
@@ -144,127 +233,198 @@ enum {
 enum {
     DISK_ID_COLOR_GROUP = 1,
 
-    // Color 1-16 disk IDs (each color uses 3 consecutive IDs)
+    // Color 1-16 disk IDs (each color uses consecutive IDs from a block of 10)
     DISK_ID_COLOR1_ENABLED = 10,
     DISK_ID_COLOR1,
     DISK_ID_COLOR1_TOLERANCE,
+    DISK_ID_COLOR1_RECOLOR,
+    DISK_ID_COLOR1_NEW_COLOR,
+    DISK_ID_COLOR1_CUSTOM_TEXTURE,
+    DISK_ID_COLOR1_LINE_WIDTH,
+    DISK_ID_COLOR1_LINE_DENSITY,
+    DISK_ID_COLOR1_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR2_ENABLED = 20,
     DISK_ID_COLOR2,
     DISK_ID_COLOR2_TOLERANCE,
+    DISK_ID_COLOR2_RECOLOR,
+    DISK_ID_COLOR2_NEW_COLOR,
+    DISK_ID_COLOR2_CUSTOM_TEXTURE,
+    DISK_ID_COLOR2_LINE_WIDTH,
+    DISK_ID_COLOR2_LINE_DENSITY,
+    DISK_ID_COLOR2_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR3_ENABLED = 30,
     DISK_ID_COLOR3,
     DISK_ID_COLOR3_TOLERANCE,
+    DISK_ID_COLOR3_RECOLOR,
+    DISK_ID_COLOR3_NEW_COLOR,
+    DISK_ID_COLOR3_CUSTOM_TEXTURE,
+    DISK_ID_COLOR3_LINE_WIDTH,
+    DISK_ID_COLOR3_LINE_DENSITY,
+    DISK_ID_COLOR3_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR4_ENABLED = 40,
     DISK_ID_COLOR4,
     DISK_ID_COLOR4_TOLERANCE,
+    DISK_ID_COLOR4_RECOLOR,
+    DISK_ID_COLOR4_NEW_COLOR,
+    DISK_ID_COLOR4_CUSTOM_TEXTURE,
+    DISK_ID_COLOR4_LINE_WIDTH,
+    DISK_ID_COLOR4_LINE_DENSITY,
+    DISK_ID_COLOR4_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR5_ENABLED = 50,
     DISK_ID_COLOR5,
     DISK_ID_COLOR5_TOLERANCE,
+    DISK_ID_COLOR5_RECOLOR,
+    DISK_ID_COLOR5_NEW_COLOR,
+    DISK_ID_COLOR5_CUSTOM_TEXTURE,
+    DISK_ID_COLOR5_LINE_WIDTH,
+    DISK_ID_COLOR5_LINE_DENSITY,
+    DISK_ID_COLOR5_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR6_ENABLED = 60,
     DISK_ID_COLOR6,
     DISK_ID_COLOR6_TOLERANCE,
+    DISK_ID_COLOR6_RECOLOR,
+    DISK_ID_COLOR6_NEW_COLOR,
+    DISK_ID_COLOR6_CUSTOM_TEXTURE,
+    DISK_ID_COLOR6_LINE_WIDTH,
+    DISK_ID_COLOR6_LINE_DENSITY,
+    DISK_ID_COLOR6_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR7_ENABLED = 70,
     DISK_ID_COLOR7,
     DISK_ID_COLOR7_TOLERANCE,
+    DISK_ID_COLOR7_RECOLOR,
+    DISK_ID_COLOR7_NEW_COLOR,
+    DISK_ID_COLOR7_CUSTOM_TEXTURE,
+    DISK_ID_COLOR7_LINE_WIDTH,
+    DISK_ID_COLOR7_LINE_DENSITY,
+    DISK_ID_COLOR7_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR8_ENABLED = 80,
     DISK_ID_COLOR8,
     DISK_ID_COLOR8_TOLERANCE,
+    DISK_ID_COLOR8_RECOLOR,
+    DISK_ID_COLOR8_NEW_COLOR,
+    DISK_ID_COLOR8_CUSTOM_TEXTURE,
+    DISK_ID_COLOR8_LINE_WIDTH,
+    DISK_ID_COLOR8_LINE_DENSITY,
+    DISK_ID_COLOR8_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR9_ENABLED = 90,
     DISK_ID_COLOR9,
     DISK_ID_COLOR9_TOLERANCE,
+    DISK_ID_COLOR9_RECOLOR,
+    DISK_ID_COLOR9_NEW_COLOR,
+    DISK_ID_COLOR9_CUSTOM_TEXTURE,
+    DISK_ID_COLOR9_LINE_WIDTH,
+    DISK_ID_COLOR9_LINE_DENSITY,
+    DISK_ID_COLOR9_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR10_ENABLED = 100,
     DISK_ID_COLOR10,
     DISK_ID_COLOR10_TOLERANCE,
+    DISK_ID_COLOR10_RECOLOR,
+    DISK_ID_COLOR10_NEW_COLOR,
+    DISK_ID_COLOR10_CUSTOM_TEXTURE,
+    DISK_ID_COLOR10_LINE_WIDTH,
+    DISK_ID_COLOR10_LINE_DENSITY,
+    DISK_ID_COLOR10_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR11_ENABLED = 110,
     DISK_ID_COLOR11,
     DISK_ID_COLOR11_TOLERANCE,
+    DISK_ID_COLOR11_RECOLOR,
+    DISK_ID_COLOR11_NEW_COLOR,
+    DISK_ID_COLOR11_CUSTOM_TEXTURE,
+    DISK_ID_COLOR11_LINE_WIDTH,
+    DISK_ID_COLOR11_LINE_DENSITY,
+    DISK_ID_COLOR11_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR12_ENABLED = 120,
     DISK_ID_COLOR12,
     DISK_ID_COLOR12_TOLERANCE,
+    DISK_ID_COLOR12_RECOLOR,
+    DISK_ID_COLOR12_NEW_COLOR,
+    DISK_ID_COLOR12_CUSTOM_TEXTURE,
+    DISK_ID_COLOR12_LINE_WIDTH,
+    DISK_ID_COLOR12_LINE_DENSITY,
+    DISK_ID_COLOR12_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR13_ENABLED = 130,
     DISK_ID_COLOR13,
     DISK_ID_COLOR13_TOLERANCE,
+    DISK_ID_COLOR13_RECOLOR,
+    DISK_ID_COLOR13_NEW_COLOR,
+    DISK_ID_COLOR13_CUSTOM_TEXTURE,
+    DISK_ID_COLOR13_LINE_WIDTH,
+    DISK_ID_COLOR13_LINE_DENSITY,
+    DISK_ID_COLOR13_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR14_ENABLED = 140,
     DISK_ID_COLOR14,
     DISK_ID_COLOR14_TOLERANCE,
+    DISK_ID_COLOR14_RECOLOR,
+    DISK_ID_COLOR14_NEW_COLOR,
+    DISK_ID_COLOR14_CUSTOM_TEXTURE,
+    DISK_ID_COLOR14_LINE_WIDTH,
+    DISK_ID_COLOR14_LINE_DENSITY,
+    DISK_ID_COLOR14_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR15_ENABLED = 150,
     DISK_ID_COLOR15,
     DISK_ID_COLOR15_TOLERANCE,
+    DISK_ID_COLOR15_RECOLOR,
+    DISK_ID_COLOR15_NEW_COLOR,
+    DISK_ID_COLOR15_CUSTOM_TEXTURE,
+    DISK_ID_COLOR15_LINE_WIDTH,
+    DISK_ID_COLOR15_LINE_DENSITY,
+    DISK_ID_COLOR15_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR16_ENABLED = 160,
     DISK_ID_COLOR16,
     DISK_ID_COLOR16_TOLERANCE,
+    DISK_ID_COLOR16_RECOLOR,
+    DISK_ID_COLOR16_NEW_COLOR,
+    DISK_ID_COLOR16_CUSTOM_TEXTURE,
+    DISK_ID_COLOR16_LINE_WIDTH,
+    DISK_ID_COLOR16_LINE_DENSITY,
+    DISK_ID_COLOR16_TEXTURE_STRENGTH,
 
     DISK_ID_COLOR_GROUP_END = 200,
 
     DISK_ID_TEXTURE_GROUP = 210,
     DISK_ID_LINE_WIDTH,
     DISK_ID_LINE_DENSITY,
-    DISK_ID_TEXTURE_STRENGTH,
+    DISK_ID_TEXTURE_STRENGTH_1_0,   // Retired in 1.1, see DISK_ID_TEXTURE_STRENGTH
     DISK_ID_TEXTURE_GROUP_END,
 
     DISK_ID_OUTPUT_GROUP = 220,
     DISK_ID_OUTPUT_MODE,
-    DISK_ID_OUTPUT_GROUP_END
-};
+    DISK_ID_OUTPUT_GROUP_END,
 
-// Helper macros to get parameter IDs for color N (1-based)
-#define COLOR_ENABLED_PARAM(n) (PENCILLINE_COLOR1_ENABLED + ((n) - 1) * 3)
-#define COLOR_PARAM(n)         (PENCILLINE_COLOR1 + ((n) - 1) * 3)
-#define COLOR_TOLERANCE_PARAM(n) (PENCILLINE_COLOR1_TOLERANCE + ((n) - 1) * 3)
-
-// Default parameter values
-constexpr PF_FpLong DEFAULT_TOLERANCE = 0.0;
-constexpr A_long DEFAULT_LINE_WIDTH = 2;
-constexpr PF_FpLong DEFAULT_LINE_DENSITY = 50.0;
-constexpr PF_FpLong DEFAULT_TEXTURE_STRENGTH = 50.0;
-
-// Parameter ranges
-constexpr PF_FpLong TOLERANCE_MIN = 0.0;
-constexpr PF_FpLong TOLERANCE_MAX = 100.0;
-constexpr A_long LINE_WIDTH_MIN = 1;
-constexpr A_long LINE_WIDTH_MAX = 20;
-constexpr PF_FpLong LINE_DENSITY_MIN = 0.0;
-constexpr PF_FpLong LINE_DENSITY_MAX = 100.0;
-constexpr PF_FpLong TEXTURE_STRENGTH_MIN = 0.0;
-constexpr PF_FpLong TEXTURE_STRENGTH_MAX = 100.0;
-
-// Single color entry for processing
-struct ColorEntry {
-    PF_Boolean enabled;
-    PF_Pixel color;
-    PF_FpLong tolerance;
-    A_long toleranceSq;     // Precomputed squared tolerance
+    // 1.0 saved Texture Strength (default 50) while the texture was a no-op;
+    // the new ID drops that value so those projects load at 0 and look the same
+    DISK_ID_TEXTURE_STRENGTH = 230
 };
 
-// Processing info structure passed between PreRender and SmartRender
-struct PencilLineInfo {
-    // Color selection parameters
-    A_long colorCount;              // Active color count (always 16)
-    ColorEntry colors[MAX_COLORS];  // All color entries
-
-    // Pencil texture parameters
-    A_long lineWidth;
-    PF_FpLong lineDensity;
-    PF_FpLong textureStrength;
-
-    // Output mode
-    A_long outputMode;
-};
+// Helper macros to get parameter IDs for color N (1-based)
+#define COLOR_PARAM_STRIDE     (PENCILLINE_COLOR2_ENABLED - PENCILLINE_COLOR1_ENABLED)
+#define COLOR_ENABLED_PARAM(n) (PENCILLINE_COLOR1_ENABLED + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_PARAM(n)         (PENCILLINE_COLOR1 + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_TOLERANCE_PARAM(n) (PENCILLINE_COLOR1_TOLERANCE + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_RECOLOR_PARAM(n) (PENCILLINE_COLOR1_RECOLOR + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_NEW_COLOR_PARAM(n) (PENCILLINE_COLOR1_NEW_COLOR + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_CUSTOM_TEXTURE_PARAM(n) (PENCILLINE_COLOR1_CUSTOM_TEXTURE + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_LINE_WIDTH_PARAM(n) (PENCILLINE_COLOR1_LINE_WIDTH + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_LINE_DENSITY_PARAM(n) (PENCILLINE_COLOR1_LINE_DENSITY + ((n) - 1) * COLOR_PARAM_STRIDE)
+#define COLOR_TEXTURE_STRENGTH_PARAM(n) (PENCILLINE_COLOR1_TEXTURE_STRENGTH + ((n) - 1) * COLOR_PARAM_STRIDE)
+
+// Disk ID of color N's param, given color 1's (each color owns a block of 10 IDs)
+#define COLOR_DISK_ID(n, color1Id) ((color1Id) + ((n) - 1) * (DISK_ID_COLOR2_ENABLED - DISK_ID_COLOR1_ENABLED))
 
 // Function declarations
 extern "C" {
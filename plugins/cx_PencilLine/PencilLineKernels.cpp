@@ -0,0 +1,387 @@
+/*
+ * PencilLineKernels.cpp
+ * cx_PencilLine - render core shared by the AE and OpenFX plugins
+ *
+ * Extracts multiple target colors and applies pencil line texture processing.
+ * Multi-bit-depth (8/16/32-bit); reaches the host only through CX_Host.
+ */
+
+#include "PencilLineKernels.h"
+#include "CXColorMatch.h"
+#include <mutex>
+
+// ============================================================================
+// Color matching (CX_ColorMatcher from CXColorMatch.h)
+// ============================================================================
+
+// Builds the matcher from the enabled colors; label = color slot + 1
+static PF_Err InitColorMatcher(const PencilLineInfo* info, CX_ColorMatcher* matcher)
+{
+    CX_MatchEntry entries[MAX_COLORS];
+    A_long count = 0;
+    for (A_long i = 0; i < info->colorCount; ++i) {
+        const ColorEntry& entry = info->colors[i];
+        if (!entry.enabled) continue;
+        entries[count++] = CX_MakeMatchEntry(entry.color, entry.tolerance, static_cast<A_u_char>(i + 1));
+    }
+    return CX_ColorMatcherInit(matcher, entries, count);
+}
+
+// ============================================================================
+// Pencil grain
+// ============================================================================
+
+// Grain tiles are periodic in full-resolution layer space; the size is a
+// power of two so coordinates wrap with a mask
+constexpr A_long GRAIN_TILE_SIZE = 256;
+constexpr A_long GRAIN_TILE_MASK = GRAIN_TILE_SIZE - 1;
+
+// Mip levels 256x256 down to 8x8; level L serves 2^L x downsampled renders
+constexpr A_long GRAIN_MIP_LEVELS = 6;
+
+// Graphite amount per texel (255 = full pressure) for one line width; the
+// levels follow each other from level 0, each a 2x2 box average of the last
+struct PencilGrainTile {
+    A_u_char value[GRAIN_TILE_SIZE * GRAIN_TILE_SIZE * 4 / 3];
+    A_long offset[GRAIN_MIP_LEVELS];
+};
+
+static inline A_u_long GrainHash(A_u_long a, A_u_long b)
+{
+    A_u_long h = a * 0x9E3779B1u ^ (b + 0x7F4A7C15u) * 0x85EBCA77u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+// Uniform 0.0-1.0 from two integers
+static inline PF_FpLong GrainRandom(A_u_long a, A_u_long b)
+{
+    return (GrainHash(a, b) >> 8) * (1.0 / 16777216.0);
+}
+
+// Level 0: diagonal strokes lineWidth pixels wide: u = x + y crosses them, v = x - y
+// runs along them. Each stroke has its own pressure, varying smoothly along
+// its length, over a fine paper tooth. Band and cell counts divide the tile,
+// so it wraps without seams.
+static void BuildGrainTile(A_long lineWidth, PencilGrainTile* tile)
+{
+    const A_long bands = CX_MAX(1, (GRAIN_TILE_SIZE + lineWidth / 2) / lineWidth);
+    const A_long cells = CX_MAX(1, (GRAIN_TILE_SIZE + lineWidth * 2) / (lineWidth * 4));
+
+    for (A_long y = 0; y < GRAIN_TILE_SIZE; ++y) {
+        for (A_long x = 0; x < GRAIN_TILE_SIZE; ++x) {
+            const A_long u = (x + y) & GRAIN_TILE_MASK;
+            const A_long v = (x - y) & GRAIN_TILE_MASK;
+
+            const PF_FpLong bandPos = static_cast<PF_FpLong>(u) * bands / GRAIN_TILE_SIZE;
+            const A_long band = static_cast<A_long>(bandPos);
+            const PF_FpLong across = 2.0 * (bandPos - band) - 1.0;
+            const PF_FpLong pressure = 0.55 + 0.45 * GrainRandom(band, 0);
+
+            const PF_FpLong cellPos = static_cast<PF_FpLong>(v) * cells / GRAIN_TILE_SIZE;
+            const A_long cell = static_cast<A_long>(cellPos);
+            PF_FpLong f = cellPos - cell;
+            f = f * f * (3.0 - 2.0 * f);
+            const PF_FpLong a = GrainRandom(band, cell + 1);
+            const PF_FpLong b = GrainRandom(band, (cell + 1) % cells + 1);
+            const PF_FpLong along = a + (b - a) * f;
+
+            const PF_FpLong paper = GrainRandom(x + 0x10000, y);
+
+            const PF_FpLong value = pressure * (0.6 + 0.4 * along) *
+                                    (0.4 + 0.6 * (1.0 - across * across)) *
+                                    (0.85 + 0.15 * paper);
+            tile->value[y * GRAIN_TILE_SIZE + x] = CX_ClampByte(value * 255.0 + 0.5);
+        }
+    }
+
+    // Mip chain; the tile is periodic, so every level tiles exactly
+    A_long offset = 0;
+    for (A_long level = 0; level < GRAIN_MIP_LEVELS; ++level) {
+        tile->offset[level] = offset;
+        offset += (GRAIN_TILE_SIZE >> level) * (GRAIN_TILE_SIZE >> level);
+    }
+    for (A_long level = 1; level < GRAIN_MIP_LEVELS; ++level) {
+        const A_long size = GRAIN_TILE_SIZE >> level;
+        const A_u_char* above = tile->value + tile->offset[level - 1];
+        A_u_char* out = tile->value + tile->offset[level];
+        for (A_long y = 0; y < size; ++y) {
+            const A_u_char* row0 = above + (y * 2) * (size * 2);
+            const A_u_char* row1 = row0 + size * 2;
+            for (A_long x = 0; x < size; ++x) {
+                out[y * size + x] = static_cast<A_u_char>(
+                    (row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1] + 2) >> 2);
+            }
+        }
+    }
+}
+
+// Built once per line width on first use; immutable afterwards, so render threads share it
+static const PencilGrainTile* GetGrainTile(A_long lineWidth)
+{
+    static std::once_flag once[LINE_WIDTH_MAX + 1];
+    static PencilGrainTile tiles[LINE_WIDTH_MAX + 1];
+    lineWidth = CX_CLAMP(lineWidth, LINE_WIDTH_MIN, LINE_WIDTH_MAX);
+    std::call_once(once[lineWidth], [lineWidth] { BuildGrainTile(lineWidth, &tiles[lineWidth]); });
+    return &tiles[lineWidth];
+}
+
+// ============================================================================
+// Line slots
+// ============================================================================
+
+// Per-label line settings in the render depth; label 0 (no match) is unused
+template <typename PixelT>
+struct PencilLineSlots {
+    bool                    recolor[MAX_COLORS + 1];
+    PixelT                  color[MAX_COLORS + 1];
+    const A_u_char*         grain[MAX_COLORS + 1];          // Mip level texels, NULL: no texture
+    float                   alphaScale[MAX_COLORS + 1][256]; // Grain value -> alpha factor
+
+    // Grain lookup for the render's downsampling, shared by all labels:
+    // texel = ((layer * scale) >> shift) & mask on each axis
+    A_long                  scaleX;
+    A_long                  scaleY;
+    A_long                  shift;
+    A_long                  mask;
+};
+
+// Finest level whose texels are no smaller than a rendered pixel
+static A_long GrainMipLevel(A_long downsample)
+{
+    A_long level = 0;
+    while (level + 1 < GRAIN_MIP_LEVELS && (2 << level) <= downsample) ++level;
+    return level;
+}
+
+// Density sets how much of the grain counts as graphite, strength how far
+// the uncovered part fades the line
+static void InitAlphaScale(PF_FpLong lineDensity, PF_FpLong textureStrength, float* alphaScale)
+{
+    const PF_FpLong density = lineDensity / LINE_DENSITY_MAX;
+    const PF_FpLong strength = textureStrength / TEXTURE_STRENGTH_MAX;
+    for (A_long g = 0; g < 256; ++g) {
+        const PF_FpLong coverage = CX_Clamp01((g / 255.0 + density - 0.5) * 2.0);
+        alphaScale[g] = static_cast<float>(1.0 - strength * (1.0 - coverage));
+    }
+}
+
+template <typename PixelT>
+static void InitLineSlots(const PencilLineInfo* info, PencilLineSlots<PixelT>* slots)
+{
+    typedef CX_PixelTraits<PixelT> Traits;
+    typedef CX_PixelTraits<PF_Pixel8> Traits8;
+    memset(slots, 0, sizeof(PencilLineSlots<PixelT>));
+
+    // Downsampled renders sample the level matching the coarser axis, so the
+    // grain keeps its full-resolution look and the texels read stay small
+    slots->scaleX = CX_MAX(1, info->downsampleX);
+    slots->scaleY = CX_MAX(1, info->downsampleY);
+    const A_long level = GrainMipLevel(CX_MAX(slots->scaleX, slots->scaleY));
+    slots->shift = level;
+    slots->mask = (GRAIN_TILE_SIZE >> level) - 1;
+
+    for (A_long i = 0; i < info->colorCount; ++i) {
+        const ColorEntry& entry = info->colors[i];
+        if (!entry.enabled) continue;
+
+        const A_long label = i + 1;
+        slots->recolor[label] = entry.recolor != FALSE;
+        slots->color[label].red = Traits::FromUnit(Traits8::ToUnit(entry.newColor.red));
+        slots->color[label].green = Traits::FromUnit(Traits8::ToUnit(entry.newColor.green));
+        slots->color[label].blue = Traits::FromUnit(Traits8::ToUnit(entry.newColor.blue));
+
+        const A_long lineWidth = entry.customTexture ? entry.lineWidth : info->lineWidth;
+        const PF_FpLong lineDensity = entry.customTexture ? entry.lineDensity : info->lineDensity;
+        const PF_FpLong textureStrength = entry.customTexture ? entry.textureStrength : info->textureStrength;
+        if (textureStrength > 0.0) {
+            const PencilGrainTile* tile = GetGrainTile(lineWidth);
+            slots->grain[label] = tile->value + tile->offset[level];
+            InitAlphaScale(lineDensity, textureStrength, slots->alphaScale[label]);
+        }
+    }
+}
+
+// ============================================================================
+// Pencil texture processing
+// ============================================================================
+
+// Fades the line's alpha by the grain of its color slot; x, y are layer coordinates
+// at render resolution
+template <typename PixelT>
+static inline void ApplyPencilTexture(
+    PixelT*                         outP,
+    const PixelT*                   inP,
+    const PencilLineSlots<PixelT>*  slots,
+    A_u_char                        label,
+    A_long                          x,
+    A_long                          y)
+{
+    typedef CX_PixelTraits<PixelT> Traits;
+    *outP = *inP;
+    const A_u_char* grain = slots->grain[label];
+    if (grain) {
+        const A_long tx = ((x * slots->scaleX) >> slots->shift) & slots->mask;
+        const A_long ty = ((y * slots->scaleY) >> slots->shift) & slots->mask;
+        const A_u_char g = grain[ty * (slots->mask + 1) + tx];
+        outP->alpha = Traits::FromAccum(inP->alpha * slots->alphaScale[label][g]);
+    }
+}
+
+// ============================================================================
+// Main processing function (instantiated per bit depth)
+// ============================================================================
+
+// Matched line pixel: recolor by the matched slot, then texture
+template <typename PixelT>
+static inline void ShadeLinePixel(
+    const PencilLineSlots<PixelT>*  slots,
+    A_long                          x,
+    A_long                          y,
+    A_u_char                        label,
+    const PixelT*                   inP,
+    PixelT*                         outP)
+{
+    if (slots->recolor[label]) {
+        PixelT line = slots->color[label];
+        line.alpha = inP->alpha;
+        ApplyPencilTexture(outP, &line, slots, label, x, y);
+    } else {
+        ApplyPencilTexture(outP, inP, slots, label, x, y);
+    }
+}
+
+template <typename PixelT>
+static inline void ProcessPencilPixel(
+    const PencilLineInfo*           info,
+    const PencilLineSlots<PixelT>*  slots,
+    A_long                          x,
+    A_long                          y,
+    A_u_char                        label,
+    const PixelT*                   inP,
+    PixelT*                         outP)
+{
+    const bool isTargetColor = label != 0;
+    switch (info->outputMode) {
+        case OUTPUT_MODE_LINE_ONLY:
+            if (isTargetColor) {
+                ShadeLinePixel(slots, x, y, label, inP, outP);
+            } else {
+                *outP = PixelT();
+            }
+            break;
+
+        case OUTPUT_MODE_BG_ONLY:
+            if (isTargetColor) {
+                *outP = PixelT();
+            } else {
+                *outP = *inP;
+            }
+            break;
+
+        case OUTPUT_MODE_FULL:
+        default:
+            if (isTargetColor) {
+                ShadeLinePixel(slots, x, y, label, inP, outP);
+            } else {
+                *outP = *inP;
+            }
+            break;
+    }
+}
+
+// Row job context for CX_HostIterate
+template <typename PixelT>
+struct PencilLineRowContext {
+    const PencilLineInfo*   info;
+    const CX_ColorMatcher*  matcher;
+    PencilLineSlots<PixelT> slots;
+    CX_ImageView<PixelT>    input;
+    CX_ImageView<PixelT>    output;
+    A_long                  width;
+};
+
+// One output row: match labels per chunk, then shade each pixel by its label
+template <typename PixelT>
+PF_Err ProcessPencilLineRow(
+    void*           refcon,
+    A_long          thread_idx,
+    A_long          y,
+    A_long          iterations)
+{
+    const PencilLineRowContext<PixelT>* ctx = static_cast<const PencilLineRowContext<PixelT>*>(refcon);
+    const PixelT* inRow = ctx->input.Row(y);
+    PixelT* outRow = ctx->output.Row(y);
+    const A_long layerY = y + ctx->info->originY;
+    A_u_char labels[CX_MATCH_CHUNK];
+
+    for (A_long x0 = 0; x0 < ctx->width; x0 += CX_MATCH_CHUNK) {
+        A_long n = CX_MIN(CX_MATCH_CHUNK, ctx->width - x0);
+        CX_MatchRowLabels(ctx->matcher, inRow + x0, n, labels);
+        for (A_long i = 0; i < n; ++i) {
+            ProcessPencilPixel(ctx->info, &ctx->slots, ctx->info->originX + x0 + i, layerY, labels[i],
+                               inRow + x0 + i, outRow + x0 + i);
+        }
+    }
+
+    return PF_Err_NONE;
+}
+
+template <typename PixelT>
+static PF_Err RenderPencilLine(
+    const CX_Host*          host,
+    const PencilLineInfo*   info,
+    const CX_ColorMatcher*  matcher,
+    PF_EffectWorld*         input_worldP,
+    PF_EffectWorld*         output_worldP)
+{
+    PencilLineRowContext<PixelT> ctx;
+    ctx.info = info;
+    ctx.matcher = matcher;
+    InitLineSlots(info, &ctx.slots);
+    ctx.input = CX_MakeView<PixelT>(input_worldP);
+    ctx.output = CX_MakeView<PixelT>(output_worldP);
+    ctx.width = CX_MIN(ctx.input.width, ctx.output.width);
+
+    return CX_HostIterate(
+        host,
+        CX_MIN(ctx.input.height, ctx.output.height),
+        &ctx,
+        ProcessPencilLineRow<PixelT>);
+}
+
+PF_Err PencilLineRender(
+    const CX_Host*          host,
+    const PencilLineInfo*   info,
+    PF_PixelFormat          format,
+    PF_EffectWorld*         input_worldP,
+    PF_EffectWorld*         output_worldP)
+{
+    PF_Err err = PF_Err_NONE;
+    CX_ColorMatcher matcher;
+    ERR(InitColorMatcher(info, &matcher));
+
+    if (!err) {
+        switch (format) {
+            case PF_PixelFormat_ARGB128:
+                ERR(RenderPencilLine<PF_PixelFloat>(host, info, &matcher, input_worldP, output_worldP));
+                break;
+
+            case PF_PixelFormat_ARGB64:
+                ERR(RenderPencilLine<PF_Pixel16>(host, info, &matcher, input_worldP, output_worldP));
+                break;
+
+            case PF_PixelFormat_ARGB32:
+            default:
+                ERR(RenderPencilLine<PF_Pixel8>(host, info, &matcher, input_worldP, output_worldP));
+                break;
+        }
+    }
+    CX_ColorMatcherDispose(&matcher);
+
+    return err;
+}
@@ -0,0 +1,87 @@
+/*
+ * PencilLineKernels.h
+ * cx_PencilLine - host-neutral render core
+ *
+ * Options, ranges and the render info shared by the AE and OpenFX plugins.
+ * Each plugin fills a PencilLineInfo from its own params and calls
+ * PencilLineRender with its CX_Host.
+ */
+
+#pragma once
+
+#include "CXCommon.h"
+#include "CXHost.h"
+
+// Maximum number of colors supported
+constexpr A_long MAX_COLORS = 16;
+
+// Output modes
+enum OutputMode {
+    OUTPUT_MODE_FULL = 1,       // Full image with processed lines
+    OUTPUT_MODE_LINE_ONLY,      // Only extracted lines with texture
+    OUTPUT_MODE_BG_ONLY         // Only background (no lines)
+};
+
+// Default parameter values
+constexpr PF_FpLong DEFAULT_TOLERANCE = 0.0;
+constexpr A_long DEFAULT_LINE_WIDTH = 2;
+constexpr PF_FpLong DEFAULT_LINE_DENSITY = 50.0;
+constexpr PF_FpLong DEFAULT_TEXTURE_STRENGTH = 0.0;           // Off: projects from before 1.1 had no texture
+constexpr PF_FpLong DEFAULT_CUSTOM_TEXTURE_STRENGTH = 50.0;    // Custom Texture N opts in
+
+// Parameter ranges
+constexpr PF_FpLong TOLERANCE_MIN = 0.0;
+constexpr PF_FpLong TOLERANCE_MAX = 100.0;
+constexpr A_long LINE_WIDTH_MIN = 1;
+constexpr A_long LINE_WIDTH_MAX = 20;
+constexpr PF_FpLong LINE_DENSITY_MIN = 0.0;
+constexpr PF_FpLong LINE_DENSITY_MAX = 100.0;
+constexpr PF_FpLong TEXTURE_STRENGTH_MIN = 0.0;
+constexpr PF_FpLong TEXTURE_STRENGTH_MAX = 100.0;
+
+// Single color entry for processing
+struct ColorEntry {
+    PF_Boolean enabled;
+    PF_Pixel color;
+    PF_FpLong tolerance;
+    A_long toleranceSq;     // Precomputed squared tolerance
+    PF_Boolean recolor;     // Replace matched pixels' RGB with newColor
+    PF_Pixel newColor;
+
+    // Texture for this color's lines (customTexture off: the global settings)
+    PF_Boolean customTexture;
+    A_long lineWidth;
+    PF_FpLong lineDensity;
+    PF_FpLong textureStrength;
+};
+
+// Processing info structure passed between PreRender and SmartRender
+struct PencilLineInfo {
+    // Color selection parameters
+    A_long colorCount;              // Active color count (always 16)
+    ColorEntry colors[MAX_COLORS];  // All color entries
+
+    // Pencil texture parameters (colors without custom texture)
+    A_long lineWidth;
+    PF_FpLong lineDensity;
+    PF_FpLong textureStrength;
+
+    // Output mode
+    A_long outputMode;
+
+    // Layer position of the worlds' top-left pixel; the grain is fixed to the layer
+    A_long originX;
+    A_long originY;
+
+    // Full-resolution pixels per rendered pixel (1 at full resolution)
+    A_long downsampleX;
+    A_long downsampleY;
+};
+
+// Renders input into output over the overlap of both worlds
+PF_Err PencilLineRender(
+    const CX_Host*          host,
+    const PencilLineInfo*   info,
+    PF_PixelFormat          format,
+    PF_EffectWorld*         input_worldP,
+    PF_EffectWorld*         output_worldP);
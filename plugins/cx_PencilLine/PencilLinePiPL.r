@@ -41,7 +41,7 @@ resource 'PiPL' (16000) {
 		},
 		/* [8] */
 		AE_Effect_Version {
-			524289	/* 1.0 */
+			557057	/* 1.1 */
 		},
 		/* [9] */
 		AE_Effect_Info_Flags {
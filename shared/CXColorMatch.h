@@ -0,0 +1,529 @@
+/*
+	CXColorMatch.h
+
+	CX Animation Tools - Multi-target color matching engine
+	Classifies pixels against a set of (color, tolerance, metric) entries and
+	writes either a line mask or per-pixel labels for whole rows.
+
+	Backends (chosen automatically from the entry set):
+	- DIRECT : SoA distance test, vectorized across pixels. Best up to 8 colors.
+	- LUT    : 32x32x32 coarse cell table (32 KB). Cells entirely inside or
+	           outside the set are answered by one lookup, cells on a tolerance
+	           boundary fall back to DIRECT.
+	- BITSET : exact 2^24-bit table (2 MB) of every 8-bit RGB value. Used when
+	           too many LUT cells sit on a boundary (large tolerances, many colors).
+
+	LUT and BITSET tables are built once per entry set and shared by later
+	matchers with the same entries (CX_MATCH_TABLE_CACHE_SIZE sets), so a
+	render only pays for the build when the colors or tolerances change.
+
+	All backends produce identical results: matching is always done in 8-bit
+	space (AE color picker space), first matching entry wins for labels.
+	Float pixels reach 8-bit space with the caller's CX_MatchRounding.
+
+	Distance planes store one target's per-pixel distance so a cached frame can
+	be re-thresholded at any tolerance without converting pixels again.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_COLOR_MATCH_H
+#define CX_COLOR_MATCH_H
+
+#include "CXCommon.h"
+#include "CXFrameCache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ============================================================================
+// Entries and Configuration
+// ============================================================================
+
+constexpr A_long CX_MATCH_MAX_ENTRIES = 16;
+
+// Pixels per conversion chunk in the row functions (stack scratch)
+constexpr A_long CX_MATCH_CHUNK = 256;
+
+// AUTO stays on DIRECT up to this many entries: its cost grows per entry but
+// starts far below a table lookup's (1080p, 8-bit: a DIRECT entry ~3.5 ms,
+// LUT / BITSET 20-40 ms whatever the count; they break even around 8-9)
+constexpr A_long CX_MATCH_DIRECT_MAX_ENTRIES = 8;
+
+// LUT cells with mixed results above this count switch AUTO to BITSET
+constexpr A_long CX_MATCH_BITSET_MIXED_CELLS = 1024;
+
+// Entry sets whose built tables stay cached (BITSET sets take 2 MB each)
+constexpr A_long CX_MATCH_TABLE_CACHE_SIZE = 4;
+
+enum CX_MatchMetric {
+	CX_MATCH_METRIC_RGB = 0,		// Euclidean distance in 8-bit RGB
+	CX_MATCH_METRIC_MAX_CHANNEL		// Largest single-channel difference
+};
+
+// How float channels round to 8-bit: ColorLines and PencilLine rounded
+// differently before they shared the matcher, and each keeps its own
+enum CX_MatchRounding {
+	CX_MATCH_ROUND_FLOAT = 0,		// CX_PixelTraits::ToMatch8 (PencilLine)
+	CX_MATCH_ROUND_DOUBLE			// CX_PixelTraits::ToMatch8Double (ColorLines)
+};
+
+enum CX_MatchBackend {
+	CX_MATCH_BACKEND_AUTO = 0,
+	CX_MATCH_BACKEND_DIRECT,
+	CX_MATCH_BACKEND_LUT,
+	CX_MATCH_BACKEND_BITSET
+};
+
+// One target color. threshold is compared against the metric value:
+// squared distance for RGB, plain channel difference for MAX_CHANNEL.
+struct CX_MatchEntry {
+	A_long		red, green, blue;	// 8-bit target
+	A_long		threshold;
+	A_long		metric;				// CX_MatchMetric
+	A_u_char	label;				// Written for pixels matching this entry (1-255, 0 reads as no match)
+};
+
+// Build an entry from an AE color and a 0-100 tolerance slider value
+static inline CX_MatchEntry CX_MakeMatchEntry(const PF_Pixel& color, PF_FpLong tolerance,
+                                              A_u_char label, A_long metric = CX_MATCH_METRIC_RGB) {
+	CX_MatchEntry entry;
+	entry.red = color.red;
+	entry.green = color.green;
+	entry.blue = color.blue;
+	entry.metric = metric;
+	entry.label = label;
+	if (metric == CX_MATCH_METRIC_MAX_CHANNEL) {
+		entry.threshold = static_cast<A_long>(tolerance * 2.55 + 0.5);
+	} else {
+		entry.threshold = CX_ToleranceToDistSq(tolerance);
+	}
+	return entry;
+}
+
+// ============================================================================
+// Matcher
+// ============================================================================
+
+// LUT cell states: 0 = no entry matches, 1..16 = every color matches entry
+// (state - 1) first, CX_MATCH_CELL_MIXED = test each color directly
+constexpr A_u_char CX_MATCH_CELL_MISS = 0;
+constexpr A_u_char CX_MATCH_CELL_MIXED = 255;
+constexpr A_long CX_MATCH_LUT_CELLS = 32 * 32 * 32;
+constexpr A_long CX_MATCH_BITSET_BYTES = (1 << 24) / 8;
+
+struct CX_ColorMatcher {
+	A_long		count;
+	A_long		backend;
+	A_long		rounding;		// CX_MatchRounding
+	PF_Boolean	anyMaxChannel;
+
+	// Entries in SoA layout, padded to CX_MATCH_MAX_ENTRIES
+	A_long		red[CX_MATCH_MAX_ENTRIES];
+	A_long		green[CX_MATCH_MAX_ENTRIES];
+	A_long		blue[CX_MATCH_MAX_ENTRIES];
+	A_long		threshold[CX_MATCH_MAX_ENTRIES];
+	A_long		metric[CX_MATCH_MAX_ENTRIES];
+	A_u_char	label[CX_MATCH_MAX_ENTRIES];
+
+	A_u_char	*cells;		// LUT and BITSET: CX_MATCH_LUT_CELLS states
+	A_u_char	*bits;		// BITSET only: one bit per 8-bit RGB value
+	CX_FrameBufferP	*tables;	// Reference on the cached buffer holding cells and bits
+};
+
+static inline A_long CX_MatchCellIndex(A_long r, A_long g, A_long b) {
+	return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+}
+
+static inline A_long CX_MatchBitIndex(A_long r, A_long g, A_long b) {
+	return (r << 16) | (g << 8) | b;
+}
+
+// Metric value of one entry for an 8-bit color
+static inline A_long CX_MatchDistance(const CX_ColorMatcher *m, A_long i, A_long r, A_long g, A_long b) {
+	A_long dr = r - m->red[i];
+	A_long dg = g - m->green[i];
+	A_long db = b - m->blue[i];
+	if (m->metric[i] == CX_MATCH_METRIC_MAX_CHANNEL) {
+		dr = dr < 0 ? -dr : dr;
+		dg = dg < 0 ? -dg : dg;
+		db = db < 0 ? -db : db;
+		return CX_MAX(dr, CX_MAX(dg, db));
+	}
+	return dr * dr + dg * dg + db * db;
+}
+
+// Reference path: first matching entry's label, 0 if none
+static inline A_u_char CX_MatchDirect(const CX_ColorMatcher *m, A_long r, A_long g, A_long b) {
+	for (A_long i = 0; i < m->count; i++) {
+		if (CX_MatchDistance(m, i, r, g, b) <= m->threshold[i]) return m->label[i];
+	}
+	return 0;
+}
+
+// Smallest and largest metric value of entry i over the 8x8x8 cell at (cr, cg, cb)
+static inline void CX_MatchCellRange(const CX_ColorMatcher *m, A_long i, A_long cr, A_long cg, A_long cb,
+                                     A_long *minD, A_long *maxD) {
+	const A_long lo[3] = { cr << 3, cg << 3, cb << 3 };
+	const A_long t[3] = { m->red[i], m->green[i], m->blue[i] };
+	A_long nearD[3], farD[3];
+	for (A_long c = 0; c < 3; c++) {
+		A_long hi = lo[c] + 7;
+		nearD[c] = t[c] < lo[c] ? lo[c] - t[c] : (t[c] > hi ? t[c] - hi : 0);
+		farD[c] = CX_MAX(t[c] - lo[c], hi - t[c]);
+	}
+	if (m->metric[i] == CX_MATCH_METRIC_MAX_CHANNEL) {
+		*minD = CX_MAX(nearD[0], CX_MAX(nearD[1], nearD[2]));
+		*maxD = CX_MAX(farD[0], CX_MAX(farD[1], farD[2]));
+	} else {
+		*minD = nearD[0] * nearD[0] + nearD[1] * nearD[1] + nearD[2] * nearD[2];
+		*maxD = farD[0] * farD[0] + farD[1] * farD[1] + farD[2] * farD[2];
+	}
+}
+
+// Fills the coarse table; returns the number of mixed cells
+static inline A_long CX_MatchBuildCells(CX_ColorMatcher *m) {
+	A_long mixed = 0;
+	for (A_long cr = 0; cr < 32; cr++) {
+		for (A_long cg = 0; cg < 32; cg++) {
+			for (A_long cb = 0; cb < 32; cb++) {
+				A_u_char state = CX_MATCH_CELL_MISS;
+				for (A_long i = 0; i < m->count; i++) {
+					A_long minD, maxD;
+					CX_MatchCellRange(m, i, cr, cg, cb, &minD, &maxD);
+					if (minD > m->threshold[i]) continue;
+					// First entry touching the cell decides: whole cell inside it, or mixed
+					state = (maxD <= m->threshold[i]) ? static_cast<A_u_char>(i + 1) : CX_MATCH_CELL_MIXED;
+					break;
+				}
+				if (state == CX_MATCH_CELL_MIXED) mixed++;
+				m->cells[(cr << 10) | (cg << 5) | cb] = state;
+			}
+		}
+	}
+	return mixed;
+}
+
+static inline void CX_MatchSetBitRange(A_u_char *bits, A_long first, A_long last) {
+	A_long firstByte = first >> 3, lastByte = last >> 3;
+	A_u_char headMask = static_cast<A_u_char>(0xFF << (first & 7));
+	A_u_char tailMask = static_cast<A_u_char>(0xFF >> (7 - (last & 7)));
+	if (firstByte == lastByte) {
+		bits[firstByte] |= headMask & tailMask;
+		return;
+	}
+	bits[firstByte] |= headMask;
+	if (lastByte - firstByte > 1) memset(bits + firstByte + 1, 0xFF, lastByte - firstByte - 1);
+	bits[lastByte] |= tailMask;
+}
+
+// Exact table: for each (r, g) row the matching b values form one interval per entry
+static inline void CX_MatchBuildBits(CX_ColorMatcher *m) {
+	memset(m->bits, 0, CX_MATCH_BITSET_BYTES);
+	for (A_long i = 0; i < m->count; i++) {
+		const A_long thr = m->threshold[i];
+		if (thr < 0) continue;
+		const PF_Boolean isMax = (m->metric[i] == CX_MATCH_METRIC_MAX_CHANNEL);
+		const A_long reach = isMax ? thr : static_cast<A_long>(sqrt(static_cast<PF_FpLong>(thr)));
+		const A_long r0 = CX_MAX(0, m->red[i] - reach - 1), r1 = CX_MIN(255, m->red[i] + reach + 1);
+		const A_long g0 = CX_MAX(0, m->green[i] - reach - 1), g1 = CX_MIN(255, m->green[i] + reach + 1);
+
+		for (A_long r = r0; r <= r1; r++) {
+			for (A_long g = g0; g <= g1; g++) {
+				A_long dr = r - m->red[i], dg = g - m->green[i];
+				A_long half;
+				if (isMax) {
+					if ((dr < 0 ? -dr : dr) > thr || (dg < 0 ? -dg : dg) > thr) continue;
+					half = thr;
+				} else {
+					A_long rem = thr - dr * dr - dg * dg;
+					if (rem < 0) continue;
+					// Largest half with half^2 <= rem
+					half = static_cast<A_long>(sqrt(static_cast<PF_FpLong>(rem)));
+					while (half * half > rem) half--;
+					while ((half + 1) * (half + 1) <= rem) half++;
+				}
+				A_long b0 = CX_MAX(0, m->blue[i] - half);
+				A_long b1 = CX_MIN(255, m->blue[i] + half);
+				if (b0 <= b1) CX_MatchSetBitRange(m->bits, CX_MatchBitIndex(r, g, b0), CX_MatchBitIndex(r, g, b1));
+			}
+		}
+	}
+}
+
+static inline void CX_ColorMatcherDispose(CX_ColorMatcher *m) {
+	delete m->tables;
+	m->tables = NULL;
+	m->cells = NULL;
+	m->bits = NULL;
+}
+
+// Built tables by entry set: cells, then bits when the set resolved to BITSET
+static inline CX_FrameRing& CX_MatchTableCache() {
+	static CX_FrameRing cache(CX_MATCH_TABLE_CACHE_SIZE);
+	return cache;
+}
+
+// Builds the tables for m's entries and the requested backend (AUTO resolved
+// here); the buffer is complete before it is shared
+static inline CX_FrameBufferP CX_MatchBuildTables(CX_ColorMatcher *m, A_long backend) {
+	CX_FrameBufferP tables = CX_NewFrameBuffer(CX_MATCH_LUT_CELLS);
+	if (!tables) return tables;
+	m->cells = tables->data();
+	A_long mixed = CX_MatchBuildCells(m);
+
+	// AUTO picked LUT: switch to the exact table when many colors need direct tests
+	if (backend == CX_MATCH_BACKEND_BITSET || (backend == CX_MATCH_BACKEND_AUTO && mixed > CX_MATCH_BITSET_MIXED_CELLS)) {
+		try {
+			tables->resize(CX_MATCH_LUT_CELLS + CX_MATCH_BITSET_BYTES);
+		} catch (const std::bad_alloc&) {
+			return CX_FrameBufferP();
+		}
+		m->bits = tables->data() + CX_MATCH_LUT_CELLS;
+		CX_MatchBuildBits(m);
+	}
+	return tables;
+}
+
+// Entries beyond CX_MATCH_MAX_ENTRIES are ignored. Pass CX_MATCH_BACKEND_AUTO
+// unless a specific backend is needed (benchmarks, conformance checks).
+static inline PF_Err CX_ColorMatcherInit(CX_ColorMatcher *m, const CX_MatchEntry *entries, A_long count,
+                                         A_long backend = CX_MATCH_BACKEND_AUTO,
+                                         A_long rounding = CX_MATCH_ROUND_FLOAT) {
+	memset(m, 0, sizeof(*m));
+	m->rounding = rounding;
+	m->count = CX_MIN(count, CX_MATCH_MAX_ENTRIES);
+	for (A_long i = 0; i < CX_MATCH_MAX_ENTRIES; i++) {
+		if (i < m->count) {
+			m->red[i] = entries[i].red;
+			m->green[i] = entries[i].green;
+			m->blue[i] = entries[i].blue;
+			m->threshold[i] = entries[i].threshold;
+			m->metric[i] = entries[i].metric;
+			m->label[i] = entries[i].label;
+			if (entries[i].metric == CX_MATCH_METRIC_MAX_CHANNEL) m->anyMaxChannel = TRUE;
+		} else {
+			m->threshold[i] = -1;	// Padding never matches
+		}
+	}
+
+	if (backend == CX_MATCH_BACKEND_AUTO && m->count <= CX_MATCH_DIRECT_MAX_ENTRIES) backend = CX_MATCH_BACKEND_DIRECT;
+	m->backend = backend;
+	if (backend == CX_MATCH_BACKEND_DIRECT) return PF_Err_NONE;
+
+	// Everything the tables depend on: the entries (padding included) and the backend
+	A_u_longlong key = CX_HashBytes(backend, m->red, sizeof(m->red));
+	key = CX_HashBytes(key, m->green, sizeof(m->green));
+	key = CX_HashBytes(key, m->blue, sizeof(m->blue));
+	key = CX_HashBytes(key, m->threshold, sizeof(m->threshold));
+	key = CX_HashBytes(key, m->metric, sizeof(m->metric));
+
+	CX_FrameBufferP tables = CX_MatchTableCache().Find(key);
+	if (!tables) {
+		tables = CX_MatchBuildTables(m, backend);
+		if (!tables) return PF_Err_OUT_OF_MEMORY;
+		tables = CX_MatchTableCache().Insert(key, tables);
+	}
+	m->tables = new (std::nothrow) CX_FrameBufferP(tables);
+	if (!m->tables) return PF_Err_OUT_OF_MEMORY;
+	m->cells = tables->data();
+	m->bits = tables->size() > (size_t)CX_MATCH_LUT_CELLS ? tables->data() + CX_MATCH_LUT_CELLS : NULL;
+	m->backend = m->bits ? CX_MATCH_BACKEND_BITSET : CX_MATCH_BACKEND_LUT;
+	return PF_Err_NONE;
+}
+
+// ============================================================================
+// Matching
+// ============================================================================
+
+// Label for one color already converted to 8-bit space. With kLabels false
+// the result is only zero / non-zero, which lets BITSET skip the label search.
+template <bool kLabels>
+static inline A_u_char CX_MatchLookup(const CX_ColorMatcher *m, A_long r, A_long g, A_long b) {
+	// 16-bit values above PF_MAX_CHAN16 can land outside 0-255; tables cover 0-255 only
+	if (m->cells && static_cast<A_u_long>(r | g | b) < 256) {
+		A_u_char state = m->cells[CX_MatchCellIndex(r, g, b)];
+		if (state == CX_MATCH_CELL_MISS) return 0;
+		if (state != CX_MATCH_CELL_MIXED) return m->label[state - 1];
+		if (m->bits) {
+			A_long bit = CX_MatchBitIndex(r, g, b);
+			if (!(m->bits[bit >> 3] & (1 << (bit & 7)))) return 0;
+			if (!kLabels) return 255;
+		}
+	}
+	return CX_MatchDirect(m, r, g, b);
+}
+
+static inline A_u_char CX_MatchRGB8(const CX_ColorMatcher *m, A_long r, A_long g, A_long b) {
+	return CX_MatchLookup<true>(m, r, g, b);
+}
+
+// One channel in 8-bit matching space
+template <typename PixelT>
+static inline A_long CX_MatchChannel8(typename CX_PixelTraits<PixelT>::ChannelType v, A_long rounding) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	if constexpr (Traits::kIsFloat) {
+		if (rounding == CX_MATCH_ROUND_DOUBLE) return Traits::ToMatch8Double(v);
+	}
+	return Traits::ToMatch8(v);
+}
+
+template <typename PixelT>
+static inline A_u_char CX_MatchPixel(const CX_ColorMatcher *m, const PixelT *pixel) {
+	return CX_MatchRGB8(m, CX_MatchChannel8<PixelT>(pixel->red, m->rounding),
+						CX_MatchChannel8<PixelT>(pixel->green, m->rounding),
+						CX_MatchChannel8<PixelT>(pixel->blue, m->rounding));
+}
+
+// 16-bit to 8-bit matching conversion via table (same values as CX_PixelTraits)
+static inline const A_short* CX_Match16Table() {
+	static A_short table[65536];
+	static const bool ready = [] {
+		for (A_long v = 0; v < 65536; v++) {
+			table[v] = static_cast<A_short>(CX_PixelTraits<PF_Pixel16>::ToMatch8(static_cast<A_u_short>(v)));
+		}
+		return true;
+	}();
+	(void)ready;
+	return table;
+}
+
+template <typename PixelT>
+static inline void CX_MatchConvertChunk(const PixelT *row, A_long n, A_long rounding,
+                                        A_short *r8, A_short *g8, A_short *b8) {
+	typedef CX_PixelTraits<PixelT> Traits;
+	if constexpr (sizeof(typename Traits::ChannelType) == 2) {
+		const A_short *table = CX_Match16Table();
+		for (A_long i = 0; i < n; i++) {
+			r8[i] = table[row[i].red];
+			g8[i] = table[row[i].green];
+			b8[i] = table[row[i].blue];
+		}
+	} else if (Traits::kIsFloat && rounding == CX_MATCH_ROUND_DOUBLE) {
+		for (A_long i = 0; i < n; i++) {
+			r8[i] = static_cast<A_short>(CX_MatchChannel8<PixelT>(row[i].red, rounding));
+			g8[i] = static_cast<A_short>(CX_MatchChannel8<PixelT>(row[i].green, rounding));
+			b8[i] = static_cast<A_short>(CX_MatchChannel8<PixelT>(row[i].blue, rounding));
+		}
+	} else {
+		for (A_long i = 0; i < n; i++) {
+			r8[i] = static_cast<A_short>(Traits::ToMatch8(row[i].red));
+			g8[i] = static_cast<A_short>(Traits::ToMatch8(row[i].green));
+			b8[i] = static_cast<A_short>(Traits::ToMatch8(row[i].blue));
+		}
+	}
+}
+
+// DIRECT backend over a converted chunk: one pass per entry, vectorizable across pixels
+static inline void CX_MatchChunkDirect(const CX_ColorMatcher *m, A_long n,
+                                       const A_short *r8, const A_short *g8, const A_short *b8, A_u_char *out) {
+	memset(out, 0, n);
+	for (A_long e = 0; e < m->count; e++) {
+		const A_long tr = m->red[e], tg = m->green[e], tb = m->blue[e], thr = m->threshold[e];
+		const A_u_char lbl = m->label[e];
+		if (m->metric[e] == CX_MATCH_METRIC_MAX_CHANNEL) {
+			for (A_long i = 0; i < n; i++) {
+				A_long dr = r8[i] - tr, dg = g8[i] - tg, db = b8[i] - tb;
+				dr = dr < 0 ? -dr : dr;
+				dg = dg < 0 ? -dg : dg;
+				db = db < 0 ? -db : db;
+				A_long d = CX_MAX(dr, CX_MAX(dg, db));
+				out[i] = (out[i] == 0 && d <= thr) ? lbl : out[i];
+			}
+		} else {
+			for (A_long i = 0; i < n; i++) {
+				A_long dr = r8[i] - tr, dg = g8[i] - tg, db = b8[i] - tb;
+				A_long d = dr * dr + dg * dg + db * db;
+				out[i] = (out[i] == 0 && d <= thr) ? lbl : out[i];
+			}
+		}
+	}
+}
+
+template <bool kLabels, typename PixelT>
+static inline void CX_MatchRowImpl(const CX_ColorMatcher *m, const PixelT *row, A_long width, A_u_char *out) {
+	if (m->count == 0) {
+		memset(out, 0, width);
+		return;
+	}
+	A_short r8[CX_MATCH_CHUNK], g8[CX_MATCH_CHUNK], b8[CX_MATCH_CHUNK];
+	for (A_long x0 = 0; x0 < width; x0 += CX_MATCH_CHUNK) {
+		A_long n = CX_MIN(CX_MATCH_CHUNK, width - x0);
+		CX_MatchConvertChunk(row + x0, n, m->rounding, r8, g8, b8);
+		if (m->backend == CX_MATCH_BACKEND_DIRECT) {
+			CX_MatchChunkDirect(m, n, r8, g8, b8, out + x0);
+		} else {
+			for (A_long i = 0; i < n; i++) {
+				out[x0 + i] = CX_MatchLookup<kLabels>(m, r8[i], g8[i], b8[i]);
+			}
+		}
+	}
+}
+
+// Writes the first matching entry's label (0 = no match) for each pixel of a row
+template <typename PixelT>
+static inline void CX_MatchRowLabels(const CX_ColorMatcher *m, const PixelT *row, A_long width, A_u_char *out) {
+	CX_MatchRowImpl<true>(m, row, width, out);
+}
+
+// Line mask for a row: hitValue where any entry matches, 0 elsewhere
+template <typename PixelT>
+static inline void CX_MatchRowMask(const CX_ColorMatcher *m, const PixelT *row, A_long width,
+                                   A_u_char *out, A_u_char hitValue = 255) {
+	CX_MatchRowImpl<false>(m, row, width, out);
+	for (A_long i = 0; i < width; i++) {
+		out[i] = out[i] ? hitValue : 0;
+	}
+}
+
+// ============================================================================
+// Distance Planes
+// ============================================================================
+
+// Per-pixel RGB distance to one target, rounded up to a whole step so a frame
+// fits 16 bits per pixel. For an integer radius, distSq <= radius^2 exactly
+// when the rounded distance <= radius, so thresholding a cached plane gives
+// the same mask as the matcher for every tolerance slider value.
+
+// Smallest s with s * s >= v
+static inline A_long CX_CeilSqrt(A_long v) {
+	A_long s = static_cast<A_long>(sqrt(static_cast<PF_FpLong>(v)));
+	while (s * s < v) s++;
+	while (s > 0 && (s - 1) * (s - 1) >= v) s--;
+	return s;
+}
+
+// One row of several targets' planes: out[k] receives the row for colors[k];
+// rounding as for the matcher the planes stand in for
+template <typename PixelT>
+static inline void CX_MatchDistanceRow(const PixelT *row, A_long width, A_long rounding, const PF_Pixel *colors,
+                                       A_long count, A_u_short *const *out) {
+	A_short r8[CX_MATCH_CHUNK], g8[CX_MATCH_CHUNK], b8[CX_MATCH_CHUNK];
+	for (A_long x0 = 0; x0 < width; x0 += CX_MATCH_CHUNK) {
+		A_long n = CX_MIN(CX_MATCH_CHUNK, width - x0);
+		CX_MatchConvertChunk(row + x0, n, rounding, r8, g8, b8);
+		for (A_long k = 0; k < count; k++) {
+			const A_long tr = colors[k].red, tg = colors[k].green, tb = colors[k].blue;
+			A_u_short *plane = out[k] + x0;
+			for (A_long i = 0; i < n; i++) {
+				A_long dr = r8[i] - tr, dg = g8[i] - tg, db = b8[i] - tb;
+				A_long distSq = dr * dr + dg * dg + db * db;
+				// Float sqrt truncates to the exact floor here: distSq < 2^20 and a
+				// non-square's root is never within float precision of an integer
+				A_long s = static_cast<A_long>(sqrtf(static_cast<float>(distSq)));
+				plane[i] = static_cast<A_u_short>(s + (s * s < distSq));
+			}
+		}
+	}
+}
+
+// ORs hitValue into out where the plane is within radius (vectorizable)
+static inline void CX_MatchThresholdRow(const A_u_short *plane, A_long width, A_long radius,
+                                        A_u_char *out, A_u_char hitValue = 255) {
+	for (A_long i = 0; i < width; i++) {
+		out[i] |= (plane[i] <= radius) ? hitValue : 0;
+	}
+}
+
+#endif // CX_COLOR_MATCH_H
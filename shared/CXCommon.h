@@ -11,13 +11,18 @@
 #ifndef CX_COMMON_H
 #define CX_COMMON_H
 
-#include "AEConfig.h"
-#include "AE_Effect.h"
-#include "AE_EffectCB.h"
-#include "AE_Macros.h"
-
-#ifdef AE_OS_WIN
-	#include <Windows.h>
+#ifdef CX_PORTABLE
+	// OpenFX and command line builds: SDK subset, no AE headers
+	#include "CXPortable.h"
+#else
+	#include "AEConfig.h"
+	#include "AE_Effect.h"
+	#include "AE_EffectCB.h"
+	#include "AE_Macros.h"
+
+	#ifdef AE_OS_WIN
+		#include <Windows.h>
+	#endif
 #endif
 
 // ============================================================================
@@ -54,17 +59,101 @@ static inline PF_FpLong CX_Clamp01(PF_FpLong value) {
 	return value < 0.0 ? 0.0 : (value > 1.0 ? 1.0 : value);
 }
 
-// Pixel access helpers
-static inline PF_Pixel8* CX_GetRow8(PF_EffectWorld *world, A_long y) {
-	return (PF_Pixel8*)((char*)world->data + y * world->rowbytes);
-}
+// ============================================================================
+// Pixel Traits and Image Views
+// ============================================================================
+
+// Per-bit-depth constants and conversions, so kernels are written once as
+// templates and instantiated for PF_Pixel8 / PF_Pixel16 / PF_PixelFloat.
+//   ChannelType  - storage type of one channel
+//   AccumType    - type used for weighted sums over neighbours
+//   kMaxChannel  - fully opaque / full intensity value
+//   ToMatch8     - channel to 8-bit matching space (AE color picker space)
+//                  (float also has ToMatch8Double, see CX_MatchRounding)
+//   ToUnit       - channel to 0..1 (float is passed through, may be HDR)
+//   FromUnit     - 0..1 back to channel (clamped for integer depths)
+//   FromAccum    - accumulated value in channel scale back to channel
+//   ClampUnit    - clamps intermediate 0..1 values for integer depths only
+template <typename PixelT> struct CX_PixelTraits;
+
+template <> struct CX_PixelTraits<PF_Pixel8> {
+	typedef A_u_char ChannelType;
+	typedef PF_FpLong AccumType;
+	static constexpr ChannelType kMaxChannel = PF_MAX_CHAN8;
+	static constexpr bool kIsFloat = false;
+
+	static inline A_long ToMatch8(ChannelType v) { return static_cast<A_long>(v); }
+	static inline PF_FpLong ToUnit(ChannelType v) { return v * 0.00392156863; }  // / 255.0
+	static inline ChannelType FromUnit(PF_FpLong v) { return CX_ClampByte(v * 255.0); }
+	static inline ChannelType FromAccum(AccumType v) { return CX_ClampByte(v); }
+	static inline PF_FpLong ClampUnit(PF_FpLong v) { return CX_Clamp01(v); }
+};
+
+template <> struct CX_PixelTraits<PF_Pixel16> {
+	typedef A_u_short ChannelType;
+	typedef PF_FpLong AccumType;
+	static constexpr ChannelType kMaxChannel = PF_MAX_CHAN16;
+	static constexpr bool kIsFloat = false;
+
+	// Precise conversion: 16-bit (0-32768) to 8-bit (0-255)
+	static inline A_long ToMatch8(ChannelType v) {
+		return static_cast<A_long>(static_cast<double>(v) / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
+	}
+	static inline PF_FpLong ToUnit(ChannelType v) { return v * (1.0 / PF_MAX_CHAN16); }
+	static inline ChannelType FromUnit(PF_FpLong v) { return CX_Clamp16(v * PF_MAX_CHAN16); }
+	static inline ChannelType FromAccum(AccumType v) { return CX_Clamp16(v); }
+	static inline PF_FpLong ClampUnit(PF_FpLong v) { return CX_Clamp01(v); }
+};
+
+template <> struct CX_PixelTraits<PF_PixelFloat> {
+	typedef PF_FpShort ChannelType;
+	typedef PF_FpLong AccumType;
+	static constexpr ChannelType kMaxChannel = 1.0f;
+	static constexpr bool kIsFloat = true;
+
+	// Float (0.0-1.0) to 8-bit (0-255); out-of-range and NaN clamp into 0-255.
+	// ToMatch8 rounds in float as PencilLine always has, ToMatch8Double in double
+	// as ColorLines always has: 128 values next to a rounding boundary differ,
+	// and each plugin keeps the step its 32-bpc projects were matched at.
+	static inline A_long ToMatch8(ChannelType v) {
+		float c = v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+		return static_cast<A_long>(c * 255.0f + 0.5f);
+	}
+	static inline A_long ToMatch8Double(ChannelType v) {
+		double c = v > 0.0f ? (v < 1.0f ? v : 1.0f) : 0.0f;
+		return static_cast<A_long>(c * 255.0 + 0.5);
+	}
+	static inline PF_FpLong ToUnit(ChannelType v) { return v; }
+	static inline ChannelType FromUnit(PF_FpLong v) { return static_cast<ChannelType>(v); }
+	static inline ChannelType FromAccum(AccumType v) { return static_cast<ChannelType>(v); }
+	static inline PF_FpLong ClampUnit(PF_FpLong v) { return v; }
+};
+
+// Strided view of a pixel buffer: origin pointer, size and row stride in bytes.
+// Trivially copyable, no ownership; all accessors inline to plain pointer math.
+template <typename PixelT>
+struct CX_ImageView {
+	char	*origin;
+	A_long	width;
+	A_long	height;
+	A_long	rowbytes;
+
+	inline PixelT* Row(A_long y) const {
+		return reinterpret_cast<PixelT*>(origin + static_cast<A_intptr_t>(y) * rowbytes);
+	}
+	inline PixelT& At(A_long x, A_long y) const { return Row(y)[x]; }
+};
 
-static inline PF_Pixel16* CX_GetRow16(PF_EffectWorld *world, A_long y) {
-	return (PF_Pixel16*)((char*)world->data + y * world->rowbytes);
+template <typename PixelT>
+static inline CX_ImageView<PixelT> CX_MakeView(const PF_EffectWorld *world) {
+	CX_ImageView<PixelT> v = { reinterpret_cast<char*>(world->data), world->width, world->height, world->rowbytes };
+	return v;
 }
 
-static inline PF_PixelFloat* CX_GetRowFloat(PF_EffectWorld *world, A_long y) {
-	return (PF_PixelFloat*)((char*)world->data + y * world->rowbytes);
+// Row access for code that works directly on PF_EffectWorld
+template <typename PixelT>
+static inline PixelT* CX_GetRow(const PF_EffectWorld *world, A_long y) {
+	return reinterpret_cast<PixelT*>(reinterpret_cast<char*>(world->data) + static_cast<A_intptr_t>(y) * world->rowbytes);
 }
 
 // Rectangle union helper
@@ -75,6 +164,10 @@ static inline void CX_UnionLRect(const PF_LRect *src, PF_LRect *dst) {
 	if (src->bottom > dst->bottom) dst->bottom = src->bottom;
 }
 
+static inline PF_Boolean CX_IsEmptyRect(const PF_LRect *rect) {
+	return rect->left >= rect->right || rect->top >= rect->bottom;
+}
+
 // ============================================================================
 // Color Matching Functions (all operate in 8-bit space for AE color picker compatibility)
 // ============================================================================
@@ -83,47 +176,6 @@ static inline void CX_UnionLRect(const PF_LRect *src, PF_LRect *dst) {
 // sqrt(255^2 * 3) ≈ 441.67, so tolerance 100 = full range
 constexpr PF_FpLong CX_TOLERANCE_SCALE = 4.4167;
 
-// 8-bit color matching
-static inline PF_Boolean CX_IsTargetColor8(const PF_Pixel8* pixel,
-                                            A_long targetR, A_long targetG, A_long targetB,
-                                            A_long toleranceSq) {
-    A_long dr = static_cast<A_long>(pixel->red) - targetR;
-    A_long dg = static_cast<A_long>(pixel->green) - targetG;
-    A_long db = static_cast<A_long>(pixel->blue) - targetB;
-    A_long distSq = dr * dr + dg * dg + db * db;
-    return (distSq <= toleranceSq);
-}
-
-// 16-bit color matching (converts to 8-bit space for comparison)
-static inline PF_Boolean CX_IsTargetColor16(const PF_Pixel16* pixel,
-                                             A_long targetR8, A_long targetG8, A_long targetB8,
-                                             A_long toleranceSq8) {
-    // Precise conversion: 16-bit (0-32768) to 8-bit (0-255)
-    A_long r8 = static_cast<A_long>(static_cast<double>(pixel->red) / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
-    A_long g8 = static_cast<A_long>(static_cast<double>(pixel->green) / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
-    A_long b8 = static_cast<A_long>(static_cast<double>(pixel->blue) / PF_MAX_CHAN16 * PF_MAX_CHAN8 + 0.5);
-    A_long dr = r8 - targetR8;
-    A_long dg = g8 - targetG8;
-    A_long db = b8 - targetB8;
-    A_long distSq = dr * dr + dg * dg + db * db;
-    return (distSq <= toleranceSq8);
-}
-
-// 32-bit float color matching (converts to 8-bit space for comparison)
-static inline PF_Boolean CX_IsTargetColorFloat(const PF_PixelFloat* pixel,
-                                                A_long targetR8, A_long targetG8, A_long targetB8,
-                                                A_long toleranceSq8) {
-    // Float (0.0-1.0) to 8-bit (0-255) with clamping
-    A_long r8 = static_cast<A_long>(CX_CLAMP(pixel->red, 0.0f, 1.0f) * 255.0f + 0.5f);
-    A_long g8 = static_cast<A_long>(CX_CLAMP(pixel->green, 0.0f, 1.0f) * 255.0f + 0.5f);
-    A_long b8 = static_cast<A_long>(CX_CLAMP(pixel->blue, 0.0f, 1.0f) * 255.0f + 0.5f);
-    A_long dr = r8 - targetR8;
-    A_long dg = g8 - targetG8;
-    A_long db = b8 - targetB8;
-    A_long distSq = dr * dr + dg * dg + db * db;
-    return (distSq <= toleranceSq8);
-}
-
 // Helper to precompute squared tolerance from 0-100 scale
 static inline A_long CX_ToleranceToDistSq(PF_FpLong tolerance) {
     A_long maxDist = static_cast<A_long>(tolerance * CX_TOLERANCE_SCALE + 0.5);
@@ -0,0 +1,115 @@
+/*
+	CXCpu.h
+
+	CX Animation Tools - Runtime CPU dispatch
+	Detects the widest SIMD level the CPU and OS support, once per process.
+	Kernels for a level are compiled with CX_TARGET_AVX2 / CX_TARGET_AVX512
+	and picked at render time, so one binary runs on every node.
+
+	Setting the environment variable CX_SIMD to "scalar", "avx2" or "avx512"
+	caps the level (never raises it), e.g. to pin a render farm with mixed
+	CPUs to one code path.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_CPU_H
+#define CX_CPU_H
+
+#include "CXCommon.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#include <immintrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+#endif
+
+// ============================================================================
+// Levels and Target Attributes
+// ============================================================================
+
+enum CX_SimdLevel {
+	CX_SIMD_SCALAR = 0,
+	CX_SIMD_AVX2,		// AVX2 + FMA
+	CX_SIMD_AVX512		// AVX-512 F
+};
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	// MSVC accepts any intrinsic in any function
+	#define CX_HAS_X86_SIMD 1
+	#define CX_TARGET_AVX2
+	#define CX_TARGET_AVX512
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define CX_HAS_X86_SIMD 1
+	#define CX_TARGET_AVX2		__attribute__((target("avx2,fma")))
+	#define CX_TARGET_AVX512	__attribute__((target("avx512f,avx2,fma")))
+#else
+	#define CX_HAS_X86_SIMD 0
+#endif
+
+// ============================================================================
+// Detection
+// ============================================================================
+
+static inline A_long CX_DetectSimdLevel() {
+#if CX_HAS_X86_SIMD && defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0);
+	if (regs[0] < 7) return CX_SIMD_SCALAR;
+
+	__cpuid(regs, 1);
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	const bool fma = (regs[2] & (1 << 12)) != 0;
+	if (!osxsave) return CX_SIMD_SCALAR;
+
+	// OS must save YMM (bits 1-2) and, for AVX-512, opmask/ZMM state (bits 5-7)
+	const unsigned long long xcr0 = _xgetbv(0);
+	__cpuidex(regs, 7, 0);
+	const bool avx2 = (regs[1] & (1 << 5)) != 0;
+	const bool avx512f = (regs[1] & (1 << 16)) != 0;
+
+	if (avx512f && fma && (xcr0 & 0xE6) == 0xE6) return CX_SIMD_AVX512;
+	if (avx2 && fma && (xcr0 & 0x06) == 0x06) return CX_SIMD_AVX2;
+	return CX_SIMD_SCALAR;
+#elif CX_HAS_X86_SIMD
+	__builtin_cpu_init();
+	const bool fma = __builtin_cpu_supports("fma");
+	if (__builtin_cpu_supports("avx512f") && fma) return CX_SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2") && fma) return CX_SIMD_AVX2;
+	return CX_SIMD_SCALAR;
+#else
+	return CX_SIMD_SCALAR;
+#endif
+}
+
+// CX_SIMD environment cap; -1 when unset or unrecognised
+static inline A_long CX_SimdLevelOverride() {
+	char value[16] = { 0 };
+#ifdef AE_OS_WIN
+	if (!GetEnvironmentVariableA("CX_SIMD", value, sizeof(value))) return -1;
+#else
+	const char *env = getenv("CX_SIMD");
+	if (!env) return -1;
+	strncpy(value, env, sizeof(value) - 1);
+#endif
+	if (strcmp(value, "scalar") == 0) return CX_SIMD_SCALAR;
+	if (strcmp(value, "avx2") == 0) return CX_SIMD_AVX2;
+	if (strcmp(value, "avx512") == 0) return CX_SIMD_AVX512;
+	return -1;
+}
+
+// Level to dispatch on; detected once, thread-safe
+static inline A_long CX_SimdLevel() {
+	static const A_long level = [] {
+		A_long detected = CX_DetectSimdLevel();
+		A_long cap = CX_SimdLevelOverride();
+		return (cap >= 0 && cap < detected) ? cap : detected;
+	}();
+	return level;
+}
+
+#endif // CX_CPU_H
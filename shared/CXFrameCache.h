@@ -0,0 +1,180 @@
+/*
+	CXFrameCache.h
+
+	CX Animation Tools - Per-frame buffer cache
+	Content hashing for effect worlds and a small thread-safe ring of
+	per-frame buffers (line masks etc.) shared by concurrent render threads.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_FRAME_CACHE_H
+#define CX_FRAME_CACHE_H
+
+#include "CXCommon.h"
+#include <string.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// ============================================================================
+// Hashing
+// ============================================================================
+
+// 64-bit multiply-rotate mixing step, used for frame and parameter keys
+static inline A_u_longlong CX_HashMix(A_u_longlong h, A_u_longlong v) {
+	h ^= v * 0x9E3779B97F4A7C15ULL;
+	h = (h << 27) | (h >> 37);
+	return h * 0xBF58476D1CE4E5B9ULL;
+}
+
+static inline A_u_longlong CX_HashBytes(A_u_longlong seed, const void *data, size_t size) {
+	const unsigned char *p = static_cast<const unsigned char*>(data);
+
+	// Four independent lanes so the multiply chains overlap
+	A_u_longlong h0 = seed;
+	A_u_longlong h1 = seed ^ 0x6A09E667F3BCC908ULL;
+	A_u_longlong h2 = seed ^ 0xBB67AE8584CAA73BULL;
+	A_u_longlong h3 = seed ^ 0x3C6EF372FE94F82BULL;
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		A_u_longlong w[4];
+		memcpy(w, p + i, sizeof(w));
+		h0 = CX_HashMix(h0, w[0]);
+		h1 = CX_HashMix(h1, w[1]);
+		h2 = CX_HashMix(h2, w[2]);
+		h3 = CX_HashMix(h3, w[3]);
+	}
+	for (; i + 8 <= size; i += 8) {
+		A_u_longlong w;
+		memcpy(&w, p + i, sizeof(w));
+		h0 = CX_HashMix(h0, w);
+	}
+	if (i < size) {
+		A_u_longlong w = 0;
+		memcpy(&w, p + i, size - i);
+		h1 = CX_HashMix(h1, w);
+	}
+	return CX_HashMix(CX_HashMix(CX_HashMix(CX_HashMix(h0, h1), h2), h3), size);
+}
+
+// Hash of one row's pixels (row padding excluded). Rows can be hashed in
+// parallel and folded with CX_HashWorldRows.
+template <typename PixelT>
+static inline A_u_longlong CX_HashWorldRow(const PF_EffectWorld *world, A_long y) {
+	return CX_HashBytes(y, CX_GetRow<PixelT>(world, y), static_cast<size_t>(world->width) * sizeof(PixelT));
+}
+
+static inline A_u_longlong CX_HashWorldRows(const PF_EffectWorld *world, const A_u_longlong *rowHashes, A_u_longlong seed) {
+	A_u_longlong h = CX_HashMix(CX_HashMix(seed, world->width), world->height);
+	for (A_long y = 0; y < world->height; y++) {
+		h = CX_HashMix(h, rowHashes[y]);
+	}
+	return h;
+}
+
+// Single-threaded hash of a whole world, chained onto seed
+template <typename PixelT>
+static inline A_u_longlong CX_HashWorld(const PF_EffectWorld *world, A_u_longlong seed) {
+	A_u_longlong h = CX_HashMix(CX_HashMix(seed, world->width), world->height);
+	for (A_long y = 0; y < world->height; y++) {
+		h = CX_HashMix(h, CX_HashWorldRow<PixelT>(world, y));
+	}
+	return h;
+}
+
+// ============================================================================
+// Frame Ring
+// ============================================================================
+
+// Shared, immutable once inserted: readers keep a reference while they use it,
+// so eviction by another render thread never frees a buffer in use.
+typedef std::shared_ptr<std::vector<A_u_char>> CX_FrameBufferP;
+
+static inline CX_FrameBufferP CX_NewFrameBuffer(size_t size) {
+	try {
+		return std::make_shared<std::vector<A_u_char>>(size);
+	} catch (const std::bad_alloc&) {
+		return CX_FrameBufferP();
+	}
+}
+
+// Fixed-size ring of keyed buffers; the oldest entry is replaced first. With
+// maxBytes set, older entries are also dropped while the buffers together
+// exceed it. All methods lock, so one global instance can serve MFR render
+// threads.
+struct CX_FrameRing {
+	struct Slot {
+		A_u_longlong	key;
+		CX_FrameBufferP	buffer;
+	};
+
+	std::mutex			lock;
+	std::vector<Slot>	slots;
+	size_t				next;
+	size_t				maxBytes;	// 0: slot count only
+
+	explicit CX_FrameRing(size_t capacity, size_t maxBytes = 0) : slots(capacity), next(0), maxBytes(maxBytes) {}
+
+	CX_FrameBufferP Find(A_u_longlong key) {
+		std::lock_guard<std::mutex> guard(lock);
+		for (const Slot& slot : slots) {
+			if (slot.buffer && slot.key == key) return slot.buffer;
+		}
+		return CX_FrameBufferP();
+	}
+
+	// Returns the buffer now cached under key: the given one, or the one another
+	// thread inserted first (callers should continue with the returned buffer)
+	CX_FrameBufferP Insert(A_u_longlong key, const CX_FrameBufferP& buffer) {
+		std::lock_guard<std::mutex> guard(lock);
+		for (const Slot& slot : slots) {
+			if (slot.buffer && slot.key == key) return slot.buffer;
+		}
+		Store(key, buffer);
+		return buffer;
+	}
+
+	// Caches buffer under key in place of the current entry, which is returned
+	// (empty if there was none)
+	CX_FrameBufferP Exchange(A_u_longlong key, const CX_FrameBufferP& buffer) {
+		std::lock_guard<std::mutex> guard(lock);
+		for (Slot& slot : slots) {
+			if (slot.buffer && slot.key == key) {
+				CX_FrameBufferP previous = slot.buffer;
+				slot.buffer = buffer;
+				return previous;
+			}
+		}
+		Store(key, buffer);
+		return CX_FrameBufferP();
+	}
+
+	void Clear() {
+		std::lock_guard<std::mutex> guard(lock);
+		for (Slot& slot : slots) slot.buffer.reset();
+	}
+
+	// New entry in the oldest slot, then the byte budget (callers hold lock)
+	void Store(A_u_longlong key, const CX_FrameBufferP& buffer) {
+		size_t slot = next;
+		slots[slot].key = key;
+		slots[slot].buffer = buffer;
+		next = (next + 1) % slots.size();
+		if (!maxBytes) return;
+
+		size_t bytes = 0;
+		for (const Slot& s : slots) {
+			if (s.buffer) bytes += s.buffer->size();
+		}
+		for (size_t i = next; bytes > maxBytes && i != slot; i = (i + 1) % slots.size()) {
+			if (!slots[i].buffer) continue;
+			bytes -= slots[i].buffer->size();
+			slots[i].buffer.reset();
+		}
+	}
+};
+
+#endif // CX_FRAME_CACHE_H
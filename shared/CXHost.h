@@ -0,0 +1,74 @@
+/*
+	CXHost.h
+
+	CX Animation Tools - Host services for portable kernels
+	Kernels only need one thing from the host: a parallel for over row or
+	tile jobs with the iterate_generic contract (refcon, thread index, job
+	index, job count; jobs run in any order, any error is returned). Each
+	target supplies it: the AE plugins wrap PF_Iterate8Suite2, the OpenFX
+	plugins wrap the multithread suite.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_HOST_H
+#define CX_HOST_H
+
+#include "CXCommon.h"
+
+#ifndef CX_PORTABLE
+	#include "AE_EffectCBSuites.h"
+	#include "AEFX_SuiteHelper.h"
+#endif
+
+// ============================================================================
+// Host Interface
+// ============================================================================
+
+typedef PF_Err (*CX_IterateFunc)(void *refcon, A_long thread_idx, A_long i, A_long iterations);
+
+typedef struct CX_Host {
+	void	*context;
+	PF_Err	(*iterate)(void *context, A_long count, void *refcon, CX_IterateFunc fn);
+} CX_Host;
+
+// Runs fn for i in [0, count); returns when every job has finished
+static inline PF_Err CX_HostIterate(const CX_Host *host, A_long count, void *refcon, CX_IterateFunc fn) {
+	if (count <= 0) return PF_Err_NONE;
+	return host->iterate(host->context, count, refcon, fn);
+}
+
+// Inline host for tools without a thread pool; also a reference for adapters
+static inline PF_Err CX_SerialIterate(void *context, A_long count, void *refcon, CX_IterateFunc fn) {
+	PF_Err err = PF_Err_NONE;
+	for (A_long i = 0; i < count && !err; i++) err = fn(refcon, 0, i, count);
+	return err;
+}
+
+// ============================================================================
+// After Effects Adapter
+// ============================================================================
+
+#ifndef CX_PORTABLE
+
+typedef struct {
+	PF_InData	*in_data;
+	PF_OutData	*out_data;
+} CX_AEHostContext;
+
+// iterate_generic is bit-depth agnostic, the 8-bit suite serves all formats
+static inline PF_Err CX_AEIterate(void *context, A_long count, void *refcon, CX_IterateFunc fn) {
+	CX_AEHostContext *ae = (CX_AEHostContext*)context;
+	AEFX_SuiteScoper<PF_Iterate8Suite2> iterSuite = AEFX_SuiteScoper<PF_Iterate8Suite2>(ae->in_data, kPFIterate8Suite, kPFIterate8SuiteVersion2, ae->out_data);
+	return iterSuite->iterate_generic(count, refcon, fn);
+}
+
+static inline CX_Host CX_MakeAEHost(CX_AEHostContext *context) {
+	CX_Host host = { context, CX_AEIterate };
+	return host;
+}
+
+#endif
+
+#endif // CX_HOST_H
@@ -0,0 +1,97 @@
+/*
+	CXPortable.h
+
+	CX Animation Tools - Host-neutral SDK subset
+	Kernels are written against the After Effects SDK types. Builds for other
+	hosts (OpenFX, the command line tools) define CX_PORTABLE and get this
+	subset instead of the AE headers: same names, same layouts for the pixel
+	and rect types, and an effect world that carries only what the kernels
+	read (extent_hint, data, rowbytes, width, height).
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_PORTABLE_H
+#define CX_PORTABLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ============================================================================
+// Scalar Types
+// ============================================================================
+
+typedef int32_t			A_long;
+typedef uint32_t		A_u_long;
+typedef char			A_char;
+typedef unsigned char	A_u_char;
+typedef int16_t			A_short;
+typedef uint16_t		A_u_short;
+typedef uint64_t		A_u_longlong;
+typedef intptr_t		A_intptr_t;
+typedef unsigned char	A_Boolean;
+
+typedef A_long			PF_Err;
+typedef A_Boolean		PF_Boolean;
+typedef double			PF_FpLong;
+typedef float			PF_FpShort;
+
+#ifndef TRUE
+	#define TRUE	1
+#endif
+#ifndef FALSE
+	#define FALSE	0
+#endif
+
+#define PF_MAX_CHAN8	255
+#define PF_MAX_CHAN16	32768
+
+// Error codes keep their AE values so results pass through either host unchanged
+enum {
+	PF_Err_NONE = 0,
+	PF_Err_OUT_OF_MEMORY = 4,
+	PF_Err_INTERNAL_STRUCT_DAMAGED = 512,
+	PF_Err_INVALID_INDEX,
+	PF_Err_UNRECOGNIZED_PARAM_TYPE,
+	PF_Err_INVALID_CALLBACK,
+	PF_Err_BAD_CALLBACK_PARAM,
+	PF_Interrupt_CANCEL
+};
+
+// ============================================================================
+// Pixels, Rects and Worlds
+// ============================================================================
+
+// Channel order is ARGB as in AE; adapters for RGBA hosts swizzle at the edges
+typedef struct { A_u_char alpha, red, green, blue; } PF_Pixel8, PF_Pixel;
+typedef struct { A_u_short alpha, red, green, blue; } PF_Pixel16;
+typedef struct { PF_FpShort alpha, red, green, blue; } PF_PixelFloat, PF_Pixel32;
+
+typedef struct { A_long left, top, right, bottom; } PF_LRect, PF_Rect;
+
+typedef struct PF_LayerDef {
+	PF_LRect	extent_hint;	// Region to write, in world coordinates
+	void		*data;
+	A_long		rowbytes;
+	A_long		width;
+	A_long		height;
+} PF_LayerDef, PF_EffectWorld;
+
+typedef A_long PF_PixelFormat;
+enum {
+	PF_PixelFormat_ARGB32 = 0x61726762,		// 'argb'
+	PF_PixelFormat_ARGB64 = 0x61723634,		// 'ar64'
+	PF_PixelFormat_ARGB128 = 0x61723132,	// 'ar12'
+	PF_PixelFormat_INVALID = 0x62616466		// 'badf'
+};
+
+enum {
+	PF_Quality_LO = 0,
+	PF_Quality_HI
+};
+
+#define AEFX_CLR_STRUCT(STRUCT) memset(&(STRUCT), 0, sizeof(STRUCT))
+#define ERR(FUNC) do { if (!err) { err = (FUNC); } } while (0)
+
+#endif // CX_PORTABLE_H
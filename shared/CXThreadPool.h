@@ -0,0 +1,151 @@
+/*
+	CXThreadPool.h
+
+	CX Animation Tools - Worker pool for standalone hosts
+	Persistent threads behind a CX_Host, for tools that run the kernels
+	outside AE and OpenFX (C library, command line). Workers are created
+	once and reused by every pass, so a render costs no thread start-up.
+
+	Copyright (c) 2025 CX Animation Tools
+*/
+
+#pragma once
+#ifndef CX_THREAD_POOL_H
+#define CX_THREAD_POOL_H
+
+#include "CXCommon.h"
+#include "CXHost.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Thread Pool
+// ============================================================================
+
+// One batch runs at a time; concurrent Iterate calls queue on submitLock.
+// The calling thread works as thread index 0, workers as 1..n-1. Jobs are
+// handed out from a shared counter; the first error wins and the remaining
+// jobs still run, as with iterate_generic.
+struct CX_ThreadPool {
+	std::mutex					submitLock;
+	std::mutex					lock;
+	std::condition_variable		wake;
+	std::condition_variable		idle;
+	std::vector<std::thread>	workers;
+
+	// Current batch (written under lock before workers are woken)
+	A_long						count;
+	void						*refcon;
+	CX_IterateFunc				fn;
+	std::atomic<A_long>			next;
+	std::atomic<PF_Err>			err;
+	A_u_long					generation;
+	A_long						active;		// Workers still inside the batch
+	bool						quit;
+
+	// threads <= 0 uses every hardware thread. Throws std::system_error (or
+	// std::bad_alloc) when a worker cannot be started; workers already
+	// running are stopped and joined first.
+	explicit CX_ThreadPool(A_long threads) : count(0), refcon(NULL), fn(NULL), next(0), err(PF_Err_NONE),
+											 generation(0), active(0), quit(false) {
+		if (threads <= 0) threads = (A_long)std::thread::hardware_concurrency();
+		try {
+			workers.reserve(threads > 1 ? threads - 1 : 0);
+			for (A_long t = 1; t < threads; t++) {
+				workers.emplace_back(&CX_ThreadPool::WorkerMain, this, t);
+			}
+		} catch (...) {
+			StopWorkers();
+			throw;
+		}
+	}
+
+	~CX_ThreadPool() {
+		StopWorkers();
+	}
+
+	CX_ThreadPool(const CX_ThreadPool&) = delete;
+	CX_ThreadPool& operator=(const CX_ThreadPool&) = delete;
+
+	A_long ThreadCount() const {
+		return (A_long)workers.size() + 1;
+	}
+
+	PF_Err Iterate(A_long jobCount, void *jobRefcon, CX_IterateFunc jobFn) {
+		if (workers.empty() || jobCount <= 1) return CX_SerialIterate(NULL, jobCount, jobRefcon, jobFn);
+
+		std::lock_guard<std::mutex> submit(submitLock);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			count = jobCount;
+			refcon = jobRefcon;
+			fn = jobFn;
+			next = 0;
+			err = PF_Err_NONE;
+			active = (A_long)workers.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		RunJobs(0);
+
+		// Workers may still hold refcon; wait until every one has left the batch
+		std::unique_lock<std::mutex> guard(lock);
+		idle.wait(guard, [this] { return active == 0; });
+		return err;
+	}
+
+	CX_Host Host() {
+		CX_Host host = { this, IterateThunk };
+		return host;
+	}
+
+private:
+	void StopWorkers() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			quit = true;
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers) worker.join();
+		workers.clear();
+	}
+
+	static PF_Err IterateThunk(void *context, A_long jobCount, void *jobRefcon, CX_IterateFunc jobFn) {
+		return static_cast<CX_ThreadPool*>(context)->Iterate(jobCount, jobRefcon, jobFn);
+	}
+
+	void RunJobs(A_long threadIndex) {
+		for (;;) {
+			A_long i = next++;
+			if (i >= count) break;
+			PF_Err jobErr = fn(refcon, threadIndex, i, count);
+			if (jobErr) {
+				PF_Err none = PF_Err_NONE;
+				err.compare_exchange_strong(none, jobErr);
+			}
+		}
+	}
+
+	void WorkerMain(A_long threadIndex) {
+		A_u_long seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				wake.wait(guard, [&] { return quit || generation != seen; });
+				if (quit) return;
+				seen = generation;
+			}
+			RunJobs(threadIndex);
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if (--active == 0) idle.notify_one();
+			}
+		}
+	}
+};
+
+#endif // CX_THREAD_POOL_H